@@ -0,0 +1,64 @@
+﻿using System;
+using System.Buffers.Binary;
+using ov7675.Protocol;
+
+namespace ov7675.Codec
+{
+    /// <summary>
+    /// Target found by the detector of the device (see cfar.h of the firmware)
+    /// </summary>
+    public readonly struct Detection
+    {
+        /// <summary>
+        /// Size of an encoded detection
+        /// </summary>
+        public const int Size = 6;
+
+        /// <summary>
+        /// Range bin of the target
+        /// </summary>
+        public int RangeBin { get; }
+
+        /// <summary>
+        /// Doppler bin of the target, 0: zero velocity (always 0 with the range profile)
+        /// </summary>
+        public int DopplerBin { get; }
+
+        /// <summary>
+        /// Magnitude of the target over the noise in dB
+        /// </summary>
+        public double SnrDb { get; }
+
+        public Detection(int rangeBin, int dopplerBin, double snrDb)
+        {
+            RangeBin = rangeBin;
+            DopplerBin = dopplerBin;
+            SnrDb = snrDb;
+        }
+
+        /// <summary>
+        /// Decode the list of detections of a message
+        /// </summary>
+        /// <param name="data">Payload of the message (range bin, Doppler bin, SNR in dB 8.8, 16 bits little endian each)</param>
+        /// <param name="header">Header of the message (dims: detections, range bins, Doppler bins)</param>
+        /// <returns>Detections, by increasing range bin, null if the payload is too short or not a list of detections</returns>
+        public static Detection[]? Decode(byte[] data, ProtocolHeader header)
+        {
+            int count = header.Dims[0];
+
+            if ((header.Format != PayloadFormat.Detections) || (data.Length < count * Size)) return null;
+
+            Detection[] detections = new Detection[count];
+            for (int i = 0; i < count; ++i)
+            {
+                ReadOnlySpan<byte> encoded = data.AsSpan(i * Size, Size);
+                detections[i] = new Detection(
+                    BinaryPrimitives.ReadUInt16LittleEndian(encoded),
+                    BinaryPrimitives.ReadInt16LittleEndian(encoded.Slice(2)),
+                    BinaryPrimitives.ReadUInt16LittleEndian(encoded.Slice(4)) / 256.0);
+            }
+
+            return detections;
+        }
+    }
+}
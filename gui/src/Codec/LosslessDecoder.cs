@@ -0,0 +1,125 @@
+﻿using System;
+using System.Numerics;
+using System.Runtime.InteropServices;
+
+namespace ov7675.Codec
+{
+    /// <summary>
+    /// Decoder of the lossless RGB565 frames (see lossless_codec.h of the firmware for the format)
+    /// The operations are parsed into the residuals of a line, the line is then
+    /// rebuilt from the line above with SIMD (System.Numerics.Vector)
+    /// </summary>
+    public static class LosslessDecoder
+    {
+        private const ushort MaskR = 0xF800;
+        private const ushort MaskG = 0x07E0;
+        private const ushort MaskB = 0x001F;
+
+        private const byte OpMask = 0xC0;
+        private const byte OpRun = 0x00;
+        private const byte OpSmall = 0x40;
+        private const byte OpMedium = 0x80;
+        private const byte OpLiteral = 0xC0;
+
+        /// <summary>
+        /// Decode a frame
+        /// </summary>
+        /// <param name="data">Encoded frame</param>
+        /// <param name="width">Number of pixels per line</param>
+        /// <param name="height">Number of lines</param>
+        /// <returns>RGB565 pixels (little endian, width * height * 2 bytes), null if the data is corrupted</returns>
+        public static byte[]? Decode(byte[] data, int width, int height)
+        {
+            if ((width <= 0) || (height <= 0)) return null;
+
+            byte[] image = new byte[width * height * 2];
+            Span<ushort> pixels = MemoryMarshal.Cast<byte, ushort>(image.AsSpan());
+            ushort[] residuals = new ushort[width];
+            ushort[] zero = new ushort[width];
+            int position = 0;
+
+            for (int y = 0; y < height; ++y)
+            {
+                int x = 0;
+                while (x < width)
+                {
+                    if (position >= data.Length) return null;
+
+                    byte op = data[position++];
+                    switch (op & OpMask)
+                    {
+                        case OpRun:
+                            int run = (op & 0x3F) + 1;
+                            if (x + run > width) return null;
+                            Array.Clear(residuals, x, run);
+                            x += run;
+                            break;
+
+                        case OpSmall:
+                            residuals[x++] = (ushort)((((((op >> 4) & 3) - 2) & 0x1F) << 11)
+                                | (((((op >> 2) & 3) - 2) & 0x3F) << 5)
+                                | (((op & 3) - 2) & 0x1F));
+                            break;
+
+                        case OpMedium:
+                            if (position >= data.Length) return null;
+                            int dg = (op & 0x3F) - 32;
+                            int half = dg >> 1;
+                            byte rb = data[position++];
+                            residuals[x++] = (ushort)(((((rb >> 4) - 8 + half) & 0x1F) << 11)
+                                | ((dg & 0x3F) << 5)
+                                | (((rb & 0x0F) - 8 + half) & 0x1F));
+                            break;
+
+                        default:
+                            if ((op != OpLiteral) || (position + 2 > data.Length)) return null;
+                            residuals[x++] = BitConverter.ToUInt16(data, position);
+                            position += 2;
+                            break;
+                    }
+                }
+
+                ReadOnlySpan<ushort> above = (y > 0) ? pixels.Slice((y - 1) * width, width) : zero;
+                Reconstruct(above, residuals, pixels.Slice(y * width, width));
+            }
+
+            return (position == data.Length) ? image : null;
+        }
+
+        /// <summary>
+        /// line = above + residuals, per component (modulo the size of the component)
+        /// </summary>
+        private static void Reconstruct(ReadOnlySpan<ushort> above, ReadOnlySpan<ushort> residuals, Span<ushort> line)
+        {
+            int x = 0;
+
+            if (Vector.IsHardwareAccelerated)
+            {
+                Vector<ushort> maskR = new Vector<ushort>(MaskR);
+                Vector<ushort> maskG = new Vector<ushort>(MaskG);
+                Vector<ushort> maskB = new Vector<ushort>(MaskB);
+
+                for (; x <= line.Length - Vector<ushort>.Count; x += Vector<ushort>.Count)
+                {
+                    Vector<ushort> up = new Vector<ushort>(above.Slice(x));
+                    Vector<ushort> residual = new Vector<ushort>(residuals.Slice(x));
+
+                    Vector<ushort> pixel = (((up & maskR) + (residual & maskR)) & maskR)
+                        | (((up & maskG) + (residual & maskG)) & maskG)
+                        | (((up & maskB) + (residual & maskB)) & maskB);
+                    pixel.CopyTo(line.Slice(x));
+                }
+            }
+
+            for (; x < line.Length; ++x)
+            {
+                int up = above[x];
+                int residual = residuals[x];
+
+                line[x] = (ushort)((((up & MaskR) + (residual & MaskR)) & MaskR)
+                    | (((up & MaskG) + (residual & MaskG)) & MaskG)
+                    | (((up & MaskB) + (residual & MaskB)) & MaskB));
+            }
+        }
+    }
+}
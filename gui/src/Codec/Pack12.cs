@@ -0,0 +1,80 @@
+﻿using System;
+using System.Runtime.InteropServices;
+using System.Runtime.Intrinsics;
+using System.Runtime.Intrinsics.X86;
+
+namespace ov7675.Codec
+{
+    /// <summary>
+    /// Unpacking of the 12 bits radar samples: two samples in three bytes (see pack12.h of the firmware)
+    /// </summary>
+    public static class Pack12
+    {
+        /// <summary>
+        /// Size of count packed samples
+        /// </summary>
+        public static int PackedSize(int count)
+        {
+            return ((count * 3) + 1) / 2;
+        }
+
+        /// <summary>
+        /// Unpack the samples to 16 bits (SSSE3 if available, 8 samples per iteration)
+        /// </summary>
+        /// <param name="data">Packed samples</param>
+        /// <param name="count">Number of samples</param>
+        /// <returns>Samples as uint16 little endian (count * 2 bytes), null if data is too short</returns>
+        public static byte[]? Unpack(byte[] data, int count)
+        {
+            return Unpack(data, count, Ssse3.IsSupported);
+        }
+
+        /// <summary>
+        /// Unpack the samples to 16 bits, with or without SSSE3 (the tests compare both paths)
+        /// </summary>
+        /// <param name="data">Packed samples</param>
+        /// <param name="count">Number of samples</param>
+        /// <param name="useSsse3">SSSE3 for the blocks of 8 samples, ignored if not supported</param>
+        /// <returns>Samples as uint16 little endian (count * 2 bytes), null if data is too short</returns>
+        internal static byte[]? Unpack(byte[] data, int count, bool useSsse3)
+        {
+            if ((count < 0) || (data.Length < PackedSize(count))) return null;
+
+            byte[] output = new byte[count * 2];
+            Span<ushort> samples = MemoryMarshal.Cast<byte, ushort>(output.AsSpan());
+            int i = 0;
+            int offset = 0;
+
+            if (useSsse3 && Ssse3.IsSupported)
+            {
+                // Each 16 bits lane gets the 2 bytes holding its sample
+                Vector128<byte> shuffle = Vector128.Create((byte)0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+                Vector128<ushort> mask = Vector128.Create((ushort)0x0FFF);
+                Vector128<ushort> firstLanes = Vector128.Create((ushort)0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0);
+
+                // 16 bytes are loaded for the 12 of 8 samples
+                for (; (i + 8 <= count) && (offset + 16 <= data.Length); i += 8, offset += 12)
+                {
+                    Vector128<ushort> words = Ssse3.Shuffle(Vector128.LoadUnsafe(ref data[offset]), shuffle).AsUInt16();
+                    Vector128<ushort> first = words & mask;
+                    Vector128<ushort> second = Vector128.ShiftRightLogical(words, 4);
+
+                    Vector128.ConditionalSelect(firstLanes, first, second).CopyTo(samples.Slice(i));
+                }
+            }
+
+            for (; i + 1 < count; i += 2, offset += 3)
+            {
+                samples[i] = (ushort)(data[offset] | ((data[offset + 1] & 0x0F) << 8));
+                samples[i + 1] = (ushort)((data[offset + 1] >> 4) | (data[offset + 2] << 4));
+            }
+
+            if (i < count)
+            {
+                samples[i] = (ushort)(data[offset] | ((data[offset + 1] & 0x0F) << 8));
+            }
+
+            return output;
+        }
+    }
+}
@@ -0,0 +1,116 @@
+﻿using System;
+using System.Runtime.InteropServices;
+using ov7675.Protocol;
+
+namespace ov7675.Codec
+{
+    /// <summary>
+    /// Range bins computed by the device (see range_fft.h of the firmware)
+    /// </summary>
+    public static class RangeProfile
+    {
+        /// <summary>
+        /// True if the format carries range bins
+        /// </summary>
+        public static bool IsRange(PayloadFormat format)
+        {
+            return (format >= PayloadFormat.RangeMagU16) && (format <= PayloadFormat.RangeComplexF32);
+        }
+
+        /// <summary>
+        /// Magnitude of the bins of a range message, in the unit of the float formats
+        /// (the integer formats are scaled by 16 / samples per chirp)
+        /// </summary>
+        /// <param name="data">Payload of the message</param>
+        /// <param name="header">Header of the message (dims: range bins, chirps, antennas)</param>
+        /// <returns>Magnitudes, chirp after chirp, null if the payload is too short or not a range format</returns>
+        public static double[]? Magnitudes(byte[] data, ProtocolHeader header)
+        {
+            int bins = header.Dims[0];
+            int count = bins * header.Dims[1] * header.Dims[2];
+            // Samples per chirp: 2 * bins
+            double scale = (2.0 * bins) / 16.0;
+            double[] output = new double[count];
+
+            switch (header.Format)
+            {
+                case PayloadFormat.RangeMagU16:
+                    if (data.Length < count * sizeof(ushort)) return null;
+                    ReadOnlySpan<ushort> magU16 = MemoryMarshal.Cast<byte, ushort>(data.AsSpan(0, count * sizeof(ushort)));
+                    for (int i = 0; i < count; ++i) output[i] = magU16[i] * scale;
+                    break;
+
+                case PayloadFormat.RangeMagF32:
+                    if (data.Length < count * sizeof(float)) return null;
+                    ReadOnlySpan<float> magF32 = MemoryMarshal.Cast<byte, float>(data.AsSpan(0, count * sizeof(float)));
+                    for (int i = 0; i < count; ++i) output[i] = magF32[i];
+                    break;
+
+                case PayloadFormat.RangeComplexI16:
+                    if (data.Length < count * 2 * sizeof(short)) return null;
+                    ReadOnlySpan<short> complexI16 = MemoryMarshal.Cast<byte, short>(data.AsSpan(0, count * 2 * sizeof(short)));
+                    for (int i = 0; i < count; ++i)
+                    {
+                        output[i] = Math.Sqrt(((double)complexI16[2 * i] * complexI16[2 * i])
+                            + ((double)complexI16[(2 * i) + 1] * complexI16[(2 * i) + 1])) * scale;
+                    }
+                    break;
+
+                case PayloadFormat.RangeComplexF32:
+                    if (data.Length < count * 2 * sizeof(float)) return null;
+                    ReadOnlySpan<float> complexF32 = MemoryMarshal.Cast<byte, float>(data.AsSpan(0, count * 2 * sizeof(float)));
+                    for (int i = 0; i < count; ++i)
+                    {
+                        output[i] = Math.Sqrt(((double)complexF32[2 * i] * complexF32[2 * i])
+                            + ((double)complexF32[(2 * i) + 1] * complexF32[(2 * i) + 1]));
+                    }
+                    break;
+
+                default:
+                    return null;
+            }
+
+            return output;
+        }
+
+        /// <summary>
+        /// Range-Doppler map of the first antenna in dBFS (see range_doppler.h of the firmware:
+        /// a full scale sine of the 12 bits ADC at a constant velocity gives 8192)
+        /// </summary>
+        /// <param name="data">Payload of the message (uint16 magnitudes, one row of Doppler bins per range bin)</param>
+        /// <param name="header">Header of the message (dims: Doppler bins, range bins, antennas)</param>
+        /// <returns>Magnitudes [Doppler bin, range bin], null if the payload is too short or not a map</returns>
+        public static double[,]? DopplerMap(byte[] data, ProtocolHeader header)
+        {
+            int dopplerBins = header.Dims[0];
+            int rangeBins = header.Dims[1];
+
+            if ((header.Format != PayloadFormat.RangeDopplerU16) || (data.Length < dopplerBins * rangeBins * sizeof(ushort))) return null;
+
+            ReadOnlySpan<ushort> magnitudes = MemoryMarshal.Cast<byte, ushort>(data.AsSpan(0, dopplerBins * rangeBins * sizeof(ushort)));
+            double[,] map = new double[dopplerBins, rangeBins];
+
+            for (int k = 0; k < rangeBins; ++k)
+            {
+                for (int d = 0; d < dopplerBins; ++d)
+                {
+                    map[d, k] = 20.0 * Math.Log10(Math.Max(magnitudes[(k * dopplerBins) + d], (ushort)1) / 8192.0);
+                }
+            }
+
+            return map;
+        }
+
+        /// <summary>
+        /// Magnitude in dB relative to a full scale sine of the 12 bits ADC
+        /// (amplitude 2048 through the Hann window: 2048 * samples per chirp / 4)
+        /// </summary>
+        /// <param name="magnitude">Magnitude of a bin</param>
+        /// <param name="bins">Range bins per chirp</param>
+        public static double ToDbFs(double magnitude, int bins)
+        {
+            double fullScale = 2048.0 * (2.0 * bins) / 4.0;
+            return 20.0 * Math.Log10(Math.Max(magnitude, 1e-3) / fullScale);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+﻿using System;
+
+namespace ov7675.Codec
+{
+    /// <summary>
+    /// Reconstruction of the delta frames: tiles changed since the last frame (see tile_delta.h of the firmware)
+    /// </summary>
+    public static class TileDelta
+    {
+        /// <summary>
+        /// Copy the tiles of a delta frame into the last frame
+        /// </summary>
+        /// <param name="data">Delta frame: column, row (1 byte each) and pixels of each tile</param>
+        /// <param name="width">Width of the frame</param>
+        /// <param name="height">Height of the frame</param>
+        /// <param name="tileSize">Width and height of a tile</param>
+        /// <param name="image">Last frame (RGB565, little endian), updated</param>
+        /// <returns>False if the delta frame is corrupted (the frame may be partially updated)</returns>
+        public static bool Apply(byte[] data, int width, int height, int tileSize, byte[] image)
+        {
+            if ((tileSize <= 0) || (width % tileSize != 0) || (height % tileSize != 0)) return false;
+            if (image.Length != width * height * 2) return false;
+
+            int lineSize = tileSize * 2;
+            int entrySize = 2 + (tileSize * lineSize);
+            if (data.Length % entrySize != 0) return false;
+
+            for (int offset = 0; offset < data.Length; offset += entrySize)
+            {
+                int column = data[offset];
+                int row = data[offset + 1];
+                if ((column >= width / tileSize) || (row >= height / tileSize)) return false;
+
+                for (int y = 0; y < tileSize; ++y)
+                {
+                    int destination = ((((row * tileSize) + y) * width) + (column * tileSize)) * 2;
+                    Buffer.BlockCopy(data, offset + 2 + (y * lineSize), image, destination, lineSize);
+                }
+            }
+
+            return true;
+        }
+    }
+}
@@ -36,6 +36,7 @@
             connectButton = new Button();
             disconnectButton = new Button();
             statusTextBox = new TextBox();
+            codecLabel = new Label();
             dataLoggerTabPage = new TabPage();
             storedSizeTextBox = new TextBox();
             storedSizeLabel = new Label();
@@ -48,8 +49,26 @@
             mainMenuStrip = new MenuStrip();
             optionsToolStripMenuItem = new ToolStripMenuItem();
             flipVerticalyToolStripMenuItem = new ToolStripMenuItem();
+            jpegCompressionToolStripMenuItem = new ToolStripMenuItem();
+            losslessCompressionToolStripMenuItem = new ToolStripMenuItem();
+            motionGateToolStripMenuItem = new ToolStripMenuItem();
+            motionDeltaToolStripMenuItem = new ToolStripMenuItem();
+            vgaToolStripMenuItem = new ToolStripMenuItem();
+            rgb555ToolStripMenuItem = new ToolStripMenuItem();
+            fps15ToolStripMenuItem = new ToolStripMenuItem();
+            fps30ToolStripMenuItem = new ToolStripMenuItem();
+            packedRadarToolStripMenuItem = new ToolStripMenuItem();
+            rangeProfileToolStripMenuItem = new ToolStripMenuItem();
+            rangeDopplerToolStripMenuItem = new ToolStripMenuItem();
+            detectionsToolStripMenuItem = new ToolStripMenuItem();
+            batchRadarToolStripMenuItem = new ToolStripMenuItem();
+            chirpPacketsRadarToolStripMenuItem = new ToolStripMenuItem();
             fileToolStripMenuItem = new ToolStripMenuItem();
             savePictureToolStripMenuItem = new ToolStripMenuItem();
+            loadRadarProfileToolStripMenuItem = new ToolStripMenuItem();
+            compiledRadarProfileToolStripMenuItem = new ToolStripMenuItem();
+            deviceStatusToolStripMenuItem = new ToolStripMenuItem();
+            saveTraceToolStripMenuItem = new ToolStripMenuItem();
             ((System.ComponentModel.ISupportInitialize)ov7675PictureBox).BeginInit();
             dataLoggerTabPage.SuspendLayout();
             dataLoggerTabControl.SuspendLayout();
@@ -121,6 +140,14 @@
             statusTextBox.Size = new Size(125, 27);
             statusTextBox.TabIndex = 9;
             // 
+            // codecLabel
+            // 
+            codecLabel.AutoSize = true;
+            codecLabel.Location = new Point(583, 34);
+            codecLabel.Name = "codecLabel";
+            codecLabel.Size = new Size(0, 20);
+            codecLabel.TabIndex = 12;
+            // 
             // dataLoggerTabPage
             // 
             dataLoggerTabPage.Controls.Add(storedSizeTextBox);
@@ -229,7 +256,7 @@
             // 
             // optionsToolStripMenuItem
             // 
-            optionsToolStripMenuItem.DropDownItems.AddRange(new ToolStripItem[] { flipVerticalyToolStripMenuItem });
+            optionsToolStripMenuItem.DropDownItems.AddRange(new ToolStripItem[] { flipVerticalyToolStripMenuItem, jpegCompressionToolStripMenuItem, losslessCompressionToolStripMenuItem, motionGateToolStripMenuItem, motionDeltaToolStripMenuItem, vgaToolStripMenuItem, rgb555ToolStripMenuItem, fps15ToolStripMenuItem, fps30ToolStripMenuItem, packedRadarToolStripMenuItem, rangeProfileToolStripMenuItem, rangeDopplerToolStripMenuItem, detectionsToolStripMenuItem, batchRadarToolStripMenuItem, chirpPacketsRadarToolStripMenuItem });
             optionsToolStripMenuItem.Name = "optionsToolStripMenuItem";
             optionsToolStripMenuItem.Size = new Size(75, 24);
             optionsToolStripMenuItem.Text = "Options";
@@ -241,9 +268,109 @@
             flipVerticalyToolStripMenuItem.Text = "Flip vertically";
             flipVerticalyToolStripMenuItem.Click += flipVerticalyToolStripMenuItem_Click;
             // 
+            // jpegCompressionToolStripMenuItem
+            // 
+            jpegCompressionToolStripMenuItem.Name = "jpegCompressionToolStripMenuItem";
+            jpegCompressionToolStripMenuItem.Size = new Size(179, 26);
+            jpegCompressionToolStripMenuItem.Text = "JPEG compression";
+            jpegCompressionToolStripMenuItem.Click += jpegCompressionToolStripMenuItem_Click;
+            // 
+            // losslessCompressionToolStripMenuItem
+            // 
+            losslessCompressionToolStripMenuItem.Name = "losslessCompressionToolStripMenuItem";
+            losslessCompressionToolStripMenuItem.Size = new Size(224, 26);
+            losslessCompressionToolStripMenuItem.Text = "Lossless compression";
+            losslessCompressionToolStripMenuItem.Click += losslessCompressionToolStripMenuItem_Click;
+            // 
+            // motionGateToolStripMenuItem
+            // 
+            motionGateToolStripMenuItem.Name = "motionGateToolStripMenuItem";
+            motionGateToolStripMenuItem.Size = new Size(252, 26);
+            motionGateToolStripMenuItem.Text = "Skip unchanged frames";
+            motionGateToolStripMenuItem.Click += motionGateToolStripMenuItem_Click;
+            // 
+            // motionDeltaToolStripMenuItem
+            // 
+            motionDeltaToolStripMenuItem.Name = "motionDeltaToolStripMenuItem";
+            motionDeltaToolStripMenuItem.Size = new Size(252, 26);
+            motionDeltaToolStripMenuItem.Text = "Send changed tiles only";
+            motionDeltaToolStripMenuItem.Click += motionDeltaToolStripMenuItem_Click;
+            // 
+            // vgaToolStripMenuItem
+            // 
+            vgaToolStripMenuItem.Name = "vgaToolStripMenuItem";
+            vgaToolStripMenuItem.Size = new Size(252, 26);
+            vgaToolStripMenuItem.Text = "Camera VGA (640x480)";
+            vgaToolStripMenuItem.Enabled = false;
+            vgaToolStripMenuItem.ToolTipText = "Refused by the device unless built with OV7675_VGA_MODE_ENABLED=1";
+            vgaToolStripMenuItem.Click += vgaToolStripMenuItem_Click;
+            // 
+            // rgb555ToolStripMenuItem
+            // 
+            rgb555ToolStripMenuItem.Name = "rgb555ToolStripMenuItem";
+            rgb555ToolStripMenuItem.Size = new Size(252, 26);
+            rgb555ToolStripMenuItem.Text = "Camera RGB555";
+            rgb555ToolStripMenuItem.Click += rgb555ToolStripMenuItem_Click;
+            // 
+            // fps15ToolStripMenuItem
+            // 
+            fps15ToolStripMenuItem.Name = "fps15ToolStripMenuItem";
+            fps15ToolStripMenuItem.Size = new Size(252, 26);
+            fps15ToolStripMenuItem.Text = "Camera 15 fps";
+            fps15ToolStripMenuItem.Click += fps15ToolStripMenuItem_Click;
+            // 
+            // fps30ToolStripMenuItem
+            // 
+            fps30ToolStripMenuItem.Name = "fps30ToolStripMenuItem";
+            fps30ToolStripMenuItem.Size = new Size(252, 26);
+            fps30ToolStripMenuItem.Text = "Camera 30 fps";
+            fps30ToolStripMenuItem.Click += fps30ToolStripMenuItem_Click;
+            // 
+            // packedRadarToolStripMenuItem
+            // 
+            packedRadarToolStripMenuItem.Name = "packedRadarToolStripMenuItem";
+            packedRadarToolStripMenuItem.Size = new Size(252, 26);
+            packedRadarToolStripMenuItem.Text = "Packed radar samples";
+            packedRadarToolStripMenuItem.Click += packedRadarToolStripMenuItem_Click;
+            // 
+            // rangeProfileToolStripMenuItem
+            // 
+            rangeProfileToolStripMenuItem.Name = "rangeProfileToolStripMenuItem";
+            rangeProfileToolStripMenuItem.Size = new Size(252, 26);
+            rangeProfileToolStripMenuItem.Text = "Range profiles (on device)";
+            rangeProfileToolStripMenuItem.Click += rangeProfileToolStripMenuItem_Click;
+            // 
+            // rangeDopplerToolStripMenuItem
+            // 
+            rangeDopplerToolStripMenuItem.Name = "rangeDopplerToolStripMenuItem";
+            rangeDopplerToolStripMenuItem.Size = new Size(252, 26);
+            rangeDopplerToolStripMenuItem.Text = "Range-Doppler maps (on device)";
+            rangeDopplerToolStripMenuItem.Click += rangeDopplerToolStripMenuItem_Click;
+            // 
+            // detectionsToolStripMenuItem
+            // 
+            detectionsToolStripMenuItem.Name = "detectionsToolStripMenuItem";
+            detectionsToolStripMenuItem.Size = new Size(252, 26);
+            detectionsToolStripMenuItem.Text = "Detections only (CFAR on device)";
+            detectionsToolStripMenuItem.Click += detectionsToolStripMenuItem_Click;
+            // 
+            // batchRadarToolStripMenuItem
+            // 
+            batchRadarToolStripMenuItem.Name = "batchRadarToolStripMenuItem";
+            batchRadarToolStripMenuItem.Size = new Size(252, 26);
+            batchRadarToolStripMenuItem.Text = "Batched radar frames";
+            batchRadarToolStripMenuItem.Click += batchRadarToolStripMenuItem_Click;
+            // 
+            // chirpPacketsRadarToolStripMenuItem
+            // 
+            chirpPacketsRadarToolStripMenuItem.Name = "chirpPacketsRadarToolStripMenuItem";
+            chirpPacketsRadarToolStripMenuItem.Size = new Size(252, 26);
+            chirpPacketsRadarToolStripMenuItem.Text = "Per-chirp radar packets";
+            chirpPacketsRadarToolStripMenuItem.Click += chirpPacketsRadarToolStripMenuItem_Click;
+            // 
             // fileToolStripMenuItem
             // 
-            fileToolStripMenuItem.DropDownItems.AddRange(new ToolStripItem[] { savePictureToolStripMenuItem });
+            fileToolStripMenuItem.DropDownItems.AddRange(new ToolStripItem[] { savePictureToolStripMenuItem, loadRadarProfileToolStripMenuItem, compiledRadarProfileToolStripMenuItem, deviceStatusToolStripMenuItem, saveTraceToolStripMenuItem });
             fileToolStripMenuItem.Name = "fileToolStripMenuItem";
             fileToolStripMenuItem.Size = new Size(46, 24);
             fileToolStripMenuItem.Text = "File";
@@ -255,12 +382,41 @@
             savePictureToolStripMenuItem.Text = "Save picture";
             savePictureToolStripMenuItem.Click += savePictureToolStripMenuItem_Click;
             // 
+            // loadRadarProfileToolStripMenuItem
+            // 
+            loadRadarProfileToolStripMenuItem.Name = "loadRadarProfileToolStripMenuItem";
+            loadRadarProfileToolStripMenuItem.Size = new Size(224, 26);
+            loadRadarProfileToolStripMenuItem.Text = "Load radar profile...";
+            loadRadarProfileToolStripMenuItem.Click += loadRadarProfileToolStripMenuItem_Click;
+            // 
+            // compiledRadarProfileToolStripMenuItem
+            // 
+            compiledRadarProfileToolStripMenuItem.Name = "compiledRadarProfileToolStripMenuItem";
+            compiledRadarProfileToolStripMenuItem.Size = new Size(224, 26);
+            compiledRadarProfileToolStripMenuItem.Text = "Compiled radar profile";
+            compiledRadarProfileToolStripMenuItem.Click += compiledRadarProfileToolStripMenuItem_Click;
+            // 
+            // deviceStatusToolStripMenuItem
+            // 
+            deviceStatusToolStripMenuItem.Name = "deviceStatusToolStripMenuItem";
+            deviceStatusToolStripMenuItem.Size = new Size(224, 26);
+            deviceStatusToolStripMenuItem.Text = "Device status";
+            deviceStatusToolStripMenuItem.Click += deviceStatusToolStripMenuItem_Click;
+            // 
+            // saveTraceToolStripMenuItem
+            // 
+            saveTraceToolStripMenuItem.Name = "saveTraceToolStripMenuItem";
+            saveTraceToolStripMenuItem.Size = new Size(224, 26);
+            saveTraceToolStripMenuItem.Text = "Save trace...";
+            saveTraceToolStripMenuItem.Click += saveTraceToolStripMenuItem_Click;
+            // 
             // MainForm
             // 
             AutoScaleDimensions = new SizeF(8F, 20F);
             AutoScaleMode = AutoScaleMode.Font;
             ClientSize = new Size(1026, 730);
             Controls.Add(dataLoggerTabControl);
+            Controls.Add(codecLabel);
             Controls.Add(statusTextBox);
             Controls.Add(disconnectButton);
             Controls.Add(connectButton);
@@ -293,6 +449,7 @@
         private Button connectButton;
         private Button disconnectButton;
         private TextBox statusTextBox;
+        private Label codecLabel;
         private TabPage dataLoggerTabPage;
         private TabControl dataLoggerTabControl;
         private Button dataLoggerOpenPathButton;
@@ -305,7 +462,25 @@
         private MenuStrip mainMenuStrip;
         private ToolStripMenuItem optionsToolStripMenuItem;
         private ToolStripMenuItem flipVerticalyToolStripMenuItem;
+        private ToolStripMenuItem jpegCompressionToolStripMenuItem;
+        private ToolStripMenuItem losslessCompressionToolStripMenuItem;
+        private ToolStripMenuItem motionGateToolStripMenuItem;
+        private ToolStripMenuItem motionDeltaToolStripMenuItem;
+        private ToolStripMenuItem vgaToolStripMenuItem;
+        private ToolStripMenuItem rgb555ToolStripMenuItem;
+        private ToolStripMenuItem fps15ToolStripMenuItem;
+        private ToolStripMenuItem fps30ToolStripMenuItem;
+        private ToolStripMenuItem packedRadarToolStripMenuItem;
+        private ToolStripMenuItem rangeProfileToolStripMenuItem;
+        private ToolStripMenuItem rangeDopplerToolStripMenuItem;
+        private ToolStripMenuItem detectionsToolStripMenuItem;
+        private ToolStripMenuItem batchRadarToolStripMenuItem;
+        private ToolStripMenuItem chirpPacketsRadarToolStripMenuItem;
         private ToolStripMenuItem fileToolStripMenuItem;
         private ToolStripMenuItem savePictureToolStripMenuItem;
+        private ToolStripMenuItem loadRadarProfileToolStripMenuItem;
+        private ToolStripMenuItem compiledRadarProfileToolStripMenuItem;
+        private ToolStripMenuItem deviceStatusToolStripMenuItem;
+        private ToolStripMenuItem saveTraceToolStripMenuItem;
     }
 }
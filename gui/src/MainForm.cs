@@ -1,7 +1,9 @@
-using System;
+﻿using System;
 using System.Drawing.Imaging;
 using System.IO.Ports;
 using kit_pse84_ai_streaming;
+using ov7675.Codec;
+using ov7675.Protocol;
 
 namespace ov7675
 {
@@ -10,16 +12,48 @@ namespace ov7675
         private OV7675CDCReader cdcreader;
         private DataLogger dataLogger;
 
-        private const int width = 320;
-        private const int height = 240;
+        /// <summary>
+        /// Last statistics of the device
+        /// </summary>
+        private Telemetry? lastTelemetry;
 
         private const int bytes_per_pix = 2;
 
-        // TODO dynamic
-        private const int samplesPerChirp = 128;
-
         private bool flipVertically = false;
 
+        /// <summary>
+        /// Quality of the camera frames when the JPEG compression is enabled
+        /// </summary>
+        private const byte jpegQuality = 75;
+
+        /// <summary>
+        /// Mean difference per pixel above which a tile has changed (motion gating)
+        /// </summary>
+        private const byte motionThreshold = 4;
+
+        /// <summary>
+        /// Radar frames per message and deadline in ms when the batching is enabled
+        /// </summary>
+        private const byte radarBatchFrames = 8;
+        private const ushort radarBatchDeadlineMs = 500;
+
+        /// <summary>
+        /// Chirps per block when the per-chirp packets are enabled (dividing the chirps of the radar frames)
+        /// </summary>
+        private const ushort radarBlockChirps = 4;
+
+        /// <summary>
+        /// Last raw camera frame, the delta frames are applied to it
+        /// </summary>
+        private byte[]? lastFrame = null;
+
+        /// <summary>
+        /// Capture mode selected in the menu
+        /// </summary>
+        private CameraMode.Resolution cameraResolution = CameraMode.Initial.Size;
+        private CameraMode.PixelFormat cameraPixelFormat = CameraMode.Initial.Format;
+        private byte cameraFps = CameraMode.Initial.Fps;
+
         public MainForm()
         {
             InitializeComponent();
@@ -28,17 +62,26 @@ namespace ov7675
             cdcreader.OnNewConnectionState += Cdcreader_OnNewConnectionState;
             cdcreader.OnNewOV7675 += Cdcreader_OnNewOV7675;
             cdcreader.OnNewRadarPacket += Cdcreader_OnNewRadarPacket;
+            cdcreader.OnNewRangeProfile += Cdcreader_OnNewRangeProfile;
+            cdcreader.OnNewRangeDopplerMap += Cdcreader_OnNewRangeDopplerMap;
+            cdcreader.OnNewDetections += Cdcreader_OnNewDetections;
+            cdcreader.OnNewRadarProfile += Cdcreader_OnNewRadarProfile;
+            cdcreader.OnNewCameraMode += Cdcreader_OnNewCameraMode;
+            cdcreader.OnNewCommandAck += Cdcreader_OnNewCommandAck;
+            cdcreader.OnNewTelemetry += Cdcreader_OnNewTelemetry;
+            cdcreader.OnNewTrace += Cdcreader_OnNewTrace;
 
             dataLogger = new DataLogger();
             dataLogger.OnNewLoggerState += DataLogger_OnNewLoggerState;
             dataLogger.OnNewBytesWritten += DataLogger_OnNewBytesWritten;
         }
 
-        private void Cdcreader_OnNewRadarPacket(object sender, byte[] data)
+        private void Cdcreader_OnNewRadarPacket(object sender, byte[] data, ProtocolHeader header)
         {
             dataLogger.LogRadar(data);
 
-            // Get the first chirp and display it
+            // Get the first chirp and display it (shape of the current radar profile)
+            int samplesPerChirp = Math.Min((int)header.Dims[0], data.Length / 2);
             double[] samples = new double[samplesPerChirp];
 
             double sum = 0;
@@ -60,8 +103,138 @@ namespace ov7675
             rawRadarSignalsView.updateData(samples);
         }
 
-        private void Cdcreader_OnNewOV7675(object sender, byte[] data)
+        private void Cdcreader_OnNewRangeProfile(object sender, double[] magnitudes, ProtocolHeader header)
+        {
+            // The range bins are not logged (the log holds samples): display the first chirp
+            int bins = header.Dims[0];
+            double[] profile = new double[bins];
+
+            for (int i = 0; i < bins; ++i)
+            {
+                profile[i] = RangeProfile.ToDbFs(magnitudes[i], bins);
+            }
+
+            rawRadarSignalsView.updateProfile(profile);
+        }
+
+        private void Cdcreader_OnNewRangeDopplerMap(object sender, double[,] map, ProtocolHeader header)
+        {
+            rawRadarSignalsView.updateMap(map);
+        }
+
+        private void Cdcreader_OnNewDetections(object sender, Detection[] detections, ProtocolHeader header)
+        {
+            rawRadarSignalsView.updateDetections(detections, header.Dims[1], header.Dims[2]);
+        }
+
+        private void Cdcreader_OnNewRadarProfile(object sender, int status, uint switchUs, ProtocolHeader header)
+        {
+            System.Diagnostics.Debug.WriteLine(string.Format("Radar profile {0}x{1}x{2}: status {3}, switched in {4} us",
+                header.Dims[0], header.Dims[1], header.Dims[2], status, switchUs));
+            if (status != 0)
+            {
+                MessageBox.Show(string.Format("The radar profile has been rejected ({0})", CommandClient.StatusText(status)), "Radar profile",
+                    MessageBoxButtons.OK, MessageBoxIcon.Warning);
+            }
+        }
+
+        private void Cdcreader_OnNewCameraMode(object sender, int status, uint reconfigureUs, uint firstFrameUs, ProtocolHeader header)
+        {
+            System.Diagnostics.Debug.WriteLine(string.Format("Camera mode {0}x{1} {2} fps: status {3}, reconfigured in {4} us, first frame after {5} us",
+                header.Dims[0], header.Dims[1], header.Dims[2], status, reconfigureUs, firstFrameUs));
+            if (status != 0)
+            {
+                MessageBox.Show(string.Format("The camera mode has been rejected ({0})", CommandClient.StatusText(status)), "Camera mode",
+                    MessageBoxButtons.OK, MessageBoxIcon.Warning);
+            }
+        }
+
+        private void Cdcreader_OnNewCommandAck(object sender, CommandClient.Ack ack)
+        {
+            System.Diagnostics.Debug.WriteLine(string.Format("Command {0} (request {1}): status {2}, round trip {3} us",
+                ack.Command, ack.RequestId, ack.Status, ack.RoundTripUs));
+            if ((ack.Command == TraceDump.CommandTrace) && (ack.Status == CommandClient.StatusUnknown))
+            {
+                MessageBox.Show("The firmware has been built without the profiling probes (TRACE_ENABLED=1)", "Trace",
+                    MessageBoxButtons.OK, MessageBoxIcon.Warning);
+                return;
+            }
+            if ((ack.Command == CameraMode.CommandCameraMode) && (ack.Status == CommandClient.StatusInvalid))
+            {
+                // Refused by the acknowledgement alone: no CameraMode reply follows
+                MessageBox.Show(string.Format("The camera mode has been rejected ({0})", CommandClient.StatusText(ack.Status)), "Camera mode",
+                    MessageBoxButtons.OK, MessageBoxIcon.Warning);
+                return;
+            }
+            if (ack.Command != CommandClient.CommandStatus) return;
+
+            DeviceStatus? status = DeviceStatus.Decode(ack.Data);
+            if (status != null)
+            {
+                string text = status.ToString();
+                if (lastTelemetry != null) text += "\r\n\r\n" + lastTelemetry.ToString();
+                MessageBox.Show(text, "Device status", MessageBoxButtons.OK, MessageBoxIcon.Information);
+            }
+        }
+
+        private void Cdcreader_OnNewTrace(object sender, TraceDump dump)
         {
+            SaveFileDialog dlg = new SaveFileDialog();
+            dlg.FileName = "trace";
+            dlg.DefaultExt = "json";
+            dlg.Filter = "Chrome trace (.json)|*.json";
+            dlg.Title = "Save trace (Perfetto, chrome://tracing)";
+
+            if (dlg.ShowDialog() == DialogResult.OK)
+            {
+                File.WriteAllText(dlg.FileName, dump.ToChromeJson());
+            }
+            MessageBox.Show(dump.ToString(), "Trace", MessageBoxButtons.OK, MessageBoxIcon.Information);
+        }
+
+        private void Cdcreader_OnNewTelemetry(object sender, Telemetry report)
+        {
+            // Shown with the state of the device
+            lastTelemetry = report;
+        }
+
+        private void Cdcreader_OnNewOV7675(object sender, byte[] data, ProtocolHeader header)
+        {
+            ShowCodec(data, header);
+
+            if (header.Format == PayloadFormat.Jpeg)
+            {
+                ShowJpeg(data);
+                return;
+            }
+
+            if (header.Format == PayloadFormat.Rgb565Lossless)
+            {
+                // Same pixels as the raw frame: logged and displayed as such
+                byte[]? pixels = LosslessDecoder.Decode(data, header.Dims[0], header.Dims[1]);
+                if (pixels == null)
+                {
+                    System.Diagnostics.Debug.WriteLine("Invalid lossless frame");
+                    return;
+                }
+                data = pixels;
+            }
+
+            if (header.Format == PayloadFormat.Rgb565Tiles)
+            {
+                // Only the tiles changed since the last frame: applied to a copy of it
+                if ((lastFrame == null) || (lastFrame.Length != header.Dims[0] * header.Dims[1] * bytes_per_pix)) return;
+                byte[] frame = (byte[])lastFrame.Clone();
+                if (!TileDelta.Apply(data, header.Dims[0], header.Dims[1], header.Dims[2], frame))
+                {
+                    System.Diagnostics.Debug.WriteLine("Invalid delta frame");
+                    return;
+                }
+                data = frame;
+            }
+
+            int width = header.Dims[0];
+            int height = header.Dims[1];
             int data_count = width * height * bytes_per_pix;
             //if (data_count != (data.Length - OV7675CDCReader.COM_OVERHEAD))
             if (data_count != data.Length)
@@ -70,6 +243,7 @@ namespace ov7675
                 return;
             }
 
+            lastFrame = data;
             dataLogger.LogOV7675(data);
 
             // Cast buffer to uint16
@@ -86,10 +260,15 @@ namespace ov7675
                 {
                     UInt16 p = u16buffer[y * width + x];
 
-                    // convert RGB565 to RGB 24-bit
+                    // convert RGB565 (or RGB555) to RGB 24-bit
                     int r = ((p >> 11) & 0x1f) << 3;
                     int g = ((p >> 5) & 0x3f) << 2;
                     int b = ((p >> 0) & 0x1f) << 3;
+                    if (header.Format == PayloadFormat.Rgb555)
+                    {
+                        r = ((p >> 10) & 0x1f) << 3;
+                        g = ((p >> 5) & 0x1f) << 3;
+                    }
 
                     int xindex = x;
                     if (flipVertically) xindex = (width - 1) - x;
@@ -102,6 +281,54 @@ namespace ov7675
             ov7675PictureBox.Image = bmp;
         }
 
+        /// <summary>
+        /// Display the compression ratio and the encode cost of a camera frame
+        /// </summary>
+        private void ShowCodec(byte[] data, ProtocolHeader header)
+        {
+            if (header.Format == PayloadFormat.Rgb565Tiles)
+            {
+                int frameSize = header.Dims[0] * header.Dims[1] * bytes_per_pix;
+                codecLabel.Text = string.Format("{0}: {1:F1}% of a frame", header.Format, 100.0 * data.Length / frameSize);
+                return;
+            }
+
+            if ((header.Format != PayloadFormat.Jpeg) && (header.Format != PayloadFormat.Rgb565Lossless))
+            {
+                codecLabel.Text = "";
+                return;
+            }
+
+            double ratio = (double)(header.Dims[0] * header.Dims[1] * bytes_per_pix) / data.Length;
+            codecLabel.Text = string.Format("{0}: ratio {1:F2}, {2:F1} cycles/pixel",
+                header.Format, ratio, header.EncodeCost / 256.0);
+        }
+
+        /// <summary>
+        /// Display a JPEG frame (not logged: the logger stores raw frames)
+        /// </summary>
+        private void ShowJpeg(byte[] data)
+        {
+            Bitmap bmp;
+            try
+            {
+                using (MemoryStream stream = new MemoryStream(data))
+                using (Image image = Image.FromStream(stream))
+                {
+                    bmp = new Bitmap(image);
+                }
+            }
+            catch (ArgumentException)
+            {
+                System.Diagnostics.Debug.WriteLine("Invalid JPEG frame");
+                return;
+            }
+
+            if (flipVertically) bmp.RotateFlip(RotateFlipType.RotateNoneFlipX);
+
+            ov7675PictureBox.Image = bmp;
+        }
+
         private void Cdcreader_OnNewConnectionState(object sender, OV7675CDCReader.ConnectionState state)
         {
             // System.Diagnostics.Debug.WriteLine("CDC New connection state: " + state.ToString());
@@ -233,6 +460,150 @@ namespace ov7675
             flipVerticalyToolStripMenuItem.Checked = flipVertically;
         }
 
+        private void jpegCompressionToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            jpegCompressionToolStripMenuItem.Checked = !jpegCompressionToolStripMenuItem.Checked;
+            losslessCompressionToolStripMenuItem.Checked = false;
+            cdcreader.SetCameraCodec(jpegCompressionToolStripMenuItem.Checked ?
+                OV7675CDCReader.CameraCodec.Jpeg : OV7675CDCReader.CameraCodec.Raw, jpegQuality);
+        }
+
+        private void losslessCompressionToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            losslessCompressionToolStripMenuItem.Checked = !losslessCompressionToolStripMenuItem.Checked;
+            jpegCompressionToolStripMenuItem.Checked = false;
+            cdcreader.SetCameraCodec(losslessCompressionToolStripMenuItem.Checked ?
+                OV7675CDCReader.CameraCodec.Lossless : OV7675CDCReader.CameraCodec.Raw, 0);
+        }
+
+        private void motionGateToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            motionGateToolStripMenuItem.Checked = !motionGateToolStripMenuItem.Checked;
+            motionDeltaToolStripMenuItem.Checked = false;
+            cdcreader.SetCameraMotion(motionGateToolStripMenuItem.Checked ?
+                OV7675CDCReader.CameraMotion.Gate : OV7675CDCReader.CameraMotion.Off, motionThreshold);
+        }
+
+        private void motionDeltaToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            motionDeltaToolStripMenuItem.Checked = !motionDeltaToolStripMenuItem.Checked;
+            motionGateToolStripMenuItem.Checked = false;
+            cdcreader.SetCameraMotion(motionDeltaToolStripMenuItem.Checked ?
+                OV7675CDCReader.CameraMotion.Delta : OV7675CDCReader.CameraMotion.Off, motionThreshold);
+        }
+
+        private void packedRadarToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            packedRadarToolStripMenuItem.Checked = !packedRadarToolStripMenuItem.Checked;
+            rangeProfileToolStripMenuItem.Checked = false;
+            rangeDopplerToolStripMenuItem.Checked = false;
+            detectionsToolStripMenuItem.Checked = false;
+            cdcreader.SetRadarFormat(packedRadarToolStripMenuItem.Checked ? PayloadFormat.RadarU12 : PayloadFormat.RadarU16);
+        }
+
+        private void rangeProfileToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            rangeProfileToolStripMenuItem.Checked = !rangeProfileToolStripMenuItem.Checked;
+            packedRadarToolStripMenuItem.Checked = false;
+            rangeDopplerToolStripMenuItem.Checked = false;
+            detectionsToolStripMenuItem.Checked = false;
+            cdcreader.SetRadarFormat(rangeProfileToolStripMenuItem.Checked ? PayloadFormat.RangeMagU16 : PayloadFormat.RadarU16);
+        }
+
+        private void rangeDopplerToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            rangeDopplerToolStripMenuItem.Checked = !rangeDopplerToolStripMenuItem.Checked;
+            packedRadarToolStripMenuItem.Checked = false;
+            rangeProfileToolStripMenuItem.Checked = false;
+            detectionsToolStripMenuItem.Checked = false;
+            cdcreader.SetRadarFormat(rangeDopplerToolStripMenuItem.Checked ? PayloadFormat.RangeDopplerU16 : PayloadFormat.RadarU16);
+        }
+
+        private void detectionsToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            detectionsToolStripMenuItem.Checked = !detectionsToolStripMenuItem.Checked;
+            packedRadarToolStripMenuItem.Checked = false;
+            rangeProfileToolStripMenuItem.Checked = false;
+            rangeDopplerToolStripMenuItem.Checked = false;
+            cdcreader.SetRadarFormat(detectionsToolStripMenuItem.Checked ? PayloadFormat.Detections : PayloadFormat.RadarU16);
+        }
+
+        private void batchRadarToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            batchRadarToolStripMenuItem.Checked = !batchRadarToolStripMenuItem.Checked;
+            cdcreader.SetRadarBatch(batchRadarToolStripMenuItem.Checked ? radarBatchFrames : (byte)1, radarBatchDeadlineMs);
+        }
+
+        private void chirpPacketsRadarToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            chirpPacketsRadarToolStripMenuItem.Checked = !chirpPacketsRadarToolStripMenuItem.Checked;
+            cdcreader.SetRadarBlock(chirpPacketsRadarToolStripMenuItem.Checked ? radarBlockChirps : (ushort)0,
+                chirpPacketsRadarToolStripMenuItem.Checked);
+        }
+
+        private void loadRadarProfileToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            OpenFileDialog dlg = new OpenFileDialog();
+            dlg.Filter = "Radar settings (.h)|*.h";
+
+            if (dlg.ShowDialog() != DialogResult.OK) return;
+
+            // Export of the Radar Fusion GUI, same format as radar_settings.h
+            RadarProfile? profile = RadarProfile.Parse(File.ReadAllText(dlg.FileName));
+            if (profile == null)
+            {
+                MessageBox.Show("No radar profile in this file", "Radar profile", MessageBoxButtons.OK, MessageBoxIcon.Warning);
+                return;
+            }
+
+            cdcreader.SetRadarProfile(profile);
+        }
+
+        private void compiledRadarProfileToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            cdcreader.SetRadarProfile(RadarProfile.Compiled);
+        }
+
+        private void deviceStatusToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            cdcreader.RequestStatus();
+        }
+
+        private void saveTraceToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            cdcreader.RequestTrace();
+        }
+
+        private void vgaToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            vgaToolStripMenuItem.Checked = !vgaToolStripMenuItem.Checked;
+            cameraResolution = vgaToolStripMenuItem.Checked ? CameraMode.Resolution.Vga : CameraMode.Resolution.Qvga;
+            cdcreader.SetCameraMode(new CameraMode(cameraResolution, cameraPixelFormat, cameraFps));
+        }
+
+        private void rgb555ToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            rgb555ToolStripMenuItem.Checked = !rgb555ToolStripMenuItem.Checked;
+            cameraPixelFormat = rgb555ToolStripMenuItem.Checked ? CameraMode.PixelFormat.Rgb555 : CameraMode.PixelFormat.Rgb565;
+            cdcreader.SetCameraMode(new CameraMode(cameraResolution, cameraPixelFormat, cameraFps));
+        }
+
+        private void fps15ToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            fps15ToolStripMenuItem.Checked = !fps15ToolStripMenuItem.Checked;
+            fps30ToolStripMenuItem.Checked = false;
+            cameraFps = fps15ToolStripMenuItem.Checked ? (byte)15 : CameraMode.Initial.Fps;
+            cdcreader.SetCameraMode(new CameraMode(cameraResolution, cameraPixelFormat, cameraFps));
+        }
+
+        private void fps30ToolStripMenuItem_Click(object sender, EventArgs e)
+        {
+            fps30ToolStripMenuItem.Checked = !fps30ToolStripMenuItem.Checked;
+            fps15ToolStripMenuItem.Checked = false;
+            cameraFps = fps30ToolStripMenuItem.Checked ? (byte)30 : CameraMode.Initial.Fps;
+            cdcreader.SetCameraMode(new CameraMode(cameraResolution, cameraPixelFormat, cameraFps));
+        }
+
         private void savePictureToolStripMenuItem_Click(object sender, EventArgs e)
         {
             SaveFileDialog dlg = new SaveFileDialog();
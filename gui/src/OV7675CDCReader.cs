@@ -6,6 +6,8 @@ using System.IO.Ports;
 using System.Linq;
 using System.Text;
 using System.Threading.Tasks;
+using ov7675.Codec;
+using ov7675.Protocol;
 using static System.Windows.Forms.VisualStyles.VisualStyleElement;
 
 namespace ov7675
@@ -20,10 +22,100 @@ namespace ov7675
 
         private const int WORKER_OV7675_PACKET = 10;
         private const int WORKER_RADAR_PACKET = 11;
+        private const int WORKER_RANGE_PACKET = 12;
+        private const int WORKER_DETECTIONS_PACKET = 13;
+        private const int WORKER_RADAR_PROFILE = 14;
+        private const int WORKER_CAMERA_MODE = 15;
+        private const int WORKER_COMMAND_ACK = 16;
+        private const int WORKER_TELEMETRY = 17;
+        private const int WORKER_TRACE = 18;
 
-        public const int COM_OVERHEAD = 8;
+        /// <summary>
+        /// Size of the reads from the serial port
+        /// </summary>
+        private const int READ_BUFFER_SIZE = 65536;
+
+        /// <summary>
+        /// Period of the clock synchronization requests
+        /// </summary>
+        private const long TIME_SYNC_PERIOD_US = 1000000;
+
+        /// <summary>
+        /// Command selecting the compression of the camera frames, followed by the codec and the quality
+        /// </summary>
+        private const byte COMMAND_CAMERA_CODEC = 52;
+
+        /// <summary>
+        /// Command selecting the motion gating of the camera frames, followed by the mode and the threshold
+        /// </summary>
+        private const byte COMMAND_CAMERA_MOTION = 53;
+
+        /// <summary>
+        /// Command selecting the format of the radar frames (samples or range bins), followed by the format
+        /// </summary>
+        private const byte COMMAND_RADAR_FORMAT = 54;
+
+        /// <summary>
+        /// Command configuring the detector of the Detections format, followed by the input,
+        /// the mode, the guard and training cells, the threshold in dB and the rank
+        /// </summary>
+        private const byte COMMAND_RADAR_CFAR = 55;
+
+        /// <summary>
+        /// Command selecting the batching of the radar frames, followed by the frames per message
+        /// and the deadline in ms (16 bits little endian)
+        /// </summary>
+        private const byte COMMAND_RADAR_BATCH = 56;
+
+        /// <summary>
+        /// Command switching the register profile of the radar, followed by the shape of the frames
+        /// and the registers (see RadarProfile)
+        /// </summary>
+        private const byte COMMAND_RADAR_PROFILE = 57;
+
+        /// <summary>
+        /// Command switching the capture mode of the camera, followed by the resolution,
+        /// the pixel format and the frame rate (see CameraMode)
+        /// </summary>
+        private const byte COMMAND_CAMERA_MODE = CameraMode.CommandCameraMode;
+
+        /// <summary>
+        /// Compression of the camera frames (camera_codec_t of the firmware)
+        /// </summary>
+        public enum CameraCodec : byte
+        {
+            Raw = 0,
+            Jpeg = 1,
+            Lossless = 2
+        }
+
+        /// <summary>
+        /// Motion gating of the camera frames (camera_motion_t of the firmware)
+        /// </summary>
+        public enum CameraMotion : byte
+        {
+            Off = 0,
+            Gate = 1,
+            Delta = 2
+        }
 
-        private int[] POSSIBLE_LENGTHS = new int[] { 153600, 4096 };
+        /// <summary>
+        /// Input of the detector (radar_cfar_source_t of the firmware)
+        /// </summary>
+        public enum CfarSource : byte
+        {
+            RangeDoppler = 0,
+            RangeProfile = 1
+        }
+
+        /// <summary>
+        /// Noise estimation of the detector (cfar_mode_t of the firmware)
+        /// </summary>
+        public enum CfarMode : byte
+        {
+            CellAveraging = 0,
+            OrderedStatistic = 1
+        }
 
         public enum ConnectionState
         {
@@ -35,12 +127,36 @@ namespace ov7675
         public delegate void OnNewConnectionStateEventHandler(object sender, ConnectionState state);
         public event OnNewConnectionStateEventHandler? OnNewConnectionState;
 
-        public delegate void OnNewOV7675PacketEventHandler(object sender, byte[] data);
+        public delegate void OnNewOV7675PacketEventHandler(object sender, byte[] data, ProtocolHeader header);
         public event OnNewOV7675PacketEventHandler? OnNewOV7675;
 
-        public delegate void OnNewRadarPacketEventHandler(object sender, byte[] data);
+        public delegate void OnNewRadarPacketEventHandler(object sender, byte[] data, ProtocolHeader header);
         public event OnNewRadarPacketEventHandler? OnNewRadarPacket;
 
+        public delegate void OnNewRangeProfileEventHandler(object sender, double[] magnitudes, ProtocolHeader header);
+        public event OnNewRangeProfileEventHandler? OnNewRangeProfile;
+
+        public delegate void OnNewRangeDopplerMapEventHandler(object sender, double[,] map, ProtocolHeader header);
+        public event OnNewRangeDopplerMapEventHandler? OnNewRangeDopplerMap;
+
+        public delegate void OnNewDetectionsEventHandler(object sender, Detection[] detections, ProtocolHeader header);
+        public event OnNewDetectionsEventHandler? OnNewDetections;
+
+        public delegate void OnNewRadarProfileEventHandler(object sender, int status, uint switchUs, ProtocolHeader header);
+        public event OnNewRadarProfileEventHandler? OnNewRadarProfile;
+
+        public delegate void OnNewCameraModeEventHandler(object sender, int status, uint reconfigureUs, uint firstFrameUs, ProtocolHeader header);
+        public event OnNewCameraModeEventHandler? OnNewCameraMode;
+
+        public delegate void OnNewCommandAckEventHandler(object sender, CommandClient.Ack ack);
+        public event OnNewCommandAckEventHandler? OnNewCommandAck;
+
+        public delegate void OnNewTelemetryEventHandler(object sender, Telemetry report);
+        public event OnNewTelemetryEventHandler? OnNewTelemetry;
+
+        public delegate void OnNewTraceEventHandler(object sender, TraceDump dump);
+        public event OnNewTraceEventHandler? OnNewTrace;
+
         /// <summary>
         /// Serial port used for the communication
         /// </summary>
@@ -55,6 +171,87 @@ namespace ov7675
 
         private object sync = new object();
 
+        /// <summary>
+        /// Compression of the camera frames, sent by the worker
+        /// </summary>
+        private CameraCodec cameraCodec = CameraCodec.Raw;
+        private byte cameraQuality = 0;
+        private bool cameraCodecChanged = false;
+
+        /// <summary>
+        /// Motion gating of the camera frames, sent by the worker
+        /// </summary>
+        private CameraMotion cameraMotion = CameraMotion.Off;
+        private byte cameraMotionThreshold = 0;
+        private bool cameraMotionChanged = false;
+
+        /// <summary>
+        /// Format of the radar frames (RadarU16, RadarU12 or RangeXxx), sent by the worker
+        /// </summary>
+        private PayloadFormat radarFormat = PayloadFormat.RadarU16;
+        private bool radarFormatChanged = false;
+
+        /// <summary>
+        /// Configuration of the detector, sent by the worker
+        /// </summary>
+        private byte[] radarCfar = new byte[7] { COMMAND_RADAR_CFAR, (byte)CfarSource.RangeDoppler, (byte)CfarMode.CellAveraging, 2, 8, 12, 0 };
+        private bool radarCfarChanged = false;
+
+        /// <summary>
+        /// Batching of the radar frames (1: none), sent by the worker
+        /// </summary>
+        private byte radarBatchFrames = 1;
+        private ushort radarBatchDeadlineMs = 0;
+        private bool radarBatchChanged = false;
+
+        /// <summary>
+        /// Blocks of chirps read from the FIFO of the radar (0: whole frames) and per-chirp packets,
+        /// sent by the worker; the blocks received are put together into frames
+        /// </summary>
+        private ushort radarBlockChirps = 0;
+        private bool radarBlockPackets = false;
+        private bool radarBlockChanged = false;
+        private RadarChirps radarChirps = new RadarChirps();
+
+        /// <summary>
+        /// Register profile of the radar (null: not changed since the device started), sent by the worker
+        /// </summary>
+        private RadarProfile? radarProfile = null;
+        private bool radarProfileChanged = false;
+
+        /// <summary>
+        /// Capture mode of the camera (null: not changed since the device started), sent by the worker
+        /// </summary>
+        private CameraMode? cameraMode = null;
+        private bool cameraModeChanged = false;
+
+        /// <summary>
+        /// State of the device requested, sent by the worker
+        /// </summary>
+        private bool statusRequested = false;
+
+        /// <summary>
+        /// Events of the profiling probes requested, sent by the worker
+        /// </summary>
+        private bool traceRequested = false;
+
+        /// <summary>
+        /// Framing of the commands and matching of their acknowledgements
+        /// Used by the background worker
+        /// </summary>
+        private CommandClient commands = new CommandClient();
+
+        /// <summary>
+        /// Parser of the protocol v2
+        /// </summary>
+        private ProtocolParser parser = new ProtocolParser();
+
+        /// <summary>
+        /// Offset between the timestamps of the device and the host clock
+        /// Updated by the background worker
+        /// </summary>
+        public ClockSync Clock { get; } = new ClockSync();
+
         public void SetPortName(string portName)
         {
             try
@@ -84,131 +281,168 @@ namespace ov7675
             if (worker != null) worker.RunWorkerAsync();
         }
 
-        public void Disconnect()
+        /// <summary>
+        /// Select the compression of the camera frames
+        /// </summary>
+        /// <param name="codec">Codec</param>
+        /// <param name="quality">1 to 100: JPEG quality (ignored by the other codecs)</param>
+        public void SetCameraCodec(CameraCodec codec, byte quality)
         {
-            lock(sync)
+            lock (sync)
             {
-                stopRequest = true;
+                cameraCodec = codec;
+                cameraQuality = quality;
+                cameraCodecChanged = true;
             }
         }
 
-        private void CreateBackgroundWorker()
+        /// <summary>
+        /// Select the motion gating of the camera frames
+        /// </summary>
+        /// <param name="motion">Mode</param>
+        /// <param name="threshold">Mean difference per compared pixel above which a tile has changed</param>
+        public void SetCameraMotion(CameraMotion motion, byte threshold)
         {
-            if (this.worker != null)
+            lock (sync)
             {
-                this.worker.CancelAsync();
+                cameraMotion = motion;
+                cameraMotionThreshold = threshold;
+                cameraMotionChanged = true;
             }
-
-            this.worker = new BackgroundWorker();
-            this.worker.WorkerReportsProgress = true;
-            this.worker.WorkerSupportsCancellation = true;
-            this.worker.DoWork += Worker_DoWork;
-            this.worker.ProgressChanged += Worker_ProgressChanged;
-            this.worker.RunWorkerCompleted += Worker_RunWorkerCompleted;
         }
 
         /// <summary>
-        /// Compute CRC
+        /// Select the format of the radar frames
         /// </summary>
-        /// <param name="buffer"></param>
-        /// <param name="startIndex">Start index (included)</param>
-        /// <param name="stopIndex">Stop index (excluded)</param>
-        /// <returns></returns>
-        private static byte Crc(byte[] buffer, int startIndex, int stopIndex)
+        /// <param name="format">RadarU16, RadarU12 (12 bits samples packed by 2 in 3 bytes)
+        /// RangeXxx (range bins computed by the device) or RangeDopplerU16 (range-Doppler maps)</param>
+        public void SetRadarFormat(PayloadFormat format)
         {
-            byte crc = 0x15;
-            int j = 0;
-            for (j = startIndex; j < stopIndex; ++j)
+            lock (sync)
             {
-                byte tmp = (byte)(buffer[j] ^ crc);
-                int i = 0;
-                for (i = 0; i < 8; ++i)
-                {
-                    byte lsb = (byte)(tmp & 0x01);
-                    tmp >>= 1;
-                    if (lsb != 0) tmp ^= 0x8C; //polynome 0x8C
-                }
-                crc = (byte)tmp;
+                radarFormat = format;
+                radarFormatChanged = true;
             }
-
-            return crc;
         }
 
-        private int readHeader(byte[] header, out byte counter, out int packetLength, out byte crc)
+        /// <summary>
+        /// Configure the detector of the Detections format
+        /// </summary>
+        /// <param name="source">Range-Doppler map (range and velocity) or range profile (range only)</param>
+        /// <param name="mode">Noise estimation</param>
+        /// <param name="guard">Guard cells on each side of the cell under test (0 to 8)</param>
+        /// <param name="training">Training cells on each side (1 to 16)</param>
+        /// <param name="thresholdDb">Magnitude over noise of a detection (0 to 60)</param>
+        /// <param name="rank">OrderedStatistic: rank of the noise in the sorted training cells, 0: 3/4</param>
+        public void SetRadarCfar(CfarSource source, CfarMode mode, byte guard, byte training, byte thresholdDb, byte rank)
         {
-            // Default
-            packetLength = -1;
-            crc = 0;
-            counter = 0;
-
-            // Header is COM_OVERHEAD bytes
-            if ((header == null) || (header.Length != COM_OVERHEAD)) return -1;
-            if (port == null) return -2;
-
-            int readIndex = 0;
-            int remaining = COM_OVERHEAD;
-
-            try
+            lock (sync)
             {
-                for (; ; )
-                {
-                    int read_bytes = port.Read(header, readIndex, remaining);
-                    readIndex += read_bytes;
-                    remaining -= read_bytes;
-                    if (remaining == 0) break;
-                }
+                radarCfar = new byte[7] { COMMAND_RADAR_CFAR, (byte)source, (byte)mode, guard, training, thresholdDb, rank };
+                radarCfarChanged = true;
             }
-            catch(Exception)
+        }
+
+        /// <summary>
+        /// Select the batching of the radar frames
+        /// </summary>
+        /// <param name="frames">Frames per message (1 to 16, 1: no batching)</param>
+        /// <param name="deadlineMs">Longest time between the capture of a frame and the sending of its batch (0: device default)</param>
+        public void SetRadarBatch(byte frames, ushort deadlineMs)
+        {
+            lock (sync)
             {
-                return -3;
+                radarBatchFrames = frames;
+                radarBatchDeadlineMs = deadlineMs;
+                radarBatchChanged = true;
             }
+        }
 
-            // Check content
-            if ((header[0] != 0x55) || (header[1] != 0x55)) return -4;
-
-            // Get counter
-            counter = header[2];
-
-            // Get length
-            packetLength = BitConverter.ToInt32(header, 3);
+        /// <summary>
+        /// Select the blocks of chirps read at each data interrupt of the radar
+        /// </summary>
+        /// <param name="chirps">Chirps per block (dividing the chirps of a frame), 0: whole frames</param>
+        /// <param name="packets">Each block sent as soon as read (put together into frames here)
+        /// or put together by the device</param>
+        public void SetRadarBlock(ushort chirps, bool packets)
+        {
+            lock (sync)
+            {
+                radarBlockChirps = chirps;
+                radarBlockPackets = packets;
+                radarBlockChanged = true;
+            }
+        }
 
-            // TODO check if length is plausible or not
+        /// <summary>
+        /// Switch the register profile of the radar, the device replies with OnNewRadarProfile
+        /// </summary>
+        /// <param name="profile">Profile, RadarProfile.Compiled: profile compiled in the firmware</param>
+        public void SetRadarProfile(RadarProfile profile)
+        {
+            lock (sync)
+            {
+                radarProfile = profile;
+                radarProfileChanged = true;
+            }
+        }
 
-            // Get CRC
-            crc = header[7];
+        /// <summary>
+        /// Switch the capture mode of the camera, the device replies with OnNewCameraMode
+        /// </summary>
+        public void SetCameraMode(CameraMode mode)
+        {
+            lock (sync)
+            {
+                cameraMode = mode;
+                cameraModeChanged = true;
+            }
+        }
 
-            return 0;
+        /// <summary>
+        /// Request the state of the device, the device replies with OnNewCommandAck (DeviceStatus)
+        /// </summary>
+        public void RequestStatus()
+        {
+            lock (sync)
+            {
+                statusRequested = true;
+            }
         }
 
         /// <summary>
-        /// 
+        /// Request the events of the profiling probes, the device replies with OnNewTrace
+        /// (or with a CommandAck of status StatusUnknown if built without the probes)
         /// </summary>
-        /// <param name="packet"></param>
-        /// <returns></returns>
-        private int readPacket(byte[] packet)
+        public void RequestTrace()
         {
-            if (port == null) return -1;
-            if ((packet == null) ||(packet.Length == 0))  return -2; 
+            lock (sync)
+            {
+                traceRequested = true;
+            }
+        }
 
-            int readIndex = 0;
-            int remaining = packet.Length;
-            try
+        public void Disconnect()
+        {
+            lock(sync)
             {
-                for (; ; )
-                {
-                    // TODO: add try/catch here
-                    int read_bytes = port.Read(packet, readIndex, remaining);
-                    readIndex += read_bytes;
-                    remaining -= read_bytes;
-                    if (remaining == 0) break;
-                }
+                stopRequest = true;
             }
-            catch(Exception)
+        }
+
+        private void CreateBackgroundWorker()
+        {
+            if (this.worker != null)
             {
-                return -3;
+                this.worker.CancelAsync();
             }
 
-            return 0;
+            this.worker = new BackgroundWorker();
+            this.worker.WorkerReportsProgress = true;
+            this.worker.WorkerSupportsCancellation = true;
+            this.worker.DoWork += Worker_DoWork;
+            this.worker.ProgressChanged += Worker_ProgressChanged;
+            this.worker.RunWorkerCompleted += Worker_RunWorkerCompleted;
         }
 
         private void Worker_DoWork(object? sender, DoWorkEventArgs e)
@@ -219,8 +453,9 @@ namespace ov7675
             BackgroundWorker worker = (BackgroundWorker)sender;
 
             // Stop
-            byte[] stopBuffer = new byte[1] { 50 };
-            port.Write(stopBuffer, 0, 1);
+            commands.Reset();
+            byte[] stopBuffer = new byte[1] { CommandClient.CommandStop };
+            WriteCommand(stopBuffer);
 
             System.Threading.Thread.Sleep(500);
 
@@ -231,130 +466,243 @@ namespace ov7675
             }
 
             // Start and read
-            byte[] startBuffer = new byte[1] { 49 };
-            port.Write(startBuffer, 0, 1);
+            parser.Reset();
+            Clock.Reset();
+            byte[] startBuffer = new byte[1] { CommandClient.CommandStart };
+            WriteCommand(startBuffer);
 
-            Stopwatch sw = new Stopwatch();
-            sw.Start();
+            lock (sync)
+            {
+                cameraCodecChanged = true;
+                cameraMotionChanged = true;
+                radarFormatChanged = true;
+                radarCfarChanged = true;
+                radarBatchChanged = true;
+                radarBlockChanged = true;
+                radarProfileChanged = (radarProfile != null);
+                cameraModeChanged = (cameraMode != null);
+            }
 
-            byte[] headerBuffer = new byte[COM_OVERHEAD];
+            byte[] readBuffer = new byte[READ_BUFFER_SIZE];
+            long lastTimeSyncUs = long.MinValue;
 
             for(; ;)
             {
-                bool doStop = false;
                 lock(sync)
                 {
                     if (stopRequest)
                     {
-                        doStop = true;
                         stopRequest = false;
 
-                        port.Write(stopBuffer, 0, 1);
+                        WriteCommand(stopBuffer);
 
                         port.Close();
                         return;
                     }
-                }
-
-                if (doStop)
-                {
-                    return;
-                }
-
-                // Reader header buffer
-                byte packetCounter = 0;
-                int packetLength = 0;
-                byte crc = 0;
 
-                int retval = readHeader(headerBuffer, out packetCounter, out packetLength, out crc);
-                if (retval != 0)
-                {
-                    System.Diagnostics.Debug.WriteLine(string.Format("readHeader returns {0}", retval));
-
-                    port.Write(stopBuffer, 0, 1);
-                    System.Threading.Thread.Sleep(500);
+                    if (cameraCodecChanged)
+                    {
+                        cameraCodecChanged = false;
+                        byte[] codecBuffer = new byte[3] { COMMAND_CAMERA_CODEC, (byte)cameraCodec, cameraQuality };
+                        WriteCommand(codecBuffer);
+                    }
 
-                    for (; ; )
+                    if (cameraMotionChanged)
                     {
-                        string cnt = port.ReadExisting();
-                        if (cnt.Length == 0) break;
+                        cameraMotionChanged = false;
+                        byte[] motionBuffer = new byte[3] { COMMAND_CAMERA_MOTION, (byte)cameraMotion, cameraMotionThreshold };
+                        WriteCommand(motionBuffer);
                     }
 
-                    port.Write(startBuffer, 0, 1);
+                    if (radarFormatChanged)
+                    {
+                        radarFormatChanged = false;
+                        byte[] formatBuffer = new byte[2] { COMMAND_RADAR_FORMAT, (byte)radarFormat };
+                        WriteCommand(formatBuffer);
+                    }
 
-                    continue;
-                }
+                    if (radarCfarChanged)
+                    {
+                        radarCfarChanged = false;
+                        WriteCommand(radarCfar);
+                    }
 
-                // Allocate memory
-                byte[] packetBuffer = new byte[packetLength];
+                    if (radarBatchChanged)
+                    {
+                        radarBatchChanged = false;
+                        byte[] batchBuffer = new byte[4] { COMMAND_RADAR_BATCH, radarBatchFrames,
+                            (byte)radarBatchDeadlineMs, (byte)(radarBatchDeadlineMs >> 8) };
+                        WriteCommand(batchBuffer);
+                    }
 
-                // Read packet
-                retval = readPacket(packetBuffer);
-                if (retval != 0)
-                {
-                    System.Diagnostics.Debug.WriteLine(string.Format("readPacket returns {0}", retval));
+                    if (radarBlockChanged)
+                    {
+                        radarBlockChanged = false;
+                        WriteCommand(RadarChirps.Encode(radarBlockChirps, radarBlockPackets));
+                    }
 
-                    port.Write(stopBuffer, 0, 1);
-                    System.Threading.Thread.Sleep(500);
+                    if (radarProfileChanged && (radarProfile != null))
+                    {
+                        radarProfileChanged = false;
+                        byte[] profileBuffer = radarProfile.Encode(COMMAND_RADAR_PROFILE);
+                        WriteCommand(profileBuffer);
+                    }
 
-                    for (; ; )
+                    if (cameraModeChanged && (cameraMode != null))
                     {
-                        string cnt = port.ReadExisting();
-                        if (cnt.Length == 0) break;
+                        cameraModeChanged = false;
+                        byte[] modeBuffer = cameraMode.Encode(COMMAND_CAMERA_MODE);
+                        WriteCommand(modeBuffer);
                     }
 
-                    port.Write(startBuffer, 0, 1);
+                    if (statusRequested)
+                    {
+                        statusRequested = false;
+                        byte[] statusBuffer = new byte[1] { CommandClient.CommandStatus };
+                        WriteCommand(statusBuffer);
+                    }
 
-                    continue;
+                    if (traceRequested)
+                    {
+                        traceRequested = false;
+                        WriteCommand(TraceDump.Encode(TraceDump.ActionDump));
+                    }
                 }
 
-                // check CRC
-                byte computedCRC = Crc(packetBuffer, 0, packetLength);
-                if (computedCRC != crc)
+                // Clock synchronization, the reply comes with the data
+                int readBytes = 0;
+                long hostTimeUs = Clock.HostTimeUs;
+                try
                 {
-                    System.Diagnostics.Debug.WriteLine(string.Format("CRC mismatch. Computed {0} but got {1}", computedCRC, crc));
-
-                    port.Write(stopBuffer, 0, 1);
-                    System.Threading.Thread.Sleep(500);
-
-                    for (; ; )
+                    if (hostTimeUs - lastTimeSyncUs >= TIME_SYNC_PERIOD_US)
                     {
-                        string cnt = port.ReadExisting();
-                        if (cnt.Length == 0) break;
+                        lastTimeSyncUs = hostTimeUs;
+                        byte[] request = Clock.CreateRequest();
+                        WriteCommand(request);
                     }
 
-                    port.Write(startBuffer, 0, 1);
-
-                    continue;
+                    // Read whatever is available, the parser reassembles the messages
+                    // and resynchronizes on the next header after an error
+                    readBytes = port.Read(readBuffer, 0, readBuffer.Length);
+                    hostTimeUs = Clock.HostTimeUs;
                 }
-
-                if ((packetLength == 153600) || (packetLength == 614400))
+                catch (TimeoutException)
                 {
-                    // Pic
-                    worker.ReportProgress(WORKER_OV7675_PACKET, packetBuffer);
+                    continue;
                 }
-                else if (packetLength == 4096)
+                catch (Exception)
                 {
-                    worker.ReportProgress(WORKER_RADAR_PACKET, packetBuffer);
+                    port.Close();
+                    return;
                 }
-                else
-                {
-                    System.Diagnostics.Debug.WriteLine(string.Format("other {0}", packetLength));
-
-                    port.Write(stopBuffer, 0, 1);
-                    System.Threading.Thread.Sleep(500);
 
-                    for (; ; )
+                foreach (ProtocolMessage message in parser.Push(readBuffer, 0, readBytes))
+                {
+                    switch (message.Header.Stream)
                     {
-                        string cnt = port.ReadExisting();
-                        if (cnt.Length == 0) break;
+                        case StreamType.Camera:
+                            worker.ReportProgress(WORKER_OV7675_PACKET, message);
+                            break;
+                        case StreamType.Radar:
+                            if (message.Header.Format == PayloadFormat.RadarChirps)
+                            {
+                                // Blocks of chirps: the frame is handled once complete
+                                ProtocolMessage? chirpFrame = radarChirps.Push(message);
+                                if (chirpFrame != null) ReportRadarFrame(worker, chirpFrame);
+                                break;
+                            }
+                            if (message.Header.Format != PayloadFormat.RadarBatch)
+                            {
+                                ReportRadarFrame(worker, message);
+                                break;
+                            }
+                            // The frames of a batch are handled as if they had been sent one by one
+                            List<ProtocolMessage>? frames = RadarBatch.Split(message);
+                            if (frames == null)
+                            {
+                                System.Diagnostics.Debug.WriteLine(string.Format("Invalid radar batch {0}", message.Header.Sequence));
+                                break;
+                            }
+                            foreach (ProtocolMessage frame in frames) ReportRadarFrame(worker, frame);
+                            break;
+                        case StreamType.Control:
+                            if (message.Header.Format == PayloadFormat.RadarProfile)
+                            {
+                                worker.ReportProgress(WORKER_RADAR_PROFILE, message);
+                            }
+                            else if (message.Header.Format == PayloadFormat.CameraMode)
+                            {
+                                worker.ReportProgress(WORKER_CAMERA_MODE, message);
+                            }
+                            else if (message.Header.Format == PayloadFormat.CommandAck)
+                            {
+                                CommandClient.Ack? ack = commands.HandleAck(message, hostTimeUs);
+                                if (ack == null) break;
+                                // The clock synchronization has its own reply
+                                if ((ack.Command != ClockSync.CommandTimeSync) || (ack.Status != CommandClient.StatusOk))
+                                {
+                                    worker.ReportProgress(WORKER_COMMAND_ACK, ack);
+                                }
+                            }
+                            else if (message.Header.Format == PayloadFormat.Trace)
+                            {
+                                TraceDump? dump = TraceDump.Decode(message);
+                                if (dump != null) worker.ReportProgress(WORKER_TRACE, dump);
+                            }
+                            else if (message.Header.Format == PayloadFormat.Telemetry)
+                            {
+                                Telemetry? report = Telemetry.Decode(message);
+                                if (report != null) worker.ReportProgress(WORKER_TELEMETRY, report);
+                            }
+                            else if (Clock.HandleReply(message, hostTimeUs))
+                            {
+                                System.Diagnostics.Debug.WriteLine(string.Format("Clock offset {0} us (round trip {1} us)",
+                                    Clock.OffsetUs, Clock.RoundTripUs));
+                            }
+                            break;
+                        default:
+                            System.Diagnostics.Debug.WriteLine(string.Format("Unknown stream {0}", message.Header.Stream));
+                            break;
                     }
+                }
+            }
+        }
 
-                    port.Write(startBuffer, 0, 1);
+        /// <summary>
+        /// Write a command to the device, framed with a new request id
+        /// </summary>
+        /// <param name="command">Command followed by its parameters</param>
+        private void WriteCommand(byte[] command)
+        {
+            if (port == null) return;
 
-                    continue;
-                }
+            byte[] frame = commands.CreateRequest(command, Clock.HostTimeUs);
+            port.Write(frame, 0, frame.Length);
+        }
+
+        /// <summary>
+        /// Hand a radar frame to the UI thread according to its format
+        /// </summary>
+        private void ReportRadarFrame(BackgroundWorker worker, ProtocolMessage message)
+        {
+            if (RangeProfile.IsRange(message.Header.Format) || (message.Header.Format == PayloadFormat.RangeDopplerU16))
+            {
+                worker.ReportProgress(WORKER_RANGE_PACKET, message);
+                return;
             }
+            if (message.Header.Format == PayloadFormat.Detections)
+            {
+                worker.ReportProgress(WORKER_DETECTIONS_PACKET, message);
+                return;
+            }
+            byte[]? samples = message.Payload;
+            if (message.Header.Format == PayloadFormat.RadarU12)
+            {
+                // Unpacked here, the consumers get 16 bits samples
+                int count = message.Header.Dims[0] * message.Header.Dims[1] * message.Header.Dims[2];
+                samples = Pack12.Unpack(message.Payload, count);
+            }
+            if (samples != null) worker.ReportProgress(WORKER_RADAR_PACKET, new ProtocolMessage(message.Header, samples));
         }
 
         private void Worker_ProgressChanged(object? sender, ProgressChangedEventArgs e)
@@ -364,13 +712,80 @@ namespace ov7675
                 case WORKER_OV7675_PACKET:
                     if (e.UserState != null)
                     {
-                        OnNewOV7675?.Invoke(this, (byte[])e.UserState);
+                        ProtocolMessage message = (ProtocolMessage)e.UserState;
+                        OnNewOV7675?.Invoke(this, message.Payload, message.Header);
                     }
                     break;
                 case WORKER_RADAR_PACKET:
                     if (e.UserState != null)
                     {
-                        OnNewRadarPacket?.Invoke(this, (byte[])e.UserState);
+                        ProtocolMessage message = (ProtocolMessage)e.UserState;
+                        OnNewRadarPacket?.Invoke(this, message.Payload, message.Header);
+                    }
+                    break;
+                case WORKER_RANGE_PACKET:
+                    if (e.UserState != null)
+                    {
+                        ProtocolMessage message = (ProtocolMessage)e.UserState;
+                        if (message.Header.Format == PayloadFormat.RangeDopplerU16)
+                        {
+                            double[,]? map = RangeProfile.DopplerMap(message.Payload, message.Header);
+                            if (map != null) OnNewRangeDopplerMap?.Invoke(this, map, message.Header);
+                            break;
+                        }
+                        double[]? magnitudes = RangeProfile.Magnitudes(message.Payload, message.Header);
+                        if (magnitudes != null) OnNewRangeProfile?.Invoke(this, magnitudes, message.Header);
+                    }
+                    break;
+                case WORKER_DETECTIONS_PACKET:
+                    if (e.UserState != null)
+                    {
+                        ProtocolMessage message = (ProtocolMessage)e.UserState;
+                        Detection[]? detections = Detection.Decode(message.Payload, message.Header);
+                        if (detections != null) OnNewDetections?.Invoke(this, detections, message.Header);
+                    }
+                    break;
+                case WORKER_RADAR_PROFILE:
+                    if (e.UserState != null)
+                    {
+                        ProtocolMessage message = (ProtocolMessage)e.UserState;
+                        int status;
+                        uint switchUs;
+                        if (RadarProfile.DecodeReply(message, out status, out switchUs))
+                        {
+                            OnNewRadarProfile?.Invoke(this, status, switchUs, message.Header);
+                        }
+                    }
+                    break;
+                case WORKER_CAMERA_MODE:
+                    if (e.UserState != null)
+                    {
+                        ProtocolMessage message = (ProtocolMessage)e.UserState;
+                        int status;
+                        uint reconfigureUs;
+                        uint firstFrameUs;
+                        if (CameraMode.DecodeReply(message, out status, out reconfigureUs, out firstFrameUs))
+                        {
+                            OnNewCameraMode?.Invoke(this, status, reconfigureUs, firstFrameUs, message.Header);
+                        }
+                    }
+                    break;
+                case WORKER_COMMAND_ACK:
+                    if (e.UserState != null)
+                    {
+                        OnNewCommandAck?.Invoke(this, (CommandClient.Ack)e.UserState);
+                    }
+                    break;
+                case WORKER_TRACE:
+                    if (e.UserState != null)
+                    {
+                        OnNewTrace?.Invoke(this, (TraceDump)e.UserState);
+                    }
+                    break;
+                case WORKER_TELEMETRY:
+                    if (e.UserState != null)
+                    {
+                        OnNewTelemetry?.Invoke(this, (Telemetry)e.UserState);
                     }
                     break;
             }
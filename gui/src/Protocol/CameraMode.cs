@@ -0,0 +1,74 @@
+﻿using System;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Capture mode of the camera, switched while streaming (see mtb_dvp_camera_ov7675.h of the firmware)
+    /// </summary>
+    public class CameraMode
+    {
+        /// <summary>
+        /// Command switching the capture mode, followed by the resolution, the pixel format and the frame rate
+        /// </summary>
+        public const byte CommandCameraMode = 58;
+
+        public enum Resolution : byte
+        {
+            Qvga = 0,
+            Vga = 1
+        }
+
+        public enum PixelFormat : byte
+        {
+            Rgb565 = 0,
+            Rgb555 = 1
+        }
+
+        public Resolution Size { get; }
+        public PixelFormat Format { get; }
+        public byte Fps { get; }
+
+        /// <summary>
+        /// Mode of the camera when the device starts
+        /// </summary>
+        public static CameraMode Initial { get; } = new CameraMode(Resolution.Qvga, PixelFormat.Rgb565, 5);
+
+        /// <param name="fps">Frame rate: 30, 15 or 5</param>
+        public CameraMode(Resolution size, PixelFormat format, byte fps)
+        {
+            Size = size;
+            Format = format;
+            Fps = fps;
+        }
+
+        /// <summary>
+        /// Command sent to the device: command, resolution, pixel format and frame rate
+        /// </summary>
+        public byte[] Encode(byte command)
+        {
+            return new byte[4] { command, (byte)Size, (byte)Format, Fps };
+        }
+
+        /// <summary>
+        /// Decode the reply of the device (CameraMode message of the control stream)
+        /// </summary>
+        /// <param name="message">Reply, dims: width, height and frame rate of the active mode</param>
+        /// <param name="status">0: success, otherwise the device keeps the previous mode</param>
+        /// <param name="reconfigureUs">Time from the reception of the command until the capture is restarted</param>
+        /// <param name="firstFrameUs">Time from the reception of the command until the first frame of the new mode</param>
+        /// <returns>False if the message is not a reply</returns>
+        public static bool DecodeReply(ProtocolMessage message, out int status, out uint reconfigureUs, out uint firstFrameUs)
+        {
+            status = 0;
+            reconfigureUs = 0;
+            firstFrameUs = 0;
+            if (message.Header.Format != PayloadFormat.CameraMode) return false;
+            if (message.Payload.Length < 12) return false;
+
+            status = BitConverter.ToInt32(message.Payload, 0);
+            reconfigureUs = BitConverter.ToUInt32(message.Payload, 4);
+            firstFrameUs = BitConverter.ToUInt32(message.Payload, 8);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,151 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Estimation of the offset between the clock of the device (timestamps of the messages)
+    /// and the clock of the host
+    /// The host sends a request with a token, the device replies with the time it has read
+    /// the request (TimeSync message of the control stream). The device time is assumed to be
+    /// in the middle of the round trip: the exchange with the shortest round trip of the last
+    /// exchanges is kept (the least delayed by the other USB transfers).
+    /// </summary>
+    public class ClockSync
+    {
+        /// <summary>
+        /// Command of the firmware, followed by the token (uint32, little endian)
+        /// </summary>
+        public const byte CommandTimeSync = 51;
+
+        public const int CommandSize = 5;
+
+        /// <summary>
+        /// Number of exchanges the best one is selected from
+        /// </summary>
+        private const int Window = 8;
+
+        /// <summary>
+        /// Requests without reply are forgotten after this time
+        /// </summary>
+        private const long RequestTimeoutUs = 2000000;
+
+        private class Sample
+        {
+            public long OffsetUs;
+            public long RoundTripUs;
+        }
+
+        private readonly Stopwatch stopwatch = Stopwatch.StartNew();
+
+        /// <summary>
+        /// Host time of the pending requests, per token
+        /// </summary>
+        private readonly Dictionary<uint, long> pending = new Dictionary<uint, long>();
+
+        private readonly Queue<Sample> samples = new Queue<Sample>();
+
+        private uint nextToken = 1;
+
+        /// <summary>
+        /// Device time minus host time (valid if IsSynchronized)
+        /// </summary>
+        public long OffsetUs { get; private set; }
+
+        /// <summary>
+        /// Round trip of the exchange used for the offset, the error of the offset is below half of it
+        /// </summary>
+        public long RoundTripUs { get; private set; }
+
+        public bool IsSynchronized { get; private set; }
+
+        /// <summary>
+        /// Time of the host (microseconds since the creation of this object)
+        /// </summary>
+        public long HostTimeUs
+        {
+            get { return (long)(stopwatch.ElapsedTicks * (1000000.0 / Stopwatch.Frequency)); }
+        }
+
+        /// <summary>
+        /// Forget all exchanges (e.g. the device has been reset)
+        /// </summary>
+        public void Reset()
+        {
+            pending.Clear();
+            samples.Clear();
+            IsSynchronized = false;
+        }
+
+        /// <summary>
+        /// Create a request, to be written to the device right away
+        /// </summary>
+        /// <returns>Command bytes</returns>
+        public byte[] CreateRequest()
+        {
+            long now = HostTimeUs;
+            uint token = nextToken++;
+
+            // Lost replies
+            List<uint> expired = new List<uint>();
+            foreach (KeyValuePair<uint, long> request in pending)
+            {
+                if (now - request.Value > RequestTimeoutUs) expired.Add(request.Key);
+            }
+            foreach (uint key in expired) pending.Remove(key);
+
+            byte[] command = new byte[CommandSize];
+            command[0] = CommandTimeSync;
+            BitConverter.GetBytes(token).CopyTo(command, 1);
+
+            pending[token] = now;
+            return command;
+        }
+
+        /// <summary>
+        /// Handle a reply of the device
+        /// </summary>
+        /// <param name="message">TimeSync message of the control stream</param>
+        /// <param name="hostReceiveUs">Host time the bytes of the message have been read</param>
+        /// <returns>True if the offset has been updated</returns>
+        public bool HandleReply(ProtocolMessage message, long hostReceiveUs)
+        {
+            if (message.Header.Format != PayloadFormat.TimeSync) return false;
+            if (message.Payload.Length < 4) return false;
+
+            uint token = BitConverter.ToUInt32(message.Payload, 0);
+            long hostSendUs;
+            if (!pending.TryGetValue(token, out hostSendUs)) return false;
+            pending.Remove(token);
+
+            Sample sample = new Sample
+            {
+                RoundTripUs = hostReceiveUs - hostSendUs,
+                OffsetUs = (long)message.Header.TimestampUs - (hostSendUs + hostReceiveUs) / 2
+            };
+
+            samples.Enqueue(sample);
+            while (samples.Count > Window) samples.Dequeue();
+
+            Sample best = sample;
+            foreach (Sample s in samples)
+            {
+                if (s.RoundTripUs < best.RoundTripUs) best = s;
+            }
+
+            OffsetUs = best.OffsetUs;
+            RoundTripUs = best.RoundTripUs;
+            IsSynchronized = true;
+            return true;
+        }
+
+        /// <summary>
+        /// Convert a timestamp of the device into the host time base
+        /// </summary>
+        public long DeviceToHostUs(ulong deviceUs)
+        {
+            return (long)deviceUs - OffsetUs;
+        }
+    }
+}
@@ -0,0 +1,195 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Client of the command channel of the firmware (see protocol/command.h)
+    /// Every command is framed: sync bytes, command, flags, request id, size of the parameters,
+    /// parameters and CRC-32. The device acknowledges each command on the control stream
+    /// (CommandAck message) with the request id, the status and the data of the command.
+    /// </summary>
+    public class CommandClient
+    {
+        public const byte Sync0 = 0xA5;
+        public const byte Sync1 = 0x5A;
+
+        public const int HeaderSize = 8;
+        public const int CrcSize = 4;
+        public const int MaxParams = 512;
+        public const int AckSize = 8;
+
+        /// <summary>
+        /// Commands of the firmware without parameters (the others are built by their classes)
+        /// </summary>
+        public const byte CommandStart = 49;
+        public const byte CommandStop = 50;
+        public const byte CommandStatus = 59;
+
+        /// <summary>
+        /// Status of the acknowledgements and of the replies of the commands (COMMAND_STATUS_xxx)
+        /// </summary>
+        public const int StatusOk = 0;
+        public const int StatusUnknown = -1;
+        public const int StatusParam = -2;
+        public const int StatusBusy = -3;
+        public const int StatusInvalid = -4;
+        public const int StatusConfigFailed = -5;
+        public const int StatusDrainTimeout = -6;
+        public const int StatusNoMemory = -7;
+
+        /// <summary>
+        /// Requests without acknowledgement are forgotten after this time
+        /// </summary>
+        private const long RequestTimeoutUs = 2000000;
+
+        /// <summary>
+        /// Acknowledgement of a command
+        /// </summary>
+        public class Ack
+        {
+            public ushort RequestId;
+            public byte Command;
+            public int Status;
+            /// <summary>
+            /// Data of the command (e.g. DeviceStatus), empty for most commands
+            /// </summary>
+            public byte[] Data = Array.Empty<byte>();
+            /// <summary>
+            /// Time from the writing of the command until the reception of the acknowledgement
+            /// </summary>
+            public long RoundTripUs;
+        }
+
+        private class Request
+        {
+            public byte Command;
+            public long SentUs;
+        }
+
+        /// <summary>
+        /// Pending requests, per request id
+        /// </summary>
+        private readonly Dictionary<ushort, Request> pending = new Dictionary<ushort, Request>();
+
+        private ushort nextRequestId = 1;
+
+        /// <summary>
+        /// Requests forgotten without acknowledgement
+        /// </summary>
+        public uint Lost { get; private set; }
+
+        /// <summary>
+        /// Forget the pending requests (e.g. the device has been reset)
+        /// </summary>
+        public void Reset()
+        {
+            pending.Clear();
+            Lost = 0;
+        }
+
+        /// <summary>
+        /// Text of a status of the device
+        /// </summary>
+        /// <param name="status">Status of an acknowledgement or of a reply</param>
+        /// <returns>Description of the status</returns>
+        public static string StatusText(int status)
+        {
+            switch (status)
+            {
+                case StatusOk: return "success";
+                case StatusUnknown: return "unknown command";
+                case StatusParam: return "wrong size of the parameters";
+                case StatusBusy: return "busy";
+                case StatusInvalid: return "parameter out of range";
+                case StatusConfigFailed: return "the sensor cannot be programmed";
+                case StatusDrainTimeout: return "the transfers in flight cannot be completed";
+                case StatusNoMemory: return "not enough memory";
+                default: return string.Format("status {0}", status);
+            }
+        }
+
+        /// <summary>
+        /// Encode a command frame
+        /// </summary>
+        /// <param name="command">Command</param>
+        /// <param name="requestId">Request id, returned in the acknowledgement</param>
+        /// <param name="parameters">Buffer holding the parameters</param>
+        /// <param name="offset">Index of the parameters in the buffer</param>
+        /// <param name="count">Size of the parameters (at most MaxParams)</param>
+        /// <returns>Frame</returns>
+        public static byte[] Encode(byte command, ushort requestId, byte[] parameters, int offset, int count)
+        {
+            if ((count < 0) || (count > MaxParams)) throw new ArgumentOutOfRangeException(nameof(count));
+
+            byte[] frame = new byte[HeaderSize + count + CrcSize];
+            frame[0] = Sync0;
+            frame[1] = Sync1;
+            frame[2] = command;
+            frame[3] = 0;
+            BitConverter.GetBytes(requestId).CopyTo(frame, 4);
+            BitConverter.GetBytes((ushort)count).CopyTo(frame, 6);
+            Array.Copy(parameters, offset, frame, HeaderSize, count);
+            BitConverter.GetBytes(Crc32.Compute(frame, 0, HeaderSize + count)).CopyTo(frame, HeaderSize + count);
+            return frame;
+        }
+
+        /// <summary>
+        /// Create the frame of a command, to be written to the device right away
+        /// </summary>
+        /// <param name="command">Command followed by its parameters (e.g. CameraMode.Encode)</param>
+        /// <param name="hostTimeUs">Time of the host (ClockSync.HostTimeUs)</param>
+        /// <returns>Frame</returns>
+        public byte[] CreateRequest(byte[] command, long hostTimeUs)
+        {
+            // Lost acknowledgements
+            List<ushort> expired = new List<ushort>();
+            foreach (KeyValuePair<ushort, Request> request in pending)
+            {
+                if (hostTimeUs - request.Value.SentUs > RequestTimeoutUs) expired.Add(request.Key);
+            }
+            foreach (ushort key in expired) pending.Remove(key);
+            Lost += (uint)expired.Count;
+
+            ushort requestId = nextRequestId++;
+            if (nextRequestId == 0) nextRequestId = 1;
+
+            pending[requestId] = new Request { Command = command[0], SentUs = hostTimeUs };
+            return Encode(command[0], requestId, command, 1, command.Length - 1);
+        }
+
+        /// <summary>
+        /// Decode an acknowledgement (CommandAck message of the control stream)
+        /// </summary>
+        /// <param name="message">Message of the control stream</param>
+        /// <param name="hostTimeUs">Time the message has been received</param>
+        /// <returns>Acknowledgement, null if the message is not one</returns>
+        public Ack? HandleAck(ProtocolMessage message, long hostTimeUs)
+        {
+            if (message.Header.Format != PayloadFormat.CommandAck) return null;
+            if (message.Payload.Length < AckSize) return null;
+
+            Ack ack = new Ack
+            {
+                RequestId = BitConverter.ToUInt16(message.Payload, 0),
+                Command = message.Payload[2],
+                Status = BitConverter.ToInt32(message.Payload, 4),
+                Data = new byte[message.Payload.Length - AckSize]
+            };
+            Array.Copy(message.Payload, AckSize, ack.Data, 0, ack.Data.Length);
+
+            // Acknowledgement of a request of a previous connection or already forgotten
+            Request? request;
+            if (pending.TryGetValue(ack.RequestId, out request) && (request.Command == ack.Command))
+            {
+                ack.RoundTripUs = hostTimeUs - request.SentUs;
+                pending.Remove(ack.RequestId);
+            }
+            else
+            {
+                ack.RoundTripUs = -1;
+            }
+            return ack;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+﻿using System;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// CRC-32 used by the protocol v2 (IEEE 802.3, reflected polynome 0xEDB88320)
+    /// Slice-by-8 implementation, same result as crc32_compute of crc.c
+    /// </summary>
+    public static class Crc32
+    {
+        public const uint Init = 0;
+
+        private const uint Polynome = 0xEDB88320;
+
+        /// <summary>
+        /// tables[k][b] is the CRC register after the byte b followed by k zero bytes
+        /// </summary>
+        private static readonly uint[][] tables = CreateTables();
+
+        private static uint[][] CreateTables()
+        {
+            uint[][] result = new uint[8][];
+            for (int k = 0; k < 8; ++k) result[k] = new uint[256];
+
+            for (uint i = 0; i < 256; ++i)
+            {
+                uint tmp = i;
+                for (int j = 0; j < 8; ++j)
+                {
+                    tmp = ((tmp & 1) != 0) ? ((tmp >> 1) ^ Polynome) : (tmp >> 1);
+                }
+                result[0][i] = tmp;
+            }
+
+            for (int k = 1; k < 8; ++k)
+            {
+                for (int i = 0; i < 256; ++i)
+                {
+                    uint prev = result[k - 1][i];
+                    result[k][i] = (prev >> 8) ^ result[0][prev & 0xFF];
+                }
+            }
+
+            return result;
+        }
+
+        /// <summary>
+        /// Compute CRC
+        /// </summary>
+        /// <param name="buffer"></param>
+        /// <param name="startIndex">Start index (included)</param>
+        /// <param name="stopIndex">Stop index (excluded)</param>
+        /// <returns></returns>
+        public static uint Compute(byte[] buffer, int startIndex, int stopIndex)
+        {
+            return Update(Init, buffer, startIndex, stopIndex);
+        }
+
+        /// <summary>
+        /// Continue the computation of a CRC with the next part of a buffer
+        /// </summary>
+        /// <param name="crc">CRC of the previous parts (Init for the first part)</param>
+        /// <param name="buffer"></param>
+        /// <param name="startIndex">Start index (included)</param>
+        /// <param name="stopIndex">Stop index (excluded)</param>
+        /// <returns></returns>
+        public static uint Update(uint crc, byte[] buffer, int startIndex, int stopIndex)
+        {
+            uint[] t0 = tables[0], t1 = tables[1], t2 = tables[2], t3 = tables[3];
+            uint[] t4 = tables[4], t5 = tables[5], t6 = tables[6], t7 = tables[7];
+
+            crc = ~crc;
+
+            int i = startIndex;
+            for (; i + 8 <= stopIndex; i += 8)
+            {
+                uint low = crc ^ BitConverter.ToUInt32(buffer, i);
+                uint high = BitConverter.ToUInt32(buffer, i + 4);
+                crc = t7[low & 0xFF] ^ t6[(low >> 8) & 0xFF] ^ t5[(low >> 16) & 0xFF] ^ t4[low >> 24]
+                    ^ t3[high & 0xFF] ^ t2[(high >> 8) & 0xFF] ^ t1[(high >> 16) & 0xFF] ^ t0[high >> 24];
+            }
+
+            for (; i < stopIndex; ++i)
+            {
+                crc = (crc >> 8) ^ t0[(crc ^ buffer[i]) & 0xFF];
+            }
+
+            return ~crc;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+﻿using System;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// State of the device, data of the acknowledgement of CommandClient.CommandStatus
+    /// (see COM_CMD_STATUS of main.c)
+    /// </summary>
+    public class DeviceStatus
+    {
+        public const int Size = 36;
+
+        public bool Streaming;
+        public PayloadFormat RadarFormat;
+        public byte CameraCodec;
+        public byte CameraMotion;
+        public byte RadarBatchFrames;
+        public CameraMode.PixelFormat CameraFormat;
+        public byte CameraFps;
+        public byte CfarSource;
+        public ushort CameraWidth;
+        public ushort CameraHeight;
+        public ushort SamplesPerChirp;
+        public ushort ChirpsPerFrame;
+        public ushort Antennas;
+        public ushort RadarBatchDeadlineMs;
+
+        /// <summary>
+        /// Counters of the command parser of the device
+        /// </summary>
+        public uint Commands;
+        public uint CrcErrors;
+        public uint SizeErrors;
+        public uint SkippedBytes;
+
+        /// <returns>Null if the data is too short</returns>
+        public static DeviceStatus? Decode(byte[] data)
+        {
+            if (data.Length < Size) return null;
+
+            return new DeviceStatus
+            {
+                Streaming = data[0] != 0,
+                RadarFormat = (PayloadFormat)data[1],
+                CameraCodec = data[2],
+                CameraMotion = data[3],
+                RadarBatchFrames = data[4],
+                CameraFormat = (CameraMode.PixelFormat)data[5],
+                CameraFps = data[6],
+                CfarSource = data[7],
+                CameraWidth = BitConverter.ToUInt16(data, 8),
+                CameraHeight = BitConverter.ToUInt16(data, 10),
+                SamplesPerChirp = BitConverter.ToUInt16(data, 12),
+                ChirpsPerFrame = BitConverter.ToUInt16(data, 14),
+                Antennas = BitConverter.ToUInt16(data, 16),
+                RadarBatchDeadlineMs = BitConverter.ToUInt16(data, 18),
+                Commands = BitConverter.ToUInt32(data, 20),
+                CrcErrors = BitConverter.ToUInt32(data, 24),
+                SizeErrors = BitConverter.ToUInt32(data, 28),
+                SkippedBytes = BitConverter.ToUInt32(data, 32)
+            };
+        }
+
+        public override string ToString()
+        {
+            return string.Format("Streaming: {0}\r\n"
+                + "Camera: {1}x{2} {3} {4} fps, codec {5}, motion {6}\r\n"
+                + "Radar: {7} samples x {8} chirps x {9} antennas, format {10}, batch {11} frames ({12} ms), CFAR input {13}\r\n"
+                + "Commands: {14} received, {15} CRC errors, {16} size errors, {17} bytes skipped",
+                Streaming, CameraWidth, CameraHeight, CameraFormat, CameraFps, CameraCodec, CameraMotion,
+                SamplesPerChirp, ChirpsPerFrame, Antennas, RadarFormat, RadarBatchFrames, RadarBatchDeadlineMs, CfarSource,
+                Commands, CrcErrors, SizeErrors, SkippedBytes);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+﻿using System;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Stream of a packet
+    /// </summary>
+    public enum StreamType : byte
+    {
+        Radar = 1,
+        Camera = 2,
+        Control = 3
+    }
+
+    /// <summary>
+    /// Format of the payload
+    /// </summary>
+    public enum PayloadFormat : byte
+    {
+        Raw = 0,
+        Rgb565 = 1,
+        RadarU16 = 2,
+        TimeSync = 3,
+        Jpeg = 4,
+        Rgb565Lossless = 5,
+        Rgb565Tiles = 6,
+        RadarU12 = 7,
+        RangeMagU16 = 8,
+        RangeMagF32 = 9,
+        RangeComplexI16 = 10,
+        RangeComplexF32 = 11,
+        RangeDopplerU16 = 12,
+        Detections = 13,
+        RadarBatch = 14,
+        RadarProfile = 15,
+        CameraMode = 16,
+        Rgb555 = 17,
+        CommandAck = 18,
+        Telemetry = 19,
+        Trace = 20,
+        RadarChirps = 21
+    }
+
+    /// <summary>
+    /// Header of the protocol v2 (see protocol.h of the firmware for the layout)
+    /// </summary>
+    public class ProtocolHeader
+    {
+        public const byte Sync0 = 0x55;
+        public const byte Sync1 = 0xAA;
+        public const byte Version = 2;
+        public const int Size = 48;
+
+        public const ushort FlagFragment = 0x0001;
+        public const ushort FlagMoreFragments = 0x0002;
+
+        private const int HeaderCrcOffset = 44;
+
+        /// <summary>
+        /// Result of the decoding
+        /// </summary>
+        public enum DecodeResult
+        {
+            Ok = 0,
+            Size = -1,
+            Sync = -2,
+            Version = -3,
+            HeaderCrc = -4,
+            Fragment = -5
+        }
+
+        public StreamType Stream { get; set; }
+        public PayloadFormat Format { get; set; }
+        public ushort Flags { get; set; }
+        public uint Sequence { get; set; }
+        public uint PayloadSize { get; set; }
+        public ulong TimestampUs { get; set; }
+        public uint MessageSize { get; set; }
+        public uint FragmentOffset { get; set; }
+
+        /// <summary>
+        /// Width, height, 1 (Rgb565), samples per chirp, chirps, antennas (RadarU16, RadarU12)
+        /// range bins, chirps, antennas (RangeXxx), Doppler bins, range bins, antennas (RangeDopplerU16)
+        /// detections, range bins, Doppler bins (Detections), frames (RadarBatch)
+        /// or samples per chirp, chirps, antennas after the switch (RadarProfile)
+        /// </summary>
+        public ushort[] Dims { get; } = new ushort[3];
+
+        /// <summary>
+        /// CPU cycles per pixel (sample) spent compressing (processing) the data (8.8 fixed point, 0 if not measured)
+        /// </summary>
+        public ushort EncodeCost { get; set; }
+
+        public uint MessageCrc { get; set; }
+
+        public bool IsFragment => (Flags & FlagFragment) != 0;
+        public bool HasMoreFragments => (Flags & FlagMoreFragments) != 0;
+
+        /// <summary>
+        /// Decode and check a header
+        /// </summary>
+        /// <param name="buffer"></param>
+        /// <param name="offset">Start of the header inside the buffer</param>
+        /// <param name="count">Number of bytes available from offset</param>
+        /// <param name="header">Decoded header (only valid if Ok is returned)</param>
+        /// <returns></returns>
+        public static DecodeResult Decode(byte[] buffer, int offset, int count, out ProtocolHeader header)
+        {
+            header = new ProtocolHeader();
+
+            if (count < Size) return DecodeResult.Size;
+            if ((buffer[offset] != Sync0) || (buffer[offset + 1] != Sync1)) return DecodeResult.Sync;
+            if ((buffer[offset + 2] != Version) || (buffer[offset + 3] != Size)) return DecodeResult.Version;
+
+            uint headerCrc = BitConverter.ToUInt32(buffer, offset + HeaderCrcOffset);
+            if (headerCrc != Crc32.Compute(buffer, offset, offset + HeaderCrcOffset)) return DecodeResult.HeaderCrc;
+
+            header.Stream = (StreamType)buffer[offset + 4];
+            header.Format = (PayloadFormat)buffer[offset + 5];
+            header.Flags = BitConverter.ToUInt16(buffer, offset + 6);
+            header.Sequence = BitConverter.ToUInt32(buffer, offset + 8);
+            header.PayloadSize = BitConverter.ToUInt32(buffer, offset + 12);
+            header.TimestampUs = BitConverter.ToUInt64(buffer, offset + 16);
+            header.MessageSize = BitConverter.ToUInt32(buffer, offset + 24);
+            header.FragmentOffset = BitConverter.ToUInt32(buffer, offset + 28);
+            header.Dims[0] = BitConverter.ToUInt16(buffer, offset + 32);
+            header.Dims[1] = BitConverter.ToUInt16(buffer, offset + 34);
+            header.Dims[2] = BitConverter.ToUInt16(buffer, offset + 36);
+            header.EncodeCost = BitConverter.ToUInt16(buffer, offset + 38);
+            header.MessageCrc = BitConverter.ToUInt32(buffer, offset + 40);
+
+            if ((header.PayloadSize > header.MessageSize)
+                || (header.FragmentOffset > header.MessageSize - header.PayloadSize))
+            {
+                return DecodeResult.Fragment;
+            }
+
+            return DecodeResult.Ok;
+        }
+    }
+}
@@ -0,0 +1,207 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Message received: header of the last packet and whole payload (fragments reassembled)
+    /// </summary>
+    public class ProtocolMessage
+    {
+        public ProtocolHeader Header { get; }
+        public byte[] Payload { get; }
+
+        public ProtocolMessage(ProtocolHeader header, byte[] payload)
+        {
+            Header = header;
+            Payload = payload;
+        }
+    }
+
+    /// <summary>
+    /// Reference parser of the protocol v2
+    /// The received bytes are pushed in any chunking, complete and valid messages are returned.
+    /// After an error the parser resynchronizes on the next valid header.
+    /// </summary>
+    public class ProtocolParser
+    {
+        /// <summary>
+        /// Larger messages are rejected (protects against corrupted sizes)
+        /// </summary>
+        public const uint MaxMessageSize = 16 * 1024 * 1024;
+
+        /// <summary>
+        /// Message being reassembled
+        /// </summary>
+        private class Assembly
+        {
+            public uint Sequence;
+            public uint Received;
+            public byte[] Buffer = Array.Empty<byte>();
+        }
+
+        private readonly byte[] header = new byte[ProtocolHeader.Size];
+        private int headerCount = 0;
+
+        private ProtocolHeader? current;
+        private byte[] payload = Array.Empty<byte>();
+        private int payloadCount = 0;
+
+        private readonly Dictionary<StreamType, Assembly> assemblies = new Dictionary<StreamType, Assembly>();
+        private readonly Dictionary<StreamType, uint> lastSequences = new Dictionary<StreamType, uint>();
+
+        /// <summary>
+        /// Bytes skipped to find a header
+        /// </summary>
+        public long BytesSkipped { get; private set; }
+
+        /// <summary>
+        /// Headers rejected (version, header CRC, fragment)
+        /// </summary>
+        public long HeaderErrors { get; private set; }
+
+        /// <summary>
+        /// Messages rejected: CRC of the payload or missing fragment
+        /// </summary>
+        public long MessageErrors { get; private set; }
+
+        /// <summary>
+        /// Messages missing according to the sequence numbers
+        /// </summary>
+        public long SequenceGaps { get; private set; }
+
+        /// <summary>
+        /// Forget the partial data (e.g. after the stream has been restarted)
+        /// </summary>
+        public void Reset()
+        {
+            headerCount = 0;
+            current = null;
+            payloadCount = 0;
+            assemblies.Clear();
+            lastSequences.Clear();
+        }
+
+        /// <summary>
+        /// Push received bytes
+        /// </summary>
+        /// <param name="buffer"></param>
+        /// <param name="offset"></param>
+        /// <param name="count"></param>
+        /// <returns>Messages completed by these bytes</returns>
+        public List<ProtocolMessage> Push(byte[] buffer, int offset, int count)
+        {
+            List<ProtocolMessage> messages = new List<ProtocolMessage>();
+
+            while (count > 0)
+            {
+                if (current == null)
+                {
+                    int n = Math.Min(count, ProtocolHeader.Size - headerCount);
+                    Array.Copy(buffer, offset, header, headerCount, n);
+                    headerCount += n;
+                    offset += n;
+                    count -= n;
+
+                    if (headerCount == ProtocolHeader.Size) OnHeader(messages);
+                }
+                else
+                {
+                    int n = Math.Min(count, payload.Length - payloadCount);
+                    Array.Copy(buffer, offset, payload, payloadCount, n);
+                    payloadCount += n;
+                    offset += n;
+                    count -= n;
+
+                    if (payloadCount == payload.Length) OnPayload(messages);
+                }
+            }
+
+            return messages;
+        }
+
+        private void OnHeader(List<ProtocolMessage> messages)
+        {
+            ProtocolHeader.DecodeResult result = ProtocolHeader.Decode(header, 0, headerCount, out ProtocolHeader decoded);
+            if ((result == ProtocolHeader.DecodeResult.Ok) && (decoded.MessageSize <= MaxMessageSize))
+            {
+                current = decoded;
+                payload = new byte[decoded.PayloadSize];
+                payloadCount = 0;
+                headerCount = 0;
+
+                if (payload.Length == 0) OnPayload(messages);
+                return;
+            }
+
+            if (result != ProtocolHeader.DecodeResult.Sync) HeaderErrors++;
+
+            // Resynchronize: keep the bytes from the next possible sync
+            int next = 1;
+            while ((next < headerCount) && (header[next] != ProtocolHeader.Sync0)) next++;
+            BytesSkipped += next;
+            Array.Copy(header, next, header, 0, headerCount - next);
+            headerCount -= next;
+        }
+
+        private void OnPayload(List<ProtocolMessage> messages)
+        {
+            ProtocolHeader h = current!;
+            current = null;
+
+            if (!h.IsFragment)
+            {
+                Complete(messages, h, payload);
+                return;
+            }
+
+            // Fragment: copy at its offset, the message is complete with the last fragment
+            Assembly? assembly;
+            if (h.FragmentOffset == 0)
+            {
+                assembly = new Assembly { Sequence = h.Sequence, Buffer = new byte[h.MessageSize] };
+                assemblies[h.Stream] = assembly;
+            }
+            else if (!assemblies.TryGetValue(h.Stream, out assembly)
+                || (assembly.Sequence != h.Sequence) || (assembly.Received != h.FragmentOffset)
+                || (assembly.Buffer.Length != h.MessageSize))
+            {
+                // First fragment(s) lost
+                assemblies.Remove(h.Stream);
+                MessageErrors++;
+                return;
+            }
+
+            Array.Copy(payload, 0, assembly.Buffer, h.FragmentOffset, payload.Length);
+            assembly.Received += (uint)payload.Length;
+
+            if (!h.HasMoreFragments)
+            {
+                assemblies.Remove(h.Stream);
+                if (assembly.Received != h.MessageSize)
+                {
+                    MessageErrors++;
+                    return;
+                }
+                Complete(messages, h, assembly.Buffer);
+            }
+        }
+
+        private void Complete(List<ProtocolMessage> messages, ProtocolHeader h, byte[] data)
+        {
+            if (Crc32.Compute(data, 0, data.Length) != h.MessageCrc)
+            {
+                MessageErrors++;
+                return;
+            }
+
+            if (lastSequences.TryGetValue(h.Stream, out uint last) && (h.Sequence > last + 1))
+            {
+                SequenceGaps += (uint)(h.Sequence - last - 1);
+            }
+            lastSequences[h.Stream] = h.Sequence;
+
+            messages.Add(new ProtocolMessage(h, data));
+        }
+    }
+}
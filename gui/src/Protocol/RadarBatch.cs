@@ -0,0 +1,57 @@
+﻿using System;
+using System.Collections.Generic;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Radar frames gathered in one message (RadarBatch, see protocol.h of the firmware)
+    /// Each frame is a header of EntrySize bytes followed by its payload
+    /// </summary>
+    public static class RadarBatch
+    {
+        /// <summary>
+        /// Size of the header of a frame
+        /// </summary>
+        public const int EntrySize = 20;
+
+        /// <summary>
+        /// Split a batch into its frames
+        /// </summary>
+        /// <param name="message">Batch (dims: frames)</param>
+        /// <returns>Frames with the stream and the sequence number of the batch and their own format,
+        /// dimensions, encode cost and capture timestamp, null if a frame is outside of the message</returns>
+        public static List<ProtocolMessage>? Split(ProtocolMessage message)
+        {
+            List<ProtocolMessage> frames = new List<ProtocolMessage>(message.Header.Dims[0]);
+            byte[] data = message.Payload;
+            int offset = 0;
+
+            for (int i = 0; i < message.Header.Dims[0]; ++i)
+            {
+                if (data.Length - offset < EntrySize) return null;
+
+                uint size = BitConverter.ToUInt32(data, offset);
+                if (size > (uint)(data.Length - offset - EntrySize)) return null;
+
+                ProtocolHeader header = new ProtocolHeader
+                {
+                    Stream = message.Header.Stream,
+                    Format = (PayloadFormat)data[offset + 16],
+                    Sequence = message.Header.Sequence,
+                    PayloadSize = size,
+                    TimestampUs = message.Header.TimestampUs + BitConverter.ToUInt32(data, offset + 4),
+                    MessageSize = size,
+                    EncodeCost = BitConverter.ToUInt16(data, offset + 14),
+                };
+                header.Dims[0] = BitConverter.ToUInt16(data, offset + 8);
+                header.Dims[1] = BitConverter.ToUInt16(data, offset + 10);
+                header.Dims[2] = BitConverter.ToUInt16(data, offset + 12);
+
+                frames.Add(new ProtocolMessage(header, data.AsSpan(offset + EntrySize, (int)size).ToArray()));
+                offset += EntrySize + (int)size;
+            }
+
+            return frames;
+        }
+    }
+}
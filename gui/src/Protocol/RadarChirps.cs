@@ -0,0 +1,105 @@
+﻿using System;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Blocks of chirps of the radar frames (RadarChirps, see protocol.h of the firmware), sent as soon as
+    /// they are read from the FIFO of the radar, put back together into RadarU16 frames
+    /// Each block is a header of HeaderSize bytes (frame number, first chirp, chirps per frame)
+    /// followed by its samples
+    /// </summary>
+    public class RadarChirps
+    {
+        /// <summary>
+        /// Blocks of the radar: 2 bytes chirps per block (0: whole frames), 1 byte per-chirp packets
+        /// </summary>
+        public const byte CommandBlock = 62;
+
+        /// <summary>
+        /// Size of the header of a block
+        /// </summary>
+        public const int HeaderSize = 8;
+
+        /// <summary>
+        /// Frame being put together and chirps received so far
+        /// </summary>
+        private uint frameNumber = 0;
+        private byte[]? frameSamples = null;
+        private int frameChirps = 0;
+
+        /// <summary>
+        /// Frames dropped because of a missing block
+        /// </summary>
+        public uint DroppedFrames { get; private set; } = 0;
+
+        /// <summary>
+        /// Encode the command setting the blocks of the radar
+        /// </summary>
+        /// <param name="chirps">Chirps per block (dividing the chirps of a frame), 0: whole frames</param>
+        /// <param name="packets">Each block sent as soon as read (true) or put together into frames by the device</param>
+        public static byte[] Encode(ushort chirps, bool packets)
+        {
+            return new byte[4] { CommandBlock, (byte)chirps, (byte)(chirps >> 8), (byte)(packets ? 1 : 0) };
+        }
+
+        /// <summary>
+        /// Add a block to the frame being put together
+        /// </summary>
+        /// <param name="message">Block (dims: samples per chirp, chirps of the block, antennas)</param>
+        /// <returns>Frame (RadarU16, frame number as sequence number, capture timestamp of its last block)
+        /// once its last block is in, null otherwise; a frame missing a block is dropped</returns>
+        public ProtocolMessage? Push(ProtocolMessage message)
+        {
+            byte[] data = message.Payload;
+            int samplesPerChirp = message.Header.Dims[0];
+            int chirps = message.Header.Dims[1];
+            int antennas = message.Header.Dims[2];
+            int chirpSize = 2 * samplesPerChirp * antennas;
+
+            if (data.Length < HeaderSize) return null;
+
+            uint number = BitConverter.ToUInt32(data, 0);
+            int firstChirp = BitConverter.ToUInt16(data, 4);
+            int chirpsPerFrame = BitConverter.ToUInt16(data, 6);
+            if ((chirps == 0) || (chirpSize == 0) || (firstChirp + chirps > chirpsPerFrame)
+                || (data.Length - HeaderSize != chirps * chirpSize)) return null;
+
+            // First block: the frame not complete yet is lost
+            if (firstChirp == 0)
+            {
+                if (frameSamples != null) DroppedFrames++;
+                frameNumber = number;
+                frameSamples = new byte[chirpsPerFrame * chirpSize];
+                frameChirps = 0;
+            }
+            if ((frameSamples == null) || (number != frameNumber) || (firstChirp != frameChirps)
+                || (frameSamples.Length != chirpsPerFrame * chirpSize))
+            {
+                if (frameSamples != null) DroppedFrames++;
+                frameSamples = null;
+                return null;
+            }
+
+            Buffer.BlockCopy(data, HeaderSize, frameSamples, firstChirp * chirpSize, chirps * chirpSize);
+            frameChirps += chirps;
+            if (frameChirps < chirpsPerFrame) return null;
+
+            ProtocolHeader header = new ProtocolHeader
+            {
+                Stream = message.Header.Stream,
+                Format = PayloadFormat.RadarU16,
+                Sequence = number,
+                PayloadSize = (uint)frameSamples.Length,
+                TimestampUs = message.Header.TimestampUs,
+                MessageSize = (uint)frameSamples.Length,
+            };
+            header.Dims[0] = (ushort)samplesPerChirp;
+            header.Dims[1] = (ushort)chirpsPerFrame;
+            header.Dims[2] = (ushort)antennas;
+
+            ProtocolMessage frame = new ProtocolMessage(header, frameSamples);
+            frameSamples = null;
+            return frame;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.Text.RegularExpressions;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Register profile of the radar, uploaded to the device while streaming (see radar.h of the firmware)
+    /// </summary>
+    public class RadarProfile
+    {
+        /// <summary>
+        /// Maximum number of registers of a profile (RADAR_MAX_REGISTERS of the firmware)
+        /// </summary>
+        public const int MaxRegisters = 64;
+
+        public ushort SamplesPerChirp { get; }
+        public ushort ChirpsPerFrame { get; }
+        public byte Antennas { get; }
+
+        /// <summary>
+        /// Register values (address and data), empty: profile compiled in the firmware
+        /// </summary>
+        public uint[] Registers { get; }
+
+        /// <summary>
+        /// Profile compiled in the firmware (radar_settings.h)
+        /// </summary>
+        public static RadarProfile Compiled { get; } = new RadarProfile(0, 0, 0, Array.Empty<uint>());
+
+        public RadarProfile(ushort samplesPerChirp, ushort chirpsPerFrame, byte antennas, uint[] registers)
+        {
+            if (registers.Length > MaxRegisters) throw new ArgumentException("Too many registers", nameof(registers));
+
+            SamplesPerChirp = samplesPerChirp;
+            ChirpsPerFrame = chirpsPerFrame;
+            Antennas = antennas;
+            Registers = registers;
+        }
+
+        /// <summary>
+        /// Read a profile exported by the Radar Fusion GUI (same format as radar_settings.h)
+        /// </summary>
+        /// <param name="text">Content of the header file</param>
+        /// <returns>Profile, null if the shape or the registers are missing</returns>
+        public static RadarProfile? Parse(string text)
+        {
+            int samples = Define(text, "NUM_SAMPLES_PER_CHIRP");
+            int chirps = Define(text, "NUM_CHIRPS_PER_FRAME");
+            int antennas = Define(text, "NUM_RX_ANTENNAS");
+            if (samples <= 0 || samples > ushort.MaxValue || chirps <= 0 || chirps > ushort.MaxValue
+                || antennas <= 0 || antennas > byte.MaxValue) return null;
+
+            Match list = Regex.Match(text, @"register_list\s*\[\s*\]\s*=\s*\{([^}]*)\}");
+            if (!list.Success) return null;
+
+            List<uint> registers = new List<uint>();
+            foreach (Match value in Regex.Matches(list.Groups[1].Value, @"0[xX]([0-9a-fA-F]+)[uUlL]*"))
+            {
+                registers.Add(uint.Parse(value.Groups[1].Value, NumberStyles.HexNumber, CultureInfo.InvariantCulture));
+            }
+            if (registers.Count == 0 || registers.Count > MaxRegisters) return null;
+
+            return new RadarProfile((ushort)samples, (ushort)chirps, (byte)antennas, registers.ToArray());
+        }
+
+        /// <summary>
+        /// Command of the device selecting this profile
+        /// </summary>
+        /// <param name="command">Command code</param>
+        public byte[] Encode(byte command)
+        {
+            byte[] buffer = new byte[7 + 4 * Registers.Length];
+
+            buffer[0] = command;
+            BitConverter.TryWriteBytes(buffer.AsSpan(1), SamplesPerChirp);
+            BitConverter.TryWriteBytes(buffer.AsSpan(3), ChirpsPerFrame);
+            buffer[5] = Antennas;
+            buffer[6] = (byte)Registers.Length;
+            for (int i = 0; i < Registers.Length; ++i)
+            {
+                BitConverter.TryWriteBytes(buffer.AsSpan(7 + 4 * i), Registers[i]);
+            }
+
+            return buffer;
+        }
+
+        /// <summary>
+        /// Decode the reply of the device (RadarProfile message of the control stream)
+        /// </summary>
+        /// <param name="message">Reply, dims: shape of the radar frames after the switch</param>
+        /// <param name="status">0: success, otherwise the device runs the compiled profile
+        /// (or the previous one if its radar transfers could not be drained)</param>
+        /// <param name="switchUs">Time from the reception of the profile until the radar is restarted</param>
+        /// <returns>False if the message is not a reply</returns>
+        public static bool DecodeReply(ProtocolMessage message, out int status, out uint switchUs)
+        {
+            status = 0;
+            switchUs = 0;
+            if (message.Header.Format != PayloadFormat.RadarProfile) return false;
+            if (message.Payload.Length < 8) return false;
+
+            status = BitConverter.ToInt32(message.Payload, 0);
+            switchUs = BitConverter.ToUInt32(message.Payload, 4);
+            return true;
+        }
+
+        private static int Define(string text, string name)
+        {
+            Match match = Regex.Match(text, @"#define\s+XENSIV_BGT60TRXX_CONF_" + name + @"\s+\(?\s*(\d+)\s*\)?");
+            if (!match.Success) return -1;
+
+            int value;
+            return int.TryParse(match.Groups[1].Value, NumberStyles.Integer, CultureInfo.InvariantCulture, out value) ? value : -1;
+        }
+    }
+}
@@ -0,0 +1,129 @@
+﻿using System;
+using System.Text;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Statistics of the device (Telemetry message of the control stream, see telemetry.h of the firmware),
+    /// counted since the device started
+    /// </summary>
+    public class Telemetry
+    {
+        /// <summary>
+        /// Period of the statistics while streaming: 2 bytes (ms, 0: not sent)
+        /// </summary>
+        public const byte CommandTelemetry = 60;
+
+        public static readonly string[] Streams = { "Camera", "Radar" };
+        public static readonly string[] Counters = { "captured", "sent", "skipped", "dropped ring", "dropped CRC late",
+            "dropped lines", "dropped overrun", "dropped FIFO", "dropped idle", "dropped USB" };
+        public static readonly string[] Histograms = { "USB transfers", "Camera messages", "Radar messages", "Camera CRC",
+            "Radar readout", "Radar readout CPU", "CM33 CRC" };
+
+        public class Histogram
+        {
+            public uint Count;
+            public uint Max;
+            /// <summary>
+            /// Bucket 0: 0 us, bucket b: [2^(b-1), 2^b[ us, the last one holds the larger values
+            /// </summary>
+            public uint[] Buckets = Array.Empty<uint>();
+
+            /// <returns>Upper bound (us) of the bucket holding the given percentage of the values</returns>
+            public uint Percentile(uint percent)
+            {
+                if (Count == 0) return 0;
+                ulong target = ((ulong)Count * percent + 99) / 100;
+                ulong sum = 0;
+                for (int b = 0; b < Buckets.Length; b++)
+                {
+                    sum += Buckets[b];
+                    if (sum >= target)
+                    {
+                        if (b == 0) return 0;
+                        return (b == Buckets.Length - 1) ? Max : Math.Min((1u << b) - 1, Max);
+                    }
+                }
+                return Max;
+            }
+        }
+
+        /// <summary>
+        /// Counters per stream (Streams), in the order of Counters
+        /// </summary>
+        public uint[][] StreamCounters = Array.Empty<uint[]>();
+        public Histogram[] Latencies = Array.Empty<Histogram>();
+        public ProtocolHeader? Header;
+
+        public static byte[] EncodePeriod(ushort periodMs)
+        {
+            return new byte[3] { CommandTelemetry, (byte)periodMs, (byte)(periodMs >> 8) };
+        }
+
+        /// <returns>Null if the message is not a valid report</returns>
+        public static Telemetry? Decode(ProtocolMessage message)
+        {
+            if (message.Header.Format != PayloadFormat.Telemetry) return null;
+
+            int counters = message.Header.Dims[0];
+            int histograms = message.Header.Dims[1];
+            int buckets = message.Header.Dims[2];
+            int size = 4 * ((Streams.Length * counters) + (histograms * (2 + buckets)));
+            if (message.Payload.Length < size) return null;
+
+            Telemetry report = new Telemetry { Header = message.Header };
+            int offset = 0;
+            report.StreamCounters = new uint[Streams.Length][];
+            for (int s = 0; s < Streams.Length; s++)
+            {
+                report.StreamCounters[s] = new uint[counters];
+                for (int c = 0; c < counters; c++, offset += 4)
+                {
+                    report.StreamCounters[s][c] = BitConverter.ToUInt32(message.Payload, offset);
+                }
+            }
+            report.Latencies = new Histogram[histograms];
+            for (int h = 0; h < histograms; h++)
+            {
+                Histogram histogram = new Histogram
+                {
+                    Count = BitConverter.ToUInt32(message.Payload, offset),
+                    Max = BitConverter.ToUInt32(message.Payload, offset + 4),
+                    Buckets = new uint[buckets]
+                };
+                offset += 8;
+                for (int b = 0; b < buckets; b++, offset += 4)
+                {
+                    histogram.Buckets[b] = BitConverter.ToUInt32(message.Payload, offset);
+                }
+                report.Latencies[h] = histogram;
+            }
+            return report;
+        }
+
+        public override string ToString()
+        {
+            StringBuilder text = new StringBuilder();
+            for (int s = 0; s < StreamCounters.Length; s++)
+            {
+                text.Append(Streams[s]).Append(':');
+                for (int c = 0; c < StreamCounters[s].Length; c++)
+                {
+                    // Counters that do not apply to the stream stay at 0
+                    if (StreamCounters[s][c] == 0 && c > 1) continue;
+                    string name = (c < Counters.Length) ? Counters[c] : string.Format("counter {0}", c);
+                    text.AppendFormat(" {0} {1},", StreamCounters[s][c], name);
+                }
+                text.Length--;
+                text.Append("\r\n");
+            }
+            for (int h = 0; h < Latencies.Length; h++)
+            {
+                string name = (h < Histograms.Length) ? Histograms[h] : string.Format("histogram {0}", h);
+                text.AppendFormat("{0}: {1}, median <= {2} us, 99% <= {3} us, max {4} us\r\n", name,
+                    Latencies[h].Count, Latencies[h].Percentile(50), Latencies[h].Percentile(99), Latencies[h].Max);
+            }
+            return text.ToString().TrimEnd();
+        }
+    }
+}
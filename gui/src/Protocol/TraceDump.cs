@@ -0,0 +1,215 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.Linq;
+using System.Text;
+
+namespace ov7675.Protocol
+{
+    /// <summary>
+    /// Events of the profiling probes of the device (Trace message of the control stream, see trace.h
+    /// of the firmware): converted to the latency distribution of each stage and to a timeline in the
+    /// Chrome trace event format (JSON, opened by Perfetto or chrome://tracing)
+    /// The firmware must be built with TRACE_ENABLED=1, otherwise the command is unknown
+    /// </summary>
+    public class TraceDump
+    {
+        /// <summary>
+        /// Probes: 1 byte action (0 stop, 1 clear and start, 2 dump)
+        /// </summary>
+        public const byte CommandTrace = 61;
+        public const byte ActionStop = 0;
+        public const byte ActionStart = 1;
+        public const byte ActionDump = 2;
+
+        private const int HeaderSize = 16;
+        private const int EventSize = 8;
+
+        /// <summary>
+        /// Stages in the order of trace_stage_t, and the timeline row of each
+        /// (the interrupts and the USB transfers overlap the main loop)
+        /// </summary>
+        public static readonly string[] Stages = { "Scheduler", "Commands", "Camera frame", "Camera motion", "Camera copy",
+            "Camera encode", "CRC", "Submit", "Radar read", "Radar process", "USB transfer", "VSYNC interrupt",
+            "Camera CRC interrupt", "Radar interrupt" };
+        private static readonly int[] StageThreads = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 3, 4, 5 };
+        private static readonly string[] ThreadNames = { "", "Main loop", "USB", "Camera interrupt", "Camera deferred", "Radar interrupt" };
+
+        public enum EventType : byte
+        {
+            Begin = 0,
+            End = 1,
+            Mark = 2
+        }
+
+        public class Event
+        {
+            /// <summary>
+            /// Device time (timestamp_now_us)
+            /// </summary>
+            public double TimeUs;
+            public byte Stage;
+            public EventType Type;
+            public ushort Arg;
+        }
+
+        public class StageStats
+        {
+            public string Name = "";
+            /// <summary>
+            /// Durations of the begin/end pairs, sorted
+            /// </summary>
+            public List<double> DurationsUs = new List<double>();
+
+            public double Percentile(double percent)
+            {
+                if (DurationsUs.Count == 0) return 0;
+                int index = (int)Math.Ceiling(DurationsUs.Count * percent / 100.0) - 1;
+                return DurationsUs[Math.Clamp(index, 0, DurationsUs.Count - 1)];
+            }
+        }
+
+        public List<Event> Events = new List<Event>();
+        public uint CyclesPerUs;
+        /// <summary>
+        /// Events recorded since the start of the recording (the older ones have been overwritten)
+        /// </summary>
+        public uint Recorded;
+
+        public static byte[] Encode(byte action)
+        {
+            return new byte[2] { CommandTrace, action };
+        }
+
+        /// <returns>Null if the message is not a valid dump</returns>
+        public static TraceDump? Decode(ProtocolMessage message)
+        {
+            if (message.Header.Format != PayloadFormat.Trace) return null;
+            if (message.Payload.Length < HeaderSize) return null;
+
+            byte[] data = message.Payload;
+            uint cyclesPerUs = BitConverter.ToUInt32(data, 0);
+            uint dumpCycles = BitConverter.ToUInt32(data, 4);
+            uint count = BitConverter.ToUInt32(data, 12);
+            if ((cyclesPerUs == 0) || (data.Length < HeaderSize + (long)count * EventSize)) return null;
+
+            TraceDump dump = new TraceDump { CyclesPerUs = cyclesPerUs, Recorded = BitConverter.ToUInt32(data, 8) };
+
+            // The cycle counter wraps around (32 bits): extended with the differences between
+            // consecutive events, then placed before the timestamp of the message
+            ulong[] cycles = new ulong[count];
+            ulong total = 0;
+            uint previous = (count > 0) ? BitConverter.ToUInt32(data, HeaderSize) : dumpCycles;
+            for (int i = 0; i < count; i++)
+            {
+                uint current = BitConverter.ToUInt32(data, HeaderSize + i * EventSize);
+                total += current - previous;
+                previous = current;
+                cycles[i] = total;
+            }
+            total += dumpCycles - previous;
+
+            for (int i = 0; i < count; i++)
+            {
+                uint info = BitConverter.ToUInt32(data, HeaderSize + i * EventSize + 4);
+                dump.Events.Add(new Event
+                {
+                    TimeUs = message.Header.TimestampUs - (double)(total - cycles[i]) / cyclesPerUs,
+                    Stage = (byte)info,
+                    Type = (EventType)(byte)(info >> 8),
+                    Arg = (ushort)(info >> 16)
+                });
+            }
+            return dump;
+        }
+
+        private static string StageName(byte stage)
+        {
+            return (stage < Stages.Length) ? Stages[stage] : string.Format("Stage {0}", stage);
+        }
+
+        private static int StageThread(byte stage)
+        {
+            return (stage < StageThreads.Length) ? StageThreads[stage] : 1;
+        }
+
+        /// <summary>
+        /// Durations of each stage: a begin is paired with the next end of the same stage
+        /// (the stages of the main loop nest, the others do not overlap themselves)
+        /// </summary>
+        public List<StageStats> Latencies()
+        {
+            var stats = new SortedDictionary<byte, StageStats>();
+            var open = new Dictionary<byte, Stack<double>>();
+
+            foreach (Event e in Events)
+            {
+                if (e.Type == EventType.Begin)
+                {
+                    if (!open.ContainsKey(e.Stage)) open[e.Stage] = new Stack<double>();
+                    open[e.Stage].Push(e.TimeUs);
+                }
+                else if ((e.Type == EventType.End) && open.ContainsKey(e.Stage) && (open[e.Stage].Count > 0))
+                {
+                    if (!stats.ContainsKey(e.Stage)) stats[e.Stage] = new StageStats { Name = StageName(e.Stage) };
+                    stats[e.Stage].DurationsUs.Add(e.TimeUs - open[e.Stage].Pop());
+                }
+            }
+
+            foreach (StageStats s in stats.Values) s.DurationsUs.Sort();
+            return stats.Values.ToList();
+        }
+
+        /// <summary>
+        /// Timeline in the Chrome trace event format, times in us
+        /// The ends without begin (begin overwritten in the ring) are left out
+        /// </summary>
+        public string ToChromeJson()
+        {
+            StringBuilder json = new StringBuilder();
+            var depth = new Dictionary<byte, int>();
+
+            json.Append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+            for (int t = 1; t < ThreadNames.Length; t++)
+            {
+                json.AppendFormat(CultureInfo.InvariantCulture,
+                    "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{0},\"args\":{{\"name\":\"{1}\"}}}},\n", t, ThreadNames[t]);
+            }
+            foreach (Event e in Events)
+            {
+                string phase = "i";
+                if (e.Type == EventType.Begin)
+                {
+                    phase = "B";
+                    depth[e.Stage] = depth.GetValueOrDefault(e.Stage) + 1;
+                }
+                else if (e.Type == EventType.End)
+                {
+                    if (depth.GetValueOrDefault(e.Stage) == 0) continue;
+                    phase = "E";
+                    depth[e.Stage]--;
+                }
+                json.AppendFormat(CultureInfo.InvariantCulture,
+                    "{{\"name\":\"{0}\",\"ph\":\"{1}\",\"ts\":{2:F3},\"pid\":1,\"tid\":{3}{4}{5}}},\n",
+                    StageName(e.Stage), phase, e.TimeUs, StageThread(e.Stage),
+                    (phase == "i") ? ",\"s\":\"t\"" : "",
+                    (phase == "E") ? "" : string.Format(",\"args\":{{\"arg\":{0}}}", e.Arg));
+            }
+            if (json[json.Length - 2] == ',') json.Length -= 2;
+            json.Append("\n]}\n");
+            return json.ToString();
+        }
+
+        public override string ToString()
+        {
+            StringBuilder text = new StringBuilder();
+            text.AppendFormat("{0} events ({1} recorded), {2} cycles per us\r\n", Events.Count, Recorded, CyclesPerUs);
+            foreach (StageStats s in Latencies())
+            {
+                text.AppendFormat(CultureInfo.InvariantCulture, "{0}: {1}, min {2:F1} us, median {3:F1} us, 99% {4:F1} us, max {5:F1} us\r\n",
+                    s.Name, s.DurationsUs.Count, s.DurationsUs[0], s.Percentile(50), s.Percentile(99), s.DurationsUs[^1]);
+            }
+            return text.ToString().TrimEnd();
+        }
+    }
+}
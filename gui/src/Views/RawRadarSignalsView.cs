@@ -10,6 +10,7 @@ using System.Windows.Forms;
 using OxyPlot.Axes;
 using OxyPlot.Series;
 using OxyPlot;
+using ov7675.Codec;
 
 namespace ov7675.Views
 {
@@ -52,6 +53,57 @@ namespace ov7675.Views
 
         private LineSeries timeSignalAntenna0LineSeries = new LineSeries();
 
+        /// <summary>
+        /// Range-Doppler map: Doppler bins along X, range bins along Y, magnitude in dBFS
+        /// </summary>
+        private LinearColorAxis mapColorAxis = new LinearColorAxis
+        {
+            Position = AxisPosition.Right,
+            Palette = OxyPalettes.Jet(256),
+            Minimum = -100,
+            Maximum = 0,
+            Unit = "dBFS",
+            Key = "Color",
+        };
+
+        private HeatMapSeries mapSeries = new HeatMapSeries
+        {
+            Interpolate = false,
+            RenderMethod = HeatMapRenderMethod.Rectangles,
+            ColorAxisKey = "Color",
+        };
+
+        private PlotModel timeModel = new PlotModel
+        {
+            PlotType = PlotType.XY,
+            PlotAreaBorderThickness = new OxyThickness(0),
+        };
+
+        private PlotModel mapModel = new PlotModel
+        {
+            PlotType = PlotType.XY,
+            PlotAreaBorderThickness = new OxyThickness(0),
+        };
+
+        /// <summary>
+        /// Detections: Doppler bin along X, range bin along Y, SNR in dB as color
+        /// </summary>
+        private LinearAxis detectionsDopplerAxis = new LinearAxis { Position = AxisPosition.Bottom, FontSize = 10, Unit = "Doppler bin" };
+        private LinearAxis detectionsRangeAxis = new LinearAxis { Position = AxisPosition.Left, FontSize = 10, Unit = "Range bin" };
+
+        private ScatterSeries detectionsSeries = new ScatterSeries
+        {
+            MarkerType = MarkerType.Circle,
+            MarkerSize = 5,
+            ColorAxisKey = "Snr",
+        };
+
+        private PlotModel detectionsModel = new PlotModel
+        {
+            PlotType = PlotType.XY,
+            PlotAreaBorderThickness = new OxyThickness(0),
+        };
+
         public RawRadarSignalsView()
         {
             InitializeComponent();
@@ -61,12 +113,6 @@ namespace ov7675.Views
         private void InitPlot()
         {
             // Raw signals plot
-            var timeModel = new PlotModel
-            {
-                PlotType = PlotType.XY,
-                PlotAreaBorderThickness = new OxyThickness(0),
-            };
-
             // Set the axes
             timeModel.Axes.Add(xAxis);
             timeModel.Axes.Add(yAxis);
@@ -77,12 +123,34 @@ namespace ov7675.Views
 
             timeModel.Series.Add(timeSignalAntenna0LineSeries);
 
+            // Range-Doppler map
+            mapModel.Axes.Add(new LinearAxis { Position = AxisPosition.Bottom, FontSize = 10, Unit = "Doppler bin" });
+            mapModel.Axes.Add(new LinearAxis { Position = AxisPosition.Left, FontSize = 10, Unit = "Range bin" });
+            mapModel.Axes.Add(mapColorAxis);
+            mapModel.Series.Add(mapSeries);
+
+            // Detections
+            detectionsModel.Axes.Add(detectionsDopplerAxis);
+            detectionsModel.Axes.Add(detectionsRangeAxis);
+            detectionsModel.Axes.Add(new LinearColorAxis
+            {
+                Position = AxisPosition.Right,
+                Palette = OxyPalettes.Jet(256),
+                Minimum = 0,
+                Maximum = 40,
+                Unit = "SNR dB",
+                Key = "Snr",
+            });
+            detectionsModel.Series.Add(detectionsSeries);
+
             plotView.Model = timeModel;
             plotView.InvalidatePlot(true);
         }
 
         public void updateData(double[] signal)
         {
+            if (plotView.Model != timeModel) plotView.Model = timeModel;
+            setAxes("Sample index", "ADC tick", -1, 1);
             timeSignalAntenna0LineSeries.Points.Clear();
             for (int i = 0; i < signal.Length; ++i)
             {
@@ -90,5 +158,72 @@ namespace ov7675.Views
             }
             plotView.InvalidatePlot(true);
         }
+
+        /// <summary>
+        /// Display a range profile
+        /// </summary>
+        /// <param name="profile">Magnitude of the range bins in dBFS</param>
+        public void updateProfile(double[] profile)
+        {
+            if (plotView.Model != timeModel) plotView.Model = timeModel;
+            setAxes("Range bin", "dBFS", -120, 0);
+            timeSignalAntenna0LineSeries.Points.Clear();
+            for (int i = 0; i < profile.Length; ++i)
+            {
+                timeSignalAntenna0LineSeries.Points.Add(new DataPoint(i, profile[i]));
+            }
+            plotView.InvalidatePlot(true);
+        }
+
+        /// <summary>
+        /// Display a range-Doppler map
+        /// </summary>
+        /// <param name="map">Magnitude in dBFS, [Doppler bin, range bin] (zero velocity at the middle)</param>
+        public void updateMap(double[,] map)
+        {
+            if (plotView.Model != mapModel) plotView.Model = mapModel;
+
+            int dopplerBins = map.GetLength(0);
+            mapSeries.X0 = -dopplerBins / 2;
+            mapSeries.X1 = (dopplerBins / 2) - 1;
+            mapSeries.Y0 = 0;
+            mapSeries.Y1 = map.GetLength(1) - 1;
+            mapSeries.Data = map;
+            plotView.InvalidatePlot(true);
+        }
+
+        /// <summary>
+        /// Display the detections of a frame
+        /// </summary>
+        /// <param name="detections">Detections</param>
+        /// <param name="rangeBins">Range bins of the detector input</param>
+        /// <param name="dopplerBins">Doppler bins of the detector input (1: range profile)</param>
+        public void updateDetections(Detection[] detections, int rangeBins, int dopplerBins)
+        {
+            if (plotView.Model != detectionsModel) plotView.Model = detectionsModel;
+
+            detectionsDopplerAxis.Minimum = -(dopplerBins / 2) - 0.5;
+            detectionsDopplerAxis.Maximum = (dopplerBins / 2) - 0.5;
+            detectionsRangeAxis.Minimum = -0.5;
+            detectionsRangeAxis.Maximum = rangeBins - 0.5;
+            detectionsSeries.Points.Clear();
+            foreach (Detection detection in detections)
+            {
+                detectionsSeries.Points.Add(new ScatterPoint(detection.DopplerBin, detection.RangeBin, double.NaN, detection.SnrDb));
+            }
+            plotView.InvalidatePlot(true);
+        }
+
+        private void setAxes(string xUnit, string yUnit, double minimum, double maximum)
+        {
+            if (yAxis.Unit == yUnit) return;
+
+            xAxis.Unit = xUnit;
+            yAxis.Unit = yUnit;
+            yAxis.Minimum = minimum;
+            yAxis.Maximum = maximum;
+            xAxis.Reset();
+            yAxis.Reset();
+        }
     }
 }
@@ -0,0 +1,38 @@
+﻿using System.Runtime.CompilerServices;
+
+namespace ov7675.Tests
+{
+    /// <summary>
+    /// Checks of the host tests: a failed check is printed and counted, the test goes on
+    /// </summary>
+    internal static class Check
+    {
+        private static int failures;
+
+        public static void True(bool condition, string message,
+            [CallerFilePath] string file = "", [CallerLineNumber] int line = 0)
+        {
+            if (!condition)
+            {
+                failures++;
+                Console.WriteLine($"{Path.GetFileName(file)}:{line}: check failed: {message}");
+            }
+        }
+
+        public static void Equal<T>(T expected, T actual, string message,
+            [CallerFilePath] string file = "", [CallerLineNumber] int line = 0)
+        {
+            if (!EqualityComparer<T>.Default.Equals(expected, actual))
+            {
+                failures++;
+                Console.WriteLine($"{Path.GetFileName(file)}:{line}: {message}: expected {expected}, got {actual}");
+            }
+        }
+
+        public static int Result()
+        {
+            Console.WriteLine((failures == 0) ? "gui tests: passed" : $"gui tests: {failures} check(s) failed");
+            return failures;
+        }
+    }
+}
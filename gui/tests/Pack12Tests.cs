@@ -0,0 +1,117 @@
+﻿using System.Diagnostics;
+using System.Runtime.Intrinsics.X86;
+using ov7675.Codec;
+
+namespace ov7675.Tests
+{
+    /// <summary>
+    /// Unpacking of the 12 bits radar samples: SSSE3 and scalar paths against the layout of pack12.h
+    /// </summary>
+    internal static class Pack12Tests
+    {
+        /// <summary>
+        /// Radar frame of the default profile: 128 samples, 64 chirps, 3 antennas
+        /// </summary>
+        private const int FrameSamples = 128 * 64 * 3;
+
+        public static void Run(int iterations)
+        {
+            Random random = new Random(0x2545F491);
+
+            Check.True(Pack12.Unpack(new byte[4], 3) == null, "data too short");
+            Check.True(Pack12.Unpack(new byte[4], -1) == null, "negative count");
+            Check.Equal(0, Pack12.Unpack(Array.Empty<byte>(), 0)?.Length ?? -1, "no sample");
+
+            // Every count up to 64 covers the blocks of 8 samples and the tails, then a radar frame
+            for (int count = 0; count <= 67; count++)
+            {
+                int n = (count <= 64) ? count : FrameSamples - 66 + count;
+                ushort[] samples = new ushort[n];
+
+                for (int i = 0; i < n; i++)
+                {
+                    samples[i] = (ushort)random.Next(0, 4096);
+                }
+
+                byte[] packed = Pack(samples);
+                byte[]? scalar = Pack12.Unpack(packed, n, false);
+                byte[]? simd = Pack12.Unpack(packed, n, true);
+
+                Check.True(scalar != null && Matches(samples, scalar), $"scalar unpack of {n} samples");
+                Check.True(simd != null && Matches(samples, simd), $"SSSE3 unpack of {n} samples");
+            }
+
+            Benchmark(random, iterations);
+        }
+
+        /// <summary>
+        /// Pack from the layout of pack12.h: the 24 bits little endian word first | (second << 12)
+        /// </summary>
+        private static byte[] Pack(ushort[] samples)
+        {
+            byte[] packed = new byte[Pack12.PackedSize(samples.Length)];
+            int offset = 0;
+            int i = 0;
+
+            for (; i + 1 < samples.Length; i += 2)
+            {
+                int word = samples[i] | (samples[i + 1] << 12);
+
+                packed[offset++] = (byte)word;
+                packed[offset++] = (byte)(word >> 8);
+                packed[offset++] = (byte)(word >> 16);
+            }
+
+            if (i < samples.Length)
+            {
+                packed[offset++] = (byte)samples[i];
+                packed[offset] = (byte)(samples[i] >> 8);
+            }
+
+            return packed;
+        }
+
+        private static bool Matches(ushort[] samples, byte[] unpacked)
+        {
+            if (unpacked.Length != samples.Length * 2) return false;
+
+            for (int i = 0; i < samples.Length; i++)
+            {
+                if (BitConverter.ToUInt16(unpacked, i * 2) != samples[i]) return false;
+            }
+
+            return true;
+        }
+
+        /// <summary>
+        /// Nanoseconds per sample of both paths (best run)
+        /// </summary>
+        private static void Benchmark(Random random, int iterations)
+        {
+            ushort[] samples = new ushort[FrameSamples];
+
+            for (int i = 0; i < samples.Length; i++)
+            {
+                samples[i] = (ushort)random.Next(0, 4096);
+            }
+
+            byte[] packed = Pack(samples);
+            double scalar = double.MaxValue;
+            double simd = double.MaxValue;
+
+            for (int i = 0; i < iterations; i++)
+            {
+                long start = Stopwatch.GetTimestamp();
+                Pack12.Unpack(packed, FrameSamples, false);
+                scalar = Math.Min(scalar, Stopwatch.GetElapsedTime(start).TotalNanoseconds);
+
+                start = Stopwatch.GetTimestamp();
+                Pack12.Unpack(packed, FrameSamples, true);
+                simd = Math.Min(simd, Stopwatch.GetElapsedTime(start).TotalNanoseconds);
+            }
+
+            Console.WriteLine($"Pack12 unpack: scalar {scalar / FrameSamples:F2} ns/sample, " +
+                (Ssse3.IsSupported ? $"SSSE3 {simd / FrameSamples:F2} ns/sample" : "SSSE3 not supported"));
+        }
+    }
+}
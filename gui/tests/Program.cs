@@ -0,0 +1,18 @@
+﻿namespace ov7675.Tests
+{
+    internal static class Program
+    {
+        /// <summary>
+        /// Run every test, the exit code is the number of failed checks
+        /// </summary>
+        /// <param name="args">Optional: iterations of the benchmarks</param>
+        private static int Main(string[] args)
+        {
+            int iterations = ((args.Length > 0) && int.TryParse(args[0], out int count) && (count > 0)) ? count : 20;
+
+            Pack12Tests.Run(iterations);
+
+            return Check.Result();
+        }
+    }
+}
@@ -0,0 +1,222 @@
+/*
+ * command_client.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "command_client.h"
+
+#include <string.h>
+
+#include "crc.h"
+
+static uint16_t _get_u16(const uint8_t* buffer)
+{
+	return (uint16_t)(buffer[0] | (buffer[1] << 8));
+}
+
+static uint32_t _get_u32(const uint8_t* buffer)
+{
+	return (uint32_t)_get_u16(buffer) | ((uint32_t)_get_u16(&buffer[2]) << 16);
+}
+
+void command_client_init(command_client_t* client)
+{
+	memset(client, 0, sizeof(*client));
+	client->next_request_id = 1;
+}
+
+int32_t command_client_request(command_client_t* client, uint8_t command, const uint8_t* params, uint16_t size,
+		uint64_t now_us, uint8_t* frame, uint32_t frame_size)
+{
+	command_t request;
+	command_client_request_t* slot = NULL;
+
+	if (size > COMMAND_MAX_PARAMS)
+	{
+		return COMMAND_CLIENT_ERROR_PARAM;
+	}
+	if (frame_size < (uint32_t)(COMMAND_HEADER_SIZE + size + COMMAND_CRC_SIZE))
+	{
+		return COMMAND_CLIENT_ERROR_OVERFLOW;
+	}
+
+	// Forget the requests without acknowledgement, take a free slot or the oldest one
+	for (int i = 0; i < COMMAND_CLIENT_MAX_PENDING; ++i)
+	{
+		command_client_request_t* pending = &client->requests[i];
+
+		if (pending->pending && ((now_us - pending->sent_us) > COMMAND_CLIENT_TIMEOUT_US))
+		{
+			pending->pending = 0;
+			client->stats.lost++;
+		}
+		if ((slot == NULL) || (slot->pending && (!pending->pending || (pending->sent_us < slot->sent_us))))
+		{
+			slot = pending;
+		}
+	}
+	if (slot->pending)
+	{
+		client->stats.lost++;
+	}
+
+	request.id = command;
+	request.flags = 0;
+	request.request_id = client->next_request_id++;
+	request.size = size;
+	request.params = params;
+	if (client->next_request_id == 0)
+	{
+		client->next_request_id = 1;
+	}
+
+	slot->sent_us = now_us;
+	slot->request_id = request.request_id;
+	slot->command = command;
+	slot->pending = 1;
+
+	return (int32_t)command_encode(&request, frame);
+}
+
+/**
+ * @brief Drop the first byte of the buffered message and the bytes before the next sync bytes
+ */
+static void _command_client_resync(command_client_t* client)
+{
+	uint32_t start = 1 + protocol_find_sync(&client->message[1], client->length - 1);
+
+	client->stats.skipped_bytes += start;
+	client->length -= start;
+	memmove(client->message, &client->message[start], client->length);
+}
+
+/**
+ * @brief Decode the acknowledgement of the buffered message and match it with its request
+ */
+static int _command_client_ack(command_client_t* client, uint64_t now_us, command_client_ack_t* ack)
+{
+	const uint8_t* payload = &client->message[PROTOCOL_HEADER_SIZE];
+	const uint32_t size = client->header.payload_size;
+
+	// Acknowledgements are never fragmented
+	if ((client->header.message_size != size)
+			|| (client->header.message_crc != crc32_compute(payload, size)))
+	{
+		client->stats.crc_errors++;
+		return 0;
+	}
+
+	ack->request_id = _get_u16(payload);
+	ack->command = payload[2];
+	ack->status = (int32_t)_get_u32(&payload[4]);
+	ack->data = &payload[COMMAND_ACK_SIZE];
+	ack->size = size - COMMAND_ACK_SIZE;
+	ack->round_trip_us = -1;
+
+	// Not pending: request of a previous connection or already forgotten
+	for (int i = 0; i < COMMAND_CLIENT_MAX_PENDING; ++i)
+	{
+		command_client_request_t* request = &client->requests[i];
+
+		if (request->pending && (request->request_id == ack->request_id) && (request->command == ack->command))
+		{
+			ack->round_trip_us = (int64_t)(now_us - request->sent_us);
+			request->pending = 0;
+			break;
+		}
+	}
+
+	client->stats.acks++;
+	return 1;
+}
+
+int command_client_receive(command_client_t* client, const uint8_t* data, uint32_t size, uint32_t* consumed,
+		uint64_t now_us, command_client_ack_t* ack)
+{
+	uint32_t used = 0;
+
+	// The acknowledgement returned last time is done with
+	if (client->delivered != 0)
+	{
+		client->length = 0;
+		client->delivered = 0;
+	}
+
+	for (;;)
+	{
+		uint32_t wanted = 0;
+		uint32_t count = 0;
+
+		// Payload of a data stream: skipped without copy
+		if (client->skip != 0)
+		{
+			count = ((size - used) < client->skip) ? (size - used) : client->skip;
+			client->skip -= count;
+			used += count;
+			if (client->skip != 0)
+			{
+				break;
+			}
+			continue;
+		}
+
+		// Header first, then the payload of an acknowledgement
+		wanted = (client->length < PROTOCOL_HEADER_SIZE) ? PROTOCOL_HEADER_SIZE
+				: (PROTOCOL_HEADER_SIZE + client->header.payload_size);
+		count = wanted - client->length;
+		count = ((size - used) < count) ? (size - used) : count;
+		memcpy(&client->message[client->length], &data[used], count);
+		client->length += count;
+		used += count;
+		if (client->length < wanted)
+		{
+			break;
+		}
+
+		if (wanted == PROTOCOL_HEADER_SIZE)
+		{
+			if (protocol_decode_header(client->message, client->length, &client->header) != 0)
+			{
+				client->stats.header_errors++;
+				_command_client_resync(client);
+				continue;
+			}
+
+			client->stats.messages++;
+			if ((client->header.stream != PROTOCOL_STREAM_CONTROL)
+					|| (client->header.format != PROTOCOL_FORMAT_COMMAND_ACK))
+			{
+				client->skip = client->header.payload_size;
+				client->length = 0;
+			}
+			else if ((client->header.payload_size < COMMAND_ACK_SIZE)
+					|| (client->header.payload_size > COMMAND_CLIENT_MAX_ACK_SIZE))
+			{
+				client->stats.crc_errors++;
+				client->skip = client->header.payload_size;
+				client->length = 0;
+			}
+			continue;
+		}
+
+		if (_command_client_ack(client, now_us, ack))
+		{
+			client->delivered = 1;
+			*consumed = used;
+			return 1;
+		}
+		client->length = 0;
+	}
+
+	*consumed = used;
+	return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * command_client.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Host client of the command channel (see protocol/command.h of the CM55 project),
+ * for scripts and test benches without the GUI: the same logic as CommandClient.cs.
+ *
+ * - command_client_request frames a command with the next request id and keeps it
+ *   pending until its acknowledgement (COMMAND_CLIENT_TIMEOUT_US at most).
+ * - command_client_receive takes the bytes read from the device as they come, whatever
+ *   the USB transfers they are split into. The messages of the data streams are
+ *   skipped without being copied, the acknowledgements of the control stream are
+ *   checked (header and message CRC) and returned with their round trip time.
+ *
+ * The client does no I/O: the caller writes the frames to the CDC port and pushes
+ * what it reads. This file and command_client.c only depend on the C standard
+ * library and on the protocol files of the CM55 project.
+ */
+
+#ifndef HOST_COMMAND_CLIENT_H_
+#define HOST_COMMAND_CLIENT_H_
+
+#include <stdint.h>
+
+#include "protocol/command.h"
+#include "protocol/protocol.h"
+
+/**
+ * @def COMMAND_CLIENT_MAX_PENDING
+ * Requests waiting for their acknowledgement, the oldest one is forgotten beyond
+ */
+#define COMMAND_CLIENT_MAX_PENDING		32
+
+/**
+ * @def COMMAND_CLIENT_TIMEOUT_US
+ * Requests without acknowledgement are forgotten after this time
+ */
+#define COMMAND_CLIENT_TIMEOUT_US		2000000u
+
+/**
+ * @def COMMAND_CLIENT_MAX_ACK_SIZE
+ * Largest acknowledgement kept (status and data of the command), larger ones are skipped
+ */
+#define COMMAND_CLIENT_MAX_ACK_SIZE		1024
+
+/**
+ * Errors
+ */
+#define COMMAND_CLIENT_ERROR_PARAM		-1	/**< Parameters larger than COMMAND_MAX_PARAMS */
+#define COMMAND_CLIENT_ERROR_OVERFLOW	-2	/**< Frame buffer too small */
+
+/**
+ * Acknowledgement of a command
+ */
+typedef struct
+{
+	uint16_t request_id;
+	uint8_t command;
+	int32_t status;					/**< COMMAND_STATUS_xxx */
+	const uint8_t* data;			/**< Data of the command (in the client: valid until the next receive) */
+	uint32_t size;					/**< Size of the data */
+	int64_t round_trip_us;			/**< From the request to the acknowledgement, -1: not a pending request */
+} command_client_ack_t;
+
+/**
+ * Request waiting for its acknowledgement
+ */
+typedef struct
+{
+	uint64_t sent_us;
+	uint16_t request_id;
+	uint8_t command;
+	uint8_t pending;
+} command_client_request_t;
+
+/**
+ * Counters of the client since its initialization
+ */
+typedef struct
+{
+	uint32_t messages;				/**< Messages of the device (all streams) */
+	uint32_t acks;					/**< Valid acknowledgements */
+	uint32_t lost;					/**< Requests forgotten without acknowledgement */
+	uint32_t header_errors;			/**< Invalid headers (the client resynchronizes) */
+	uint32_t crc_errors;			/**< Acknowledgements dropped: wrong message CRC or size */
+	uint32_t skipped_bytes;			/**< Bytes dropped while searching a header */
+} command_client_stats_t;
+
+/**
+ * Client
+ */
+typedef struct
+{
+	command_client_request_t requests[COMMAND_CLIENT_MAX_PENDING];
+	uint16_t next_request_id;
+	uint8_t message[PROTOCOL_HEADER_SIZE + COMMAND_CLIENT_MAX_ACK_SIZE];	/**< Header, then the acknowledgement */
+	uint32_t length;				/**< Number of bytes in message */
+	protocol_header_t header;		/**< Header of the message, once length >= PROTOCOL_HEADER_SIZE */
+	uint32_t skip;					/**< Bytes of a payload still to skip */
+	uint32_t delivered;				/**< An acknowledgement has been returned, removed by the next receive */
+	command_client_stats_t stats;
+} command_client_t;
+
+/**
+ * @brief Prepare a client
+ *
+ * @param [out] client Client
+ */
+void command_client_init(command_client_t* client);
+
+/**
+ * @brief Frame a command and keep it pending
+ *
+ * @param [in,out] client Client
+ * @param [in] command Command
+ * @param [in] params Parameters (NULL if size is 0)
+ * @param [in] size Size of the parameters (at most COMMAND_MAX_PARAMS)
+ * @param [in] now_us Time of the host
+ * @param [out] frame Frame to write to the device
+ * @param [in] frame_size Size of the frame buffer
+ *
+ * @retval Size of the frame
+ * @retval COMMAND_CLIENT_ERROR_PARAM Parameters too large
+ * @retval COMMAND_CLIENT_ERROR_OVERFLOW Frame buffer too small
+ */
+int32_t command_client_request(command_client_t* client, uint8_t command, const uint8_t* params, uint16_t size,
+		uint64_t now_us, uint8_t* frame, uint32_t frame_size);
+
+/**
+ * @brief Push the bytes read from the device, until an acknowledgement is complete
+ * Call again with the bytes not consumed (or none) as long as an acknowledgement is returned.
+ *
+ * @param [in,out] client Client
+ * @param [in] data Bytes read
+ * @param [in] size Number of bytes
+ * @param [out] consumed Number of bytes of data taken by the client
+ * @param [in] now_us Time the bytes have been read
+ * @param [out] ack Acknowledgement
+ *
+ * @retval 1 An acknowledgement is complete
+ * @retval 0 All bytes consumed, no acknowledgement complete
+ */
+int command_client_receive(command_client_t* client, const uint8_t* data, uint32_t size, uint32_t* consumed,
+		uint64_t now_us, command_client_ack_t* ack);
+
+#endif /* HOST_COMMAND_CLIENT_H_ */
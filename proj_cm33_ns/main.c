@@ -43,6 +43,7 @@
 * Header Files
 *******************************************************************************/
 #include "cybsp.h"
+#include "io_ring.h"
 //#include "cy_time.h"
 //
 //#include "FreeRTOS.h"
@@ -67,6 +68,16 @@
 #define CM55_APP_BOOT_ADDR                  (CYMEM_CM33_0_m55_nvm_START + \
                                                 CYBSP_MCUBOOT_HEADER_SIZE)
 
+/* Rate of the SysTick waking the CM33 up while it waits for the requests of
+ * the CM55 (in case the event sent by the CM55 does not reach the CM33).
+ */
+#define IO_RING_TICK_HZ                     (10000U)
+
+/* Time given to the CM55 to publish the ring: without ring (offload disabled
+ * in the CM55 project) the CM33 goes to deep sleep.
+ */
+#define IO_RING_FIND_TIMEOUT_MSEC           (5000U)
+
 /* Enabling or disabling a MCWDT requires a wait time of upto 2 CLK_LF cycles  
  * to come into effect. This wait time value will depend on the actual CLK_LF  
  * frequency set by the BSP.
@@ -111,6 +122,82 @@ static void handle_app_error(void)
     while(true);
 }
 
+/*******************************************************************************
+* Function Name: SysTick_Handler
+********************************************************************************
+* Summary:
+* Wakes the CM33 up from __WFE while it serves the ring.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*******************************************************************************/
+void SysTick_Handler(void)
+{
+}
+
+/*******************************************************************************
+* Function Name: io_ring_run
+********************************************************************************
+* Summary:
+* Serves the CRC requests of the CM55 (see io_ring.h): the CM33 computes the
+* CRC-32 of the messages posted by the CM55 and waits for an event in between.
+* The busy and elapsed cycles are counted in the ring for the CM55.
+* Returns if the CM55 does not publish a ring within IO_RING_FIND_TIMEOUT_MSEC.
+*
+* Parameters:
+*  void
+*
+* Return:
+*  void
+*
+*******************************************************************************/
+static void io_ring_run(void)
+{
+    io_ring_t *ring = NULL;
+    uint32_t ticks = 0U;
+
+    /* Cycle counter measuring the requests and the load */
+#if defined(DCB)
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+#else
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#endif
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    (void)SysTick_Config(SystemCoreClock / IO_RING_TICK_HZ);
+
+    while (NULL == ring)
+    {
+        ring = io_ring_find();
+        if ((NULL == ring) && (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk))
+        {
+            ticks++;
+            if (ticks >= ((IO_RING_FIND_TIMEOUT_MSEC * IO_RING_TICK_HZ) / 1000U))
+            {
+                SysTick->CTRL = 0U;
+                return;
+            }
+        }
+        __WFE();
+    }
+
+    for (;;)
+    {
+        /* Also counts the wraps of the cycle counter: at least one tick per wrap */
+        io_ring_tick(ring);
+        if (0 == io_ring_serve(ring))
+        {
+            /* Woken up by the event of the CM55 (new request) or by the SysTick */
+            __WFE();
+        }
+    }
+}
+
 /*******************************************************************************
  * Function Name: cm33_blinky_task 
  *******************************************************************************
@@ -265,8 +352,9 @@ static void handle_app_error(void)
  *    2. It sets up the CLIB support library for CM33 CPU. 
  *    3. It sets up the LPTimer instance for CM33 CPU. 
  *    4. It enables the CM55 CPU using 'Cy_SysEnableCM55'.
- *    5. It creates the FreeRTOS application task 'cm33_blinky_task'.
- *    6. It starts the RTOS task scheduler.
+ *    5. It serves the CRC requests of the CM55 (shared memory ring).
+ *    6. It creates the FreeRTOS application task 'cm33_blinky_task'.
+ *    7. It starts the RTOS task scheduler.
  *
  * Parameters:
  *  void
@@ -301,6 +389,9 @@ int main(void)
     /* Enable global interrupts */
     __enable_irq();
 
+    /* Serve the CRC requests of the CM55, returns if the CM55 has no ring */
+    io_ring_run();
+
 //    /* Create the FreeRTOS Task */
 //    result = xTaskCreate(cm33_blinky_task, BLINKY_LED_TASK_NAME,
 //                        BLINKY_LED_TASK_STACK_SIZE, NULL,
@@ -0,0 +1,117 @@
+/*
+ * FreeRTOSConfig.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Kernel configuration of the task pipeline of the CM55, only used by the
+ * build with RTOS=1 (see the Makefile and app_rtos.c).
+ *
+ * - The kernel owns SVC, PendSV and SysTick: the camera driver is built with
+ *   OV7675_DEFERRED_PENDSV=0 and its deferred path runs in the camera task.
+ * - The tasks, the queue and the lock of app_rtos.c are allocated statically; the
+ *   memory of the idle and timer tasks is given by abstraction-rtos, a
+ *   dependency of the freertos library.
+ * - The interrupts of the application (radar data at priority 1, SPI and DMA
+ *   at 2, camera at 6) wake up the tasks: every priority but 0 may call the
+ *   FromISR functions, the critical sections mask them all.
+ * - Idle: the tick stops while no task is ready (tickless, SysTick), the CPU
+ *   sleeps until the next interrupt.
+ * - Run time of the tasks in microseconds (timestamp.h, the cycle counter).
+ */
+
+#ifndef FREERTOS_CONFIG_H_
+#define FREERTOS_CONFIG_H_
+
+#if defined(__GNUC__) || defined(__ICCARM__) || defined(__ARMCC_VERSION)
+#include <stdint.h>
+
+extern uint32_t SystemCoreClock;
+uint64_t timestamp_now_us(void);
+#endif
+
+#define configUSE_PREEMPTION					1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
+#define configUSE_TICKLESS_IDLE					1
+#define configCPU_CLOCK_HZ						SystemCoreClock
+#define configTICK_RATE_HZ						1000u
+#define configMAX_PRIORITIES					6
+#define configMINIMAL_STACK_SIZE				256
+#define configMAX_TASK_NAME_LEN					12
+#define configUSE_16_BIT_TICKS					0
+#define configIDLE_SHOULD_YIELD					1
+#define configUSE_TASK_NOTIFICATIONS			1
+#define configUSE_MUTEXES						1
+#define configUSE_RECURSIVE_MUTEXES				0
+#define configUSE_COUNTING_SEMAPHORES			1
+#define configQUEUE_REGISTRY_SIZE				0
+#define configUSE_QUEUE_SETS					0
+#define configUSE_TIME_SLICING					1
+#define configUSE_NEWLIB_REENTRANT				1
+#define configENABLE_BACKWARD_COMPATIBILITY		0
+
+/* Memory: static for the application, the heap for the libraries (emUSB) */
+#define configSUPPORT_STATIC_ALLOCATION			1
+#define configSUPPORT_DYNAMIC_ALLOCATION		1
+#define configTOTAL_HEAP_SIZE					(16 * 1024)
+#define configAPPLICATION_ALLOCATED_HEAP		0
+
+/* Hooks */
+#define configUSE_IDLE_HOOK						0
+#define configUSE_TICK_HOOK						0
+#define configCHECK_FOR_STACK_OVERFLOW			2
+#define configUSE_MALLOC_FAILED_HOOK			0
+#define configUSE_DAEMON_TASK_STARTUP_HOOK		0
+
+/* Load of the tasks, printed when the stream stops */
+#define configGENERATE_RUN_TIME_STATS			1
+#define configRUN_TIME_COUNTER_TYPE				uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()		timestamp_now_us()
+#define configUSE_TRACE_FACILITY				1
+#define configUSE_STATS_FORMATTING_FUNCTIONS	0
+
+/* Software timers (not used by the application) */
+#define configUSE_TIMERS						1
+#define configTIMER_TASK_PRIORITY				(configMAX_PRIORITIES - 1)
+#define configTIMER_QUEUE_LENGTH				10
+#define configTIMER_TASK_STACK_DEPTH			configMINIMAL_STACK_SIZE
+
+/* Cortex-M55, non-secure, without MPU */
+#define configENABLE_FPU						1
+#define configENABLE_MVE						1
+#define configENABLE_MPU						0
+#define configENABLE_TRUSTZONE					0
+#define configRUN_FREERTOS_SECURE_ONLY			0
+
+/* Interrupt priorities: 3 bits on the CM55 (__NVIC_PRIO_BITS) */
+#define configPRIO_BITS							3
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY			7
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY	1
+#define configKERNEL_INTERRUPT_PRIORITY			(configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY	(configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+#define configASSERT(x)							if ((x) == 0) { taskDISABLE_INTERRUPTS(); for (;;); }
+
+/* Functions included */
+#define INCLUDE_vTaskPrioritySet				0
+#define INCLUDE_uxTaskPriorityGet				0
+#define INCLUDE_vTaskDelete						1
+#define INCLUDE_vTaskSuspend					1
+#define INCLUDE_vTaskDelayUntil					1
+#define INCLUDE_vTaskDelay						1
+#define INCLUDE_xTaskGetSchedulerState			1
+#define INCLUDE_xTaskGetCurrentTaskHandle		1
+#define INCLUDE_uxTaskGetStackHighWaterMark		1
+#define INCLUDE_xTaskGetIdleTaskHandle			1
+#define INCLUDE_eTaskGetState					0
+#define INCLUDE_xTimerPendFunctionCall			0
+
+#endif /* FREERTOS_CONFIG_H_ */
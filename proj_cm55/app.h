@@ -0,0 +1,724 @@
+/*
+ * app.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Private header of the application of the CM55: configuration of the pipelines,
+ * state shared by its modules and their entry points.
+ * - main.c: startup, USB stage, CRC offload to the CM33 and telemetry
+ * - app_commands.c: commands of the host, acknowledgements and drain of the sensors
+ * - app_camera.c: camera pipeline (capture, codecs, motion gating and capture modes)
+ * - app_radar.c: radar pipeline (readout, range processing, batches, blocks and profiles)
+ * - app_rtos.c: tasks of the pipeline (RTOS_ENABLED=1)
+ *
+ * The stages of the pipeline run one at a time (main loop, or under the lock of the tasks):
+ * the state is shared without further protection.
+ */
+
+#ifndef APP_H_
+#define APP_H_
+
+#include "cybsp.h"
+#include "cy_pdl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Access to retarget-io initialization
+// used to have printf over KitProg3
+#include "driver/retarget_io/retarget_io_init.h"
+
+// Driver of the OV7675 camera (over DVP for stream and I2C for configuration)
+#include "driver/ov7675/mtb_dvp_camera_ov7675.h"
+
+// Driver for USBD support (using emUSB from Seeger)
+#include "driver/usbd/usbd.h"
+
+// Driver for radar (BGT60TR13C)
+#include "driver/radar/radar.h"
+
+#include "crc.h"
+#include "timestamp.h"
+#include "stream_scheduler.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "ipc/io_ring.h"
+#include "protocol/protocol.h"
+#include "protocol/command.h"
+#include "codec/jpeg_encoder.h"
+#include "codec/lossless_codec.h"
+#include "codec/tile_delta.h"
+#include "codec/pack12.h"
+#include "dsp/range_doppler.h"
+#include "dsp/cfar.h"
+
+/**
+ * @def RTOS_ENABLED
+ * 1: the stages of the main loop run in FreeRTOS tasks (make RTOS=1, see FreeRTOSConfig.h), 0: superloop
+ */
+#ifndef RTOS_ENABLED
+#define RTOS_ENABLED	0
+#endif
+
+#if RTOS_ENABLED
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#endif
+
+/**
+ * @def COM_CMD_START_STREAM
+ * Command enabling to start the streaming of data
+ * The commands are framed (protocol/command.h) and acknowledged on the control stream
+ */
+#define COM_CMD_START_STREAM	49
+
+/**
+ * @def COM_CMD_STOP_STREAM
+ * Command stopping the streaming of data, the statistics are printed
+ */
+#define COM_CMD_STOP_STREAM		50
+
+/**
+ * @def COM_CMD_TIME_SYNC
+ * Clock synchronization request, followed by a token (uint32_t, little endian)
+ * The reply (control stream, PROTOCOL_FORMAT_TIME_SYNC) carries the token and
+ * the time the request has been read: the host estimates the offset between its clock
+ * and the timestamps of the messages
+ */
+#define COM_CMD_TIME_SYNC		51
+
+/**
+ * @def COM_CMD_TIME_SYNC_TOKEN_SIZE
+ * Size of the token following COM_CMD_TIME_SYNC
+ */
+#define COM_CMD_TIME_SYNC_TOKEN_SIZE	4
+
+/**
+ * @def COM_CMD_CAMERA_CODEC
+ * Compression of the camera frames, followed by the codec (camera_codec_t, 1 byte)
+ * and the quality of the JPEG frames (1 to 100, 1 byte, ignored by the other codecs)
+ */
+#define COM_CMD_CAMERA_CODEC	52
+
+/**
+ * @def COM_CMD_CAMERA_MOTION
+ * Motion gating of the camera frames, followed by the mode (camera_motion_t, 1 byte)
+ * and the threshold (mean difference per compared pixel of a tile, see tile_delta.h, 1 byte)
+ */
+#define COM_CMD_CAMERA_MOTION	53
+
+/**
+ * @def COM_CMD_RADAR_FORMAT
+ * Format of the radar frames, followed by the format (1 byte):
+ * PROTOCOL_FORMAT_RADAR_U16 (default) or PROTOCOL_FORMAT_RADAR_U12 (packed) for the samples,
+ * PROTOCOL_FORMAT_RANGE_xxx for the range bins computed on the device (range_fft.h),
+ * PROTOCOL_FORMAT_RANGE_DOPPLER_U16 for the range-Doppler map (range_doppler.h),
+ * PROTOCOL_FORMAT_DETECTIONS for the targets found by the detector (cfar.h)
+ */
+#define COM_CMD_RADAR_FORMAT	54
+
+/**
+ * @def COM_CMD_RADAR_CFAR
+ * Detector of PROTOCOL_FORMAT_DETECTIONS, followed by the input (radar_cfar_source_t, 1 byte)
+ * and the configuration (cfar_config_t: mode, guard, training, threshold in dB and rank, 1 byte each)
+ */
+#define COM_CMD_RADAR_CFAR		55
+
+/**
+ * @def COM_CMD_RADAR_CFAR_SIZE
+ * Size of the parameters following COM_CMD_RADAR_CFAR
+ */
+#define COM_CMD_RADAR_CFAR_SIZE	6
+
+/**
+ * @def COM_CMD_RADAR_BATCH
+ * Batching of the radar frames, followed by the number of frames per message (1 byte, 0 or 1: no batching)
+ * and the deadline (ms, 2 bytes little endian, 0: RADAR_BATCH_DEADLINE_MS): a batch is sent once it holds
+ * its frames or once its first frame has been captured for the deadline
+ */
+#define COM_CMD_RADAR_BATCH		56
+
+/**
+ * @def COM_CMD_RADAR_BATCH_SIZE
+ * Size of the parameters following COM_CMD_RADAR_BATCH
+ */
+#define COM_CMD_RADAR_BATCH_SIZE	3
+
+/**
+ * @def COM_CMD_RADAR_PROFILE
+ * Register profile of the radar, followed by the samples per chirp and the chirps per frame
+ * (2 bytes little endian each), the antennas (1 byte), the number of registers (1 byte,
+ * 0: profile compiled from radar_settings.h) and the registers (4 bytes little endian each).
+ * The device replies on the control stream (PROTOCOL_FORMAT_RADAR_PROFILE).
+ */
+#define COM_CMD_RADAR_PROFILE	57
+
+/**
+ * @def COM_CMD_RADAR_PROFILE_SIZE
+ * Size of the parameters following COM_CMD_RADAR_PROFILE, before the registers
+ */
+#define COM_CMD_RADAR_PROFILE_SIZE	6
+
+/**
+ * @def COM_CMD_CAMERA_MODE
+ * Capture mode of the camera, followed by the resolution (0: QVGA, 1: VGA, 1 byte),
+ * the pixel format (0: RGB565, 1: RGB555, 1 byte) and the frame rate (30, 15 or 5, 1 byte)
+ * The device replies on the control stream (PROTOCOL_FORMAT_CAMERA_MODE) with the first
+ * frame of the new mode, or right away if the mode cannot be set.
+ */
+#define COM_CMD_CAMERA_MODE		58
+
+/**
+ * @def COM_CMD_CAMERA_MODE_SIZE
+ * Size of the parameters following COM_CMD_CAMERA_MODE
+ */
+#define COM_CMD_CAMERA_MODE_SIZE	3
+
+/**
+ * @def COM_CMD_STATUS
+ * State of the device, no parameters
+ * The acknowledgement carries COM_CMD_STATUS_SIZE bytes (little endian):
+ * streaming (1 byte), radar format, camera codec, camera motion, radar batch frames,
+ * camera pixel format, camera frame rate, CFAR input (1 byte each), camera width and height,
+ * radar samples per chirp, chirps and antennas, batch deadline in ms (2 bytes each),
+ * then the counters of the command parser (command_parser_stats_t, 4 bytes each)
+ */
+#define COM_CMD_STATUS			59
+
+/**
+ * @def COM_CMD_STATUS_SIZE
+ * Size of the data acknowledging COM_CMD_STATUS
+ */
+#define COM_CMD_STATUS_SIZE		36
+
+/**
+ * @def COM_CMD_TELEMETRY
+ * Period of the statistics sent on the control stream (PROTOCOL_FORMAT_TELEMETRY, see telemetry.h)
+ * while streaming, followed by the period (ms, 2 bytes little endian, 0: not sent)
+ */
+#define COM_CMD_TELEMETRY		60
+
+/**
+ * @def COM_CMD_TELEMETRY_SIZE
+ * Size of the parameters following COM_CMD_TELEMETRY
+ */
+#define COM_CMD_TELEMETRY_SIZE	2
+
+/**
+ * @def TELEMETRY_PERIOD_MS
+ * Default period of the statistics
+ */
+#define TELEMETRY_PERIOD_MS		1000
+
+/**
+ * @def COM_CMD_TRACE
+ * Profiling probes (trace.h, only if built with TRACE_ENABLED=1), followed by the action (1 byte):
+ * 0 stop recording, 1 clear and start recording, 2 send the events recorded
+ * (control stream, PROTOCOL_FORMAT_TRACE)
+ */
+#define COM_CMD_TRACE			61
+
+/**
+ * @def COM_CMD_TRACE_SIZE
+ * Size of the parameters following COM_CMD_TRACE
+ */
+#define COM_CMD_TRACE_SIZE		1
+
+/**
+ * @def COM_CMD_RADAR_BLOCK
+ * Blocks of chirps read at each data interrupt of the radar, followed by the chirps per block
+ * (2 bytes little endian, dividing the chirps of a frame, 0: whole frames) and the per-chirp
+ * packets (1 byte, 1: each block is sent as soon as read, PROTOCOL_FORMAT_RADAR_CHIRPS,
+ * without range processing nor batching; 0: the blocks are put together into frames)
+ */
+#define COM_CMD_RADAR_BLOCK		62
+
+/**
+ * @def COM_CMD_RADAR_BLOCK_SIZE
+ * Size of the parameters following COM_CMD_RADAR_BLOCK
+ */
+#define COM_CMD_RADAR_BLOCK_SIZE	3
+
+/**
+ * @def COMMAND_RX_SIZE
+ * Bytes of the host read per iteration of the main loop (one full speed packet)
+ */
+#define COMMAND_RX_SIZE			64
+
+/**
+ * @def COMMAND_ACK_COUNT
+ * Acknowledgements being sent at the same time, a command acknowledged when all are busy gets none
+ */
+#define COMMAND_ACK_COUNT		4
+
+/**
+ * @def RADAR_BUFFER_COUNT
+ * Number of radar buffers: a buffer is not reused before its USB transfer is done
+ */
+#define RADAR_BUFFER_COUNT	2
+
+/**
+ * @def RADAR_DATA_ALIGNMENT
+ * Alignment of the radar buffers (cache line size)
+ */
+#define RADAR_DATA_ALIGNMENT	32u
+
+/**
+ * @def RADAR_BLOCK_COUNT
+ * Number of block buffers of the per-chirp packets: a block is not reused before its USB transfer is done
+ */
+#define RADAR_BLOCK_COUNT	8
+
+/**
+ * @def RADAR_CHIRPS_HEADER_SIZE
+ * Size of the header of a block of chirps (PROTOCOL_FORMAT_RADAR_CHIRPS) before its samples
+ */
+#define RADAR_CHIRPS_HEADER_SIZE	8
+
+/**
+ * @def RADAR_DRAIN_TIMEOUT_US
+ * Longest wait for the radar transfers in flight before the radar buffers are resized
+ */
+#define RADAR_DRAIN_TIMEOUT_US	200000
+
+/**
+ * @def RADAR_MAX_DETECTIONS
+ * Maximum number of detections sent per radar frame (the next ones are dropped)
+ */
+#define RADAR_MAX_DETECTIONS	64
+
+/**
+ * @def RADAR_BATCH_MAX_FRAMES
+ * Maximum number of radar frames per batch (PROTOCOL_FORMAT_RADAR_BATCH)
+ */
+#define RADAR_BATCH_MAX_FRAMES	16
+
+/**
+ * @def RADAR_BATCH_BUFFER_COUNT
+ * Number of batch buffers: one is filled while the previous one is sent
+ */
+#define RADAR_BATCH_BUFFER_COUNT	2
+
+/**
+ * @def RADAR_BATCH_BUFFER_SIZE
+ * Size of a batch buffer (at least one frame of the largest format): a batch is sent
+ * before it is full, when the largest frame would not fit anymore
+ */
+#define RADAR_BATCH_BUFFER_SIZE	32768
+
+/**
+ * @def RADAR_BATCH_DEADLINE_MS
+ * Default time between the capture of the first frame of a batch and the submission of the batch
+ */
+#define RADAR_BATCH_DEADLINE_MS	500
+
+/**
+ * @def CAMERA_CHUNK_SIZE
+ * The camera frames are sent in fragments of this size: a radar frame only
+ * waits for the fragments already handed to the USB (SCHEDULER_MAX_IN_FLIGHT)
+ */
+#define CAMERA_CHUNK_SIZE	16384
+
+/**
+ * @def CAMERA_CODEC_BUFFER_COUNT
+ * Number of buffers for the compressed frames: a frame is encoded while the previous one is sent
+ */
+#define CAMERA_CODEC_BUFFER_COUNT	2
+
+/**
+ * @def CAMERA_CODEC_BUFFER_SIZE
+ * Size of a buffer for a compressed frame of frame_size bytes, a frame not fitting is sent raw
+ * (a lossless frame compressed less than 4:3 is not worth the encoding)
+ */
+#define CAMERA_CODEC_BUFFER_SIZE(frame_size)	((frame_size) * 3 / 4)
+
+/**
+ * @def CAMERA_POOL_SECTION
+ * Section of the buffers of the modes larger than QVGA (SoCMEM shared memory):
+ * the buffers of the initial mode are on the heap
+ */
+#ifndef CAMERA_POOL_SECTION
+#define CAMERA_POOL_SECTION		".cy_socmem_data"
+#endif
+
+/**
+ * @def CAMERA_POOL_SIZE
+ * Frame ring, reference frame and codec buffers of the largest mode (VGA)
+ */
+#define CAMERA_POOL_SIZE	(((OV7675_FRAME_RING_DEPTH + 1u) * OV7675_MAX_MEMORY_BUFFER_SIZE) \
+		+ (CAMERA_CODEC_BUFFER_COUNT * CAMERA_CODEC_BUFFER_SIZE(OV7675_MAX_MEMORY_BUFFER_SIZE)))
+
+/**
+ * @def CAMERA_DRAIN_TIMEOUT_US
+ * Longest wait for the camera transfers in flight before the camera mode is switched
+ * (a raw VGA frame takes about 50 ms at USB high speed)
+ */
+#define CAMERA_DRAIN_TIMEOUT_US	200000
+
+/**
+ * @def COMMAND_STATUS_PENDING
+ * Status of a command waiting for a drain, acknowledged later by drain_stage (never sent)
+ */
+#define COMMAND_STATUS_PENDING	1
+
+/**
+ * @def CAMERA_KEYFRAME_INTERVAL
+ * With the motion gating, a full frame is sent at least once every CAMERA_KEYFRAME_INTERVAL frames
+ * (the host recovers from a lost delta frame, the tiles changing slowly are refreshed)
+ */
+#define CAMERA_KEYFRAME_INTERVAL	30
+
+/**
+ * @def CAMERA_TILE_COUNT
+ * Number of tiles compared by the motion gating
+ */
+#define CAMERA_TILE_COUNT	((OV7675_MAX_FRAME_WIDTH / TILE_DELTA_SIZE) * (OV7675_MAX_FRAME_HEIGHT / TILE_DELTA_SIZE))
+
+/**
+ * @def IO_OFFLOAD_ENABLED
+ * 1: the CRC of the large messages in shared memory is computed by the CM33 (ipc/io_ring.h)
+ */
+#ifndef IO_OFFLOAD_ENABLED
+#define IO_OFFLOAD_ENABLED	1
+#endif
+
+/**
+ * @def IO_RING_SECTION
+ * Section of the ring shared with the CM33
+ */
+#define IO_RING_SECTION		".cy_sharedmem"
+
+/**
+ * @def IO_OFFLOAD_MIN_SIZE
+ * Smaller messages are not worth the round trip to the CM33
+ */
+#define IO_OFFLOAD_MIN_SIZE	4096
+
+/**
+ * @def IO_OFFLOAD_TIMEOUT_US
+ * A request not done in time stops the offload, the CRCs are computed by the CM55 again
+ */
+#define IO_OFFLOAD_TIMEOUT_US	100000
+
+/**
+ * @def IO_OFFLOAD_QUEUE_SIZE
+ * Messages waiting for their CRC, or for a message before them in their stream
+ */
+#define IO_OFFLOAD_QUEUE_SIZE	(2 * IO_RING_SIZE)
+
+#if RTOS_ENABLED
+/**
+ * Priorities of the tasks: the sensor tasks first (woken up by their interrupts),
+ * then the USB and the processing of the frames (encoding, range processing)
+ */
+#define RTOS_CAMERA_PRIORITY		(tskIDLE_PRIORITY + 4)
+#define RTOS_RADAR_PRIORITY			(tskIDLE_PRIORITY + 3)
+#define RTOS_USB_PRIORITY			(tskIDLE_PRIORITY + 2)
+#define RTOS_PROCESSING_PRIORITY	(tskIDLE_PRIORITY + 1)
+
+/**
+ * Stacks of the tasks (words)
+ */
+#define RTOS_SENSOR_STACK_SIZE		1024
+#define RTOS_USB_STACK_SIZE			1024
+#define RTOS_PROCESSING_STACK_SIZE	2048
+
+/**
+ * @def RTOS_SENSOR_POLL_MS
+ * The sensor tasks also wake up periodically: frames held while their stream is full,
+ * deadline of the radar batches, readout timeout
+ */
+#define RTOS_SENSOR_POLL_MS			5
+
+/**
+ * @def RTOS_USB_POLL_MS
+ * The USB task waits at most this long for a segment to be sent or a message to be submitted,
+ * the commands of the host are read between the waits
+ */
+#define RTOS_USB_POLL_MS			1
+
+/**
+ * @def RTOS_PIPELINE_DEPTH
+ * Frames waiting for the processing task, at most one per camera frame buffer and radar buffer
+ */
+#define RTOS_PIPELINE_DEPTH			(OV7675_FRAME_RING_DEPTH + RADAR_BUFFER_COUNT)
+
+/**
+ * @def RTOS_MAX_TASKS
+ * Tasks in the load statistics (the ones of the application, idle and the ones of the libraries)
+ */
+#define RTOS_MAX_TASKS				12
+#endif
+
+/**
+ * Motion gating of the camera frames
+ * The frames are compared with the last frame sent (reference)
+ */
+typedef enum
+{
+	CAMERA_MOTION_OFF = 0,			/**< Every frame is sent */
+	CAMERA_MOTION_GATE = 1,			/**< Frames without changed tile are skipped */
+	CAMERA_MOTION_DELTA = 2,		/**< Only the changed tiles are sent (PROTOCOL_FORMAT_RGB565_TILES) */
+} camera_motion_t;
+
+/**
+ * How a camera frame is sent
+ */
+typedef enum
+{
+	CAMERA_SEND_FULL,
+	CAMERA_SEND_SKIP,
+	CAMERA_SEND_DELTA,
+} camera_send_t;
+
+/**
+ * Camera frame acquired and the codec buffer reserved for it, until the frame is processed
+ */
+typedef struct
+{
+	ov7675_frame_t* frame;
+	int codec_index;			/**< -1: no codec buffer free */
+} camera_handle_t;
+
+/**
+ * Statistics of the motion gating (printed when the stream stops)
+ */
+typedef struct
+{
+	uint32_t full;				/**< Keyframes and frames with motion (gate mode) */
+	uint32_t deltas;
+	uint32_t skipped;
+	uint64_t bytes;				/**< Camera payload sent */
+} camera_motion_stats_t;
+
+/**
+ * Compression of the camera frames
+ */
+typedef enum
+{
+	CAMERA_CODEC_RAW = 0,			/**< PROTOCOL_FORMAT_RGB565 */
+	CAMERA_CODEC_JPEG = 1,			/**< PROTOCOL_FORMAT_JPEG */
+	CAMERA_CODEC_LOSSLESS = 2,		/**< PROTOCOL_FORMAT_RGB565_LOSSLESS */
+} camera_codec_t;
+
+/**
+ * Statistics of the compressed camera frames (printed when the stream stops)
+ */
+typedef struct
+{
+	uint32_t frames;
+	uint64_t raw_bytes;
+	uint64_t compressed_bytes;
+	uint64_t cycles;
+	uint64_t pixels;
+} camera_codec_stats_t;
+
+/**
+ * Statistics of the range processing of the radar frames (printed when the stream stops)
+ */
+typedef struct
+{
+	uint32_t frames;
+	uint64_t cycles;
+	uint64_t bytes;				/**< Radar payload sent */
+} radar_range_stats_t;
+
+/**
+ * Message waiting for its CRC from the CM33, or behind such a message in its stream
+ */
+typedef struct
+{
+	scheduler_message_t message;
+	int stream;
+	int slot;					/**< Request of the ring, -1: CRC already set */
+	uint64_t posted_us;
+} io_offload_entry_t;
+
+/**
+ * Statistics of the CRC offload (printed with the telemetry)
+ */
+typedef struct
+{
+	uint32_t offloaded;			/**< Messages whose CRC has been computed by the CM33 */
+	uint32_t local;				/**< Messages in shared memory computed by the CM55 (CM33 not ready or ring full) */
+	uint64_t bytes;				/**< Bytes computed by the CM33 */
+	uint32_t timeouts;
+	telemetry_histogram_t latency;	/**< Post to result (us) */
+} io_offload_stats_t;
+
+/**
+ * Radar frames gathered in one message (PROTOCOL_FORMAT_RADAR_BATCH)
+ */
+typedef struct
+{
+	uint8_t* buffer;			/**< Entry header and payload of each frame */
+	uint32_t size;				/**< Bytes used */
+	uint16_t frames;
+	uint64_t timestamp_us;		/**< Capture time of the first frame */
+	uint16_t frames_sent;		/**< Frames of the batch submitted */
+	bool busy;					/**< Submitted, until sent */
+} radar_batch_t;
+
+/**
+ * Statistics of the batches (printed when the stream stops)
+ */
+typedef struct
+{
+	uint32_t messages;
+	uint32_t frames;
+	uint32_t deadline;			/**< Batches sent on deadline before holding their frames */
+	uint64_t bytes;				/**< Batch payload sent */
+	uint32_t max_wait_us;		/**< Longest time from the capture of a frame to the submission of its batch */
+	uint64_t start_us;			/**< Start of the stream */
+} radar_batch_stats_t;
+
+/**
+ * Input of the detector (PROTOCOL_FORMAT_DETECTIONS), first antenna only
+ */
+typedef enum
+{
+	RADAR_CFAR_MAP = 0,				/**< Range-Doppler map: range and velocity of the targets */
+	RADAR_CFAR_PROFILE = 1,			/**< Range profile (mean magnitude of the chirps): range only */
+} radar_cfar_source_t;
+
+/**
+ * Sensor whose transfers in flight are completed before a pending command is applied (drain_stage)
+ */
+typedef enum
+{
+	DRAIN_NONE = 0,					/**< No command pending */
+	DRAIN_RADAR,					/**< Radar buffers, blocks and batches */
+	DRAIN_CAMERA,					/**< Camera frames and codec buffers */
+} drain_sensor_t;
+
+/**
+ * @def RADAR_LATENCY_BOUND_US
+ * Maximum time between the read of a radar frame and the end of its transfer
+ * (the radar frame time is 100 ms)
+ */
+#define RADAR_LATENCY_BOUND_US	10000
+
+/**
+ * State of main.c used by the other modules
+ */
+extern int radar_stream;
+extern int camera_stream;
+extern int control_stream;
+extern int usb_tx_error;
+extern uint32_t control_sequence;
+extern telemetry_report_t telemetry;
+extern uint32_t telemetry_period_us;
+extern uint64_t telemetry_last_us;
+extern usbd_t* usb_handle;
+extern int send_data;
+extern uint8_t command_rx[COMMAND_RX_SIZE];
+
+/**
+ * State of app_commands.c used by the other modules
+ */
+extern command_parser_t command_parser;
+extern drain_sensor_t drain_sensor;
+extern uint64_t drain_start_us;
+
+/**
+ * State of app_camera.c used by the other modules
+ */
+extern ov7675_mode_t camera_mode;
+extern uint8_t* camera_frames[OV7675_FRAME_RING_DEPTH];
+extern uint8_t* camera_heap_frames[OV7675_FRAME_RING_DEPTH];
+extern uint16_t* camera_heap_reference;
+extern uint8_t* camera_heap_codec_data[CAMERA_CODEC_BUFFER_COUNT];
+extern telemetry_histogram_t camera_crc_us;
+extern camera_codec_t camera_codec;
+extern jpeg_encoder_t camera_jpeg_next;
+extern bool camera_jpeg_pending;
+extern bool camera_codec_busy[CAMERA_CODEC_BUFFER_COUNT];
+extern camera_codec_stats_t camera_codec_stats;
+extern camera_motion_t camera_motion;
+extern uint8_t camera_motion_threshold;
+extern uint32_t camera_keyframe_countdown;
+extern camera_motion_stats_t camera_motion_stats;
+extern uint32_t camera_frames_queued;
+
+/**
+ * State of app_radar.c used by the other modules
+ */
+extern bool radar_busy[RADAR_BUFFER_COUNT];
+extern uint8_t radar_format;
+extern bool radar_range_ready;
+extern radar_range_stats_t radar_range_stats;
+extern cfar_t radar_cfar;
+extern radar_cfar_source_t radar_cfar_source;
+extern uint8_t radar_batch_frames;
+extern uint32_t radar_batch_deadline_us;
+extern uint32_t radar_sequence;
+
+/**
+ * Functions of main.c (documented with their definition)
+ */
+int app_start(void);
+void control_sent_callback(void* context, int status);
+void fill_header(protocol_header_t* header, uint8_t stream, uint8_t format,
+		uint32_t sequence, uint64_t timestamp_us, uint32_t crc);
+int io_offload_submit(int stream, scheduler_message_t* message, bool shared, bool compute_crc);
+void pipeline_print_stats(void);
+void pipeline_stats_reset(void);
+void telemetry_print(void);
+void telemetry_send(void);
+void usb_stage(void);
+
+/**
+ * Functions of app_commands.c (documented with their definition)
+ */
+void command_stage(const uint8_t* rx, uint32_t size, uint64_t rx_us);
+void drain_stage(void);
+
+/**
+ * Functions of app_camera.c (documented with their definition)
+ */
+bool camera_acquire(camera_handle_t* handle);
+void camera_buffers_set(uint32_t frame_size);
+void camera_codec_print_stats(void);
+void camera_deferred_event(void* context, ov7675_deferred_event_t event, uint32_t sequence);
+bool camera_drain_busy(void);
+uint32_t camera_line_crc(uint32_t crc, const uint8_t* line, uint32_t size);
+int32_t camera_mode_apply(const command_t* command, bool drained);
+bool camera_mode_decode(const uint8_t* params, ov7675_mode_t* mode);
+void camera_motion_print_stats(void);
+void camera_process(const camera_handle_t* handle);
+
+/**
+ * Functions of app_radar.c (documented with their definition)
+ */
+int radar_acquire(uint64_t* timestamp_us);
+void radar_batch_print_stats(void);
+void radar_batch_reset(void);
+int32_t radar_block_apply(const command_t* command, bool drained);
+int radar_buffers_alloc(void);
+bool radar_drain_busy(void);
+void radar_drain_start(void);
+void radar_process(int index, uint64_t timestamp_us);
+int32_t radar_profile_apply(const command_t* command, bool drained);
+void radar_range_print_stats(void);
+
+/**
+ * Functions of app_rtos.c (documented with their definition)
+ */
+void pipeline_flush(void);
+void pipeline_lock(void);
+void pipeline_unlock(void);
+#if RTOS_ENABLED
+void rtos_start(void);
+#endif
+
+#endif /* APP_H_ */
@@ -0,0 +1,779 @@
+/*
+ * app_camera.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Camera pipeline: checksum and deferred events of the driver, frames acquired
+ * from the ring, motion gating, compression and capture modes.
+ */
+
+#include "app.h"
+
+/**
+ * Capture mode of the camera and buffers of the mode
+ * (frame ring, reference frame of the motion gating, compressed frames)
+ */
+ov7675_mode_t camera_mode;
+static uint32_t camera_frame_size = OV7675_MEMORY_BUFFER_SIZE;
+uint8_t* camera_frames[OV7675_FRAME_RING_DEPTH] = { NULL };
+uint8_t* camera_heap_frames[OV7675_FRAME_RING_DEPTH] = { NULL };
+uint16_t* camera_heap_reference = NULL;
+uint8_t* camera_heap_codec_data[CAMERA_CODEC_BUFFER_COUNT] = { NULL };
+static uint8_t camera_pool[CAMERA_POOL_SIZE] __attribute__((section(CAMERA_POOL_SECTION), aligned(32)));
+static uint32_t camera_frames_in_flight = 0;
+
+/**
+ * Time spent checksumming the lines of the frame being completed, and per frame
+ * queued (deferred path of the camera interrupt only)
+ */
+static uint32_t camera_crc_cycles = 0;
+telemetry_histogram_t camera_crc_us;
+
+/**
+ * Reply of the mode switch (status, reconfiguration and first frame times),
+ * pending until the first frame of the new mode, busy until sent
+ */
+static uint8_t camera_mode_reply[12];
+static bool camera_mode_pending = false;
+static bool camera_mode_busy = false;
+static int32_t camera_mode_status = 0;
+static uint64_t camera_mode_start_us = 0;
+static uint32_t camera_mode_switch_us = 0;
+
+/**
+ * Compression of the camera frames
+ * The JPEG encoder set by the host is taken by camera_process before the next frame:
+ * the encoder in use is only touched by the processing stage
+ */
+camera_codec_t camera_codec = CAMERA_CODEC_RAW;
+static jpeg_encoder_t camera_jpeg;
+jpeg_encoder_t camera_jpeg_next;
+bool camera_jpeg_pending = false;
+static uint8_t* camera_codec_data[CAMERA_CODEC_BUFFER_COUNT] = { NULL };
+static uint32_t camera_codec_buffer_size = CAMERA_CODEC_BUFFER_SIZE(OV7675_MEMORY_BUFFER_SIZE);
+bool camera_codec_busy[CAMERA_CODEC_BUFFER_COUNT] = { false };
+camera_codec_stats_t camera_codec_stats;
+
+/**
+ * Motion gating of the camera frames
+ */
+camera_motion_t camera_motion = CAMERA_MOTION_OFF;
+uint8_t camera_motion_threshold = 4;
+static uint16_t* camera_reference = NULL;
+static uint8_t camera_tiles_changed[CAMERA_TILE_COUNT];
+uint32_t camera_keyframe_countdown = 0;
+camera_motion_stats_t camera_motion_stats;
+
+/**
+ * Camera frames acquired, not processed yet: each one takes a slot of the camera stream
+ */
+uint32_t camera_frames_queued = 0;
+
+/**
+ * Frame processed without the lock (RTOS, see pipeline_unlock): settings taken before,
+ * buffers reserved for the frame, then results applied to the state once locked again
+ */
+typedef struct
+{
+	camera_codec_t codec;
+	camera_motion_t motion;
+	uint8_t threshold;
+	bool keyframe;				/**< Keyframe due (camera_keyframe_countdown) */
+	ov7675_mode_t mode;
+	uint32_t frame_size;
+	uint8_t* output;			/**< Codec buffer reserved by camera_acquire, NULL if none */
+	uint32_t output_size;
+	uint16_t* reference;
+	camera_send_t send;			/**< How the frame is sent */
+	int32_t size;				/**< Size of the codec buffer sent, raw frame sent if not positive */
+	uint8_t format;				/**< Format of the codec buffer (protocol_format_t) */
+	uint16_t cost;				/**< Encoding cost per pixel (8.8 fixed point) */
+	uint32_t cycles;			/**< Encoding time */
+	bool encoded;				/**< Compressed by the codec */
+	bool delta;					/**< Changed tiles sent */
+	bool reference_set;			/**< Frame copied into the reference (keyframe) */
+} camera_work_t;
+
+/**
+ * @brief Line callback of the camera driver: CRC-32 of the frame, line by line
+ *
+ * @param [in] crc CRC-32 of the previous lines
+ * @param [in] line Line captured
+ * @param [in] size Size of the line
+ * @retval CRC-32 including the line
+ */
+uint32_t camera_line_crc(uint32_t crc, const uint8_t* line, uint32_t size)
+{
+	uint32_t start = timestamp_now();
+
+	crc = crc32_update(crc, line, size);
+	camera_crc_cycles += timestamp_now() - start;
+
+	return crc;
+}
+
+/**
+ * @brief Deferred callback of the camera driver: profiling probes and checksum time of the frames
+ * (a frame taken back by the interrupt passes its time on to the next one if its checksum had not begun)
+ *
+ * @param [in] context Not used
+ * @param [in] event Event of the capture
+ * @param [in] sequence Sequence of the frame
+ */
+void camera_deferred_event(void* context, ov7675_deferred_event_t event, uint32_t sequence)
+{
+	(void)context;
+	(void)sequence;
+
+	switch (event)
+	{
+	case kOV7675_Deferred_Vsync:
+		TRACE_MARK(TRACE_STAGE_ISR_VSYNC, sequence);
+		break;
+	case kOV7675_Deferred_FrameBegin:
+		TRACE_BEGIN(TRACE_STAGE_ISR_CAMERA_CRC, sequence);
+		break;
+	case kOV7675_Deferred_FrameQueued:
+		telemetry_histogram_add(&camera_crc_us, timestamp_cycles_to_us(camera_crc_cycles));
+		camera_crc_cycles = 0;
+		TRACE_END(TRACE_STAGE_ISR_CAMERA_CRC);
+		break;
+	case kOV7675_Deferred_FrameLost:
+		camera_crc_cycles = 0;
+		TRACE_END(TRACE_STAGE_ISR_CAMERA_CRC);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Called once a camera frame has been sent: the frame goes back to the camera driver
+ *
+ * @param [in] context Frame (ov7675_frame_t*)
+ * @param [in] status 0 if the frame has been sent
+ */
+static void frame_sent_callback(void* context, int status)
+{
+	mtb_dvp_cam_ov7675_release((ov7675_frame_t*)context);
+	camera_frames_in_flight--;
+	Cy_GPIO_Write(CYBSP_LED_RGB_GREEN_PORT, CYBSP_LED_RGB_GREEN_PIN, 0);
+
+	if (status != 0)
+	{
+		usb_tx_error = 1;
+		telemetry.counters[TELEMETRY_STREAM_CAMERA][TELEMETRY_DROP_USB]++;
+		return;
+	}
+	telemetry.counters[TELEMETRY_STREAM_CAMERA][TELEMETRY_SENT]++;
+}
+
+/**
+ * @brief Called once a compressed frame has been sent: its buffer can be reused
+ *
+ * @param [in] context Busy flag of the buffer (bool*)
+ * @param [in] status 0 if the frame has been sent
+ */
+static void codec_sent_callback(void* context, int status)
+{
+	*(bool*)context = false;
+	Cy_GPIO_Write(CYBSP_LED_RGB_GREEN_PORT, CYBSP_LED_RGB_GREEN_PIN, 0);
+
+	if (status != 0)
+	{
+		usb_tx_error = 1;
+		telemetry.counters[TELEMETRY_STREAM_CAMERA][TELEMETRY_DROP_USB]++;
+		return;
+	}
+	telemetry.counters[TELEMETRY_STREAM_CAMERA][TELEMETRY_SENT]++;
+}
+
+/**
+ * @brief Get a free buffer for a compressed frame
+ *
+ * @retval Index of the buffer, -1 if compression is disabled or all buffers are being sent
+ */
+static int camera_codec_free_buffer(void)
+{
+	if ((camera_codec == CAMERA_CODEC_RAW) && (camera_motion != CAMERA_MOTION_DELTA))
+	{
+		return -1;
+	}
+
+	for (int i = 0; i < CAMERA_CODEC_BUFFER_COUNT; ++i)
+	{
+		if (!camera_codec_busy[i])
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Compress a camera frame with the selected codec (without the lock)
+ *
+ * @param [in] frame Captured frame
+ * @param [in,out] work Codec, mode and codec buffer of the frame; receives the format,
+ * the CPU cycles per pixel spent compressing the frame (8.8 fixed point) and the time
+ *
+ * @retval Size of the compressed frame, negative if it does not fit (sent raw)
+ */
+static int32_t camera_encode(const ov7675_frame_t* frame, camera_work_t* work)
+{
+	const uint32_t pixels = (uint32_t)work->mode.width * work->mode.height;
+	uint32_t start = timestamp_now();
+	uint64_t cycles_per_pixel = 0;
+	int32_t size = -1;
+
+	if (work->codec == CAMERA_CODEC_JPEG)
+	{
+		work->format = PROTOCOL_FORMAT_JPEG;
+		size = jpeg_encode_rgb565(&camera_jpeg, frame->buffer, work->mode.width, work->mode.height,
+				work->output, work->output_size);
+	}
+	else if (work->codec == CAMERA_CODEC_LOSSLESS)
+	{
+		// Pixels are little endian: the frame buffer is read as uint16_t
+		work->format = PROTOCOL_FORMAT_RGB565_LOSSLESS;
+		size = lossless_encode_rgb565((const uint16_t*)frame->buffer, work->mode.width, work->mode.height,
+				work->output, work->output_size);
+	}
+
+	work->cycles = timestamp_now() - start;
+	work->encoded = true;
+	cycles_per_pixel = ((uint64_t)work->cycles << 8) / pixels;
+	work->cost = (cycles_per_pixel > UINT16_MAX) ? UINT16_MAX : (uint16_t)cycles_per_pixel;
+
+	return size;
+}
+
+/**
+ * @brief Print the compression ratio and the encode cost of the camera frames since the last call
+ */
+void camera_codec_print_stats(void)
+{
+	uint64_t ratio = 0;
+	uint64_t cycles_per_pixel = 0;
+
+	if (camera_codec_stats.frames != 0)
+	{
+		// Hundredths
+		ratio = (camera_codec_stats.raw_bytes * 100) / camera_codec_stats.compressed_bytes;
+		cycles_per_pixel = (camera_codec_stats.cycles * 100)
+				/ camera_codec_stats.pixels;
+	}
+
+	printf("Camera codec %u: %lu frames compressed, ratio %lu.%02lu, %lu.%02lu cycles per pixel \r\n",
+			(unsigned int)camera_codec,
+			(unsigned long)camera_codec_stats.frames,
+			(unsigned long)(ratio / 100), (unsigned long)(ratio % 100),
+			(unsigned long)(cycles_per_pixel / 100), (unsigned long)(cycles_per_pixel % 100));
+	memset(&camera_codec_stats, 0, sizeof(camera_codec_stats));
+}
+
+/**
+ * @brief Decide how a camera frame is sent (without the lock)
+ * Compares the frame with the reference when the motion gating is enabled
+ *
+ * @param [in] frame Captured frame
+ * @param [in] work Motion gating, mode, reference and codec buffer of the frame
+ *
+ * @retval CAMERA_SEND_FULL Keyframe or motion gating disabled
+ * @retval CAMERA_SEND_SKIP No tile changed
+ * @retval CAMERA_SEND_DELTA Some tiles changed (camera_tiles_changed)
+ */
+static camera_send_t camera_motion_select(const ov7675_frame_t* frame, const camera_work_t* work)
+{
+	int32_t changed = 0;
+
+	// The codecs and the motion gating handle RGB565 only
+	if ((work->motion == CAMERA_MOTION_OFF) || work->keyframe || (work->mode.format != kOV7675_RGB565))
+	{
+		return CAMERA_SEND_FULL;
+	}
+
+	// Pixels are little endian: the frame buffer is read as uint16_t
+	TRACE_BEGIN(TRACE_STAGE_CAMERA_MOTION, frame->sequence);
+	changed = tile_delta_detect((const uint16_t*)frame->buffer, work->reference,
+			work->mode.width, work->mode.height, work->threshold, camera_tiles_changed);
+	TRACE_END(TRACE_STAGE_CAMERA_MOTION);
+	if (changed == 0)
+	{
+		return CAMERA_SEND_SKIP;
+	}
+
+	// The tiles need a codec buffer: none if the gating was switched after the frame was taken
+	return ((work->motion == CAMERA_MOTION_DELTA) && (work->output != NULL)) ? CAMERA_SEND_DELTA : CAMERA_SEND_FULL;
+}
+
+/**
+ * @brief Motion gating and compression of a camera frame, run without the lock (RTOS):
+ * only the settings of work, the buffers reserved for the frame, the reference and the
+ * JPEG encoder in use are touched (all of them only by the processing stage)
+ *
+ * @param [in] frame Captured frame
+ * @param [in,out] work Settings of the frame, receives the results
+ */
+static void camera_work(const ov7675_frame_t* frame, camera_work_t* work)
+{
+	work->size = -1;
+	work->format = PROTOCOL_FORMAT_RGB565;
+	work->cost = 0;
+	work->cycles = 0;
+	work->encoded = false;
+	work->delta = false;
+	work->reference_set = false;
+
+	work->send = camera_motion_select(frame, work);
+	if (work->send == CAMERA_SEND_SKIP)
+	{
+		return;
+	}
+
+	if (work->send == CAMERA_SEND_DELTA)
+	{
+		// Updates the reference with the changed tiles, a full frame is sent if they do not fit
+		work->format = PROTOCOL_FORMAT_RGB565_TILES;
+		TRACE_BEGIN(TRACE_STAGE_CAMERA_MOTION, frame->sequence);
+		work->size = tile_delta_encode((const uint16_t*)frame->buffer, work->reference,
+				work->mode.width, work->mode.height, camera_tiles_changed, work->output, work->output_size);
+		TRACE_END(TRACE_STAGE_CAMERA_MOTION);
+		work->delta = (work->size > 0);
+	}
+
+	if ((work->size <= 0) && (work->motion != CAMERA_MOTION_OFF))
+	{
+		// Keyframe: the host shows this frame
+		TRACE_BEGIN(TRACE_STAGE_CAMERA_COPY, frame->sequence);
+		memcpy(work->reference, frame->buffer, work->frame_size);
+		TRACE_END(TRACE_STAGE_CAMERA_COPY);
+		work->reference_set = true;
+	}
+
+	// The delta frames patch exact pixels: no JPEG keyframe under them
+	if ((work->size <= 0) && (work->output != NULL) && (work->codec != CAMERA_CODEC_RAW)
+			&& (work->mode.format == kOV7675_RGB565)
+			&& !((work->motion == CAMERA_MOTION_DELTA) && (work->codec == CAMERA_CODEC_JPEG)))
+	{
+		TRACE_BEGIN(TRACE_STAGE_CAMERA_ENCODE, frame->sequence);
+		work->size = camera_encode(frame, work);
+		TRACE_END(TRACE_STAGE_CAMERA_ENCODE);
+	}
+}
+
+/**
+ * @brief Print the statistics of the motion gating since the last call
+ */
+void camera_motion_print_stats(void)
+{
+	uint32_t frames = camera_motion_stats.full + camera_motion_stats.deltas + camera_motion_stats.skipped;
+	uint64_t percent = 0;
+
+	if (frames != 0)
+	{
+		percent = (camera_motion_stats.bytes * 100) / ((uint64_t)frames * camera_frame_size);
+	}
+
+	printf("Camera motion %u: %lu full, %lu delta, %lu skipped, %lu%% of the raw bandwidth \r\n",
+			(unsigned int)camera_motion,
+			(unsigned long)camera_motion_stats.full,
+			(unsigned long)camera_motion_stats.deltas,
+			(unsigned long)camera_motion_stats.skipped,
+			(unsigned long)percent);
+	memset(&camera_motion_stats, 0, sizeof(camera_motion_stats));
+}
+
+/**
+ * @brief Check whether camera frames or compressed frames are still in flight,
+ * or a frame is being processed (RTOS, without the lock)
+ * camera_acquire takes no new frame meanwhile
+ *
+ * @retval true Still in flight
+ */
+bool camera_drain_busy(void)
+{
+	bool busy = (camera_frames_in_flight != 0) || (camera_frames_queued != 0);
+
+	for (uint32_t i = 0; i < CAMERA_CODEC_BUFFER_COUNT; ++i)
+	{
+		busy = busy || camera_codec_busy[i];
+	}
+
+	return busy;
+}
+
+/**
+ * @brief Select the camera buffers for frames of frame_size bytes:
+ * the heap buffers for the initial mode (QVGA), the shared memory pool for the larger modes
+ *
+ * @param [in] frame_size Size of a frame
+ */
+void camera_buffers_set(uint32_t frame_size)
+{
+	uint8_t* pool = camera_pool;
+
+	camera_frame_size = frame_size;
+	camera_codec_buffer_size = CAMERA_CODEC_BUFFER_SIZE(frame_size);
+
+	if (frame_size <= OV7675_MEMORY_BUFFER_SIZE)
+	{
+		memcpy(camera_frames, camera_heap_frames, sizeof(camera_frames));
+		memcpy(camera_codec_data, camera_heap_codec_data, sizeof(camera_codec_data));
+		camera_reference = camera_heap_reference;
+		return;
+	}
+
+	for (uint32_t i = 0; i < OV7675_FRAME_RING_DEPTH; ++i)
+	{
+		camera_frames[i] = pool;
+		pool += frame_size;
+	}
+	camera_reference = (uint16_t*)pool;
+	pool += frame_size;
+	for (uint32_t i = 0; i < CAMERA_CODEC_BUFFER_COUNT; ++i)
+	{
+		camera_codec_data[i] = pool;
+		pool += camera_codec_buffer_size;
+	}
+}
+
+/**
+ * @brief Send the reply of the camera mode switch (PROTOCOL_FORMAT_CAMERA_MODE)
+ * The dimensions are the active mode (width, height, frame rate)
+ */
+static void camera_mode_reply_send(void)
+{
+	scheduler_message_t message;
+	uint32_t first_frame_us = 0;
+
+	camera_mode_pending = false;
+	if (camera_mode_status == 0)
+	{
+		first_frame_us = (uint32_t)(timestamp_now_us() - camera_mode_start_us);
+		printf("Camera mode: first frame after %lu us \r\n", (unsigned long)first_frame_us);
+	}
+
+	if (camera_mode_busy)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		camera_mode_reply[i] = (uint8_t)((uint32_t)camera_mode_status >> (8 * i));
+		camera_mode_reply[4 + i] = (uint8_t)(camera_mode_switch_us >> (8 * i));
+		camera_mode_reply[8 + i] = (uint8_t)(first_frame_us >> (8 * i));
+	}
+	message.payload = camera_mode_reply;
+	message.size = sizeof(camera_mode_reply);
+	fill_header(&message.header, PROTOCOL_STREAM_CONTROL, PROTOCOL_FORMAT_CAMERA_MODE,
+			control_sequence, timestamp_now_us(), crc32_compute(camera_mode_reply, sizeof(camera_mode_reply)));
+	message.header.dims[0] = camera_mode.width;
+	message.header.dims[1] = camera_mode.height;
+	message.header.dims[2] = camera_mode.fps;
+	message.callback = control_sent_callback;
+	message.context = &camera_mode_busy;
+
+	camera_mode_busy = true;
+	if (scheduler_submit(control_stream, &message) != 0)
+	{
+		camera_mode_busy = false;
+		return;
+	}
+	control_sequence++;
+}
+
+/**
+ * @brief Decode the capture mode of COM_CMD_CAMERA_MODE
+ * The VGA resolution is refused unless the driver is built with OV7675_VGA_MODE_ENABLED=1.
+ *
+ * @param [in] params Parameters of the command (resolution, pixel format and frame rate)
+ * @param [out] mode Capture mode
+ *
+ * @retval true The mode is supported
+ */
+bool camera_mode_decode(const uint8_t* params, ov7675_mode_t* mode)
+{
+	mode->width = (params[0] == 1) ? OV7675_MAX_FRAME_WIDTH : OV7675_FRAME_WIDTH;
+	mode->height = (params[0] == 1) ? OV7675_MAX_FRAME_HEIGHT : OV7675_FRAME_HEIGHT;
+	mode->format = (params[1] == 1) ? kOV7675_RGB555 : kOV7675_RGB565;
+	mode->fps = params[2];
+
+	return !((params[0] > 1) || ((params[0] == 1) && !OV7675_VGA_MODE_ENABLED) || (params[1] > 1)
+			|| ((mode->fps != 30) && (mode->fps != 15) && (mode->fps != 5)));
+}
+
+/**
+ * @brief End of a camera mode switch: a successful switch is replied with the first frame
+ * of the new mode, a failed one right away
+ *
+ * @param [in] status Status of the switch
+ */
+static void camera_mode_done(int32_t status)
+{
+	camera_mode_switch_us = (uint32_t)(timestamp_now_us() - camera_mode_start_us);
+	camera_mode_status = status;
+	printf("Camera mode: status %ld, reconfigured in %lu us \r\n", (long)status,
+			(unsigned long)camera_mode_switch_us);
+
+	camera_mode_pending = true;
+	if (status != 0)
+	{
+		camera_mode_reply_send();
+	}
+}
+
+/**
+ * @brief Switch the camera to another capture mode while streaming (called by drain_stage)
+ * Once the camera transfers in flight are drained, the sensor is reprogrammed (no reset) and
+ * the frame ring restarts with the buffers of the new mode at the next VSYNC.
+ * If the sensor cannot be programmed, the previous mode is restored.
+ * The reply (PROTOCOL_FORMAT_CAMERA_MODE) is sent with the first frame of the new mode.
+ *
+ * @param [in] command Command of the host (checked by camera_mode_command), copied by drain_start
+ * @param [in] drained true if the camera transfers in flight are completed
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_DRAIN_TIMEOUT The transfers in flight cannot be completed, mode kept
+ * @retval COMMAND_STATUS_CONFIG_FAILED The sensor cannot be programmed, previous mode restored
+ */
+int32_t camera_mode_apply(const command_t* command, bool drained)
+{
+	ov7675_mode_t previous = camera_mode;
+	ov7675_mode_t mode;
+	int32_t status = COMMAND_STATUS_OK;
+
+	(void)camera_mode_decode(command->params, &mode);
+	camera_mode_start_us = drain_start_us;
+	if (!drained)
+	{
+		// The camera buffers cannot be changed: the current mode is kept
+		status = COMMAND_STATUS_DRAIN_TIMEOUT;
+	}
+	else
+	{
+		camera_buffers_set((uint32_t)mode.width * mode.height * OV7675_BYTES_PER_PIXEL);
+		if (mtb_dvp_cam_ov7675_set_mode(&mode, camera_frames, OV7675_FRAME_RING_DEPTH) != CY_RSLT_SUCCESS)
+		{
+			// The driver has restored the previous mode and its buffers
+			status = COMMAND_STATUS_CONFIG_FAILED;
+			camera_buffers_set((uint32_t)previous.width * previous.height * OV7675_BYTES_PER_PIXEL);
+		}
+		mtb_dvp_cam_ov7675_get_mode(&camera_mode);
+
+		// The host has no reference frame of the new mode
+		camera_keyframe_countdown = 0;
+		memset(&camera_codec_stats, 0, sizeof(camera_codec_stats));
+		memset(&camera_motion_stats, 0, sizeof(camera_motion_stats));
+	}
+	camera_mode_done(status);
+
+	return status;
+}
+
+/**
+ * @brief Take the next camera frame ready, if it can be sent
+ *
+ * @param [out] handle Frame and codec buffer reserved for it
+ *
+ * @retval true A frame is to be processed (camera_process)
+ */
+bool camera_acquire(camera_handle_t* handle)
+{
+	// While the camera stream (or all codec buffers) is busy the frames stay in the ring
+	// The codec buffer is reserved until the frame is processed
+	handle->frame = NULL;
+	if (drain_sensor == DRAIN_CAMERA)
+	{
+		// No new frame in flight until the mode is switched (drain_stage)
+		return false;
+	}
+	handle->codec_index = camera_codec_free_buffer();
+	if ((send_data == 0)
+			|| ((scheduler_free_slots(camera_stream) > camera_frames_queued)
+					&& (((camera_codec == CAMERA_CODEC_RAW) && (camera_motion != CAMERA_MOTION_DELTA)) || (handle->codec_index >= 0))))
+	{
+		handle->frame = mtb_dvp_cam_ov7675_acquire();
+	}
+	if (handle->frame == NULL)
+	{
+		return false;
+	}
+
+	if (handle->codec_index >= 0)
+	{
+		camera_codec_busy[handle->codec_index] = true;
+	}
+	camera_frames_queued++;
+	return true;
+}
+
+/**
+ * @brief Encode and send a camera frame, or release it
+ * Called with the lock held (RTOS): it is given back while the frame is compared and encoded
+ *
+ * @param [in] handle Frame taken by camera_acquire
+ */
+void camera_process(const camera_handle_t* handle)
+{
+	ov7675_frame_t* frame = handle->frame;
+	int codec_index = handle->codec_index;
+	bool codec_sent = false;
+	camera_work_t work;
+	scheduler_message_t message;
+
+	TRACE_BEGIN(TRACE_STAGE_CAMERA_FRAME, frame->sequence);
+
+	// The buffer is owned by the application until it is released:
+	// the data is sent directly from it
+	if (camera_mode_pending && (frame->status.integrity == kOV7675_Frame_Ok))
+	{
+		camera_mode_reply_send();
+	}
+
+	if (frame->status.integrity != kOV7675_Frame_Ok)
+	{
+		printf("Incomplete frame: %d lines \r\n", frame->status.lines);
+		mtb_dvp_cam_ov7675_release(frame);
+	}
+	else if (send_data == 0)
+	{
+		telemetry.counters[TELEMETRY_STREAM_CAMERA][TELEMETRY_DROP_IDLE]++;
+		mtb_dvp_cam_ov7675_release(frame);
+	}
+	else
+	{
+		// Settings of the frame: the commands can change them while the lock is given back
+		// The mode and the buffers only change once the frame is processed (drain)
+		if (camera_jpeg_pending)
+		{
+			camera_jpeg = camera_jpeg_next;
+			camera_jpeg_pending = false;
+		}
+		work.codec = camera_codec;
+		work.motion = camera_motion;
+		work.threshold = camera_motion_threshold;
+		work.keyframe = (camera_keyframe_countdown == 0);
+		work.mode = camera_mode;
+		work.frame_size = camera_frame_size;
+		work.output = (codec_index >= 0) ? camera_codec_data[codec_index] : NULL;
+		work.output_size = camera_codec_buffer_size;
+		work.reference = camera_reference;
+
+		pipeline_unlock();
+		camera_work(frame, &work);
+		pipeline_lock();
+
+		if (send_data == 0)
+		{
+			// Stopped meanwhile
+			telemetry.counters[TELEMETRY_STREAM_CAMERA][TELEMETRY_DROP_IDLE]++;
+			mtb_dvp_cam_ov7675_release(frame);
+		}
+		else if ((work.send == CAMERA_SEND_SKIP) || (work.delta && (camera_keyframe_countdown == 0)))
+		{
+			// Nothing changed since the last frame sent, or the reference has been reset
+			// meanwhile (the next frame is a keyframe)
+			telemetry.counters[TELEMETRY_STREAM_CAMERA][TELEMETRY_SKIPPED]++;
+			camera_motion_stats.skipped++;
+			if (camera_keyframe_countdown != 0)
+			{
+				camera_keyframe_countdown--;
+			}
+			mtb_dvp_cam_ov7675_release(frame);
+		}
+		else
+		{
+			// The sequence number is the VSYNC counter: the receiver sees the dropped frames
+			// The timestamp has been latched by the VSYNC interrupt at the start of the capture
+			bool compute_crc = false;
+			bool shared = false;
+
+			if (work.delta)
+			{
+				camera_motion_stats.deltas++;
+				camera_keyframe_countdown--;
+			}
+			if (work.reference_set)
+			{
+				camera_motion_stats.full++;
+				camera_keyframe_countdown = CAMERA_KEYFRAME_INTERVAL;
+			}
+			if (work.encoded && (work.size > 0))
+			{
+				camera_codec_stats.frames++;
+				camera_codec_stats.raw_bytes += work.frame_size;
+				camera_codec_stats.compressed_bytes += (uint32_t)work.size;
+				camera_codec_stats.cycles += work.cycles;
+				camera_codec_stats.pixels += (uint32_t)work.mode.width * work.mode.height;
+			}
+
+			if (work.size > 0)
+			{
+				// The frame goes back to the camera right away, the compressed frame is sent
+				// (its CRC is computed on submission)
+				fill_header(&message.header, PROTOCOL_STREAM_CAMERA, work.format,
+						frame->sequence, frame->timestamp_us, 0);
+				message.header.encode_cost = work.cost;
+				mtb_dvp_cam_ov7675_release(frame);
+				message.payload = work.output;
+				message.size = (uint32_t)work.size;
+				message.callback = codec_sent_callback;
+				message.context = &camera_codec_busy[codec_index];
+				codec_sent = true;
+				compute_crc = true;
+			}
+			else
+			{
+				// Raw (compression disabled, RGB555 or frame not fitting in a codec buffer)
+				// The CRC has been computed line by line during the capture
+				fill_header(&message.header, PROTOCOL_STREAM_CAMERA,
+						(work.mode.format == kOV7675_RGB555) ? PROTOCOL_FORMAT_RGB555 : PROTOCOL_FORMAT_RGB565,
+						frame->sequence, frame->timestamp_us, frame->status.crc);
+				message.payload = frame->buffer;
+				message.size = work.frame_size;
+				message.callback = frame_sent_callback;
+				message.context = frame;
+				camera_frames_in_flight++;
+			}
+			message.header.dims[0] = work.mode.width;
+			message.header.dims[1] = work.mode.height;
+			message.header.dims[2] = (message.header.format == PROTOCOL_FORMAT_RGB565_TILES) ? TILE_DELTA_SIZE : 1;
+			camera_motion_stats.bytes += message.size;
+
+			// The buffers of the pool (modes larger than QVGA) are seen by the CM33 as well
+			shared = (message.payload >= camera_pool)
+					&& ((message.payload + message.size) <= &camera_pool[CAMERA_POOL_SIZE]);
+
+			// Send per USB, the frame (or codec buffer) is released once sent
+			Cy_GPIO_Write(CYBSP_LED_RGB_GREEN_PORT, CYBSP_LED_RGB_GREEN_PIN, 1);
+			TRACE_BEGIN(TRACE_STAGE_SUBMIT, frame->sequence);
+			if (io_offload_submit(camera_stream, &message, shared, compute_crc) != 0)
+			{
+				printf("Failed to write OV7675 values over USB\r\n");
+				send_data = 0;
+				// Counted as dropped
+				message.callback(message.context, -1);
+			}
+			TRACE_END(TRACE_STAGE_SUBMIT);
+		}
+	}
+
+	// Reserved by camera_acquire: the codec buffer stays busy while it is sent
+	camera_frames_queued--;
+	if ((codec_index >= 0) && !codec_sent)
+	{
+		camera_codec_busy[codec_index] = false;
+	}
+	TRACE_END(TRACE_STAGE_CAMERA_FRAME);
+}
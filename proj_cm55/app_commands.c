@@ -0,0 +1,789 @@
+/*
+ * app_commands.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Commands of the host: parsed as their bytes arrive, handled and acknowledged
+ * on the control stream. The commands changing the buffers of a sensor wait
+ * for its transfers in flight (drain_stage) while the other stages go on.
+ */
+
+#include "app.h"
+
+/**
+ * Parser of the commands of the host and acknowledgements, busy until sent
+ */
+command_parser_t command_parser;
+static uint8_t command_ack[COMMAND_ACK_COUNT][COMMAND_ACK_SIZE + COM_CMD_STATUS_SIZE];
+static bool command_ack_busy[COMMAND_ACK_COUNT] = { false };
+static uint32_t command_ack_dropped = 0;
+
+/**
+ * Command waiting for the transfers in flight of a sensor (drain_start), with its parameters
+ */
+drain_sensor_t drain_sensor = DRAIN_NONE;
+static command_t drain_command;
+static uint8_t drain_params[COMMAND_MAX_PARAMS];
+uint64_t drain_start_us = 0;
+
+#if TRACE_ENABLED
+/**
+ * Events of the probes sent to the host, busy until sent
+ */
+static uint8_t trace_packet[TRACE_DUMP_SIZE];
+static bool trace_busy = false;
+#endif
+
+/**
+ * Token of the clock synchronization reply, busy until sent
+ */
+static uint8_t time_sync_token[COM_CMD_TIME_SYNC_TOKEN_SIZE];
+static bool time_sync_busy = false;
+
+/**
+ * @brief Set the compression of the camera frames
+ *
+ * @param [in] command Command of the host (codec and quality)
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters
+ * @retval COMMAND_STATUS_INVALID Unknown codec or JPEG quality out of range, the codec in use is kept
+ */
+static int32_t camera_codec_command(const command_t* command)
+{
+	const uint8_t* params = command->params;
+
+	if (command->size != 2)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	printf("Camera codec: %u quality %u \r\n", (unsigned int)params[0], (unsigned int)params[1]);
+	switch (params[0])
+	{
+		case CAMERA_CODEC_JPEG:
+			// The encoder is left unchanged if the quality is refused,
+			// camera_process takes the new one before the next frame
+			if (jpeg_encoder_init(&camera_jpeg_next, params[1]) != 0)
+			{
+				printf("Camera codec: JPEG quality refused, codec %u kept \r\n", (unsigned int)camera_codec);
+				return COMMAND_STATUS_INVALID;
+			}
+			camera_jpeg_pending = true;
+			camera_codec = CAMERA_CODEC_JPEG;
+			break;
+
+		case CAMERA_CODEC_LOSSLESS:
+			camera_codec = CAMERA_CODEC_LOSSLESS;
+			break;
+
+		case CAMERA_CODEC_RAW:
+			camera_codec = CAMERA_CODEC_RAW;
+			break;
+
+		default:
+			printf("Camera codec: unknown, codec %u kept \r\n", (unsigned int)camera_codec);
+			return COMMAND_STATUS_INVALID;
+	}
+	memset(&camera_codec_stats, 0, sizeof(camera_codec_stats));
+
+	return COMMAND_STATUS_OK;
+}
+
+/**
+ * @brief Set the motion gating of the camera frames
+ *
+ * @param [in] command Command of the host (mode and threshold)
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters
+ * @retval COMMAND_STATUS_INVALID Unknown mode, the mode and threshold in use are kept
+ */
+static int32_t camera_motion_command(const command_t* command)
+{
+	const uint8_t* params = command->params;
+
+	if (command->size != 2)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	if (params[0] > CAMERA_MOTION_DELTA)
+	{
+		printf("Camera motion: unknown, mode %u kept \r\n", (unsigned int)camera_motion);
+		return COMMAND_STATUS_INVALID;
+	}
+
+	printf("Camera motion: %u threshold %u \r\n", (unsigned int)params[0], (unsigned int)params[1]);
+	camera_motion = (camera_motion_t)params[0];
+	camera_motion_threshold = params[1];
+	camera_keyframe_countdown = 0;
+	memset(&camera_motion_stats, 0, sizeof(camera_motion_stats));
+
+	return COMMAND_STATUS_OK;
+}
+
+/**
+ * @brief Set the format of the radar frames
+ *
+ * @param [in] command Command of the host (format)
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters
+ * @retval COMMAND_STATUS_INVALID Unknown format, or range format not suiting the shape of the frames
+ * of the radar profile, the format in use is kept
+ */
+static int32_t radar_format_command(const command_t* command)
+{
+	uint8_t format = 0;
+
+	if (command->size != 1)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	format = command->params[0];
+
+	printf("Radar format: %u \r\n", (unsigned int)format);
+	switch (format)
+	{
+		case PROTOCOL_FORMAT_RADAR_U16:
+		case PROTOCOL_FORMAT_RADAR_U12:
+			break;
+
+		case PROTOCOL_FORMAT_RANGE_MAG_U16:
+		case PROTOCOL_FORMAT_RANGE_MAG_F32:
+		case PROTOCOL_FORMAT_RANGE_COMPLEX_I16:
+		case PROTOCOL_FORMAT_RANGE_COMPLEX_F32:
+		case PROTOCOL_FORMAT_RANGE_DOPPLER_U16:
+		case PROTOCOL_FORMAT_DETECTIONS:
+			// The range processing may not suit the shape of the frames of the radar profile
+			if (!radar_range_ready)
+			{
+				printf("Radar format: no range processing for this profile, format %u kept \r\n",
+						(unsigned int)radar_format);
+				return COMMAND_STATUS_INVALID;
+			}
+			break;
+
+		default:
+			printf("Radar format: unknown, format %u kept \r\n", (unsigned int)radar_format);
+			return COMMAND_STATUS_INVALID;
+	}
+	radar_format = format;
+	memset(&radar_range_stats, 0, sizeof(radar_range_stats));
+
+	return COMMAND_STATUS_OK;
+}
+
+/**
+ * @brief Configure the detector of the targets
+ * The previous configuration is kept if the new one is invalid
+ *
+ * @param [in] command Command of the host (input and configuration)
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters
+ * @retval COMMAND_STATUS_INVALID Invalid configuration
+ */
+static int32_t radar_cfar_command(const command_t* command)
+{
+	const uint8_t* params = command->params;
+	cfar_config_t config = { 0 };
+
+	if (command->size != COM_CMD_RADAR_CFAR_SIZE)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	config.mode = params[1];
+	config.guard = params[2];
+	config.training = params[3];
+	config.threshold_db = params[4];
+	config.rank = params[5];
+	printf("Radar CFAR: input %u mode %u guard %u training %u threshold %u dB rank %u \r\n",
+			(unsigned int)params[0], (unsigned int)config.mode, (unsigned int)config.guard,
+			(unsigned int)config.training, (unsigned int)config.threshold_db, (unsigned int)config.rank);
+	if ((params[0] > RADAR_CFAR_PROFILE) || (cfar_init(&radar_cfar, &config) != 0))
+	{
+		printf("Invalid CFAR configuration \r\n");
+		return COMMAND_STATUS_INVALID;
+	}
+	radar_cfar_source = (radar_cfar_source_t)params[0];
+	memset(&radar_range_stats, 0, sizeof(radar_range_stats));
+
+	return COMMAND_STATUS_OK;
+}
+
+/**
+ * @brief Set the batching of the radar frames
+ * The batch pending with the previous setting is sent by radar_batch_poll
+ *
+ * @param [in] command Command of the host (number of frames and deadline)
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters
+ */
+static int32_t radar_batch_command(const command_t* command)
+{
+	const uint8_t* params = command->params;
+	uint32_t deadline_ms = 0;
+
+	if (command->size != COM_CMD_RADAR_BATCH_SIZE)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	deadline_ms = (uint32_t)params[1] | ((uint32_t)params[2] << 8);
+	printf("Radar batch: %u frames, deadline %lu ms \r\n", (unsigned int)params[0], (unsigned long)deadline_ms);
+	radar_batch_frames = (params[0] > RADAR_BATCH_MAX_FRAMES) ? RADAR_BATCH_MAX_FRAMES : ((params[0] == 0) ? 1 : params[0]);
+	radar_batch_deadline_us = ((deadline_ms == 0) ? RADAR_BATCH_DEADLINE_MS : deadline_ms) * 1000u;
+
+	return COMMAND_STATUS_OK;
+}
+
+/**
+ * @brief Defer a command until the transfers in flight of a sensor are completed (drain_stage)
+ * The other stages go on meanwhile: the USB completes the transfers, the other sensor is streamed
+ * and the other commands are handled.
+ *
+ * @param [in] command Command of the host, copied
+ * @param [in] sensor Sensor whose buffers the command changes
+ *
+ * @retval COMMAND_STATUS_PENDING Acknowledged by drain_stage
+ * @retval COMMAND_STATUS_BUSY Another command is waiting for a drain
+ */
+static int32_t drain_start(const command_t* command, drain_sensor_t sensor)
+{
+	if (drain_sensor != DRAIN_NONE)
+	{
+		return COMMAND_STATUS_BUSY;
+	}
+
+	// The parameters are in the parser until the next push
+	drain_command = *command;
+	memcpy(drain_params, command->params, command->size);
+	drain_command.params = drain_params;
+	drain_sensor = sensor;
+	drain_start_us = timestamp_now_us();
+	if (sensor == DRAIN_RADAR)
+	{
+		radar_drain_start();
+	}
+	else
+	{
+		pipeline_flush();
+	}
+
+	return COMMAND_STATUS_PENDING;
+}
+
+/**
+ * @brief Reply to a clock synchronization request
+ * The time is taken when the request is read: the reply goes to the stream of highest priority,
+ * the host keeps the exchanges with the shortest round trip.
+ * A request received while the previous reply is still queued is ignored (the host retries).
+ *
+ * @param [in] command Command of the host (token)
+ * @param [in] now_us Time the bytes of the request have been received
+ *
+ * @retval COMMAND_STATUS_OK Reply queued
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters
+ * @retval COMMAND_STATUS_BUSY Previous reply still queued
+ */
+static int32_t time_sync_reply(const command_t* command, uint64_t now_us)
+{
+	scheduler_message_t message;
+
+	if (command->size != COM_CMD_TIME_SYNC_TOKEN_SIZE)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	if (time_sync_busy)
+	{
+		return COMMAND_STATUS_BUSY;
+	}
+
+	memcpy(time_sync_token, command->params, COM_CMD_TIME_SYNC_TOKEN_SIZE);
+	message.payload = time_sync_token;
+	message.size = COM_CMD_TIME_SYNC_TOKEN_SIZE;
+	fill_header(&message.header, PROTOCOL_STREAM_CONTROL, PROTOCOL_FORMAT_TIME_SYNC,
+			control_sequence, now_us, crc32_compute(time_sync_token, COM_CMD_TIME_SYNC_TOKEN_SIZE));
+	message.callback = control_sent_callback;
+	message.context = &time_sync_busy;
+
+	time_sync_busy = true;
+	if (scheduler_submit(control_stream, &message) != 0)
+	{
+		time_sync_busy = false;
+		return COMMAND_STATUS_BUSY;
+	}
+	control_sequence++;
+
+	return COMMAND_STATUS_OK;
+}
+
+/**
+ * @brief Handle COM_CMD_RADAR_PROFILE: the profile is applied once the radar transfers in flight
+ * are drained (radar_profile_apply)
+ *
+ * @param [in] command Command of the host (profile)
+ *
+ * @retval COMMAND_STATUS_PENDING Acknowledged by drain_stage
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters (acknowledged, no profile reply)
+ * @retval COMMAND_STATUS_BUSY Another switch is pending (acknowledged, no profile reply)
+ */
+static int32_t radar_profile_command(const command_t* command)
+{
+	if ((command->size < COM_CMD_RADAR_PROFILE_SIZE)
+			|| (command->size != (COM_CMD_RADAR_PROFILE_SIZE + 4u * command->params[5])))
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	return drain_start(command, DRAIN_RADAR);
+}
+
+/**
+ * @brief Handle COM_CMD_RADAR_BLOCK: the setting is applied once the radar transfers in flight
+ * are drained (radar_block_apply)
+ *
+ * @param [in] command Command of the host (chirps per block and packets)
+ *
+ * @retval COMMAND_STATUS_PENDING Acknowledged by drain_stage
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters
+ * @retval COMMAND_STATUS_BUSY Another switch is pending
+ */
+static int32_t radar_block_command(const command_t* command)
+{
+	if (command->size != COM_CMD_RADAR_BLOCK_SIZE)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	return drain_start(command, DRAIN_RADAR);
+}
+
+/**
+ * @brief Handle COM_CMD_CAMERA_MODE: a supported mode is applied once the camera transfers
+ * in flight are drained (camera_mode_apply), another one is only acknowledged with its status
+ *
+ * @param [in] command Command of the host (resolution, pixel format and frame rate)
+ *
+ * @retval COMMAND_STATUS_PENDING Acknowledged by drain_stage, then replied by camera_mode_done
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters (acknowledged, no mode reply)
+ * @retval COMMAND_STATUS_INVALID Resolution, pixel format or frame rate refused, mode kept
+ * (acknowledged, no mode reply)
+ * @retval COMMAND_STATUS_BUSY Another switch is pending (acknowledged, no mode reply)
+ */
+static int32_t camera_mode_command(const command_t* command)
+{
+	ov7675_mode_t mode;
+
+	if (command->size != COM_CMD_CAMERA_MODE_SIZE)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	if (!camera_mode_decode(command->params, &mode))
+	{
+		printf("Camera mode: %ux%u, format %u, %u fps refused \r\n", (unsigned int)mode.width,
+				(unsigned int)mode.height, (unsigned int)mode.format, (unsigned int)mode.fps);
+		return COMMAND_STATUS_INVALID;
+	}
+	printf("Camera mode: %ux%u, format %u, %u fps \r\n", (unsigned int)mode.width,
+			(unsigned int)mode.height, (unsigned int)mode.format, (unsigned int)mode.fps);
+
+	return drain_start(command, DRAIN_CAMERA);
+}
+
+/**
+ * @brief Fill the state of the device (data acknowledging COM_CMD_STATUS)
+ *
+ * @param [in] streaming 1 if the data is streamed
+ * @param [out] data State (COM_CMD_STATUS_SIZE bytes)
+ */
+static void device_status_fill(int streaming, uint8_t* data)
+{
+	uint16_t values[6] = { 0 };
+	uint32_t counters[4] = { 0 };
+
+	data[0] = (uint8_t)streaming;
+	data[1] = radar_format;
+	data[2] = (uint8_t)camera_codec;
+	data[3] = (uint8_t)camera_motion;
+	data[4] = radar_batch_frames;
+	data[5] = (uint8_t)camera_mode.format;
+	data[6] = camera_mode.fps;
+	data[7] = (uint8_t)radar_cfar_source;
+
+	values[0] = camera_mode.width;
+	values[1] = camera_mode.height;
+	radar_get_frame_shape(&values[2], &values[3], &values[4]);
+	values[5] = (uint16_t)(radar_batch_deadline_us / 1000u);
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		data[8 + 2 * i] = (uint8_t)values[i];
+		data[9 + 2 * i] = (uint8_t)(values[i] >> 8);
+	}
+
+	counters[0] = command_parser.stats.commands;
+	counters[1] = command_parser.stats.crc_errors;
+	counters[2] = command_parser.stats.size_errors;
+	counters[3] = command_parser.stats.skipped_bytes;
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		for (uint32_t j = 0; j < 4; ++j)
+		{
+			data[20 + 4 * i + j] = (uint8_t)(counters[i] >> (8 * j));
+		}
+	}
+}
+
+/**
+ * @brief Acknowledge a command of the host (control stream, PROTOCOL_FORMAT_COMMAND_ACK)
+ * Not sent if all the acknowledgements are busy: the host times out
+ *
+ * @param [in] command Command acknowledged
+ * @param [in] status Status of the command
+ * @param [in] data Data of the acknowledgement (NULL: none)
+ * @param [in] size Size of the data (at most COM_CMD_STATUS_SIZE)
+ */
+static void command_ack_send(const command_t* command, int32_t status, const uint8_t* data, uint32_t size)
+{
+	scheduler_message_t message;
+	int index = -1;
+
+	for (int i = 0; i < COMMAND_ACK_COUNT; ++i)
+	{
+		if (!command_ack_busy[i])
+		{
+			index = i;
+			break;
+		}
+	}
+	if (index < 0)
+	{
+		command_ack_dropped++;
+		return;
+	}
+
+	message.size = command_encode_ack(command, status, command_ack[index]);
+	if (data != NULL)
+	{
+		memcpy(&command_ack[index][message.size], data, size);
+		message.size += size;
+	}
+	message.payload = command_ack[index];
+	fill_header(&message.header, PROTOCOL_STREAM_CONTROL, PROTOCOL_FORMAT_COMMAND_ACK,
+			control_sequence, timestamp_now_us(), crc32_compute(command_ack[index], message.size));
+	message.callback = control_sent_callback;
+	message.context = &command_ack_busy[index];
+
+	command_ack_busy[index] = true;
+	if (scheduler_submit(control_stream, &message) != 0)
+	{
+		command_ack_busy[index] = false;
+		command_ack_dropped++;
+		return;
+	}
+	control_sequence++;
+}
+
+/**
+ * @brief Set the period of the statistics
+ *
+ * @param [in] command Command of the host (period)
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters
+ */
+static int32_t telemetry_command(const command_t* command)
+{
+	uint32_t period_ms = 0;
+
+	if (command->size != COM_CMD_TELEMETRY_SIZE)
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	period_ms = (uint32_t)command->params[0] | ((uint32_t)command->params[1] << 8);
+	printf("Telemetry: every %lu ms \r\n", (unsigned long)period_ms);
+	telemetry_period_us = period_ms * 1000u;
+
+	return COMMAND_STATUS_OK;
+}
+
+#if TRACE_ENABLED
+/**
+ * @brief Start or stop the recording of the probes, or send the events recorded
+ *
+ * @param [in] command Command of the host (action)
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_PARAM Wrong size of the parameters or unknown action
+ * @retval COMMAND_STATUS_BUSY The previous events are being sent
+ */
+static int32_t trace_command(const command_t* command)
+{
+	scheduler_message_t message;
+	uint64_t now_us = 0;
+
+	if ((command->size != COM_CMD_TRACE_SIZE) || (command->params[0] > 2))
+	{
+		return COMMAND_STATUS_PARAM;
+	}
+
+	if (command->params[0] == 0)
+	{
+		trace_stop();
+		return COMMAND_STATUS_OK;
+	}
+	if (command->params[0] == 1)
+	{
+		trace_start();
+		return COMMAND_STATUS_OK;
+	}
+
+	if (trace_busy)
+	{
+		return COMMAND_STATUS_BUSY;
+	}
+
+	// The cycle counter of the dump is read right after the timestamp
+	now_us = timestamp_now_us();
+	message.size = trace_dump(trace_packet);
+	message.payload = trace_packet;
+	fill_header(&message.header, PROTOCOL_STREAM_CONTROL, PROTOCOL_FORMAT_TRACE,
+			control_sequence, now_us, crc32_compute(trace_packet, message.size));
+	message.header.dims[0] = (uint16_t)((message.size - TRACE_DUMP_HEADER_SIZE) / TRACE_EVENT_SIZE);
+	message.header.dims[1] = TRACE_STAGE_COUNT;
+	message.callback = control_sent_callback;
+	message.context = &trace_busy;
+
+	trace_busy = true;
+	if (scheduler_submit(control_stream, &message) != 0)
+	{
+		trace_busy = false;
+		return COMMAND_STATUS_BUSY;
+	}
+	control_sequence++;
+
+	return COMMAND_STATUS_OK;
+}
+#endif
+
+/**
+ * @brief Apply the pending command once the transfers in flight of its sensor are completed,
+ * or once RADAR_DRAIN_TIMEOUT_US / CAMERA_DRAIN_TIMEOUT_US have elapsed, and acknowledge it
+ * Checked after every progress of the USB transfers: no stage waits for the drain.
+ */
+void drain_stage(void)
+{
+	bool busy = false;
+	uint32_t timeout_us = 0;
+	int32_t status = COMMAND_STATUS_OK;
+
+	if (drain_sensor == DRAIN_NONE)
+	{
+		return;
+	}
+
+	if (drain_sensor == DRAIN_RADAR)
+	{
+		busy = radar_drain_busy();
+		timeout_us = RADAR_DRAIN_TIMEOUT_US;
+	}
+	else
+	{
+		busy = camera_drain_busy();
+		timeout_us = CAMERA_DRAIN_TIMEOUT_US;
+	}
+	if (busy && ((timestamp_now_us() - drain_start_us) <= timeout_us))
+	{
+		return;
+	}
+
+	switch (drain_command.id)
+	{
+		case COM_CMD_RADAR_PROFILE:
+			status = radar_profile_apply(&drain_command, !busy);
+			break;
+
+		case COM_CMD_RADAR_BLOCK:
+			status = radar_block_apply(&drain_command, !busy);
+			break;
+
+		default:
+			status = camera_mode_apply(&drain_command, !busy);
+			break;
+	}
+	drain_sensor = DRAIN_NONE;
+	command_ack_send(&drain_command, status, NULL, 0);
+}
+
+/**
+ * @brief Handle the commands of the host and send the statistics
+ *
+ * @param [in] rx Bytes received from the host (can be none)
+ * @param [in] size Number of bytes
+ * @param [in] rx_us Time the bytes have been read
+ */
+void command_stage(const uint8_t* rx, uint32_t size, uint64_t rx_us)
+{
+	uint32_t consumed = 0;
+	uint32_t used = 0;
+	command_t command;
+	uint8_t device_status[COM_CMD_STATUS_SIZE];
+	ov7675_ring_stats_t ring_stats;
+	usbd_tx_stats_t usb_stats;
+	scheduler_stream_stats_t stream_stats;
+
+	// The commands are parsed as their bytes arrive: a command split over several packets
+	// does not hold the acquisition, several commands in a packet are all handled
+	TRACE_BEGIN(TRACE_STAGE_COMMANDS, 0);
+	while (command_parser_push(&command_parser, &rx[used], size - used, &consumed, &command) == 1)
+	{
+		int32_t status = COMMAND_STATUS_OK;
+		uint32_t data_size = 0;
+
+		used += consumed;
+		switch (command.id)
+		{
+			case COM_CMD_TIME_SYNC:
+				// Not printed: the host sends it periodically
+				status = time_sync_reply(&command, rx_us);
+				break;
+
+			case COM_CMD_CAMERA_CODEC:
+				status = camera_codec_command(&command);
+				break;
+
+			case COM_CMD_CAMERA_MOTION:
+				status = camera_motion_command(&command);
+				break;
+
+			case COM_CMD_RADAR_FORMAT:
+				status = radar_format_command(&command);
+				break;
+
+			case COM_CMD_RADAR_CFAR:
+				status = radar_cfar_command(&command);
+				break;
+
+			case COM_CMD_RADAR_BATCH:
+				status = radar_batch_command(&command);
+				break;
+
+			case COM_CMD_RADAR_PROFILE:
+				status = radar_profile_command(&command);
+				break;
+
+			case COM_CMD_CAMERA_MODE:
+				status = camera_mode_command(&command);
+				break;
+
+			case COM_CMD_TELEMETRY:
+				status = telemetry_command(&command);
+				break;
+
+			case COM_CMD_RADAR_BLOCK:
+				status = radar_block_command(&command);
+				break;
+
+#if TRACE_ENABLED
+			case COM_CMD_TRACE:
+				status = trace_command(&command);
+				break;
+#endif
+
+			case COM_CMD_STATUS:
+				device_status_fill(send_data, device_status);
+				data_size = COM_CMD_STATUS_SIZE;
+				break;
+
+			case COM_CMD_START_STREAM:
+				printf("Received command: %d \r\n", command.id);
+				send_data = 1;
+				radar_sequence = 0;
+				radar_batch_reset();
+				telemetry_last_us = timestamp_now_us();
+				// The host has no reference frame yet
+				camera_keyframe_countdown = 0;
+				pipeline_stats_reset();
+				break;
+
+			case COM_CMD_STOP_STREAM:
+				printf("Received command: %d \r\n", command.id);
+				send_data = 0;
+
+				mtb_dvp_cam_ov7675_get_stats(&ring_stats);
+				printf("Frames: %lu captured, %lu dropped (oldest), %lu dropped (newest), %lu CRC late \r\n",
+						(unsigned long)ring_stats.frames_captured,
+						(unsigned long)ring_stats.dropped_oldest,
+						(unsigned long)ring_stats.dropped_newest,
+						(unsigned long)ring_stats.crc_late);
+
+				usbd_tx_get_stats(usb_handle, &usb_stats);
+				printf("USB: %lu sent, %lu failed, max depth %lu, latency %lu us (max %lu us) \r\n",
+						(unsigned long)usb_stats.completed,
+						(unsigned long)usb_stats.failed,
+						(unsigned long)usb_stats.max_depth,
+						(unsigned long)usb_stats.last_latency_us,
+						(unsigned long)usb_stats.max_latency_us);
+
+				scheduler_get_stats(radar_stream, &stream_stats);
+				printf("Radar stream: %lu sent, latency max %lu us, bound %lu us met %lu missed %lu \r\n",
+						(unsigned long)stream_stats.messages,
+						(unsigned long)stream_stats.max_latency_us,
+						(unsigned long)RADAR_LATENCY_BOUND_US,
+						(unsigned long)stream_stats.bound_met,
+						(unsigned long)stream_stats.bound_missed);
+
+				printf("Commands: %lu received, %lu CRC errors, %lu size errors, %lu bytes skipped, %lu not acknowledged \r\n",
+						(unsigned long)command_parser.stats.commands,
+						(unsigned long)command_parser.stats.crc_errors,
+						(unsigned long)command_parser.stats.size_errors,
+						(unsigned long)command_parser.stats.skipped_bytes,
+						(unsigned long)command_ack_dropped);
+
+				telemetry_print();
+
+				camera_codec_print_stats();
+				camera_motion_print_stats();
+				radar_range_print_stats();
+				radar_batch_print_stats();
+				pipeline_print_stats();
+				break;
+
+			default:
+				printf("Unknown command: %d \r\n", command.id);
+				status = COMMAND_STATUS_UNKNOWN;
+				break;
+		}
+
+		// The parameters are in the parser until the next push
+		if (status != COMMAND_STATUS_PENDING)
+		{
+			command_ack_send(&command, status, (data_size != 0) ? device_status : NULL, data_size);
+		}
+	}
+	TRACE_END(TRACE_STAGE_COMMANDS);
+
+	// Statistics, in-band with the data
+	if ((send_data == 1) && (telemetry_period_us != 0)
+			&& ((timestamp_now_us() - telemetry_last_us) >= telemetry_period_us))
+	{
+		telemetry_last_us = timestamp_now_us();
+		telemetry_send();
+	}
+}
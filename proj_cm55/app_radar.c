@@ -0,0 +1,1102 @@
+/*
+ * app_radar.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Radar pipeline: readout of the FIFO (whole frames or blocks of chirps), range
+ * processing and detection, batches of frames and register profiles.
+ */
+
+#include "app.h"
+
+/**
+ * Radar buffers (samples of a frame), sized for the current radar profile
+ */
+static uint16_t* radar_data[RADAR_BUFFER_COUNT] = { NULL };
+static uint16_t radar_num_samples = 0;
+static size_t radar_data_size = 0;
+
+/**
+ * Radar buffers waiting for their USB transfer
+ */
+bool radar_busy[RADAR_BUFFER_COUNT] = { false };
+
+/**
+ * Radar buffer (block buffer of the per-chirp packets) being filled from the FIFO (radar_read_start),
+ * -1 if none, and position of the block in its frame
+ */
+static int radar_read_index = -1;
+static uint16_t radar_read_block = 0;
+
+/**
+ * Blocks of chirps read at each data interrupt (radar_set_block)
+ * Without per-chirp packets, the blocks are read in place into the radar buffer of their frame
+ * (radar_frame_index); with them, each block goes into the next block buffer and is sent right away
+ * (the samples follow the header, RADAR_DATA_ALIGNMENT bytes into the buffer)
+ */
+static uint16_t radar_block_chirps = 0;
+static uint16_t radar_block_samples = 0;
+static uint16_t radar_blocks_per_frame = 1;
+static int radar_frame_index = -1;
+static bool radar_block_packets = false;
+static uint8_t* radar_block_data[RADAR_BLOCK_COUNT] = { NULL };
+static bool radar_block_busy[RADAR_BLOCK_COUNT] = { false };
+static bool radar_block_last[RADAR_BLOCK_COUNT] = { false };		/**< Last block of its frame */
+static uint32_t radar_block_next = 0;
+static uint32_t radar_block_frame = 0;								/**< Frame number of the blocks sent */
+
+/**
+ * Format of the radar samples sent (protocol_format_t)
+ */
+uint8_t radar_format = PROTOCOL_FORMAT_RADAR_U16;
+
+/**
+ * Range processing of the radar frames (PROTOCOL_FORMAT_RANGE_xxx)
+ * The bins of a frame are written in the range buffer of its radar buffer,
+ * which is the work matrix of the range-Doppler map (the map replaces the samples)
+ */
+static range_doppler_t radar_range;
+bool radar_range_ready = false;			/**< The shape of the frames suits the range processing */
+static uint8_t* radar_range_data[RADAR_BUFFER_COUNT] = { NULL };
+static uint32_t radar_range_data_size = 0;
+radar_range_stats_t radar_range_stats;
+
+/**
+ * Detector of the targets (PROTOCOL_FORMAT_DETECTIONS)
+ */
+cfar_t radar_cfar;
+radar_cfar_source_t radar_cfar_source = RADAR_CFAR_MAP;
+static cfar_detection_t radar_detections[RADAR_MAX_DETECTIONS];
+
+/**
+ * Batching of the radar frames, 1 frame: no batching
+ * The frames are copied in the current batch, their radar buffers are free right away
+ */
+static radar_batch_t radar_batch[RADAR_BATCH_BUFFER_COUNT];
+static uint32_t radar_batch_buffer_size = 0;
+static uint32_t radar_batch_current = 0;
+uint8_t radar_batch_frames = 1;
+uint32_t radar_batch_deadline_us = RADAR_BATCH_DEADLINE_MS * 1000u;
+static uint32_t radar_frame_max_size = 0;
+static radar_batch_stats_t radar_batch_stats;
+
+/**
+ * Registers of the profile received from the host (COM_CMD_RADAR_PROFILE)
+ * and reply (status and switch time), busy until sent
+ */
+static uint32_t radar_profile_registers[RADAR_MAX_REGISTERS];
+static uint8_t radar_profile_reply[8];
+static bool radar_profile_busy = false;
+
+/**
+ * Sequence number of the radar messages and capture time of the frame being read
+ */
+uint32_t radar_sequence = 0;
+static uint64_t radar_timestamp = 0;			/**< Latched by the radar interrupt */
+
+/**
+ * @brief Detect the targets of the first antenna of a radar frame
+ *
+ * @param [in,out] samples Radar frame, replaced by the range-Doppler map (RADAR_CFAR_MAP)
+ * @param [in] num_samples Number of samples of the frame
+ * @param [out] range_data Work buffer, receives the list of detections (radar_range_data_size bytes)
+ * @param [in] cfar Detector (radar_cfar when the frame was taken)
+ * @param [in] source Input of the detector (radar_cfar_source when the frame was taken)
+ * @param [out] dims Detections, range bins, Doppler bins (1 for the range profile)
+ *
+ * @retval Size of the list of detections, negative on error
+ */
+static int32_t radar_detect(uint16_t* samples, uint16_t num_samples, uint8_t* range_data,
+		const cfar_t* cfar, radar_cfar_source_t source, uint16_t* dims)
+{
+	const uint32_t bins = radar_range.range.bins;
+	const uint32_t chirps = radar_range.chirps;
+	int32_t count = 0;
+
+	if (source == RADAR_CFAR_PROFILE)
+	{
+		// Non coherent integration of the chirps: the profile replaces the bins of the first chirp
+		uint16_t* magnitudes = (uint16_t*)range_data;
+		int32_t size = range_fft_process(&radar_range.range, samples, chirps, RANGE_FFT_OUTPUT_MAG_U16,
+				range_data, radar_range_data_size);
+
+		if (size < 0)
+		{
+			return size;
+		}
+		for (uint32_t k = 0; k < bins; ++k)
+		{
+			uint32_t sum = 0;
+
+			for (uint32_t c = 0; c < chirps; ++c)
+			{
+				sum += magnitudes[(c * bins) + k];
+			}
+			magnitudes[k] = (uint16_t)((sum + (chirps / 2u)) / chirps);
+		}
+		count = cfar_detect(cfar, magnitudes, (uint16_t)bins, 1, radar_detections, RADAR_MAX_DETECTIONS);
+		dims[2] = 1;
+	}
+	else
+	{
+		int32_t size = range_doppler_process(&radar_range, samples, (float*)range_data, radar_range_data_size,
+				samples, (uint32_t)num_samples * sizeof(uint16_t));
+
+		if (size < 0)
+		{
+			return size;
+		}
+		count = cfar_detect(cfar, samples, (uint16_t)bins, (uint16_t)chirps,
+				radar_detections, RADAR_MAX_DETECTIONS);
+		dims[2] = (uint16_t)chirps;
+	}
+
+	if (count < 0)
+	{
+		return count;
+	}
+
+	// The detections have been copied: the work buffer is free
+	dims[0] = (uint16_t)count;
+	dims[1] = (uint16_t)bins;
+	return (int32_t)cfar_encode(radar_detections, (uint32_t)count, range_data);
+}
+
+/**
+ * @brief Compute the range bins, the range-Doppler maps or the detections of a radar frame
+ * The frame is processed as antennas blocks of chirps of samples per chirp
+ * Runs without the lock (RTOS): the settings are the ones taken with the frame
+ *
+ * @param [in,out] samples Radar frame, replaced by the maps (PROTOCOL_FORMAT_RANGE_DOPPLER_U16)
+ * @param [in] num_samples Number of samples of the frame
+ * @param [out] range_data Range bins, detections or work matrix of the maps (radar_range_data_size bytes)
+ * @param [in] format Format of the payload (PROTOCOL_FORMAT_RANGE_xxx or PROTOCOL_FORMAT_DETECTIONS)
+ * @param [in] cfar Detector (PROTOCOL_FORMAT_DETECTIONS)
+ * @param [in] source Input of the detector (PROTOCOL_FORMAT_DETECTIONS)
+ * @param [out] payload Range bins, maps or detections
+ * @param [in,out] dims Dimensions of the frame (samples per chirp, chirps, antennas), replaced by the ones of the payload
+ * @param [out] cost CPU cycles per sample spent computing the payload (8.8 fixed point)
+ * @param [out] cycles CPU cycles spent computing the payload
+ *
+ * @retval Size of the payload (0: no detection), negative on error
+ */
+static int32_t radar_range_process(uint16_t* samples, uint16_t num_samples, uint8_t* range_data,
+		uint8_t format, const cfar_t* cfar, radar_cfar_source_t source,
+		const uint8_t** payload, uint16_t* dims, uint16_t* cost, uint32_t* cycles)
+{
+	const uint32_t chirps = num_samples / radar_range.range.size;
+	uint32_t start = timestamp_now();
+	uint64_t cycles_per_sample = 0;
+	int32_t size = 0;
+
+	if (format == PROTOCOL_FORMAT_RANGE_DOPPLER_U16)
+	{
+		// The map of an antenna is half the size of its samples: it does not reach the samples not read yet
+		const uint32_t map_samples = range_doppler_map_size(&radar_range) / sizeof(uint16_t);
+
+		*payload = (uint8_t*)samples;
+		for (uint32_t antenna = 0; (antenna < (chirps / radar_range.chirps)) && (size >= 0); ++antenna)
+		{
+			int32_t map_size = range_doppler_process(&radar_range,
+					&samples[antenna * radar_range.chirps * radar_range.range.size],
+					(float*)range_data, radar_range_data_size,
+					&samples[antenna * map_samples], (uint32_t)(num_samples - (antenna * map_samples)) * sizeof(uint16_t));
+
+			size = (map_size < 0) ? map_size : (size + map_size);
+		}
+		// Doppler bins, range bins, antennas
+		dims[1] = radar_range.range.bins;
+		dims[0] = radar_range.chirps;
+	}
+	else if (format == PROTOCOL_FORMAT_DETECTIONS)
+	{
+		*payload = range_data;
+		size = radar_detect(samples, num_samples, range_data, cfar, source, dims);
+	}
+	else
+	{
+		*payload = range_data;
+		size = range_fft_process(&radar_range.range, samples, chirps,
+				(range_fft_output_t)(format - PROTOCOL_FORMAT_RANGE_MAG_U16), range_data, radar_range_data_size);
+		dims[0] = radar_range.range.bins;
+	}
+
+	*cycles = timestamp_now() - start;
+	cycles_per_sample = ((uint64_t)*cycles << 8) / num_samples;
+	*cost = (cycles_per_sample > UINT16_MAX) ? UINT16_MAX : (uint16_t)cycles_per_sample;
+
+	return size;
+}
+
+/**
+ * @brief Print the cost of the range processing since the last call
+ */
+void radar_range_print_stats(void)
+{
+	uint64_t cycles_per_frame = 0;
+	uint64_t bytes_per_frame = 0;
+
+	if (radar_range_stats.frames != 0)
+	{
+		cycles_per_frame = radar_range_stats.cycles / radar_range_stats.frames;
+		bytes_per_frame = radar_range_stats.bytes / radar_range_stats.frames;
+	}
+
+	printf("Radar format %u: %lu frames processed, %lu cycles per frame, %lu bytes per frame \r\n",
+			(unsigned int)radar_format,
+			(unsigned long)radar_range_stats.frames,
+			(unsigned long)cycles_per_frame,
+			(unsigned long)bytes_per_frame);
+	memset(&radar_range_stats, 0, sizeof(radar_range_stats));
+}
+
+/**
+ * @brief Called once a radar frame has been sent: the radar buffer can be reused
+ *
+ * @param [in] context Busy flag of the radar buffer (bool*)
+ * @param [in] status 0 if the frame has been sent
+ */
+static void radar_sent_callback(void* context, int status)
+{
+	*(bool*)context = false;
+	Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 0);
+
+	if (status != 0)
+	{
+		usb_tx_error = 1;
+		telemetry.counters[TELEMETRY_STREAM_RADAR][TELEMETRY_DROP_USB]++;
+		return;
+	}
+	telemetry.counters[TELEMETRY_STREAM_RADAR][TELEMETRY_SENT]++;
+}
+
+/**
+ * @brief Called once a block of chirps has been sent: the block buffer can be reused
+ * A frame is counted with its last block
+ *
+ * @param [in] context Busy flag of the block buffer (bool*)
+ * @param [in] status 0 if the block has been sent
+ */
+static void radar_block_sent_callback(void* context, int status)
+{
+	bool* busy = (bool*)context;
+	bool last = radar_block_last[busy - radar_block_busy];
+
+	*busy = false;
+	Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 0);
+
+	if (status != 0)
+	{
+		usb_tx_error = 1;
+	}
+	if (last)
+	{
+		telemetry.counters[TELEMETRY_STREAM_RADAR][(status != 0) ? TELEMETRY_DROP_USB : TELEMETRY_SENT]++;
+	}
+}
+
+/**
+ * @brief Send a block of chirps read into a block buffer (PROTOCOL_FORMAT_RADAR_CHIRPS),
+ * the buffer is busy until sent
+ *
+ * @param [in] slot Block buffer
+ * @param [in] block Position of the block in its frame
+ * @param [in] sequence Sequence number of the message
+ * @param [in] timestamp_us Capture time of the block
+ *
+ * @retval 0 Success
+ * @retval -1 Cannot submit the message
+ */
+static int radar_block_send(uint32_t slot, uint16_t block, uint32_t sequence, uint64_t timestamp_us)
+{
+	scheduler_message_t message;
+	uint8_t* payload = &radar_block_data[slot][RADAR_DATA_ALIGNMENT - RADAR_CHIRPS_HEADER_SIZE];
+	uint16_t first_chirp = (uint16_t)(block * radar_block_chirps);
+	uint16_t shape[3] = { 0 };
+
+	radar_get_frame_shape(&shape[0], &shape[1], &shape[2]);
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		payload[i] = (uint8_t)(radar_block_frame >> (8 * i));
+	}
+	payload[4] = (uint8_t)first_chirp;
+	payload[5] = (uint8_t)(first_chirp >> 8);
+	payload[6] = (uint8_t)shape[1];
+	payload[7] = (uint8_t)(shape[1] >> 8);
+
+	message.payload = payload;
+	message.size = RADAR_CHIRPS_HEADER_SIZE + (radar_block_samples * sizeof(uint16_t));
+	TRACE_BEGIN(TRACE_STAGE_CRC, sequence);
+	fill_header(&message.header, PROTOCOL_STREAM_RADAR, PROTOCOL_FORMAT_RADAR_CHIRPS,
+			sequence, timestamp_us, crc32_compute(message.payload, message.size));
+	TRACE_END(TRACE_STAGE_CRC);
+	message.header.dims[0] = shape[0];
+	message.header.dims[1] = radar_block_chirps;
+	message.header.dims[2] = shape[2];
+	message.callback = radar_block_sent_callback;
+	message.context = &radar_block_busy[slot];
+
+	radar_block_last[slot] = (block == (radar_blocks_per_frame - 1u));
+	radar_block_busy[slot] = true;
+	Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 1);
+	if (scheduler_submit(radar_stream, &message) != 0)
+	{
+		radar_block_busy[slot] = false;
+		Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 0);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Called once a batch of radar frames has been sent: the batch buffer can be reused
+ *
+ * @param [in] context Batch (radar_batch_t*)
+ * @param [in] status 0 if the batch has been sent
+ */
+static void radar_batch_sent_callback(void* context, int status)
+{
+	radar_batch_t* batch = (radar_batch_t*)context;
+
+	batch->busy = false;
+	Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 0);
+
+	if (status != 0)
+	{
+		usb_tx_error = 1;
+		telemetry.counters[TELEMETRY_STREAM_RADAR][TELEMETRY_DROP_USB] += batch->frames_sent;
+		return;
+	}
+	telemetry.counters[TELEMETRY_STREAM_RADAR][TELEMETRY_SENT] += batch->frames_sent;
+}
+
+/**
+ * @brief Check that the radar stream can take the next frame
+ * (a free batch buffer when batching, no batch pending otherwise)
+ *
+ * @retval true A frame can be read and sent
+ */
+static bool radar_batch_ready(void)
+{
+	const radar_batch_t* batch = &radar_batch[radar_batch_current];
+
+	if (scheduler_free_slots(radar_stream) == 0)
+	{
+		return false;
+	}
+
+	return (radar_batch_frames > 1) ? !batch->busy : (batch->frames == 0);
+}
+
+/**
+ * @brief Copy a radar frame at the end of the current batch
+ * radar_batch_ready must have been checked: there is room for the largest frame
+ *
+ * @param [in] frame Frame (payload, size, format, timestamp, dimensions and cost of its header)
+ */
+static void radar_batch_add(const scheduler_message_t* frame)
+{
+	radar_batch_t* batch = &radar_batch[radar_batch_current];
+	protocol_batch_entry_t entry = { 0 };
+
+	if (batch->frames == 0)
+	{
+		batch->timestamp_us = frame->header.timestamp_us;
+	}
+
+	entry.size = frame->size;
+	entry.timestamp_offset_us = (uint32_t)(frame->header.timestamp_us - batch->timestamp_us);
+	memcpy(entry.dims, frame->header.dims, sizeof(entry.dims));
+	entry.encode_cost = frame->header.encode_cost;
+	entry.format = frame->header.format;
+	batch->size += protocol_encode_batch_entry(&entry, &batch->buffer[batch->size]);
+	memcpy(&batch->buffer[batch->size], frame->payload, frame->size);
+	batch->size += frame->size;
+	batch->frames++;
+}
+
+/**
+ * @brief Submit the current batch, the next frames go to the next batch buffer
+ *
+ * @param [in,out] sequence Sequence number of the radar messages
+ * @param [in] now_us Current time
+ *
+ * @retval 0 Success
+ * @retval -1 Queue of the radar stream full
+ */
+static int radar_batch_flush(uint32_t* sequence, uint64_t now_us)
+{
+	radar_batch_t* batch = &radar_batch[radar_batch_current];
+	scheduler_message_t message;
+	uint32_t wait_us = (uint32_t)(now_us - batch->timestamp_us);
+
+	fill_header(&message.header, PROTOCOL_STREAM_RADAR, PROTOCOL_FORMAT_RADAR_BATCH,
+			*sequence, batch->timestamp_us, crc32_compute(batch->buffer, batch->size));
+	message.header.dims[0] = batch->frames;
+	message.payload = batch->buffer;
+	message.size = batch->size;
+	message.callback = radar_batch_sent_callback;
+	message.context = batch;
+
+	batch->frames_sent = batch->frames;
+	batch->busy = true;
+	Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 1);
+	if (scheduler_submit(radar_stream, &message) != 0)
+	{
+		batch->busy = false;
+		Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 0);
+		return -1;
+	}
+
+	radar_batch_stats.messages++;
+	radar_batch_stats.frames += batch->frames;
+	radar_batch_stats.bytes += batch->size;
+	if (wait_us > radar_batch_stats.max_wait_us)
+	{
+		radar_batch_stats.max_wait_us = wait_us;
+	}
+
+	// The scheduler holds the size: the buffer is only reused once sent
+	batch->frames = 0;
+	batch->size = 0;
+	(*sequence)++;
+	radar_batch_current = (radar_batch_current + 1u) % RADAR_BATCH_BUFFER_COUNT;
+
+	return 0;
+}
+
+/**
+ * @brief Submit the current batch if it is complete, if its first frame reached the deadline
+ * or if the batching has been disabled
+ *
+ * @param [in,out] sequence Sequence number of the radar messages
+ *
+ * @retval 0 Nothing to send or batch submitted
+ * @retval -1 Queue of the radar stream full (the batch is submitted by a later call)
+ */
+static int radar_batch_poll(uint32_t* sequence)
+{
+	const radar_batch_t* batch = &radar_batch[radar_batch_current];
+	uint64_t now_us = timestamp_now_us();
+	bool complete = false;
+
+	if (batch->frames == 0)
+	{
+		return 0;
+	}
+
+	// The next frame may be the largest one
+	complete = (batch->frames >= radar_batch_frames)
+			|| ((radar_batch_buffer_size - batch->size) < (PROTOCOL_BATCH_ENTRY_SIZE + radar_frame_max_size));
+	if (!complete && ((now_us - batch->timestamp_us) < radar_batch_deadline_us))
+	{
+		return 0;
+	}
+
+	if (scheduler_free_slots(radar_stream) == 0)
+	{
+		return -1;
+	}
+	if (!complete)
+	{
+		radar_batch_stats.deadline++;
+	}
+
+	return radar_batch_flush(sequence, now_us);
+}
+
+/**
+ * @brief Drop the pending frames and restart the statistics of the batches (start of the stream)
+ */
+void radar_batch_reset(void)
+{
+	radar_batch[radar_batch_current].frames = 0;
+	radar_batch[radar_batch_current].size = 0;
+	memset(&radar_batch_stats, 0, sizeof(radar_batch_stats));
+	radar_batch_stats.start_us = timestamp_now_us();
+}
+
+/**
+ * @brief Print the statistics of the batches since the start of the stream
+ */
+void radar_batch_print_stats(void)
+{
+	uint64_t elapsed_us = timestamp_now_us() - radar_batch_stats.start_us;
+	uint64_t throughput = 0;
+
+	if (elapsed_us != 0)
+	{
+		// Bytes per second
+		throughput = (radar_batch_stats.bytes * 1000000u) / elapsed_us;
+	}
+
+	printf("Radar batch %u: %lu frames in %lu messages (%lu on deadline), %lu bytes/s, max wait %lu us \r\n",
+			(unsigned int)radar_batch_frames,
+			(unsigned long)radar_batch_stats.frames,
+			(unsigned long)radar_batch_stats.messages,
+			(unsigned long)radar_batch_stats.deadline,
+			(unsigned long)throughput,
+			(unsigned long)radar_batch_stats.max_wait_us);
+}
+
+/**
+ * @brief Allocate the radar buffers for the frames of the current radar profile
+ * The previous buffers are freed: none of them may be in flight
+ * The range processing is prepared for the new shape, the raw samples are sent if it does not suit it
+ * With the per-chirp packets, only the block buffers are allocated (no frame is put together)
+ *
+ * @retval 0 Success
+ * @retval -1 Not enough memory
+ */
+int radar_buffers_alloc(void)
+{
+	uint16_t shape[3] = { 0 };
+
+	uint16_t block = 0;
+	size_t block_size = 0;
+
+	radar_num_samples = (uint16_t)radar_get_num_samples_per_frame();
+	radar_data_size = radar_num_samples * sizeof(uint16_t);
+	radar_block_samples = (uint16_t)radar_get_num_samples_per_block();
+	radar_blocks_per_frame = (uint16_t)(radar_num_samples / radar_block_samples);
+	radar_get_block(&radar_block_chirps, &block);
+	radar_frame_index = -1;
+	radar_block_next = 0;
+	// Header before the samples, which start on a cache line
+	block_size = RADAR_DATA_ALIGNMENT + ((radar_block_samples * sizeof(uint16_t) + RADAR_DATA_ALIGNMENT - 1u)
+			& ~(size_t)(RADAR_DATA_ALIGNMENT - 1u));
+	// Range processing: N / 2 complex float bins per chirp of N samples at most
+	// (also the size of the work matrix of a range-Doppler map)
+	radar_range_data_size = radar_num_samples * sizeof(float);
+	// Batches: at least one frame of the largest format (range bins in float)
+	radar_frame_max_size = (radar_range_data_size > radar_data_size) ? radar_range_data_size : (uint32_t)radar_data_size;
+	radar_batch_buffer_size = RADAR_BATCH_BUFFER_SIZE;
+	if (radar_batch_buffer_size < (PROTOCOL_BATCH_ENTRY_SIZE + radar_frame_max_size))
+	{
+		radar_batch_buffer_size = PROTOCOL_BATCH_ENTRY_SIZE + radar_frame_max_size;
+	}
+
+	// Everything is freed first: the largest profile fits in the heap of the smallest one plus the free heap
+	for (uint32_t i = 0; i < RADAR_BUFFER_COUNT; ++i)
+	{
+		free(radar_data[i]);
+		free(radar_range_data[i]);
+		radar_data[i] = NULL;
+		radar_range_data[i] = NULL;
+	}
+	for (uint32_t i = 0; i < RADAR_BLOCK_COUNT; ++i)
+	{
+		free(radar_block_data[i]);
+		radar_block_data[i] = NULL;
+	}
+	for (uint32_t i = 0; i < RADAR_BATCH_BUFFER_COUNT; ++i)
+	{
+		free(radar_batch[i].buffer);
+		radar_batch[i].buffer = NULL;
+		radar_batch[i].frames = 0;
+		radar_batch[i].size = 0;
+	}
+
+	for (uint32_t i = 0; radar_block_packets && (i < RADAR_BLOCK_COUNT); ++i)
+	{
+		radar_block_data[i] = aligned_alloc(RADAR_DATA_ALIGNMENT, block_size);
+		if (radar_block_data[i] == NULL)
+		{
+			printf("Cannot allocate radar_block_data[%u] \r\n", (unsigned int)i);
+			return -1;
+		}
+	}
+	for (uint32_t i = 0; !radar_block_packets && (i < RADAR_BUFFER_COUNT); ++i)
+	{
+		// Cache lines of their own: the samples can be written by the DMA
+		radar_data[i] = aligned_alloc(RADAR_DATA_ALIGNMENT,
+				(radar_data_size + RADAR_DATA_ALIGNMENT - 1u) & ~(size_t)(RADAR_DATA_ALIGNMENT - 1u));
+		if (radar_data[i] == NULL)
+		{
+			printf("Cannot allocate radar_data[%u] \r\n", (unsigned int)i);
+			return -1;
+		}
+		radar_range_data[i] = malloc(radar_range_data_size);
+		if (radar_range_data[i] == NULL)
+		{
+			printf("Cannot allocate radar_range_data[%u] \r\n", (unsigned int)i);
+			return -1;
+		}
+	}
+	for (uint32_t i = 0; i < RADAR_BATCH_BUFFER_COUNT; ++i)
+	{
+		radar_batch[i].buffer = malloc(radar_batch_buffer_size);
+		if (radar_batch[i].buffer == NULL)
+		{
+			printf("Cannot allocate radar_batch[%u] \r\n", (unsigned int)i);
+			return -1;
+		}
+	}
+
+	radar_get_frame_shape(&shape[0], &shape[1], &shape[2]);
+	radar_range_ready = (range_doppler_init(&radar_range, shape[0], shape[1]) == 0);
+	if (!radar_range_ready)
+	{
+		printf("No range processing for %u samples per chirp and %u chirps \r\n",
+				(unsigned int)shape[0], (unsigned int)shape[1]);
+		if (radar_format >= PROTOCOL_FORMAT_RANGE_MAG_U16)
+		{
+			radar_format = PROTOCOL_FORMAT_RADAR_U16;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Start draining the radar buffers and batches (radar_drain_busy)
+ * The frames queued, the frames waiting in the current batch and the frame being read are dropped
+ */
+void radar_drain_start(void)
+{
+	pipeline_flush();
+	radar_batch[radar_batch_current].frames = 0;
+	radar_batch[radar_batch_current].size = 0;
+}
+
+/**
+ * @brief Check whether radar buffers or batches are still in flight
+ * radar_acquire reads no new data meanwhile
+ *
+ * @retval true Still in flight
+ */
+bool radar_drain_busy(void)
+{
+	bool busy = false;
+
+	// A frame being read is dropped once in memory
+	if ((radar_read_index >= 0) && (radar_read_poll() != 0))
+	{
+		radar_read_index = -1;
+		TRACE_END(TRACE_STAGE_RADAR_READ);
+	}
+	busy = (radar_read_index >= 0);
+	for (uint32_t i = 0; i < RADAR_BUFFER_COUNT; ++i)
+	{
+		busy = busy || radar_busy[i];
+	}
+	for (uint32_t i = 0; i < RADAR_BLOCK_COUNT; ++i)
+	{
+		busy = busy || radar_block_busy[i];
+	}
+	for (uint32_t i = 0; i < RADAR_BATCH_BUFFER_COUNT; ++i)
+	{
+		busy = busy || radar_batch[i].busy;
+	}
+
+	return busy;
+}
+
+/**
+ * @brief Switch the radar to another register profile while streaming (called by drain_stage)
+ * Once the radar transfers in flight are drained, the radar is reprogrammed (no reset of the sensor
+ * and no new USB enumeration) and the radar buffers are resized for the new shape of the frames.
+ * If the profile cannot be programmed, the compiled profile is restored.
+ * The reply (PROTOCOL_FORMAT_RADAR_PROFILE) gives the status and the switch time.
+ *
+ * @param [in] command Command of the host (profile), copied by drain_start
+ * @param [in] drained true if the radar transfers in flight are completed
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_INVALID Shape or number of registers out of range, compiled profile restored
+ * @retval COMMAND_STATUS_CONFIG_FAILED The radar cannot be programmed, compiled profile restored
+ * @retval COMMAND_STATUS_DRAIN_TIMEOUT The transfers in flight cannot be completed, profile kept
+ * @retval COMMAND_STATUS_NO_MEMORY Not enough memory, compiled profile restored
+ */
+int32_t radar_profile_apply(const command_t* command, bool drained)
+{
+	scheduler_message_t message;
+	const uint8_t* params = command->params;
+	radar_profile_t profile;
+	uint32_t switch_us = 0;
+	int32_t status = 0;
+
+	profile.samples_per_chirp = (uint16_t)(params[0] | (params[1] << 8));
+	profile.chirps_per_frame = (uint16_t)(params[2] | (params[3] << 8));
+	profile.antennas = params[4];
+	profile.num_registers = params[5];
+	profile.registers = radar_profile_registers;
+
+	// Too many registers are rejected by radar_configure
+	params += COM_CMD_RADAR_PROFILE_SIZE;
+	for (uint32_t i = 0; (i < profile.num_registers) && (i < RADAR_MAX_REGISTERS); ++i)
+	{
+		radar_profile_registers[i] = (uint32_t)params[4 * i] | ((uint32_t)params[4 * i + 1] << 8)
+				| ((uint32_t)params[4 * i + 2] << 16) | ((uint32_t)params[4 * i + 3] << 24);
+	}
+
+	printf("Radar profile: %u samples per chirp, %u chirps, %u antennas, %u registers \r\n",
+			(unsigned int)profile.samples_per_chirp, (unsigned int)profile.chirps_per_frame,
+			(unsigned int)profile.antennas, (unsigned int)profile.num_registers);
+
+	if (!drained)
+	{
+		// The radar buffers cannot be resized: the current profile is kept
+		status = COMMAND_STATUS_DRAIN_TIMEOUT;
+	}
+	else
+	{
+		// 0 registers: profile compiled from radar_settings.h
+		status = radar_configure((profile.num_registers == 0) ? NULL : &profile);
+		if (status != 0)
+		{
+			status = (status == -1) ? COMMAND_STATUS_INVALID : COMMAND_STATUS_CONFIG_FAILED;
+			(void)radar_configure(NULL);
+		}
+		if (radar_buffers_alloc() != 0)
+		{
+			// The compiled profile fitted at startup
+			status = COMMAND_STATUS_NO_MEMORY;
+			(void)radar_configure(NULL);
+			(void)radar_buffers_alloc();
+		}
+		memset(&radar_range_stats, 0, sizeof(radar_range_stats));
+		radar_batch_reset();
+	}
+	switch_us = (uint32_t)(timestamp_now_us() - drain_start_us);
+	printf("Radar profile: status %ld, switched in %lu us \r\n", (long)status, (unsigned long)switch_us);
+
+	if (radar_profile_busy)
+	{
+		return status;
+	}
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		radar_profile_reply[i] = (uint8_t)((uint32_t)status >> (8 * i));
+		radar_profile_reply[4 + i] = (uint8_t)(switch_us >> (8 * i));
+	}
+	message.payload = radar_profile_reply;
+	message.size = sizeof(radar_profile_reply);
+	fill_header(&message.header, PROTOCOL_STREAM_CONTROL, PROTOCOL_FORMAT_RADAR_PROFILE,
+			control_sequence, timestamp_now_us(), crc32_compute(radar_profile_reply, sizeof(radar_profile_reply)));
+	radar_get_frame_shape(&message.header.dims[0], &message.header.dims[1], &message.header.dims[2]);
+	message.callback = control_sent_callback;
+	message.context = &radar_profile_busy;
+
+	radar_profile_busy = true;
+	if (scheduler_submit(control_stream, &message) != 0)
+	{
+		radar_profile_busy = false;
+		return status;
+	}
+	control_sequence++;
+
+	return status;
+}
+
+/**
+ * @brief Read the radar FIFO by blocks of chirps (called by drain_stage)
+ * Once the radar transfers in flight are completed, the radar buffers are allocated for the new setting
+ *
+ * @param [in] command Command of the host (chirps per block and packets), copied by drain_start
+ * @param [in] drained true if the radar transfers in flight are completed
+ *
+ * @retval COMMAND_STATUS_OK Success
+ * @retval COMMAND_STATUS_INVALID The chirps per block do not divide the chirps of a frame, nothing changed
+ * @retval COMMAND_STATUS_CONFIG_FAILED The radar cannot be restarted (see radar_set_block), whole frames are read
+ * @retval COMMAND_STATUS_DRAIN_TIMEOUT The transfers in flight cannot be completed, nothing changed
+ * @retval COMMAND_STATUS_NO_MEMORY Not enough memory, whole frames are read
+ */
+int32_t radar_block_apply(const command_t* command, bool drained)
+{
+	uint16_t chirps = (uint16_t)(command->params[0] | (command->params[1] << 8));
+	bool packets = (command->params[2] != 0);
+	int32_t status = 0;
+
+	if (!drained)
+	{
+		return COMMAND_STATUS_DRAIN_TIMEOUT;
+	}
+
+	status = radar_set_block(chirps);
+	if (status == -1)
+	{
+		// Nothing changed
+		return COMMAND_STATUS_INVALID;
+	}
+	radar_block_packets = packets && (status == 0);
+	if (status != 0)
+	{
+		status = COMMAND_STATUS_CONFIG_FAILED;
+		(void)radar_set_block(0);
+	}
+	if (radar_buffers_alloc() != 0)
+	{
+		status = COMMAND_STATUS_NO_MEMORY;
+		radar_block_packets = false;
+		(void)radar_set_block(0);
+		(void)radar_buffers_alloc();
+	}
+	radar_batch_reset();
+
+	printf("Radar blocks: %u chirps, %u samples, %u per frame, packets %u, status %ld \r\n",
+			(unsigned int)radar_block_chirps, (unsigned int)radar_block_samples,
+			(unsigned int)radar_blocks_per_frame, (unsigned int)radar_block_packets, (long)status);
+
+	return status;
+}
+
+/**
+ * @brief Read the radar data: the per-chirp packets are sent as soon as read
+ *
+ * @param [out] timestamp_us Capture time of the frame
+ *
+ * @retval Index of the radar buffer holding a whole frame to process (radar_process)
+ * @retval -1 No frame complete
+ */
+int radar_acquire(uint64_t* timestamp_us)
+{
+	if (drain_sensor == DRAIN_RADAR)
+	{
+		// The data stays in the FIFO until the radar is reconfigured (drain_stage)
+		return -1;
+	}
+
+	// The data stays in the radar FIFO until a buffer is free
+	// Batch complete, on deadline or left by the previous setting (retried while the queue is full)
+	if (send_data == 1)
+	{
+		(void)radar_batch_poll(&radar_sequence);
+	}
+
+	if ((radar_read_index < 0) && radar_is_data_available())
+	{
+		uint16_t block_chirps = 0;
+		uint16_t* destination = NULL;
+		int index = -1;
+
+		radar_get_block(&block_chirps, &radar_read_block);
+		if (radar_block_packets)
+		{
+			// Per-chirp packets: next block buffer, sent as soon as read
+			if (!radar_block_busy[radar_block_next])
+			{
+				index = (int)radar_block_next;
+				destination = (uint16_t*)&radar_block_data[index][RADAR_DATA_ALIGNMENT];
+			}
+		}
+		else if ((radar_read_block != 0) && (radar_frame_index >= 0))
+		{
+			// Next block of the frame being put together, in place
+			index = radar_frame_index;
+			destination = &radar_data[index][radar_read_block * radar_block_samples];
+		}
+		else
+		{
+			// First block of a frame: free radar buffer
+			for (int i = 0; i < RADAR_BUFFER_COUNT; ++i)
+			{
+				if (!radar_busy[i])
+				{
+					index = i;
+					break;
+				}
+			}
+			if ((index >= 0) && ((send_data == 0) || radar_batch_ready()))
+			{
+				radar_frame_index = index;
+				destination = &radar_data[index][radar_read_block * radar_block_samples];
+			}
+		}
+
+		// The FIFO is read in the background, the camera and the USB go on meanwhile
+		if (destination != NULL)
+		{
+			radar_timestamp = radar_get_data_timestamp_us();
+			TRACE_BEGIN(TRACE_STAGE_RADAR_READ, radar_sequence);
+			if (radar_read_start(destination, radar_block_samples) != 0)
+			{
+				TRACE_END(TRACE_STAGE_RADAR_READ);
+				printf("Error reading radar data\r\n");
+			}
+			else
+			{
+				radar_read_index = index;
+			}
+		}
+	}
+
+	if (radar_read_index >= 0)
+	{
+		int index = radar_read_index;
+		int read_status = radar_read_poll();
+		int submit_status = 0;
+
+		if (read_status != 0)
+		{
+			radar_read_index = -1;
+			TRACE_END(TRACE_STAGE_RADAR_READ);
+		}
+
+		if (read_status < 0)
+		{
+			printf("Error reading radar data\r\n");
+		}
+		else if ((read_status > 0) && radar_block_packets)
+		{
+			bool last = (radar_read_block == (radar_blocks_per_frame - 1u));
+
+			if (radar_read_block == 0)
+			{
+				Cy_GPIO_Inv(CYBSP_USER_LED1_PORT, CYBSP_USER_LED1_PIN);
+			}
+
+			// The host puts the frames together (the frame number is in the block)
+			if (send_data == 1)
+			{
+				TRACE_BEGIN(TRACE_STAGE_SUBMIT, radar_sequence);
+				submit_status = radar_block_send((uint32_t)index, radar_read_block, radar_sequence, radar_timestamp);
+				TRACE_END(TRACE_STAGE_SUBMIT);
+				if (submit_status != 0)
+				{
+					printf("Failed to write radar data over USB\r\n");
+					send_data = 0;
+					telemetry.counters[TELEMETRY_STREAM_RADAR][TELEMETRY_DROP_USB]++;
+				}
+				else
+				{
+					radar_sequence++;
+					radar_block_next = (radar_block_next + 1u) % RADAR_BLOCK_COUNT;
+				}
+			}
+			else if (last)
+			{
+				telemetry.counters[TELEMETRY_STREAM_RADAR][TELEMETRY_DROP_IDLE]++;
+			}
+			if (last)
+			{
+				radar_block_frame++;
+			}
+		}
+		else if ((read_status > 0) && (radar_read_block == (radar_blocks_per_frame - 1u)))
+		{
+			// Whole frame in memory: its buffer is reserved until it is processed
+			radar_busy[index] = true;
+			*timestamp_us = radar_timestamp;
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Process and send a radar frame, or drop it
+ * Called with the lock held (RTOS): it is given back while the frame is packed or processed
+ *
+ * @param [in] index Radar buffer returned by radar_acquire
+ * @param [in] timestamp_us Capture time of the frame
+ */
+void radar_process(int index, uint64_t timestamp_us)
+{
+	scheduler_message_t message;
+	int submit_status = 0;
+
+	// Alive LED
+	Cy_GPIO_Inv(CYBSP_USER_LED1_PORT, CYBSP_USER_LED1_PIN);
+
+	// Add overhead
+	// The 12 bits samples are packed in place (3 bytes per 2 samples)
+	// The range bins are written in the range buffer, the range-Doppler maps over the samples
+	// Settings of the frame: the commands can change them while the lock is given back,
+	// the buffers and the shape only change once the buffer is free (drain)
+	uint8_t format = radar_format;
+	cfar_t cfar = radar_cfar;
+	radar_cfar_source_t source = radar_cfar_source;
+	uint16_t* samples = radar_data[index];
+	uint16_t num_samples = radar_num_samples;
+	uint16_t cost = 0;
+	uint32_t cycles = 0;
+	int32_t range_size = -1;
+	uint16_t dims[3] = { 0 };
+
+	radar_get_frame_shape(&dims[0], &dims[1], &dims[2]);
+	message.payload = (uint8_t*)samples;
+	message.size = (uint32_t)radar_data_size;
+
+	// The buffer stays reserved by radar_acquire meanwhile
+	pipeline_unlock();
+	TRACE_BEGIN(TRACE_STAGE_RADAR_PROCESS, radar_sequence);
+	if (format == PROTOCOL_FORMAT_RADAR_U12)
+	{
+		message.size = pack12_pack(samples, num_samples, (uint8_t*)samples);
+	}
+	else if (format >= PROTOCOL_FORMAT_RANGE_MAG_U16)
+	{
+		// Empty payload if no target has been detected
+		range_size = radar_range_process(samples, num_samples, radar_range_data[index],
+				format, &cfar, source, &message.payload, dims, &cost, &cycles);
+		if (range_size >= 0)
+		{
+			message.size = (uint32_t)range_size;
+		}
+		else
+		{
+			radar_get_frame_shape(&dims[0], &dims[1], &dims[2]);
+			message.payload = (uint8_t*)samples;
+			format = PROTOCOL_FORMAT_RADAR_U16;
+		}
+	}
+	TRACE_END(TRACE_STAGE_RADAR_PROCESS);
+	pipeline_lock();
+
+	// Busy again below if the frame is sent from the buffer
+	radar_busy[index] = false;
+	if (range_size >= 0)
+	{
+		radar_range_stats.frames++;
+		radar_range_stats.cycles += cycles;
+		radar_range_stats.bytes += (uint32_t)range_size;
+	}
+	fill_header(&message.header, PROTOCOL_STREAM_RADAR, format,
+			radar_sequence, timestamp_us, 0);
+	message.header.encode_cost = cost;
+	memcpy(message.header.dims, dims, sizeof(dims));
+	message.callback = radar_sent_callback;
+	message.context = &radar_busy[index];
+
+	if ((send_data == 1) && (radar_batch_frames > 1))
+	{
+		// Copied: the radar buffer is free again, the batch is sent by radar_batch_poll
+		radar_batch_add(&message);
+	}
+	else if (send_data == 1)
+	{
+		// Send once per USB, the buffer is busy until sent
+		TRACE_BEGIN(TRACE_STAGE_CRC, radar_sequence);
+		message.header.message_crc = crc32_compute(message.payload, message.size);
+		TRACE_END(TRACE_STAGE_CRC);
+		TRACE_BEGIN(TRACE_STAGE_SUBMIT, radar_sequence);
+		radar_sequence++;
+		radar_busy[index] = true;
+		Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 1);
+		submit_status = scheduler_submit(radar_stream, &message);
+		TRACE_END(TRACE_STAGE_SUBMIT);
+		if (submit_status != 0)
+		{
+			printf("Failed to write radar data over USB\r\n");
+			send_data = 0;
+			radar_busy[index] = false;
+			telemetry.counters[TELEMETRY_STREAM_RADAR][TELEMETRY_DROP_USB]++;
+			Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 0);
+		}
+	}
+	else
+	{
+		telemetry.counters[TELEMETRY_STREAM_RADAR][TELEMETRY_DROP_IDLE]++;
+	}
+}
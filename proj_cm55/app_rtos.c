@@ -0,0 +1,334 @@
+/*
+ * app_rtos.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Tasks of the pipeline (RTOS_ENABLED=1, see FreeRTOSConfig.h): the sensor tasks
+ * acquire the frames, the processing task encodes and submits them, the USB task
+ * moves the transfers forward and handles the commands. One stage at a time holds
+ * the lock of the application state: the processing task gives it back while it
+ * encodes a frame (pipeline_unlock) and the USB task sends the segments without it.
+ */
+
+#include "app.h"
+
+#if RTOS_ENABLED
+/**
+ * Sensor of a frame queued for the processing task
+ */
+typedef enum
+{
+	PIPELINE_CAMERA,
+	PIPELINE_RADAR,
+} pipeline_sensor_t;
+
+/**
+ * Frame queued for the processing task (handle of the buffer, the data is not copied)
+ */
+typedef struct
+{
+	pipeline_sensor_t sensor;
+	union
+	{
+		camera_handle_t camera;
+		struct
+		{
+			int index;				/**< Radar buffer */
+			uint64_t timestamp_us;
+		} radar;
+	};
+} pipeline_item_t;
+
+/**
+ * Tasks, lock of the application state (one stage at a time) and frames waiting for the processing task
+ */
+static StaticTask_t usb_task_tcb;
+static StackType_t usb_task_stack[RTOS_USB_STACK_SIZE];
+static TaskHandle_t usb_task_handle = NULL;
+static StaticTask_t camera_task_tcb;
+static StackType_t camera_task_stack[RTOS_SENSOR_STACK_SIZE];
+static TaskHandle_t camera_task_handle = NULL;
+static StaticTask_t radar_task_tcb;
+static StackType_t radar_task_stack[RTOS_SENSOR_STACK_SIZE];
+static TaskHandle_t radar_task_handle = NULL;
+static StaticTask_t processing_task_tcb;
+static StackType_t processing_task_stack[RTOS_PROCESSING_STACK_SIZE];
+static StaticSemaphore_t rtos_lock_buffer;
+static SemaphoreHandle_t rtos_lock = NULL;
+static StaticQueue_t pipeline_queue_buffer;
+static uint8_t pipeline_queue_storage[RTOS_PIPELINE_DEPTH * sizeof(pipeline_item_t)];
+static QueueHandle_t pipeline_queue = NULL;
+#endif
+
+/**
+ * @brief Give back the frames acquired and not processed yet (RTOS: queued for the processing task)
+ * Called before waiting for the buffers in flight, the frames are dropped
+ */
+void pipeline_flush(void)
+{
+#if RTOS_ENABLED
+	pipeline_item_t item;
+
+	while (xQueueReceive(pipeline_queue, &item, 0) == pdTRUE)
+	{
+		if (item.sensor == PIPELINE_CAMERA)
+		{
+			camera_frames_queued--;
+			if (item.camera.codec_index >= 0)
+			{
+				camera_codec_busy[item.camera.codec_index] = false;
+			}
+			mtb_dvp_cam_ov7675_release(item.camera.frame);
+		}
+		else
+		{
+			radar_busy[item.radar.index] = false;
+		}
+	}
+#endif
+}
+
+/**
+ * @brief Let the other stages run while the processing task encodes a frame
+ * (RTOS only, no effect in the superloop)
+ * The frame keeps its buffers reserved: the drain waits for it (camera_drain_busy, radar_drain_busy)
+ */
+void pipeline_unlock(void)
+{
+#if RTOS_ENABLED
+	(void)xSemaphoreGive(rtos_lock);
+#endif
+}
+
+/**
+ * @brief Take again the lock given back by pipeline_unlock (RTOS only, no effect in the superloop)
+ */
+void pipeline_lock(void)
+{
+#if RTOS_ENABLED
+	(void)xSemaphoreTake(rtos_lock, portMAX_DELAY);
+#endif
+}
+
+#if RTOS_ENABLED
+/**
+ * @brief Wake up a task (camera and radar events), from an interrupt or from a task
+ * (radar_read_poll calls the data interrupt handler)
+ *
+ * @param [in] context Handle of the task (TaskHandle_t*)
+ */
+static void rtos_notify(void* context)
+{
+	TaskHandle_t task = *(TaskHandle_t*)context;
+	BaseType_t woken = pdFALSE;
+
+	if (task == NULL)
+	{
+		return;
+	}
+
+	if (xPortIsInsideInterrupt())
+	{
+		vTaskNotifyGiveFromISR(task, &woken);
+		portYIELD_FROM_ISR(woken);
+	}
+	else
+	{
+		xTaskNotifyGive(task);
+	}
+}
+
+/**
+ * @brief Deferred callback of the camera driver with the tasks: the camera task is woken up
+ * by the interrupt events (lines captured, VSYNC)
+ *
+ * @param [in] context Handle of the camera task (TaskHandle_t*)
+ * @param [in] event Event of the capture
+ * @param [in] sequence Sequence of the frame
+ */
+static void rtos_camera_event(void* context, ov7675_deferred_event_t event, uint32_t sequence)
+{
+	camera_deferred_event(NULL, event, sequence);
+	if ((event == kOV7675_Deferred_Lines) || (event == kOV7675_Deferred_Vsync))
+	{
+		rtos_notify(context);
+	}
+}
+
+/**
+ * @brief Camera task: deferred path of the camera interrupt, then the frames ready are queued
+ */
+static void camera_task(void* argument)
+{
+	camera_handle_t handle;
+
+	(void)argument;
+	for (;;)
+	{
+		// Woken up by the camera interrupt (lines captured, VSYNC), or periodically
+		// for the frames held while the camera stream is full
+		(void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RTOS_SENSOR_POLL_MS));
+
+		// Driver state only: the lock is not needed
+		mtb_dvp_cam_deferred_process();
+
+		(void)xSemaphoreTake(rtos_lock, portMAX_DELAY);
+		while (camera_acquire(&handle))
+		{
+			pipeline_item_t item = { .sensor = PIPELINE_CAMERA, .camera = handle };
+
+			// Never full: one entry per frame buffer and radar buffer
+			(void)xQueueSendToBack(pipeline_queue, &item, 0);
+		}
+		(void)xSemaphoreGive(rtos_lock);
+	}
+}
+
+/**
+ * @brief Radar task: reads the FIFO and sends the per-chirp packets, the whole frames are queued
+ */
+static void radar_task(void* argument)
+{
+	pipeline_item_t item = { .sensor = PIPELINE_RADAR };
+
+	(void)argument;
+	for (;;)
+	{
+		// Woken up by the data interrupt and the end of the readout (DMA), or periodically
+		// for the batch deadline and the buffers freed by the USB
+		(void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RTOS_SENSOR_POLL_MS));
+
+		(void)xSemaphoreTake(rtos_lock, portMAX_DELAY);
+		item.radar.index = radar_acquire(&item.radar.timestamp_us);
+		if (item.radar.index >= 0)
+		{
+			// Ahead of the camera frames: the radar stream has a latency bound
+			(void)xQueueSendToFront(pipeline_queue, &item, 0);
+		}
+		(void)xSemaphoreGive(rtos_lock);
+
+		// Per-chirp packets submitted
+		rtos_notify(&usb_task_handle);
+	}
+}
+
+/**
+ * @brief Processing task: encodes and submits the frames queued by the sensor tasks
+ * The lock is given back during the encoding (camera_process, radar_process)
+ */
+static void processing_task(void* argument)
+{
+	pipeline_item_t item;
+
+	(void)argument;
+	for (;;)
+	{
+		// The item stays queued until the lock is held: pipeline_flush can drop it meanwhile
+		(void)xQueuePeek(pipeline_queue, &item, portMAX_DELAY);
+
+		(void)xSemaphoreTake(rtos_lock, portMAX_DELAY);
+		if (xQueueReceive(pipeline_queue, &item, 0) == pdTRUE)
+		{
+			if (item.sensor == PIPELINE_CAMERA)
+			{
+				camera_process(&item.camera);
+			}
+			else
+			{
+				radar_process(item.radar.index, item.radar.timestamp_us);
+			}
+		}
+		(void)xSemaphoreGive(rtos_lock);
+
+		// The message submitted is sent without waiting for the next poll of the USB task
+		rtos_notify(&usb_task_handle);
+	}
+}
+
+/**
+ * @brief USB task: starts the USB and the sensors and the other tasks,
+ * then moves the transfers forward and handles the commands of the host.
+ * Sleeps until the segment in flight is sent, or until a message is submitted (notified),
+ * at most RTOS_USB_POLL_MS for the commands of the host
+ */
+static void usb_task(void* argument)
+{
+	uint32_t size = 0;
+	uint64_t rx_us = 0;
+
+	(void)argument;
+
+	// emUSB waits for the enumeration with the RTOS: started here, not before the scheduler
+	if (app_start() != 0)
+	{
+		vTaskDelete(NULL);
+	}
+
+	rtos_lock = xSemaphoreCreateMutexStatic(&rtos_lock_buffer);
+	pipeline_queue = xQueueCreateStatic(RTOS_PIPELINE_DEPTH, sizeof(pipeline_item_t),
+			pipeline_queue_storage, &pipeline_queue_buffer);
+	camera_task_handle = xTaskCreateStatic(camera_task, "camera", RTOS_SENSOR_STACK_SIZE, NULL,
+			RTOS_CAMERA_PRIORITY, camera_task_stack, &camera_task_tcb);
+	radar_task_handle = xTaskCreateStatic(radar_task, "radar", RTOS_SENSOR_STACK_SIZE, NULL,
+			RTOS_RADAR_PRIORITY, radar_task_stack, &radar_task_tcb);
+	(void)xTaskCreateStatic(processing_task, "processing", RTOS_PROCESSING_STACK_SIZE, NULL,
+			RTOS_PROCESSING_PRIORITY, processing_task_stack, &processing_task_tcb);
+
+	// Set once the tasks exist
+	mtb_dvp_cam_ov7675_set_deferred_callback(rtos_camera_event, &camera_task_handle);
+	radar_set_event_callback(rtos_notify, &radar_task_handle);
+
+	for (;;)
+	{
+		// USB driver state only: the segments sent are ended without the lock
+		usbd_tx_poll(usb_handle);
+
+		// Only the bytes already received: never blocks
+		size = (uint32_t)usbd_receive(usb_handle, command_rx, sizeof(command_rx));
+		rx_us = timestamp_now_us();
+
+		(void)xSemaphoreTake(rtos_lock, portMAX_DELAY);
+		command_stage(command_rx, size, rx_us);
+		usb_stage();
+		(void)xSemaphoreGive(rtos_lock);
+
+		// Starts the chunks handed over by the scheduler, then waits without the lock
+		usbd_tx_poll(usb_handle);
+		if ((size == 0) && !usbd_tx_wait(usb_handle, RTOS_USB_POLL_MS))
+		{
+			(void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RTOS_USB_POLL_MS));
+		}
+	}
+}
+
+/**
+ * @brief Called by the kernel when a task has overflowed its stack (configCHECK_FOR_STACK_OVERFLOW)
+ */
+void vApplicationStackOverflowHook(TaskHandle_t task, char* name)
+{
+	(void)task;
+	printf("Stack overflow: task %s \r\n", name);
+	taskDISABLE_INTERRUPTS();
+	for (;;)
+	{
+	}
+}
+
+/**
+ * @brief Start the USB task (it starts the USB, the sensors and the other tasks) and the kernel
+ */
+void rtos_start(void)
+{
+	usb_task_handle = xTaskCreateStatic(usb_task, "usb", RTOS_USB_STACK_SIZE, NULL, RTOS_USB_PRIORITY,
+			usb_task_stack, &usb_task_tcb);
+	vTaskStartScheduler();
+}
+#endif
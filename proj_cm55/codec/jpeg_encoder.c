@@ -0,0 +1,917 @@
+/*
+ * jpeg_encoder.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "jpeg_encoder.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if (JPEG_ENGINE == JPEG_ENGINE_MVE)
+#if !defined(__ARM_FEATURE_MVE)
+#error "JPEG_ENGINE_MVE requires a core supporting Helium (MVE)"
+#endif
+#include <arm_mve.h>
+#elif (JPEG_ENGINE != JPEG_ENGINE_SCALAR)
+#error "Unknown JPEG_ENGINE"
+#endif
+
+/**
+ * Fixed point DCT (Loeffler, Ligtenberg and Moschytz), 13 fractional bits for the constants
+ * 2 more bits are kept between the passes. The output is 8 times the DCT coefficients.
+ */
+#define JPEG_CONST_BITS		13
+#define JPEG_PASS1_BITS		2
+
+#define JPEG_FIX_0_298631336	2446
+#define JPEG_FIX_0_390180644	3196
+#define JPEG_FIX_0_541196100	4433
+#define JPEG_FIX_0_765366865	6270
+#define JPEG_FIX_0_899976223	7373
+#define JPEG_FIX_1_175875602	9633
+#define JPEG_FIX_1_501321110	12299
+#define JPEG_FIX_1_847759065	15137
+#define JPEG_FIX_1_961570560	16069
+#define JPEG_FIX_2_053119869	16819
+#define JPEG_FIX_2_562915447	20995
+#define JPEG_FIX_3_072711026	25172
+
+/**
+ * Fractional bits of the reciprocals used by the quantisation
+ */
+#define JPEG_RECIPROCAL_BITS	16
+
+/**
+ * Colour conversion (JFIF), 16 fractional bits
+ */
+#define JPEG_Y_R	19595
+#define JPEG_Y_G	38470
+#define JPEG_Y_B	7471
+#define JPEG_CB_R	-11059
+#define JPEG_CB_G	-21709
+#define JPEG_CB_B	32768
+#define JPEG_CR_R	32768
+#define JPEG_CR_G	-27439
+#define JPEG_CR_B	-5329
+
+/**
+ * Huffman tables of the encoder
+ */
+#define JPEG_HUFF_DC_LUMA	0
+#define JPEG_HUFF_AC_LUMA	1
+#define JPEG_HUFF_DC_CHROMA	2
+#define JPEG_HUFF_AC_CHROMA	3
+
+/**
+ * Markers
+ */
+#define JPEG_MARKER_SOI		0xD8
+#define JPEG_MARKER_EOI		0xD9
+#define JPEG_MARKER_APP0	0xE0
+#define JPEG_MARKER_DQT		0xDB
+#define JPEG_MARKER_SOF0	0xC0
+#define JPEG_MARKER_DHT		0xC4
+#define JPEG_MARKER_SOS		0xDA
+
+/**
+ * Quantisation tables of the JPEG standard (Annex K), natural order
+ */
+static const uint8_t jpeg_std_quant[2][64] =
+{
+	{
+		16, 11, 10, 16, 24, 40, 51, 61,
+		12, 12, 14, 19, 26, 58, 60, 55,
+		14, 13, 16, 24, 40, 57, 69, 56,
+		14, 17, 22, 29, 51, 87, 80, 62,
+		18, 22, 37, 56, 68, 109, 103, 77,
+		24, 35, 55, 64, 81, 104, 113, 92,
+		49, 64, 78, 87, 103, 121, 120, 101,
+		72, 92, 95, 98, 112, 100, 103, 99
+	},
+	{
+		17, 18, 24, 47, 99, 99, 99, 99,
+		18, 21, 26, 66, 99, 99, 99, 99,
+		24, 26, 56, 99, 99, 99, 99, 99,
+		47, 66, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99
+	}
+};
+
+/**
+ * Natural index of the coefficients in zigzag order
+ */
+static const uint8_t jpeg_zigzag[64] =
+{
+	0, 1, 8, 16, 9, 2, 3, 10,
+	17, 24, 32, 25, 18, 11, 4, 5,
+	12, 19, 26, 33, 40, 48, 41, 34,
+	27, 20, 13, 6, 7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36,
+	29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46,
+	53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/**
+ * Huffman tables of the JPEG standard (Annex K): number of codes per length (1..16), then the symbols
+ */
+static const uint8_t jpeg_dc_luma_bits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+static const uint8_t jpeg_dc_chroma_bits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+static const uint8_t jpeg_dc_values[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static const uint8_t jpeg_ac_luma_bits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D };
+static const uint8_t jpeg_ac_luma_values[162] =
+{
+	0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+	0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+	0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+	0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+	0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+	0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+
+static const uint8_t jpeg_ac_chroma_bits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+static const uint8_t jpeg_ac_chroma_values[162] =
+{
+	0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+	0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+	0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+	0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+	0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+	0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+	0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+	0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+	0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+
+/**
+ * Huffman tables in the order of JPEG_HUFF_xxx
+ */
+static const uint8_t* const jpeg_huff_bits[4] =
+{
+	jpeg_dc_luma_bits, jpeg_ac_luma_bits, jpeg_dc_chroma_bits, jpeg_ac_chroma_bits
+};
+
+static const uint8_t* const jpeg_huff_values[4] =
+{
+	jpeg_dc_values, jpeg_ac_luma_values, jpeg_dc_values, jpeg_ac_chroma_values
+};
+
+/**
+ * Output of the entropy coder
+ */
+typedef struct
+{
+	uint8_t* buffer;
+	uint32_t size;
+	uint32_t position;
+	uint32_t bits;		/**< Pending bits, the last count bits are valid */
+	uint32_t count;
+	int overflow;
+} jpeg_writer_t;
+
+/**
+ * Blocks of a MCU (16x16 pixels): 4 luma blocks, then Cb and Cr
+ * Samples minus 128
+ */
+typedef struct
+{
+	int16_t y[4][64];
+	int16_t cb[64];
+	int16_t cr[64];
+} jpeg_mcu_t;
+
+static void _jpeg_put_byte(jpeg_writer_t* writer, uint8_t value)
+{
+	if (writer->position >= writer->size)
+	{
+		writer->overflow = 1;
+		return;
+	}
+
+	writer->buffer[writer->position++] = value;
+}
+
+static void _jpeg_put_u16(jpeg_writer_t* writer, uint16_t value)
+{
+	_jpeg_put_byte(writer, (uint8_t)(value >> 8));
+	_jpeg_put_byte(writer, (uint8_t)value);
+}
+
+static void _jpeg_put_marker(jpeg_writer_t* writer, uint8_t marker)
+{
+	_jpeg_put_byte(writer, 0xFF);
+	_jpeg_put_byte(writer, marker);
+}
+
+/**
+ * @brief Append up to 16 bits to the entropy coded data
+ * A 0xFF byte is followed by a 0x00 byte (stuffing)
+ */
+static void _jpeg_put_bits(jpeg_writer_t* writer, uint32_t value, uint32_t size)
+{
+	writer->bits = (writer->bits << size) | (value & ((1u << size) - 1u));
+	writer->count += size;
+
+	while (writer->count >= 8)
+	{
+		uint8_t byte = (uint8_t)(writer->bits >> (writer->count - 8));
+
+		writer->count -= 8;
+		_jpeg_put_byte(writer, byte);
+		if (byte == 0xFF)
+		{
+			_jpeg_put_byte(writer, 0x00);
+		}
+	}
+}
+
+/**
+ * @brief Complete the last byte of the entropy coded data with 1 bits
+ */
+static void _jpeg_flush_bits(jpeg_writer_t* writer)
+{
+	if (writer->count > 0)
+	{
+		_jpeg_put_bits(writer, 0x7F, 8 - writer->count);
+	}
+}
+
+/**
+ * @brief Number of bits of the magnitude of a coefficient (JPEG category)
+ */
+static uint32_t _jpeg_category(int32_t value)
+{
+	uint32_t magnitude = (uint32_t)((value < 0) ? -value : value);
+	uint32_t bits = 0;
+
+	while (magnitude != 0)
+	{
+		bits++;
+		magnitude >>= 1;
+	}
+
+	return bits;
+}
+
+/**
+ * @brief Write the headers: SOI, APP0 (JFIF), DQT, SOF0, DHT and SOS
+ */
+static void _jpeg_write_headers(const jpeg_encoder_t* encoder, jpeg_writer_t* writer,
+		uint16_t width, uint16_t height)
+{
+	uint32_t i = 0;
+	uint32_t table = 0;
+
+	_jpeg_put_marker(writer, JPEG_MARKER_SOI);
+
+	// JFIF 1.01, no density, no thumbnail
+	_jpeg_put_marker(writer, JPEG_MARKER_APP0);
+	_jpeg_put_u16(writer, 16);
+	_jpeg_put_byte(writer, 'J');
+	_jpeg_put_byte(writer, 'F');
+	_jpeg_put_byte(writer, 'I');
+	_jpeg_put_byte(writer, 'F');
+	_jpeg_put_byte(writer, 0);
+	_jpeg_put_u16(writer, 0x0101);
+	_jpeg_put_byte(writer, 0);
+	_jpeg_put_u16(writer, 1);
+	_jpeg_put_u16(writer, 1);
+	_jpeg_put_byte(writer, 0);
+	_jpeg_put_byte(writer, 0);
+
+	// Quantisation tables 0 (luma) and 1 (chroma), 8-bit precision
+	_jpeg_put_marker(writer, JPEG_MARKER_DQT);
+	_jpeg_put_u16(writer, 2 + 2 * 65);
+	for (table = 0; table < 2; ++table)
+	{
+		_jpeg_put_byte(writer, (uint8_t)table);
+		for (i = 0; i < 64; ++i)
+		{
+			_jpeg_put_byte(writer, encoder->quant[table][i]);
+		}
+	}
+
+	// Frame: Y 2x2 sampling, Cb and Cr 1x1 (4:2:0)
+	_jpeg_put_marker(writer, JPEG_MARKER_SOF0);
+	_jpeg_put_u16(writer, 8 + 3 * 3);
+	_jpeg_put_byte(writer, 8);
+	_jpeg_put_u16(writer, height);
+	_jpeg_put_u16(writer, width);
+	_jpeg_put_byte(writer, 3);
+	_jpeg_put_byte(writer, 1);
+	_jpeg_put_byte(writer, 0x22);
+	_jpeg_put_byte(writer, 0);
+	_jpeg_put_byte(writer, 2);
+	_jpeg_put_byte(writer, 0x11);
+	_jpeg_put_byte(writer, 1);
+	_jpeg_put_byte(writer, 3);
+	_jpeg_put_byte(writer, 0x11);
+	_jpeg_put_byte(writer, 1);
+
+	// Huffman tables: class (DC 0, AC 1) and identifier (luma 0, chroma 1)
+	for (table = 0; table < 4; ++table)
+	{
+		uint32_t count = 0;
+
+		for (i = 0; i < 16; ++i)
+		{
+			count += jpeg_huff_bits[table][i];
+		}
+
+		_jpeg_put_marker(writer, JPEG_MARKER_DHT);
+		_jpeg_put_u16(writer, (uint16_t)(2 + 1 + 16 + count));
+		_jpeg_put_byte(writer, (uint8_t)(((table & 1u) << 4) | (table >> 1)));
+		for (i = 0; i < 16; ++i)
+		{
+			_jpeg_put_byte(writer, jpeg_huff_bits[table][i]);
+		}
+		for (i = 0; i < count; ++i)
+		{
+			_jpeg_put_byte(writer, jpeg_huff_values[table][i]);
+		}
+	}
+
+	// Scan of the 3 components
+	_jpeg_put_marker(writer, JPEG_MARKER_SOS);
+	_jpeg_put_u16(writer, 6 + 2 * 3);
+	_jpeg_put_byte(writer, 3);
+	_jpeg_put_byte(writer, 1);
+	_jpeg_put_byte(writer, 0x00);
+	_jpeg_put_byte(writer, 2);
+	_jpeg_put_byte(writer, 0x11);
+	_jpeg_put_byte(writer, 3);
+	_jpeg_put_byte(writer, 0x11);
+	_jpeg_put_byte(writer, 0);
+	_jpeg_put_byte(writer, 63);
+	_jpeg_put_byte(writer, 0);
+}
+
+/**
+ * @brief Entropy coding of a quantised block
+ *
+ * @param [in] block Quantised coefficients, natural order
+ * @param [in,out] last_dc DC coefficient of the previous block of the component
+ * @param [in] dc Huffman table of the DC coefficient (JPEG_HUFF_xxx)
+ */
+static void _jpeg_encode_block(const jpeg_encoder_t* encoder, jpeg_writer_t* writer,
+		const int16_t* block, int32_t* last_dc, uint32_t dc)
+{
+	const uint16_t* dc_code = encoder->huff_code[dc];
+	const uint8_t* dc_size = encoder->huff_size[dc];
+	const uint16_t* ac_code = encoder->huff_code[dc + 1];
+	const uint8_t* ac_size = encoder->huff_size[dc + 1];
+	int32_t diff = block[0] - *last_dc;
+	uint32_t category = _jpeg_category(diff);
+	uint32_t run = 0;
+	uint32_t k = 0;
+
+	*last_dc = block[0];
+
+	// Negative values are sent as value - 1 (one's complement of the magnitude)
+	_jpeg_put_bits(writer, dc_code[category], dc_size[category]);
+	if (category != 0)
+	{
+		_jpeg_put_bits(writer, (uint32_t)((diff < 0) ? (diff - 1) : diff), category);
+	}
+
+	for (k = 1; k < 64; ++k)
+	{
+		int32_t value = block[jpeg_zigzag[k]];
+
+		if (value == 0)
+		{
+			run++;
+			continue;
+		}
+
+		// Runs of 16 zeros (ZRL)
+		while (run > 15)
+		{
+			_jpeg_put_bits(writer, ac_code[0xF0], ac_size[0xF0]);
+			run -= 16;
+		}
+
+		category = _jpeg_category(value);
+		_jpeg_put_bits(writer, ac_code[(run << 4) | category], ac_size[(run << 4) | category]);
+		_jpeg_put_bits(writer, (uint32_t)((value < 0) ? (value - 1) : value), category);
+		run = 0;
+	}
+
+	// End of block
+	if (run != 0)
+	{
+		_jpeg_put_bits(writer, ac_code[0x00], ac_size[0x00]);
+	}
+}
+
+#if (JPEG_ENGINE == JPEG_ENGINE_SCALAR)
+/**
+ * @brief Rounded arithmetic shift right
+ */
+static int32_t _jpeg_descale(int32_t value, uint32_t bits)
+{
+	return (value + (1 << (bits - 1))) >> bits;
+}
+
+/**
+ * @brief Colour conversion and subsampling of the MCU at x, y
+ * The chroma is computed from the sum of 2x2 pixels
+ */
+static void _jpeg_load_mcu(const uint8_t* image, uint16_t width, uint32_t x, uint32_t y, jpeg_mcu_t* mcu)
+{
+	uint32_t row = 0;
+	uint32_t column = 0;
+	uint32_t i = 0;
+
+	for (row = 0; row < JPEG_MCU_SIZE; row += 2)
+	{
+		const uint16_t* line = (const uint16_t*)&image[(((y + row) * width) + x) * 2u];
+
+		for (column = 0; column < JPEG_MCU_SIZE; column += 2)
+		{
+			int32_t r_sum = 0;
+			int32_t g_sum = 0;
+			int32_t b_sum = 0;
+			uint32_t chroma = ((row >> 1) << 3) | (column >> 1);
+
+			for (i = 0; i < 4; ++i)
+			{
+				uint32_t pixel_row = row + (i >> 1);
+				uint32_t pixel_column = column + (i & 1u);
+				uint32_t pixel = line[((i >> 1) * width) + pixel_column];
+				uint32_t block = ((pixel_row >> 3) << 1) | (pixel_column >> 3);
+				int32_t r = (int32_t)((pixel >> 11) & 0x1Fu);
+				int32_t g = (int32_t)((pixel >> 5) & 0x3Fu);
+				int32_t b = (int32_t)(pixel & 0x1Fu);
+
+				// 5/6 bits to 8 bits
+				r = (r << 3) | (r >> 2);
+				g = (g << 2) | (g >> 4);
+				b = (b << 3) | (b >> 2);
+
+				mcu->y[block][((pixel_row & 7u) << 3) | (pixel_column & 7u)] =
+						(int16_t)(((JPEG_Y_R * r + JPEG_Y_G * g + JPEG_Y_B * b + (1 << 15)) >> 16) - 128);
+
+				r_sum += r;
+				g_sum += g;
+				b_sum += b;
+			}
+
+			// Mean of 4 pixels: 2 more bits to remove
+			mcu->cb[chroma] = (int16_t)((JPEG_CB_R * r_sum + JPEG_CB_G * g_sum + JPEG_CB_B * b_sum + (1 << 17)) >> 18);
+			mcu->cr[chroma] = (int16_t)((JPEG_CR_R * r_sum + JPEG_CR_G * g_sum + JPEG_CR_B * b_sum + (1 << 17)) >> 18);
+		}
+	}
+}
+
+/**
+ * @brief One dimensional DCT of the 8 columns of a block, the result is transposed
+ * Applied twice, the coefficients are in natural order
+ *
+ * @param [in] input Block (8 rows, stride 8)
+ * @param [out] output Coefficients of column c written in row c
+ * @param [in] pass 1 for the first pass (keeps JPEG_PASS1_BITS more bits), 2 for the second one
+ */
+static void _jpeg_dct_pass(const int32_t* input, int32_t* output, uint32_t pass)
+{
+	uint32_t column = 0;
+	uint32_t shift = (pass == 1) ? (JPEG_CONST_BITS - JPEG_PASS1_BITS) : (JPEG_CONST_BITS + JPEG_PASS1_BITS);
+
+	for (column = 0; column < 8; ++column)
+	{
+		const int32_t* d = &input[column];
+		int32_t* out = &output[column * 8];
+
+		int32_t tmp0 = d[0 * 8] + d[7 * 8];
+		int32_t tmp7 = d[0 * 8] - d[7 * 8];
+		int32_t tmp1 = d[1 * 8] + d[6 * 8];
+		int32_t tmp6 = d[1 * 8] - d[6 * 8];
+		int32_t tmp2 = d[2 * 8] + d[5 * 8];
+		int32_t tmp5 = d[2 * 8] - d[5 * 8];
+		int32_t tmp3 = d[3 * 8] + d[4 * 8];
+		int32_t tmp4 = d[3 * 8] - d[4 * 8];
+
+		// Even part
+		int32_t tmp10 = tmp0 + tmp3;
+		int32_t tmp13 = tmp0 - tmp3;
+		int32_t tmp11 = tmp1 + tmp2;
+		int32_t tmp12 = tmp1 - tmp2;
+		int32_t z1 = (tmp12 + tmp13) * JPEG_FIX_0_541196100;
+
+		if (pass == 1)
+		{
+			out[0] = (tmp10 + tmp11) * (1 << JPEG_PASS1_BITS);
+			out[4] = (tmp10 - tmp11) * (1 << JPEG_PASS1_BITS);
+		}
+		else
+		{
+			out[0] = _jpeg_descale(tmp10 + tmp11, JPEG_PASS1_BITS);
+			out[4] = _jpeg_descale(tmp10 - tmp11, JPEG_PASS1_BITS);
+		}
+		out[2] = _jpeg_descale(z1 + tmp13 * JPEG_FIX_0_765366865, shift);
+		out[6] = _jpeg_descale(z1 - tmp12 * JPEG_FIX_1_847759065, shift);
+
+		// Odd part
+		int32_t z2 = tmp5 + tmp6;
+		int32_t z3 = tmp4 + tmp6;
+		int32_t z4 = tmp5 + tmp7;
+		int32_t z5 = (z3 + z4) * JPEG_FIX_1_175875602;
+
+		z1 = (tmp4 + tmp7) * -JPEG_FIX_0_899976223;
+		z2 = z2 * -JPEG_FIX_2_562915447;
+		z3 = z3 * -JPEG_FIX_1_961570560 + z5;
+		z4 = z4 * -JPEG_FIX_0_390180644 + z5;
+
+		out[7] = _jpeg_descale(tmp4 * JPEG_FIX_0_298631336 + z1 + z3, shift);
+		out[5] = _jpeg_descale(tmp5 * JPEG_FIX_2_053119869 + z2 + z4, shift);
+		out[3] = _jpeg_descale(tmp6 * JPEG_FIX_3_072711026 + z2 + z3, shift);
+		out[1] = _jpeg_descale(tmp7 * JPEG_FIX_1_501321110 + z1 + z4, shift);
+	}
+}
+
+/**
+ * @brief Forward DCT of a block, coefficients (times 8) in natural order
+ */
+static void _jpeg_forward_dct(const int16_t* block, int32_t* coefficients)
+{
+	int32_t samples[64];
+	int32_t transposed[64];
+	uint32_t i = 0;
+
+	for (i = 0; i < 64; ++i)
+	{
+		samples[i] = block[i];
+	}
+
+	_jpeg_dct_pass(samples, transposed, 1);
+	_jpeg_dct_pass(transposed, coefficients, 2);
+}
+
+/**
+ * @brief Quantisation: division rounded to the nearest, symmetric around 0
+ */
+static void _jpeg_quantize(const int32_t* coefficients, const int32_t* reciprocal, int16_t* output)
+{
+	uint32_t i = 0;
+
+	for (i = 0; i < 64; ++i)
+	{
+		int32_t value = coefficients[i];
+		int32_t magnitude = (value < 0) ? -value : value;
+		int32_t quotient = (magnitude * reciprocal[i] + (1 << (JPEG_RECIPROCAL_BITS - 1))) >> JPEG_RECIPROCAL_BITS;
+
+		output[i] = (int16_t)((value < 0) ? -quotient : quotient);
+	}
+}
+#endif
+
+#if (JPEG_ENGINE == JPEG_ENGINE_MVE)
+/**
+ * @brief Expand 4 RGB565 pixels to 8-bit components
+ */
+static inline void _jpeg_expand_mve(uint32x4_t pixels, int32x4_t* r, int32x4_t* g, int32x4_t* b)
+{
+	uint32x4_t r5 = vandq_u32(vshrq_n_u32(pixels, 11), vdupq_n_u32(0x1Fu));
+	uint32x4_t g6 = vandq_u32(vshrq_n_u32(pixels, 5), vdupq_n_u32(0x3Fu));
+	uint32x4_t b5 = vandq_u32(pixels, vdupq_n_u32(0x1Fu));
+
+	*r = vreinterpretq_s32_u32(vorrq_u32(vshlq_n_u32(r5, 3), vshrq_n_u32(r5, 2)));
+	*g = vreinterpretq_s32_u32(vorrq_u32(vshlq_n_u32(g6, 2), vshrq_n_u32(g6, 4)));
+	*b = vreinterpretq_s32_u32(vorrq_u32(vshlq_n_u32(b5, 3), vshrq_n_u32(b5, 2)));
+}
+
+/**
+ * @brief Colour conversion and subsampling of the MCU at x, y, 4 pixels per vector
+ * Same arithmetic as the scalar engine: the luma of 4 consecutive pixels, the chroma of
+ * 4 groups of 2x2 pixels (even and odd pixels gathered from 2 lines)
+ */
+static void _jpeg_load_mcu(const uint8_t* image, uint16_t width, uint32_t x, uint32_t y, jpeg_mcu_t* mcu)
+{
+	const uint32x4_t even = vidupq_n_u32(0u, 2);
+	const uint32x4_t odd = vidupq_n_u32(1u, 2);
+	uint32_t row = 0;
+	uint32_t group = 0;
+
+	for (row = 0; row < JPEG_MCU_SIZE; ++row)
+	{
+		const uint16_t* line = (const uint16_t*)&image[(((y + row) * width) + x) * 2u];
+
+		for (group = 0; group < (JPEG_MCU_SIZE / 4); ++group)
+		{
+			int32x4_t r, g, b;
+			int32x4_t luma;
+
+			_jpeg_expand_mve(vldrhq_u32(&line[group * 4u]), &r, &g, &b);
+			luma = vmulq_n_s32(r, JPEG_Y_R);
+			luma = vmlaq_n_s32(luma, g, JPEG_Y_G);
+			luma = vmlaq_n_s32(luma, b, JPEG_Y_B);
+			luma = vsubq_n_s32(vshrq_n_s32(vaddq_n_s32(luma, 1 << 15), 16), 128);
+
+			vstrhq_s32(&mcu->y[((row >> 3) << 1) | (group >> 1)][((row & 7u) << 3) | ((group & 1u) << 2)], luma);
+		}
+
+		if ((row & 1u) == 0u)
+		{
+			continue;
+		}
+
+		// Chroma of the lines row - 1 and row
+		for (group = 0; group < (JPEG_MCU_SIZE / 8); ++group)
+		{
+			const uint16_t* top = &line[group * 8u] - width;
+			const uint16_t* bottom = &line[group * 8u];
+			int32x4_t r_sum, g_sum, b_sum;
+			int32x4_t r, g, b;
+			int32x4_t chroma;
+
+			_jpeg_expand_mve(vldrhq_gather_shifted_offset_u32(top, even), &r_sum, &g_sum, &b_sum);
+			_jpeg_expand_mve(vldrhq_gather_shifted_offset_u32(top, odd), &r, &g, &b);
+			r_sum = vaddq_s32(r_sum, r);
+			g_sum = vaddq_s32(g_sum, g);
+			b_sum = vaddq_s32(b_sum, b);
+			_jpeg_expand_mve(vldrhq_gather_shifted_offset_u32(bottom, even), &r, &g, &b);
+			r_sum = vaddq_s32(r_sum, r);
+			g_sum = vaddq_s32(g_sum, g);
+			b_sum = vaddq_s32(b_sum, b);
+			_jpeg_expand_mve(vldrhq_gather_shifted_offset_u32(bottom, odd), &r, &g, &b);
+			r_sum = vaddq_s32(r_sum, r);
+			g_sum = vaddq_s32(g_sum, g);
+			b_sum = vaddq_s32(b_sum, b);
+
+			chroma = vmulq_n_s32(r_sum, JPEG_CB_R);
+			chroma = vmlaq_n_s32(chroma, g_sum, JPEG_CB_G);
+			chroma = vmlaq_n_s32(chroma, b_sum, JPEG_CB_B);
+			vstrhq_s32(&mcu->cb[((row >> 1) << 3) | (group << 2)], vshrq_n_s32(vaddq_n_s32(chroma, 1 << 17), 18));
+
+			chroma = vmulq_n_s32(r_sum, JPEG_CR_R);
+			chroma = vmlaq_n_s32(chroma, g_sum, JPEG_CR_G);
+			chroma = vmlaq_n_s32(chroma, b_sum, JPEG_CR_B);
+			vstrhq_s32(&mcu->cr[((row >> 1) << 3) | (group << 2)], vshrq_n_s32(vaddq_n_s32(chroma, 1 << 17), 18));
+		}
+	}
+}
+
+/**
+ * @brief One dimensional DCT of 4 columns, one vector per row (in place)
+ * Same arithmetic as the scalar engine
+ */
+static inline void _jpeg_dct_vectors(int32x4_t* d, uint32_t pass)
+{
+	int32x4_t tmp0 = vaddq_s32(d[0], d[7]);
+	int32x4_t tmp7 = vsubq_s32(d[0], d[7]);
+	int32x4_t tmp1 = vaddq_s32(d[1], d[6]);
+	int32x4_t tmp6 = vsubq_s32(d[1], d[6]);
+	int32x4_t tmp2 = vaddq_s32(d[2], d[5]);
+	int32x4_t tmp5 = vsubq_s32(d[2], d[5]);
+	int32x4_t tmp3 = vaddq_s32(d[3], d[4]);
+	int32x4_t tmp4 = vsubq_s32(d[3], d[4]);
+
+	// Even part
+	int32x4_t tmp10 = vaddq_s32(tmp0, tmp3);
+	int32x4_t tmp13 = vsubq_s32(tmp0, tmp3);
+	int32x4_t tmp11 = vaddq_s32(tmp1, tmp2);
+	int32x4_t tmp12 = vsubq_s32(tmp1, tmp2);
+	int32x4_t z1 = vmulq_n_s32(vaddq_s32(tmp12, tmp13), JPEG_FIX_0_541196100);
+	int32x4_t even2 = vmlaq_n_s32(z1, tmp13, JPEG_FIX_0_765366865);
+	int32x4_t even6 = vmlaq_n_s32(z1, tmp12, -JPEG_FIX_1_847759065);
+
+	// Odd part
+	int32x4_t z2 = vaddq_s32(tmp5, tmp6);
+	int32x4_t z3 = vaddq_s32(tmp4, tmp6);
+	int32x4_t z4 = vaddq_s32(tmp5, tmp7);
+	int32x4_t z5 = vmulq_n_s32(vaddq_s32(z3, z4), JPEG_FIX_1_175875602);
+
+	z1 = vmulq_n_s32(vaddq_s32(tmp4, tmp7), -JPEG_FIX_0_899976223);
+	z2 = vmulq_n_s32(z2, -JPEG_FIX_2_562915447);
+	z3 = vmlaq_n_s32(z5, z3, -JPEG_FIX_1_961570560);
+	z4 = vmlaq_n_s32(z5, z4, -JPEG_FIX_0_390180644);
+
+	int32x4_t odd7 = vmlaq_n_s32(vaddq_s32(z1, z3), tmp4, JPEG_FIX_0_298631336);
+	int32x4_t odd5 = vmlaq_n_s32(vaddq_s32(z2, z4), tmp5, JPEG_FIX_2_053119869);
+	int32x4_t odd3 = vmlaq_n_s32(vaddq_s32(z2, z3), tmp6, JPEG_FIX_3_072711026);
+	int32x4_t odd1 = vmlaq_n_s32(vaddq_s32(z1, z4), tmp7, JPEG_FIX_1_501321110);
+
+	// The shifts are immediates
+	if (pass == 1)
+	{
+		d[0] = vshlq_n_s32(vaddq_s32(tmp10, tmp11), JPEG_PASS1_BITS);
+		d[4] = vshlq_n_s32(vsubq_s32(tmp10, tmp11), JPEG_PASS1_BITS);
+		d[2] = vrshrq_n_s32(even2, JPEG_CONST_BITS - JPEG_PASS1_BITS);
+		d[6] = vrshrq_n_s32(even6, JPEG_CONST_BITS - JPEG_PASS1_BITS);
+		d[7] = vrshrq_n_s32(odd7, JPEG_CONST_BITS - JPEG_PASS1_BITS);
+		d[5] = vrshrq_n_s32(odd5, JPEG_CONST_BITS - JPEG_PASS1_BITS);
+		d[3] = vrshrq_n_s32(odd3, JPEG_CONST_BITS - JPEG_PASS1_BITS);
+		d[1] = vrshrq_n_s32(odd1, JPEG_CONST_BITS - JPEG_PASS1_BITS);
+	}
+	else
+	{
+		d[0] = vrshrq_n_s32(vaddq_s32(tmp10, tmp11), JPEG_PASS1_BITS);
+		d[4] = vrshrq_n_s32(vsubq_s32(tmp10, tmp11), JPEG_PASS1_BITS);
+		d[2] = vrshrq_n_s32(even2, JPEG_CONST_BITS + JPEG_PASS1_BITS);
+		d[6] = vrshrq_n_s32(even6, JPEG_CONST_BITS + JPEG_PASS1_BITS);
+		d[7] = vrshrq_n_s32(odd7, JPEG_CONST_BITS + JPEG_PASS1_BITS);
+		d[5] = vrshrq_n_s32(odd5, JPEG_CONST_BITS + JPEG_PASS1_BITS);
+		d[3] = vrshrq_n_s32(odd3, JPEG_CONST_BITS + JPEG_PASS1_BITS);
+		d[1] = vrshrq_n_s32(odd1, JPEG_CONST_BITS + JPEG_PASS1_BITS);
+	}
+}
+
+/**
+ * @brief Forward DCT of a block, coefficients (times 8) in natural order
+ * Each pass computes 4 columns at once and transposes with scatter stores
+ */
+static void _jpeg_forward_dct(const int16_t* block, int32_t* coefficients)
+{
+	const uint32x4_t rows = vidupq_n_u32(0u, 8);
+	int32_t transposed[64];
+	int32x4_t d[8];
+	uint32_t half = 0;
+	uint32_t k = 0;
+
+	for (half = 0; half < 2; ++half)
+	{
+		for (k = 0; k < 8; ++k)
+		{
+			d[k] = vldrhq_s32(&block[(k * 8u) + (half * 4u)]);
+		}
+		_jpeg_dct_vectors(d, 1);
+		for (k = 0; k < 8; ++k)
+		{
+			vstrwq_scatter_shifted_offset_s32(&transposed[(half * 32u) + k], rows, d[k]);
+		}
+	}
+
+	for (half = 0; half < 2; ++half)
+	{
+		for (k = 0; k < 8; ++k)
+		{
+			d[k] = vld1q_s32(&transposed[(k * 8u) + (half * 4u)]);
+		}
+		_jpeg_dct_vectors(d, 2);
+		for (k = 0; k < 8; ++k)
+		{
+			vstrwq_scatter_shifted_offset_s32(&coefficients[(half * 32u) + k], rows, d[k]);
+		}
+	}
+}
+
+/**
+ * @brief Quantisation: division rounded to the nearest, symmetric around 0
+ */
+static void _jpeg_quantize(const int32_t* coefficients, const int32_t* reciprocal, int16_t* output)
+{
+	uint32_t i = 0;
+
+	for (i = 0; i < 64; i += 4)
+	{
+		int32x4_t value = vld1q_s32(&coefficients[i]);
+		int32x4_t quotient = vmulq_s32(vabsq_s32(value), vld1q_s32(&reciprocal[i]));
+
+		quotient = vshrq_n_s32(vaddq_n_s32(quotient, 1 << (JPEG_RECIPROCAL_BITS - 1)), JPEG_RECIPROCAL_BITS);
+		quotient = vpselq_s32(vnegq_s32(quotient), quotient, vcmpltq_n_s32(value, 0));
+		vstrhq_s32(&output[i], quotient);
+	}
+}
+#endif
+
+/**
+ * @brief Transform, quantise and encode a block
+ */
+static void _jpeg_process_block(const jpeg_encoder_t* encoder, jpeg_writer_t* writer,
+		const int16_t* block, uint32_t table, int32_t* last_dc)
+{
+	int32_t coefficients[64];
+	int16_t quantized[64];
+
+	_jpeg_forward_dct(block, coefficients);
+	_jpeg_quantize(coefficients, encoder->reciprocal[table], quantized);
+	_jpeg_encode_block(encoder, writer, quantized, last_dc,
+			(table == 0) ? JPEG_HUFF_DC_LUMA : JPEG_HUFF_DC_CHROMA);
+}
+
+int jpeg_encoder_init(jpeg_encoder_t* encoder, uint8_t quality)
+{
+	uint32_t scale = 0;
+	uint32_t table = 0;
+	uint32_t i = 0;
+
+	if ((quality < 1) || (quality > 100))
+	{
+		return JPEG_ERROR_PARAM;
+	}
+
+	memset(encoder, 0, sizeof(jpeg_encoder_t));
+	encoder->quality = quality;
+
+	// Scaling of the standard tables (same as libjpeg)
+	scale = (quality < 50) ? (5000u / quality) : (200u - 2u * quality);
+
+	for (table = 0; table < 2; ++table)
+	{
+		for (i = 0; i < 64; ++i)
+		{
+			uint32_t natural = jpeg_zigzag[i];
+			uint32_t value = ((jpeg_std_quant[table][natural] * scale) + 50u) / 100u;
+
+			if (value < 1u) value = 1u;
+			if (value > 255u) value = 255u;
+
+			encoder->quant[table][i] = (uint8_t)value;
+
+			// The DCT output is 8 times the coefficient
+			encoder->reciprocal[table][natural] = (int32_t)(((1u << JPEG_RECIPROCAL_BITS) + (4u * value)) / (8u * value));
+		}
+	}
+
+	// Canonical Huffman codes (JPEG standard, Annex C)
+	for (table = 0; table < 4; ++table)
+	{
+		uint32_t code = 0;
+		uint32_t k = 0;
+		uint32_t length = 0;
+
+		for (length = 1; length <= 16; ++length)
+		{
+			for (i = 0; i < jpeg_huff_bits[table][length - 1]; ++i)
+			{
+				uint8_t symbol = jpeg_huff_values[table][k++];
+
+				encoder->huff_code[table][symbol] = (uint16_t)code;
+				encoder->huff_size[table][symbol] = (uint8_t)length;
+				code++;
+			}
+			code <<= 1;
+		}
+	}
+
+	return 0;
+}
+
+int32_t jpeg_encode_rgb565(const jpeg_encoder_t* encoder, const uint8_t* image,
+		uint16_t width, uint16_t height, uint8_t* output, uint32_t output_size)
+{
+	jpeg_writer_t writer;
+	jpeg_mcu_t mcu;
+	int32_t last_dc[3] = { 0, 0, 0 };
+	uint32_t x = 0;
+	uint32_t y = 0;
+	uint32_t i = 0;
+
+	if ((encoder->quality == 0) || (width == 0) || (height == 0)
+			|| ((width % JPEG_MCU_SIZE) != 0) || ((height % JPEG_MCU_SIZE) != 0))
+	{
+		return JPEG_ERROR_PARAM;
+	}
+
+	memset(&writer, 0, sizeof(writer));
+	writer.buffer = output;
+	writer.size = output_size;
+
+	_jpeg_write_headers(encoder, &writer, width, height);
+
+	for (y = 0; (y < height) && !writer.overflow; y += JPEG_MCU_SIZE)
+	{
+		for (x = 0; x < width; x += JPEG_MCU_SIZE)
+		{
+			_jpeg_load_mcu(image, width, x, y, &mcu);
+
+			for (i = 0; i < 4; ++i)
+			{
+				_jpeg_process_block(encoder, &writer, mcu.y[i], 0, &last_dc[0]);
+			}
+			_jpeg_process_block(encoder, &writer, mcu.cb, 1, &last_dc[1]);
+			_jpeg_process_block(encoder, &writer, mcu.cr, 1, &last_dc[2]);
+		}
+	}
+
+	_jpeg_flush_bits(&writer);
+	_jpeg_put_marker(&writer, JPEG_MARKER_EOI);
+
+	if (writer.overflow)
+	{
+		return JPEG_ERROR_OVERFLOW;
+	}
+
+	return (int32_t)writer.position;
+}
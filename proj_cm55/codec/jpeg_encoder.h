@@ -0,0 +1,104 @@
+/*
+ * jpeg_encoder.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Baseline JPEG encoder (JFIF, YCbCr 4:2:0, standard Huffman tables)
+ * for RGB565 frames (little endian pixels, red in the upper bits)
+ *
+ * This file and jpeg_encoder.c only depend on the C standard library:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef CODEC_JPEG_ENCODER_H_
+#define CODEC_JPEG_ENCODER_H_
+
+#include <stdint.h>
+
+/**
+ * @def JPEG_ENGINE_SCALAR
+ * Portable implementation
+ */
+#define JPEG_ENGINE_SCALAR	0
+
+/**
+ * @def JPEG_ENGINE_MVE
+ * Colour conversion, DCT and quantisation with Helium (MVE), 4 pixels or coefficients per instruction
+ * Only available if the compiler targets a core with MVE (Cortex-M55)
+ */
+#define JPEG_ENGINE_MVE		1
+
+/**
+ * @def JPEG_ENGINE
+ * Engine used by jpeg_encode_rgb565, selected at build time
+ * Both engines produce the same bytes
+ */
+#ifndef JPEG_ENGINE
+#if defined(__ARM_FEATURE_MVE)
+#define JPEG_ENGINE			JPEG_ENGINE_MVE
+#else
+#define JPEG_ENGINE			JPEG_ENGINE_SCALAR
+#endif
+#endif
+
+/**
+ * @def JPEG_MCU_SIZE
+ * The width and the height of the frames must be multiples of this value (4:2:0 subsampling)
+ */
+#define JPEG_MCU_SIZE		16
+
+/**
+ * Errors
+ */
+#define JPEG_ERROR_PARAM	-1	/**< Invalid quality or dimensions */
+#define JPEG_ERROR_OVERFLOW	-2	/**< Output buffer too small */
+
+/**
+ * Encoder: quantisation and Huffman tables for a given quality
+ */
+typedef struct
+{
+	uint8_t quality;
+	uint8_t quant[2][64];			/**< Luma / chroma, zigzag order (as written in the file) */
+	int32_t reciprocal[2][64];		/**< 2^16 / divisor of the DCT output, natural order */
+	uint16_t huff_code[4][256];		/**< DC luma, AC luma, DC chroma, AC chroma */
+	uint8_t huff_size[4][256];
+} jpeg_encoder_t;
+
+/**
+ * @brief Prepare the tables of the encoder
+ *
+ * @param [out] encoder Encoder
+ * @param [in] quality 1 (smallest) to 100 (best), same scale as libjpeg
+ *
+ * @retval 0 Success
+ * @retval JPEG_ERROR_PARAM Invalid quality
+ */
+int jpeg_encoder_init(jpeg_encoder_t* encoder, uint8_t quality);
+
+/**
+ * @brief Encode a RGB565 frame
+ *
+ * @param [in] encoder Encoder prepared by jpeg_encoder_init
+ * @param [in] image Pixels, width * height * 2 bytes
+ * @param [in] width Width of the frame (multiple of JPEG_MCU_SIZE)
+ * @param [in] height Height of the frame (multiple of JPEG_MCU_SIZE)
+ * @param [out] output Buffer receiving the JPEG file
+ * @param [in] output_size Size of the buffer
+ *
+ * @retval Size of the JPEG file
+ * @retval JPEG_ERROR_PARAM Invalid dimensions
+ * @retval JPEG_ERROR_OVERFLOW Output buffer too small
+ */
+int32_t jpeg_encode_rgb565(const jpeg_encoder_t* encoder, const uint8_t* image,
+		uint16_t width, uint16_t height, uint8_t* output, uint32_t output_size);
+
+#endif /* CODEC_JPEG_ENCODER_H_ */
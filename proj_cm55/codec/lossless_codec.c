@@ -0,0 +1,345 @@
+/*
+ * lossless_codec.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "lossless_codec.h"
+
+#include <stddef.h>
+
+#if (LOSSLESS_ENGINE == LOSSLESS_ENGINE_MVE)
+#if !defined(__ARM_FEATURE_MVE)
+#error "LOSSLESS_ENGINE_MVE requires a core supporting Helium (MVE)"
+#endif
+#include <arm_mve.h>
+#elif (LOSSLESS_ENGINE != LOSSLESS_ENGINE_SCALAR)
+#error "Unknown LOSSLESS_ENGINE"
+#endif
+
+/**
+ * Components of a pixel
+ */
+#define LOSSLESS_MASK_R		0xF800u
+#define LOSSLESS_MASK_G		0x07E0u
+#define LOSSLESS_MASK_B		0x001Fu
+
+/**
+ * Operations
+ */
+#define LOSSLESS_OP_RUN		0x00u
+#define LOSSLESS_OP_SMALL	0x40u
+#define LOSSLESS_OP_MEDIUM	0x80u
+#define LOSSLESS_OP_LITERAL	0xC0u
+#define LOSSLESS_OP_MASK	0xC0u
+
+#define LOSSLESS_MAX_RUN	64u
+
+/**
+ * @def LOSSLESS_CHUNK
+ * Number of residuals computed at once (stack usage of the encoder)
+ */
+#define LOSSLESS_CHUNK		64u
+
+#if (LOSSLESS_ENGINE == LOSSLESS_ENGINE_SCALAR)
+/**
+ * @brief Residuals of count pixels: difference per component with the pixel above
+ * The borrow of a component is removed by the mask
+ */
+static void _lossless_residuals(const uint16_t* line, const uint16_t* above, uint16_t* residuals, uint32_t count)
+{
+	uint32_t i = 0;
+
+	if (above == NULL)
+	{
+		for (i = 0; i < count; ++i)
+		{
+			residuals[i] = line[i];
+		}
+		return;
+	}
+
+	for (i = 0; i < count; ++i)
+	{
+		uint32_t pixel = line[i];
+		uint32_t up = above[i];
+
+		residuals[i] = (uint16_t)((((pixel & LOSSLESS_MASK_R) - (up & LOSSLESS_MASK_R)) & LOSSLESS_MASK_R)
+				| (((pixel & LOSSLESS_MASK_G) - (up & LOSSLESS_MASK_G)) & LOSSLESS_MASK_G)
+				| (((pixel & LOSSLESS_MASK_B) - (up & LOSSLESS_MASK_B)) & LOSSLESS_MASK_B));
+	}
+}
+#endif
+
+#if (LOSSLESS_ENGINE == LOSSLESS_ENGINE_MVE)
+/**
+ * @brief Residuals of count pixels, 8 pixels per vector (tail predicated)
+ */
+static void _lossless_residuals(const uint16_t* line, const uint16_t* above, uint16_t* residuals, uint32_t count)
+{
+	const uint16x8_t mask_r = vdupq_n_u16(LOSSLESS_MASK_R);
+	const uint16x8_t mask_g = vdupq_n_u16(LOSSLESS_MASK_G);
+	const uint16x8_t mask_b = vdupq_n_u16(LOSSLESS_MASK_B);
+	uint32_t i = 0;
+
+	for (i = 0; i < count; i += 8u)
+	{
+		mve_pred16_t predicate = vctp16q(count - i);
+		uint16x8_t pixel = vldrhq_z_u16(&line[i], predicate);
+		uint16x8_t up = (above != NULL) ? vldrhq_z_u16(&above[i], predicate) : vdupq_n_u16(0u);
+		uint16x8_t r = vandq_u16(vsubq_u16(vandq_u16(pixel, mask_r), vandq_u16(up, mask_r)), mask_r);
+		uint16x8_t g = vandq_u16(vsubq_u16(vandq_u16(pixel, mask_g), vandq_u16(up, mask_g)), mask_g);
+		uint16x8_t b = vandq_u16(vsubq_u16(vandq_u16(pixel, mask_b), vandq_u16(up, mask_b)), mask_b);
+
+		vstrhq_p_u16(&residuals[i], vorrq_u16(vorrq_u16(r, g), b), predicate);
+	}
+}
+#endif
+
+static void _lossless_put(lossless_encoder_t* encoder, uint8_t value)
+{
+	if (encoder->position >= encoder->size)
+	{
+		encoder->overflow = 1;
+		return;
+	}
+
+	encoder->output[encoder->position++] = value;
+}
+
+/**
+ * @brief Sign extension of a component of a residual
+ */
+static int32_t _lossless_signed(uint32_t value, uint32_t bits)
+{
+	return (value >= (1u << (bits - 1))) ? ((int32_t)value - (int32_t)(1u << bits)) : (int32_t)value;
+}
+
+/**
+ * @brief Code a residual different from 0 with the shortest operation
+ */
+static void _lossless_put_residual(lossless_encoder_t* encoder, uint16_t residual)
+{
+	int32_t dr = _lossless_signed((residual >> 11) & 0x1Fu, 5);
+	int32_t dg = _lossless_signed((residual >> 5) & 0x3Fu, 6);
+	int32_t db = _lossless_signed(residual & 0x1Fu, 5);
+	int32_t half = dg >> 1;
+	int32_t dr_dg = dr - half;
+	int32_t db_dg = db - half;
+
+	if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1))
+	{
+		_lossless_put(encoder, (uint8_t)(LOSSLESS_OP_SMALL | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+	}
+	else if ((dr_dg >= -8) && (dr_dg <= 7) && (db_dg >= -8) && (db_dg <= 7))
+	{
+		_lossless_put(encoder, (uint8_t)(LOSSLESS_OP_MEDIUM | (dg + 32)));
+		_lossless_put(encoder, (uint8_t)(((dr_dg + 8) << 4) | (db_dg + 8)));
+	}
+	else
+	{
+		_lossless_put(encoder, LOSSLESS_OP_LITERAL);
+		_lossless_put(encoder, (uint8_t)residual);
+		_lossless_put(encoder, (uint8_t)(residual >> 8));
+	}
+}
+
+void lossless_encoder_start(lossless_encoder_t* encoder, uint16_t width, uint8_t* output, uint32_t output_size)
+{
+	encoder->output = output;
+	encoder->size = output_size;
+	encoder->position = 0;
+	encoder->width = width;
+	encoder->previous = NULL;
+	encoder->overflow = 0;
+}
+
+int lossless_encoder_line(lossless_encoder_t* encoder, const uint16_t* line)
+{
+	uint16_t residuals[LOSSLESS_CHUNK];
+	uint32_t run = 0;
+	uint32_t x = 0;
+
+	if (encoder->overflow)
+	{
+		return LOSSLESS_ERROR_OVERFLOW;
+	}
+
+	for (x = 0; x < encoder->width; x += LOSSLESS_CHUNK)
+	{
+		uint32_t count = encoder->width - x;
+		uint32_t i = 0;
+
+		if (count > LOSSLESS_CHUNK)
+		{
+			count = LOSSLESS_CHUNK;
+		}
+
+		_lossless_residuals(&line[x], (encoder->previous != NULL) ? &encoder->previous[x] : NULL, residuals, count);
+
+		for (i = 0; i < count; ++i)
+		{
+			if (residuals[i] == 0)
+			{
+				run++;
+				if (run == LOSSLESS_MAX_RUN)
+				{
+					_lossless_put(encoder, (uint8_t)(LOSSLESS_OP_RUN | (run - 1u)));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run != 0)
+			{
+				_lossless_put(encoder, (uint8_t)(LOSSLESS_OP_RUN | (run - 1u)));
+				run = 0;
+			}
+
+			_lossless_put_residual(encoder, residuals[i]);
+		}
+	}
+
+	// Runs end with the line
+	if (run != 0)
+	{
+		_lossless_put(encoder, (uint8_t)(LOSSLESS_OP_RUN | (run - 1u)));
+	}
+
+	encoder->previous = line;
+
+	return encoder->overflow ? LOSSLESS_ERROR_OVERFLOW : 0;
+}
+
+int32_t lossless_encoder_finish(const lossless_encoder_t* encoder)
+{
+	if (encoder->overflow)
+	{
+		return LOSSLESS_ERROR_OVERFLOW;
+	}
+
+	return (int32_t)encoder->position;
+}
+
+int32_t lossless_encode_rgb565(const uint16_t* image, uint16_t width, uint16_t height,
+		uint8_t* output, uint32_t output_size)
+{
+	lossless_encoder_t encoder;
+	uint32_t y = 0;
+
+	if ((width == 0) || (height == 0))
+	{
+		return LOSSLESS_ERROR_PARAM;
+	}
+
+	lossless_encoder_start(&encoder, width, output, output_size);
+	for (y = 0; y < height; ++y)
+	{
+		if (lossless_encoder_line(&encoder, &image[y * width]) != 0)
+		{
+			break;
+		}
+	}
+
+	return lossless_encoder_finish(&encoder);
+}
+
+int lossless_decode_rgb565(const uint8_t* input, uint32_t input_size, uint16_t width, uint16_t height,
+		uint16_t* image)
+{
+	uint32_t position = 0;
+	uint32_t y = 0;
+
+	if ((width == 0) || (height == 0))
+	{
+		return LOSSLESS_ERROR_PARAM;
+	}
+
+	for (y = 0; y < height; ++y)
+	{
+		uint16_t* line = &image[y * width];
+		const uint16_t* above = (y > 0) ? (line - width) : NULL;
+		uint32_t x = 0;
+
+		while (x < width)
+		{
+			uint32_t residual = 0;
+			uint8_t op = 0;
+
+			if (position >= input_size)
+			{
+				return LOSSLESS_ERROR_DATA;
+			}
+
+			op = input[position++];
+			switch (op & LOSSLESS_OP_MASK)
+			{
+				case LOSSLESS_OP_RUN:
+				{
+					uint32_t run = (op & 0x3Fu) + 1u;
+
+					if ((x + run) > width)
+					{
+						return LOSSLESS_ERROR_DATA;
+					}
+					for (; run > 0; --run, ++x)
+					{
+						line[x] = (above != NULL) ? above[x] : 0u;
+					}
+					continue;
+				}
+
+				case LOSSLESS_OP_SMALL:
+					residual = ((uint32_t)(((op >> 4) & 3) - 2) & 0x1Fu) << 11
+						| ((uint32_t)(((op >> 2) & 3) - 2) & 0x3Fu) << 5
+						| ((uint32_t)((op & 3) - 2) & 0x1Fu);
+					break;
+
+				case LOSSLESS_OP_MEDIUM:
+				{
+					int32_t dg = (int32_t)(op & 0x3Fu) - 32;
+					int32_t half = dg >> 1;
+
+					if (position >= input_size)
+					{
+						return LOSSLESS_ERROR_DATA;
+					}
+					residual = ((uint32_t)(((input[position] >> 4) - 8) + half) & 0x1Fu) << 11
+						| ((uint32_t)dg & 0x3Fu) << 5
+						| ((uint32_t)(((input[position] & 0x0F) - 8) + half) & 0x1Fu);
+					position++;
+					break;
+				}
+
+				default:
+					if ((op != LOSSLESS_OP_LITERAL) || ((position + 2u) > input_size))
+					{
+						return LOSSLESS_ERROR_DATA;
+					}
+					residual = (uint32_t)input[position] | ((uint32_t)input[position + 1u] << 8);
+					position += 2u;
+					break;
+			}
+
+			if (above != NULL)
+			{
+				uint32_t up = above[x];
+
+				residual = (((up & LOSSLESS_MASK_R) + (residual & LOSSLESS_MASK_R)) & LOSSLESS_MASK_R)
+					| (((up & LOSSLESS_MASK_G) + (residual & LOSSLESS_MASK_G)) & LOSSLESS_MASK_G)
+					| (((up & LOSSLESS_MASK_B) + (residual & LOSSLESS_MASK_B)) & LOSSLESS_MASK_B);
+			}
+			line[x++] = (uint16_t)residual;
+		}
+	}
+
+	return (position == input_size) ? 0 : LOSSLESS_ERROR_DATA;
+}
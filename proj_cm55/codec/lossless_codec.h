@@ -0,0 +1,157 @@
+/*
+ * lossless_codec.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Lossless codec for RGB565 frames (little endian pixels, red in the upper bits)
+ *
+ * Each pixel is predicted by the pixel above (0 for the first line). The residual
+ * (difference per component, modulo the size of the component) is coded with
+ * byte aligned operations:
+ *
+ * | Operation | Bytes | Encoding                                                       |
+ * |-----------|-------|----------------------------------------------------------------|
+ * | Run       | 1     | 00nnnnnn: n + 1 pixels equal to the pixel above (1 to 64)      |
+ * | Small     | 1     | 01rrggbb: dr, dg, db in -2..1 (stored + 2)                     |
+ * | Medium    | 2     | 10gggggg rrrrbbbb: dg in -32..31 (+ 32), dr - dg/2 and         |
+ * |           |       | db - dg/2 in -8..7 (+ 8), dg/2 rounded towards minus infinity  |
+ * | Literal   | 3     | 11000000 then the residual (16 bits, little endian)            |
+ *
+ * The codes 11000001 to 11111111 are reserved. A run never crosses the end of a line:
+ * the frame can be encoded line by line and only the previous line is needed.
+ *
+ * This file and lossless_codec.c only depend on the C standard library:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef CODEC_LOSSLESS_CODEC_H_
+#define CODEC_LOSSLESS_CODEC_H_
+
+#include <stdint.h>
+
+/**
+ * @def LOSSLESS_ENGINE_SCALAR
+ * Portable implementation
+ */
+#define LOSSLESS_ENGINE_SCALAR	0
+
+/**
+ * @def LOSSLESS_ENGINE_MVE
+ * Residuals computed with Helium (MVE), 8 pixels per instruction
+ * Only available if the compiler targets a core with MVE (Cortex-M55)
+ */
+#define LOSSLESS_ENGINE_MVE		1
+
+/**
+ * @def LOSSLESS_ENGINE
+ * Engine used by the encoder, selected at build time
+ * Both engines produce the same bytes
+ */
+#ifndef LOSSLESS_ENGINE
+#if defined(__ARM_FEATURE_MVE)
+#define LOSSLESS_ENGINE			LOSSLESS_ENGINE_MVE
+#else
+#define LOSSLESS_ENGINE			LOSSLESS_ENGINE_SCALAR
+#endif
+#endif
+
+/**
+ * @def LOSSLESS_MAX_BYTES_PER_PIXEL
+ * Worst case size of a pixel (literal)
+ */
+#define LOSSLESS_MAX_BYTES_PER_PIXEL	3
+
+/**
+ * Errors
+ */
+#define LOSSLESS_ERROR_PARAM	-1	/**< Invalid dimensions */
+#define LOSSLESS_ERROR_OVERFLOW	-2	/**< Output buffer too small */
+#define LOSSLESS_ERROR_DATA		-3	/**< Corrupted data (decoder) */
+
+/**
+ * Encoder, state kept between the lines of a frame
+ */
+typedef struct
+{
+	uint8_t* output;
+	uint32_t size;
+	uint32_t position;
+	uint16_t width;
+	const uint16_t* previous;	/**< Line above, NULL for the first line */
+	int overflow;
+} lossless_encoder_t;
+
+/**
+ * @brief Start the encoding of a frame
+ *
+ * @param [out] encoder Encoder
+ * @param [in] width Number of pixels per line
+ * @param [out] output Buffer receiving the encoded frame
+ * @param [in] output_size Size of the buffer
+ */
+void lossless_encoder_start(lossless_encoder_t* encoder, uint16_t width, uint8_t* output, uint32_t output_size);
+
+/**
+ * @brief Encode the next line of the frame
+ * The previous line must stay unchanged until this line has been encoded
+ * (e.g. the lines are encoded in place, in the frame buffer)
+ *
+ * @param [in,out] encoder Encoder
+ * @param [in] line Pixels of the line
+ *
+ * @retval 0 Success
+ * @retval LOSSLESS_ERROR_OVERFLOW Output buffer too small (the following lines are ignored)
+ */
+int lossless_encoder_line(lossless_encoder_t* encoder, const uint16_t* line);
+
+/**
+ * @brief End the encoding of a frame
+ *
+ * @param [in] encoder Encoder
+ *
+ * @retval Size of the encoded frame
+ * @retval LOSSLESS_ERROR_OVERFLOW Output buffer too small
+ */
+int32_t lossless_encoder_finish(const lossless_encoder_t* encoder);
+
+/**
+ * @brief Encode a whole frame
+ *
+ * @param [in] image Pixels, width * height
+ * @param [in] width Number of pixels per line
+ * @param [in] height Number of lines
+ * @param [out] output Buffer receiving the encoded frame
+ * @param [in] output_size Size of the buffer
+ *
+ * @retval Size of the encoded frame
+ * @retval LOSSLESS_ERROR_PARAM Invalid dimensions
+ * @retval LOSSLESS_ERROR_OVERFLOW Output buffer too small
+ */
+int32_t lossless_encode_rgb565(const uint16_t* image, uint16_t width, uint16_t height,
+		uint8_t* output, uint32_t output_size);
+
+/**
+ * @brief Decode a frame (reference decoder)
+ *
+ * @param [in] input Encoded frame
+ * @param [in] input_size Size of the encoded frame
+ * @param [in] width Number of pixels per line
+ * @param [in] height Number of lines
+ * @param [out] image Pixels, width * height
+ *
+ * @retval 0 Success
+ * @retval LOSSLESS_ERROR_PARAM Invalid dimensions
+ * @retval LOSSLESS_ERROR_DATA Corrupted data or size not matching the dimensions
+ */
+int lossless_decode_rgb565(const uint8_t* input, uint32_t input_size, uint16_t width, uint16_t height,
+		uint16_t* image);
+
+#endif /* CODEC_LOSSLESS_CODEC_H_ */
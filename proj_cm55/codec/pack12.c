@@ -0,0 +1,105 @@
+/*
+ * pack12.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "pack12.h"
+
+#if (PACK12_ENGINE == PACK12_ENGINE_MVE)
+#if !defined(__ARM_FEATURE_MVE)
+#error "PACK12_ENGINE_MVE requires a core supporting Helium (MVE)"
+#endif
+#include <arm_mve.h>
+#elif (PACK12_ENGINE != PACK12_ENGINE_SCALAR)
+#error "Unknown PACK12_ENGINE"
+#endif
+
+/**
+ * @brief Pack the samples from index i, one pair at a time
+ * In place: the 3 bytes of a pair are written after both samples have been read
+ */
+static uint32_t _pack12_pack_scalar(const uint16_t* samples, uint32_t i, uint32_t count, uint8_t* output)
+{
+	uint8_t* out = &output[(i / 2u) * 3u];
+
+	for (; (i + 1u) < count; i += 2u)
+	{
+		uint32_t first = samples[i] & 0x0FFFu;
+		uint32_t second = samples[i + 1u] & 0x0FFFu;
+
+		out[0] = (uint8_t)first;
+		out[1] = (uint8_t)((first >> 8) | (second << 4));
+		out[2] = (uint8_t)(second >> 4);
+		out += 3;
+	}
+
+	if (i < count)
+	{
+		uint32_t last = samples[i] & 0x0FFFu;
+
+		out[0] = (uint8_t)last;
+		out[1] = (uint8_t)(last >> 8);
+	}
+
+	return PACK12_SIZE(count);
+}
+
+#if (PACK12_ENGINE == PACK12_ENGINE_SCALAR)
+uint32_t pack12_pack(const uint16_t* samples, uint32_t count, uint8_t* output)
+{
+	return _pack12_pack_scalar(samples, 0, count, output);
+}
+#endif
+
+#if (PACK12_ENGINE == PACK12_ENGINE_MVE)
+uint32_t pack12_pack(const uint16_t* samples, uint32_t count, uint8_t* output)
+{
+	// Byte offsets of the 8 pairs in the 24 output bytes
+	static const uint16_t offsets_init[8] = { 0, 3, 6, 9, 12, 15, 18, 21 };
+	const uint16x8_t offsets = vld1q_u16(offsets_init);
+	const uint16x8_t mask = vdupq_n_u16(0x0FFFu);
+	uint32_t i = 0;
+
+	// In place: the 32 bytes of a block are loaded before its 24 bytes are stored
+	for (i = 0; (i + 16u) <= count; i += 16u)
+	{
+		uint16x8x2_t pairs = vld2q_u16(&samples[i]);
+		uint16x8_t first = vandq_u16(pairs.val[0], mask);
+		uint16x8_t second = vandq_u16(pairs.val[1], mask);
+		uint8_t* out = &output[(i / 2u) * 3u];
+
+		// The scatter stores keep the low byte of each lane
+		vstrbq_scatter_offset_u16(out, offsets, first);
+		vstrbq_scatter_offset_u16(&out[1], offsets, vorrq_u16(vshrq_n_u16(first, 8), vshlq_n_u16(second, 4)));
+		vstrbq_scatter_offset_u16(&out[2], offsets, vshrq_n_u16(second, 4));
+	}
+
+	return _pack12_pack_scalar(samples, i, count, output);
+}
+#endif
+
+void pack12_unpack(const uint8_t* input, uint32_t count, uint16_t* samples)
+{
+	uint32_t i = 0;
+
+	for (i = 0; (i + 1u) < count; i += 2u)
+	{
+		samples[i] = (uint16_t)(input[0] | ((input[1] & 0x0Fu) << 8));
+		samples[i + 1u] = (uint16_t)((input[1] >> 4) | (input[2] << 4));
+		input += 3;
+	}
+
+	if (i < count)
+	{
+		samples[i] = (uint16_t)(input[0] | ((input[1] & 0x0Fu) << 8));
+	}
+}
@@ -0,0 +1,88 @@
+/*
+ * pack12.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Packing of 12 bits samples (radar ADC): two samples in three bytes
+ *
+ * | Byte | Bits                                        |
+ * |------|---------------------------------------------|
+ * | 0    | Bits 7..0 of the first sample               |
+ * | 1    | Bits 11..8 of the first sample (low nibble) |
+ * |      | Bits 3..0 of the second sample (high nibble)|
+ * | 2    | Bits 11..4 of the second sample             |
+ *
+ * i.e. the 24 bits little endian word first | (second << 12). An odd last sample
+ * is stored in 2 bytes (bytes 0 and 1, high nibble 0).
+ *
+ * This file and pack12.c only depend on the C standard library:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef CODEC_PACK12_H_
+#define CODEC_PACK12_H_
+
+#include <stdint.h>
+
+/**
+ * @def PACK12_ENGINE_SCALAR
+ * Portable implementation
+ */
+#define PACK12_ENGINE_SCALAR	0
+
+/**
+ * @def PACK12_ENGINE_MVE
+ * Packing with Helium (MVE), 16 samples per iteration
+ * Only available if the compiler targets a core with MVE (Cortex-M55)
+ */
+#define PACK12_ENGINE_MVE		1
+
+/**
+ * @def PACK12_ENGINE
+ * Engine used by pack12_pack, selected at build time
+ * Both engines produce the same bytes
+ */
+#ifndef PACK12_ENGINE
+#if defined(__ARM_FEATURE_MVE)
+#define PACK12_ENGINE			PACK12_ENGINE_MVE
+#else
+#define PACK12_ENGINE			PACK12_ENGINE_SCALAR
+#endif
+#endif
+
+/**
+ * @def PACK12_SIZE
+ * Size of count packed samples
+ */
+#define PACK12_SIZE(count)		((((uint32_t)(count) * 3u) + 1u) / 2u)
+
+/**
+ * @brief Pack 12 bits samples (the upper 4 bits of each sample are ignored)
+ * The output can be the buffer of the samples (packing in place)
+ *
+ * @param [in] samples Samples
+ * @param [in] count Number of samples
+ * @param [out] output Packed samples (PACK12_SIZE(count) bytes)
+ *
+ * @retval PACK12_SIZE(count)
+ */
+uint32_t pack12_pack(const uint16_t* samples, uint32_t count, uint8_t* output);
+
+/**
+ * @brief Unpack 12 bits samples (reference implementation)
+ *
+ * @param [in] input Packed samples (PACK12_SIZE(count) bytes)
+ * @param [in] count Number of samples
+ * @param [out] samples Samples
+ */
+void pack12_unpack(const uint8_t* input, uint32_t count, uint16_t* samples);
+
+#endif /* CODEC_PACK12_H_ */
@@ -0,0 +1,212 @@
+/*
+ * tile_delta.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "tile_delta.h"
+
+#include <string.h>
+
+#if (TILE_DELTA_ENGINE == TILE_DELTA_ENGINE_MVE)
+#if !defined(__ARM_FEATURE_MVE)
+#error "TILE_DELTA_ENGINE_MVE requires a core supporting Helium (MVE)"
+#endif
+#include <arm_mve.h>
+#elif (TILE_DELTA_ENGINE != TILE_DELTA_ENGINE_SCALAR)
+#error "Unknown TILE_DELTA_ENGINE"
+#endif
+
+/**
+ * @brief Check the dimensions of the frames
+ */
+static int _tile_delta_check(uint16_t width, uint16_t height)
+{
+	if ((width == 0) || (height == 0) || ((width % TILE_DELTA_SIZE) != 0) || ((height % TILE_DELTA_SIZE) != 0))
+	{
+		return TILE_DELTA_ERROR_PARAM;
+	}
+
+	// The coordinates of a tile are stored in a byte
+	if (((width / TILE_DELTA_SIZE) > 256u) || ((height / TILE_DELTA_SIZE) > 256u))
+	{
+		return TILE_DELTA_ERROR_PARAM;
+	}
+
+	return 0;
+}
+
+#if (TILE_DELTA_ENGINE == TILE_DELTA_ENGINE_SCALAR)
+static uint32_t _tile_delta_abs_diff(uint32_t a, uint32_t b)
+{
+	return (a > b) ? (a - b) : (b - a);
+}
+
+uint32_t tile_delta_sad(const uint16_t* frame, const uint16_t* reference, uint16_t width,
+		uint16_t column, uint16_t row)
+{
+	uint32_t offset = ((uint32_t)row * TILE_DELTA_SIZE * width) + ((uint32_t)column * TILE_DELTA_SIZE);
+	uint32_t sad = 0;
+
+	for (uint32_t y = 0; y < TILE_DELTA_SIZE; y += 2u)
+	{
+		const uint16_t* a = &frame[offset + (y * width)];
+		const uint16_t* b = &reference[offset + (y * width)];
+
+		for (uint32_t x = 0; x < TILE_DELTA_SIZE; ++x)
+		{
+			sad += 2u * _tile_delta_abs_diff(a[x] >> 11, b[x] >> 11);
+			sad += _tile_delta_abs_diff((a[x] >> 5) & 0x3Fu, (b[x] >> 5) & 0x3Fu);
+			sad += 2u * _tile_delta_abs_diff(a[x] & 0x1Fu, b[x] & 0x1Fu);
+		}
+	}
+
+	return sad;
+}
+#endif
+
+#if (TILE_DELTA_ENGINE == TILE_DELTA_ENGINE_MVE)
+uint32_t tile_delta_sad(const uint16_t* frame, const uint16_t* reference, uint16_t width,
+		uint16_t column, uint16_t row)
+{
+	const uint16x8_t mask_g = vdupq_n_u16(0x3Fu);
+	const uint16x8_t mask_b = vdupq_n_u16(0x1Fu);
+	uint32_t offset = ((uint32_t)row * TILE_DELTA_SIZE * width) + ((uint32_t)column * TILE_DELTA_SIZE);
+	uint32_t sad = 0;
+
+	for (uint32_t y = 0; y < TILE_DELTA_SIZE; y += 2u)
+	{
+		const uint16_t* a = &frame[offset + (y * width)];
+		const uint16_t* b = &reference[offset + (y * width)];
+
+		for (uint32_t x = 0; x < TILE_DELTA_SIZE; x += 8u)
+		{
+			uint16x8_t pa = vld1q_u16(&a[x]);
+			uint16x8_t pb = vld1q_u16(&b[x]);
+			uint16x8_t dr = vabdq_u16(vshrq_n_u16(pa, 11), vshrq_n_u16(pb, 11));
+			uint16x8_t dg = vabdq_u16(vandq_u16(vshrq_n_u16(pa, 5), mask_g), vandq_u16(vshrq_n_u16(pb, 5), mask_g));
+			uint16x8_t db = vabdq_u16(vandq_u16(pa, mask_b), vandq_u16(pb, mask_b));
+
+			// At most 62 + 63 + 62 per lane: no overflow of the 16 bits lanes
+			sad = vaddvaq_u16(sad, vaddq_u16(vshlq_n_u16(vaddq_u16(dr, db), 1), dg));
+		}
+	}
+
+	return sad;
+}
+#endif
+
+int32_t tile_delta_detect(const uint16_t* frame, const uint16_t* reference, uint16_t width, uint16_t height,
+		uint8_t threshold, uint8_t* changed)
+{
+	uint32_t limit = (uint32_t)threshold * TILE_DELTA_SAMPLES;
+	int32_t count = 0;
+
+	if (_tile_delta_check(width, height) != 0)
+	{
+		return TILE_DELTA_ERROR_PARAM;
+	}
+
+	for (uint16_t row = 0; row < (height / TILE_DELTA_SIZE); ++row)
+	{
+		for (uint16_t column = 0; column < (width / TILE_DELTA_SIZE); ++column)
+		{
+			uint8_t tile_changed = (tile_delta_sad(frame, reference, width, column, row) > limit) ? 1u : 0u;
+
+			*changed++ = tile_changed;
+			count += tile_changed;
+		}
+	}
+
+	return count;
+}
+
+int32_t tile_delta_encode(const uint16_t* frame, uint16_t* reference, uint16_t width, uint16_t height,
+		const uint8_t* changed, uint8_t* output, uint32_t output_size)
+{
+	const uint16_t columns = width / TILE_DELTA_SIZE;
+	const uint16_t rows = height / TILE_DELTA_SIZE;
+	uint32_t size = 0;
+
+	if (_tile_delta_check(width, height) != 0)
+	{
+		return TILE_DELTA_ERROR_PARAM;
+	}
+
+	// Size first: the reference is only updated if the whole delta frame is sent
+	for (uint32_t i = 0; i < ((uint32_t)columns * rows); ++i)
+	{
+		size += changed[i] ? TILE_DELTA_ENTRY_SIZE : 0u;
+	}
+	if (size > output_size)
+	{
+		return TILE_DELTA_ERROR_OVERFLOW;
+	}
+
+	for (uint16_t row = 0; row < rows; ++row)
+	{
+		for (uint16_t column = 0; column < columns; ++column)
+		{
+			uint32_t offset = ((uint32_t)row * TILE_DELTA_SIZE * width) + ((uint32_t)column * TILE_DELTA_SIZE);
+
+			if (!*changed++)
+			{
+				continue;
+			}
+
+			*output++ = (uint8_t)column;
+			*output++ = (uint8_t)row;
+			for (uint32_t y = 0; y < TILE_DELTA_SIZE; ++y)
+			{
+				memcpy(output, &frame[offset + (y * width)], TILE_DELTA_SIZE * sizeof(uint16_t));
+				memcpy(&reference[offset + (y * width)], output, TILE_DELTA_SIZE * sizeof(uint16_t));
+				output += TILE_DELTA_SIZE * sizeof(uint16_t);
+			}
+		}
+	}
+
+	return (int32_t)size;
+}
+
+int tile_delta_apply(const uint8_t* input, uint32_t input_size, uint16_t width, uint16_t height,
+		uint16_t* image)
+{
+	if (_tile_delta_check(width, height) != 0)
+	{
+		return TILE_DELTA_ERROR_PARAM;
+	}
+
+	if ((input_size % TILE_DELTA_ENTRY_SIZE) != 0)
+	{
+		return TILE_DELTA_ERROR_DATA;
+	}
+
+	for (; input_size > 0; input_size -= TILE_DELTA_ENTRY_SIZE)
+	{
+		uint16_t column = input[0];
+		uint16_t row = input[1];
+		uint32_t offset = ((uint32_t)row * TILE_DELTA_SIZE * width) + ((uint32_t)column * TILE_DELTA_SIZE);
+
+		if ((column >= (width / TILE_DELTA_SIZE)) || (row >= (height / TILE_DELTA_SIZE)))
+		{
+			return TILE_DELTA_ERROR_DATA;
+		}
+
+		input += 2;
+		for (uint32_t y = 0; y < TILE_DELTA_SIZE; ++y)
+		{
+			memcpy(&image[offset + (y * width)], input, TILE_DELTA_SIZE * sizeof(uint16_t));
+			input += TILE_DELTA_SIZE * sizeof(uint16_t);
+		}
+	}
+
+	return 0;
+}
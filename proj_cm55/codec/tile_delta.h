@@ -0,0 +1,154 @@
+/*
+ * tile_delta.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Change detection between RGB565 frames and delta frames made of the changed tiles
+ *
+ * A frame is split in tiles of TILE_DELTA_SIZE x TILE_DELTA_SIZE pixels. A tile has
+ * changed if the sum of absolute differences (SAD) with the reference frame, computed
+ * on every other line of the tile, is above a threshold. The difference of a pixel is
+ * 2 * |dr| + |dg| + 2 * |db| (0 to 252, the components on the scale of green).
+ *
+ * A delta frame is a list of tiles, each one:
+ *
+ * | Offset | Size | Field                                                |
+ * |--------|------|------------------------------------------------------|
+ * | 0      | 1    | Column of the tile                                   |
+ * | 1      | 1    | Row of the tile                                      |
+ * | 2      | 512  | Pixels of the tile, line by line (little endian)     |
+ *
+ * This file and tile_delta.c only depend on the C standard library:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef CODEC_TILE_DELTA_H_
+#define CODEC_TILE_DELTA_H_
+
+#include <stdint.h>
+
+/**
+ * @def TILE_DELTA_ENGINE_SCALAR
+ * Portable implementation
+ */
+#define TILE_DELTA_ENGINE_SCALAR	0
+
+/**
+ * @def TILE_DELTA_ENGINE_MVE
+ * Sums of absolute differences with Helium (MVE), 8 pixels per instruction
+ * Only available if the compiler targets a core with MVE (Cortex-M55)
+ */
+#define TILE_DELTA_ENGINE_MVE		1
+
+/**
+ * @def TILE_DELTA_ENGINE
+ * Engine used by tile_delta_sad, selected at build time
+ * Both engines return the same sums
+ */
+#ifndef TILE_DELTA_ENGINE
+#if defined(__ARM_FEATURE_MVE)
+#define TILE_DELTA_ENGINE			TILE_DELTA_ENGINE_MVE
+#else
+#define TILE_DELTA_ENGINE			TILE_DELTA_ENGINE_SCALAR
+#endif
+#endif
+
+/**
+ * @def TILE_DELTA_SIZE
+ * Width and height of a tile, the dimensions of the frames must be multiples of it
+ */
+#define TILE_DELTA_SIZE				16
+
+/**
+ * @def TILE_DELTA_SAMPLES
+ * Number of pixels compared per tile (every other line)
+ */
+#define TILE_DELTA_SAMPLES			(TILE_DELTA_SIZE * TILE_DELTA_SIZE / 2)
+
+/**
+ * @def TILE_DELTA_ENTRY_SIZE
+ * Size of a tile in a delta frame
+ */
+#define TILE_DELTA_ENTRY_SIZE		(2 + TILE_DELTA_SIZE * TILE_DELTA_SIZE * 2)
+
+/**
+ * Errors
+ */
+#define TILE_DELTA_ERROR_PARAM		-1	/**< Invalid dimensions */
+#define TILE_DELTA_ERROR_OVERFLOW	-2	/**< Output buffer too small */
+#define TILE_DELTA_ERROR_DATA		-3	/**< Corrupted delta frame */
+
+/**
+ * @brief Sum of absolute differences of a tile
+ *
+ * @param [in] frame Pixels of the new frame
+ * @param [in] reference Pixels of the reference frame
+ * @param [in] width Width of the frames
+ * @param [in] column Column of the tile
+ * @param [in] row Row of the tile
+ *
+ * @retval SAD of the tile (0 to 252 * TILE_DELTA_SAMPLES)
+ */
+uint32_t tile_delta_sad(const uint16_t* frame, const uint16_t* reference, uint16_t width,
+		uint16_t column, uint16_t row);
+
+/**
+ * @brief Find the tiles that changed
+ *
+ * @param [in] frame Pixels of the new frame
+ * @param [in] reference Pixels of the reference frame
+ * @param [in] width Width of the frames (multiple of TILE_DELTA_SIZE)
+ * @param [in] height Height of the frames (multiple of TILE_DELTA_SIZE)
+ * @param [in] threshold Mean difference per compared pixel above which a tile has changed
+ * @param [out] changed One flag per tile, row by row ((width / TILE_DELTA_SIZE) * (height / TILE_DELTA_SIZE) bytes)
+ *
+ * @retval Number of tiles that changed
+ * @retval TILE_DELTA_ERROR_PARAM Invalid dimensions
+ */
+int32_t tile_delta_detect(const uint16_t* frame, const uint16_t* reference, uint16_t width, uint16_t height,
+		uint8_t threshold, uint8_t* changed);
+
+/**
+ * @brief Write the changed tiles to a delta frame and copy them to the reference frame
+ * The reference frame stays unchanged if the delta frame does not fit
+ *
+ * @param [in] frame Pixels of the new frame
+ * @param [in,out] reference Pixels of the reference frame
+ * @param [in] width Width of the frames (multiple of TILE_DELTA_SIZE)
+ * @param [in] height Height of the frames (multiple of TILE_DELTA_SIZE)
+ * @param [in] changed Flags returned by tile_delta_detect
+ * @param [out] output Buffer receiving the delta frame
+ * @param [in] output_size Size of the buffer
+ *
+ * @retval Size of the delta frame
+ * @retval TILE_DELTA_ERROR_PARAM Invalid dimensions
+ * @retval TILE_DELTA_ERROR_OVERFLOW Output buffer too small
+ */
+int32_t tile_delta_encode(const uint16_t* frame, uint16_t* reference, uint16_t width, uint16_t height,
+		const uint8_t* changed, uint8_t* output, uint32_t output_size);
+
+/**
+ * @brief Apply a delta frame to the last frame (reference decoder)
+ *
+ * @param [in] input Delta frame
+ * @param [in] input_size Size of the delta frame
+ * @param [in] width Width of the frame (multiple of TILE_DELTA_SIZE)
+ * @param [in] height Height of the frame (multiple of TILE_DELTA_SIZE)
+ * @param [in,out] image Pixels of the last frame, updated
+ *
+ * @retval 0 Success
+ * @retval TILE_DELTA_ERROR_PARAM Invalid dimensions
+ * @retval TILE_DELTA_ERROR_DATA Corrupted delta frame
+ */
+int tile_delta_apply(const uint8_t* input, uint32_t input_size, uint16_t width, uint16_t height,
+		uint16_t* image);
+
+#endif /* CODEC_TILE_DELTA_H_ */
@@ -19,13 +19,77 @@
 #include <stdint.h>
 
 /**
- * @brief Compute CRC of the buffer
+ * @def CRC_ENGINE_BITWISE
+ * Reference implementation, 8 shift/xor steps per byte
+ */
+#define CRC_ENGINE_BITWISE	0
+
+/**
+ * @def CRC_ENGINE_TABLE
+ * One lookup in a 256 entries table per byte (1 KB)
+ */
+#define CRC_ENGINE_TABLE	1
+
+/**
+ * @def CRC_ENGINE_SLICE4
+ * Slice-by-4: 4 bytes per iteration using 4 tables (4 KB)
+ */
+#define CRC_ENGINE_SLICE4	2
+
+/**
+ * @def CRC_ENGINE_SLICE8
+ * Slice-by-8: 8 bytes per iteration using 8 tables (8 KB)
+ */
+#define CRC_ENGINE_SLICE8	3
+
+/**
+ * @def CRC_ENGINE
+ * Engine used by crc32_compute and crc32_update, selected at build time
+ * (e.g. DEFINES+=CRC_ENGINE=CRC_ENGINE_TABLE inside the Makefile)
+ * All engines produce the same result
+ */
+#ifndef CRC_ENGINE
+#define CRC_ENGINE			CRC_ENGINE_SLICE8
+#endif
+
+/**
+ * @def CRC32_INIT
+ * Initial value of the CRC-32 (value returned by crc32_compute for an empty buffer)
+ */
+#define CRC32_INIT			0x00000000u
+
+/**
+ * @brief Compute CRC-32 (IEEE 802.3, same result as zlib crc32) of the buffer
+ *
+ * @param [in] buffer Address of the buffer
+ * @param [in] length Length of the buffer
+ *
+ * @retval CRC-32 value
+ */
+uint32_t crc32_compute(const uint8_t* buffer, uint32_t length);
+
+/**
+ * @brief Continue the computation of a CRC-32 with the next part of a buffer
+ * crc32_update(CRC32_INIT, buffer, length) is equal to crc32_compute(buffer, length)
+ *
+ * @param [in] crc CRC-32 of the previous parts (CRC32_INIT for the first part)
+ * @param [in] buffer Address of the buffer
+ * @param [in] length Length of the buffer
+ *
+ * @retval CRC-32 value
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t* buffer, uint32_t length);
+
+/**
+ * @brief Reference (bitwise) implementation of crc32_update
+ * Independent of CRC_ENGINE, used to validate the other engines
  *
+ * @param [in] crc CRC-32 of the previous parts (CRC32_INIT for the first part)
  * @param [in] buffer Address of the buffer
  * @param [in] length Length of the buffer
  *
- * @retval CRC value
+ * @retval CRC-32 value
  */
-uint8_t crc_compute(uint8_t* buffer, uint32_t length);
+uint32_t crc32_update_bitwise(uint32_t crc, const uint8_t* buffer, uint32_t length);
 
 #endif /* CRC_H_ */
@@ -38,19 +38,87 @@
 #define NUM_BYTES           (1)
 #define I2C_TIMEOUT         (100)
 
+/* The deferred path (PendSV) must have a lower priority than the camera interrupt */
+#define DVP_CAM_INTR_PRIORITY       (6UL)
+#define DVP_CAM_DEFERRED_PRIORITY   (7UL)
+
+/* The capture state is exchanged between the interrupt and the deferred path
+ * as one 32-bit word, so that it is always read consistently:
+ * buffer index, capture generation, lines in the buffer, line count mismatch */
+#define FRAME_WORD_INDEX_Pos        (0u)
+#define FRAME_WORD_INDEX_Msk        (0xFu << FRAME_WORD_INDEX_Pos)
+#define FRAME_WORD_GEN_Pos          (4u)
+#define FRAME_WORD_GEN_Msk          (0x3FFu << FRAME_WORD_GEN_Pos)
+#define FRAME_WORD_LINES_Pos        (14u)
+#define FRAME_WORD_LINES_Msk        (0xFFFFu << FRAME_WORD_LINES_Pos)
+#define FRAME_WORD_MISMATCH         (1u << 30)
+#define FRAME_WORD_VALID            (1u << 31)
+
+#define FRAME_WORD_INDEX(word)      (((word) & FRAME_WORD_INDEX_Msk) >> FRAME_WORD_INDEX_Pos)
+#define FRAME_WORD_GEN(word)        (((word) & FRAME_WORD_GEN_Msk) >> FRAME_WORD_GEN_Pos)
+#define FRAME_WORD_LINES(word)      (((word) & FRAME_WORD_LINES_Msk) >> FRAME_WORD_LINES_Pos)
+
+/* Line buffers, one after the other at the line length of the current mode */
+#define LINE_BUFFER(index)          (&line_buffer[(index) * line_size])
+
+
+/*******************************************************************************
+ * Data Structures
+ ******************************************************************************/
+
+/* Lock-free queue of buffer indexes. Each buffer is in at most one queue, so
+ * a queue never holds more than OV7675_FRAME_RING_DEPTH entries. Only one
+ * context pushes, popping uses exclusive accesses (the interrupt may pop
+ * from the ready queue while the application does) */
+typedef struct
+{
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint8_t slots[OV7675_FRAME_RING_DEPTH];
+} frame_queue_t;
+
+/* Checksum of a frame buffer, owned by the deferred path */
+typedef struct
+{
+    uint32_t generation;                /* capture the checksum belongs to */
+    uint32_t lines_done;                /* lines folded into the checksum */
+    uint32_t crc;
+} frame_crc_t;
+
 
 /*******************************************************************************
 * Global variables
 *******************************************************************************/
 __attribute__((section(".cy_sharedmem")))
-__attribute((used))    uint8_t line_buffer[BUFFER_COUNT][LINE_SIZE];
+__attribute((used))    uint8_t line_buffer[BUFFER_COUNT * OV7675_MAX_LINE_SIZE];
 static bool row_buffer_flag = false;
-static bool frame_buffer_flag = false;
-// static uint8_t* image_frames = NULL;
-static uint8_t* image_frames_0 = NULL;
-static uint8_t* image_frames_1 = NULL;
-static bool* _frame_ready = NULL;
-static bool* _active_frame = NULL;
+
+/* Current mode, line length and number of lines of a frame */
+static ov7675_mode_t current_mode = { OV7675_FRAME_WIDTH, OV7675_FRAME_HEIGHT, kOV7675_RGB565, 5 };
+static uint32_t line_size = OV7675_FRAME_WIDTH * OV7675_BYTES_PER_PIXEL;
+static uint32_t frame_lines = OV7675_FRAME_HEIGHT;
+
+static ov7675_frame_t frames[OV7675_FRAME_RING_DEPTH];
+static uint32_t frame_count;        /* frame buffers of the ring */
+static frame_crc_t frame_crcs[OV7675_FRAME_RING_DEPTH];
+static uint32_t frame_sequences[OV7675_FRAME_RING_DEPTH];
+static uint64_t frame_timestamps[OV7675_FRAME_RING_DEPTH];
+static frame_queue_t free_queue;    /* application (release) -> interrupt */
+static frame_queue_t ready_queue;   /* deferred path -> application (acquire) */
+static ov7675_drop_policy_t drop_policy = kOV7675_DropOldest;
+static ov7675_ring_stats_t ring_stats;
+
+static volatile uint32_t capture_index = 0;     /* buffer filled by the DMA */
+static volatile uint32_t capture_word = 0;      /* buffer being captured */
+static volatile uint32_t closed_word = 0;       /* buffer captured, not queued yet */
+static uint32_t capture_generation = 0;
+static uint32_t vsync_counter = 0;
+static ov7675_deferred_callback_t deferred_callback = NULL;
+static void* deferred_context = NULL;
+static ov7675_line_callback_t line_callback = NULL;
+static uint32_t line_seed = 0;
+static ov7675_timestamp_t timestamp_callback = NULL;
+
 static cy_stc_scb_i2c_context_t* camera_i2c_context = NULL;
 
 
@@ -109,6 +177,7 @@ cy_rslt_t mtb_dvp_cam_start_xclk(void);
 void mtb_dvp_cam_intr_init(void);
 void mtb_dvp_cam_intr_callback(void);
 cy_rslt_t mtb_dvp_cam_axi_dmac_init(void);
+static void mtb_dvp_cam_deferred_request(ov7675_deferred_event_t event, uint32_t sequence);
 
 cy_rslt_t master_write(CySCB_Type* base, cy_stc_scb_i2c_context_t* context,
                        uint16_t dev_addr,
@@ -766,6 +835,58 @@ ov7675_status_t OV7675_FrameRateAdjustment(ov7675_handler_t* handle,
 }
 
 
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_mode_config
+*****************************************************************************
+* Sensor configuration of a capture mode.
+*****************************************************************************/
+static cy_rslt_t mtb_dvp_cam_mode_config(const ov7675_mode_t* mode, ov7675_config_t* config)
+{
+    if (!(((mode->width == OV7675_QVGA.width) && (mode->height == OV7675_QVGA.height))
+        || (OV7675_VGA_MODE_ENABLED
+            && (mode->width == OV7675_VGA.width) && (mode->height == OV7675_VGA.height))))
+    {
+        return (cy_rslt_t)kStatus_OV7675_Fail; /* not supported resolution */
+    }
+    config->resolution.width = mode->width;
+    config->resolution.height = mode->height;
+
+    switch (mode->format)
+    {
+        case kOV7675_RGB565:
+            config->outputFormat = (ov7675_output_format_config_t*)&OV7675_FORMAT_RGB565;
+            break;
+
+        case kOV7675_RGB555:
+            config->outputFormat = (ov7675_output_format_config_t*)&OV7675_FORMAT_RGB555;
+            break;
+
+        default:
+            return (cy_rslt_t)kStatus_OV7675_Fail;
+    }
+
+    switch (mode->fps)
+    {
+        case 30:
+            config->frameRate = (ov7675_frame_rate_config_t*)&OV7675_30FPS_24MHZ_XCLK;
+            break;
+
+        case 15:
+            config->frameRate = (ov7675_frame_rate_config_t*)&OV7675_15FPS_24MHZ_XCLK;
+            break;
+
+        case 5:
+            config->frameRate = (ov7675_frame_rate_config_t*)&OV7675_05FPS_24MHZ_XCLK;
+            break;
+
+        default:
+            return (cy_rslt_t)kStatus_OV7675_Fail;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+
 /*****************************************************************************
 * Function Name: mtb_dvp_cam_configure
 *****************************************************************************/
@@ -801,8 +922,118 @@ cy_rslt_t mtb_dvp_cam_start_xclk(void)
     return result;
 }
 
+/* HREF interrupts since the last VSYNC (OV7675_HREF_IRQ_PER_LINE per line) */
+static int counter_visr = 0;
+
+/*****************************************************************************
+* Function Name: frame_queue_push
+*****************************************************************************/
+static void frame_queue_push(frame_queue_t* queue, uint32_t index)
+{
+    uint32_t head = queue->head;
+
+    queue->slots[head % OV7675_FRAME_RING_DEPTH] = (uint8_t)index;
+
+    /* The slot (and the frame descriptor) must be visible before the entry */
+    __DMB();
+    queue->head = head + 1u;
+}
+
+
+/*****************************************************************************
+* Function Name: frame_queue_pop
+*****************************************************************************/
+static bool frame_queue_pop(frame_queue_t* queue, uint32_t* index)
+{
+    uint32_t tail;
+
+    do
+    {
+        tail = __LDREXW(&queue->tail);
+        if (tail == queue->head)
+        {
+            __CLREX();
+            return false;
+        }
+        *index = queue->slots[tail % OV7675_FRAME_RING_DEPTH];
+    } while (__STREXW(tail + 1u, &queue->tail) != 0u);
+
+    __DMB();
+    return true;
+}
+
+
+/*****************************************************************************
+* Function Name: frame_word_make
+*****************************************************************************/
+static uint32_t frame_word_make(uint32_t index, uint32_t generation, uint32_t lines)
+{
+    return ((index << FRAME_WORD_INDEX_Pos) & FRAME_WORD_INDEX_Msk)
+        | ((generation << FRAME_WORD_GEN_Pos) & FRAME_WORD_GEN_Msk)
+        | ((lines << FRAME_WORD_LINES_Pos) & FRAME_WORD_LINES_Msk)
+        | FRAME_WORD_VALID;
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_lines_captured
+*****************************************************************************/
+static uint32_t mtb_dvp_cam_lines_captured(uint32_t href_count)
+{
+    uint32_t lines = href_count / OV7675_HREF_IRQ_PER_LINE;
+    return (lines > frame_lines) ? frame_lines : lines;
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_deferred_notify
+*****************************************************************************
+* Reports an event of the capture to the deferred callback.
+*****************************************************************************/
+static void mtb_dvp_cam_deferred_notify(ov7675_deferred_event_t event, uint32_t sequence)
+{
+    if (deferred_callback != NULL)
+    {
+        deferred_callback(deferred_context, event, sequence);
+    }
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_next_buffer
+*****************************************************************************
+* Selects the buffer of the next capture at VSYNC (interrupt context).
+*****************************************************************************/
+static uint32_t mtb_dvp_cam_next_buffer(uint32_t closing_index)
+{
+    uint32_t index;
+    uint32_t word = closed_word;
+
+    /* The frame closed at the previous VSYNC is still not queued:
+     * the deferred path is late, its buffer is taken back */
+    if ((word & FRAME_WORD_VALID) != 0u)
+    {
+        closed_word = 0;
+        ring_stats.crc_late++;
+        return FRAME_WORD_INDEX(word);
+    }
+
+    if (frame_queue_pop(&free_queue, &index))
+    {
+        return index;
+    }
+
+    if ((drop_policy == kOV7675_DropOldest) && frame_queue_pop(&ready_queue, &index))
+    {
+        ring_stats.dropped_oldest++;
+        return index;
+    }
+
+    /* No other buffer: the frame just captured is overwritten */
+    ring_stats.dropped_newest++;
+    return closing_index;
+}
 
-int counter_visr = 0;
 
 /*****************************************************************************
 * Function Name: mtb_dvp_cam_intr_callback
@@ -815,10 +1046,9 @@ void mtb_dvp_cam_intr_callback(void)
         NVIC_ClearPendingIRQ(CYBSP_DVP_CAM_HREF_IRQ);
 
         Cy_DMA_Descriptor_SetDstAddress(&CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0,
-                                        (uint8_t*)line_buffer[row_buffer_flag]);
+                                        LINE_BUFFER(row_buffer_flag));
         #if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
-        SCB_InvalidateDCache_by_Addr((uint32_t*)line_buffer[row_buffer_flag],
-                                     sizeof(line_buffer[row_buffer_flag]));
+        SCB_InvalidateDCache_by_Addr((uint32_t*)LINE_BUFFER(row_buffer_flag), line_size);
         SCB_CleanDCache_by_Addr((uint32_t*)&CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0,
                                 sizeof(CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0));
         #endif
@@ -826,37 +1056,255 @@ void mtb_dvp_cam_intr_callback(void)
                               CYBSP_DMA_DVP_CAM_CONTROLLER_CHANNEL);
 
         row_buffer_flag = !row_buffer_flag;
-		counter_visr ++;
+        counter_visr ++;
+
+        /* A new line starts: the previous one is in the frame buffer */
+        uint32_t word = capture_word;
+        uint32_t lines = mtb_dvp_cam_lines_captured(counter_visr - 1);
+        if (lines != FRAME_WORD_LINES(word))
+        {
+            capture_word = (word & ~FRAME_WORD_LINES_Msk) | (lines << FRAME_WORD_LINES_Pos);
+            mtb_dvp_cam_deferred_request(kOV7675_Deferred_Lines, vsync_counter);
+        }
     }
 
     if (Cy_GPIO_GetInterruptStatus(CYBSP_DVP_CAM_VSYNC_PORT, CYBSP_DVP_CAM_VSYNC_NUM))
     {
+        /* Latched first: start of the next capture, independent of the main loop */
+        uint64_t vsync_time_us = (timestamp_callback != NULL) ? timestamp_callback() : 0u;
+
         Cy_GPIO_ClearInterrupt(CYBSP_DVP_CAM_VSYNC_PORT, CYBSP_DVP_CAM_VSYNC_NUM);
         NVIC_ClearPendingIRQ(CYBSP_DVP_CAM_VSYNC_IRQ);
 
-		uint32_t * dest = (uint32_t*)image_frames_0;
-		if (frame_buffer_flag) dest = (uint32_t*)image_frames_1;
+        uint32_t closing_index = capture_index;
+        uint32_t closing_word = capture_word;
+
+        /* No capture open after a mode switch: its buffer is kept */
+        capture_index = ((closing_word & FRAME_WORD_VALID) != 0u)
+            ? mtb_dvp_cam_next_buffer(closing_index) : closing_index;
+
+        uint32_t * dest = (uint32_t*)frames[capture_index].buffer;
 
         Cy_AXIDMAC_Descriptor_SetDstAddress(&CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0, dest);
-		
+
         #if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
-        SCB_InvalidateDCache_by_Addr(dest, OV7675_MEMORY_BUFFER_SIZE);
+        SCB_InvalidateDCache_by_Addr(dest, line_size * frame_lines);
         SCB_CleanDCache_by_Addr((uint32_t*)&CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0,
                                 sizeof(CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0));
         #endif
         Cy_AXIDMAC_Channel_Enable(CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_HW,
                                   CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_CHANNEL);
 
-        frame_buffer_flag = !frame_buffer_flag;
-        *_active_frame = frame_buffer_flag;
+        /* Close the captured frame, the deferred path queues it */
+        if (capture_index != closing_index)
+        {
+            uint32_t word = (closing_word & ~FRAME_WORD_LINES_Msk)
+                | (mtb_dvp_cam_lines_captured(counter_visr) << FRAME_WORD_LINES_Pos);
+            if (counter_visr != (frame_lines * OV7675_HREF_IRQ_PER_LINE))
+            {
+                word |= FRAME_WORD_MISMATCH;
+            }
+            closed_word = word;
+        }
+        counter_visr = 0;
+
+        /* Open the next capture */
+        vsync_counter++;
+        capture_generation++;
+        frame_sequences[capture_index] = vsync_counter;
+        frame_timestamps[capture_index] = vsync_time_us;
+        capture_word = frame_word_make(capture_index, capture_generation, 0);
+
+        mtb_dvp_cam_deferred_request(kOV7675_Deferred_Vsync, vsync_counter);
+    }
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_crc_fold
+*****************************************************************************
+* Folds the lines available in a buffer into its checksum (deferred path).
+*****************************************************************************/
+static uint32_t mtb_dvp_cam_crc_fold(uint32_t word)
+{
+    uint32_t index = FRAME_WORD_INDEX(word);
+    uint32_t generation = FRAME_WORD_GEN(word);
+    uint32_t lines = FRAME_WORD_LINES(word);
+    frame_crc_t* crc = &frame_crcs[index];
+
+    /* New capture in this buffer */
+    if (crc->generation != generation)
+    {
+        crc->generation = generation;
+        crc->lines_done = 0;
+        crc->crc = line_seed;
+    }
+
+    while (crc->lines_done < lines)
+    {
+        uint8_t* line = &frames[index].buffer[crc->lines_done * line_size];
+        #if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
+        SCB_InvalidateDCache_by_Addr((uint32_t*)line, line_size);
+        #endif
+        if (line_callback != NULL)
+        {
+            crc->crc = line_callback(crc->crc, line, line_size);
+        }
+        crc->lines_done++;
+    }
+
+    return crc->crc;
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_deferred_process
+*****************************************************************************
+* Deferred (lowest priority) part of the camera interrupt: folds the lines
+* copied into the frame buffer into the checksum of the frame, and queues the
+* frame closed by VSYNC as soon as its checksum is complete.
+*****************************************************************************/
+void mtb_dvp_cam_deferred_process(void)
+{
+    uint32_t word = closed_word;
+
+    if ((word & FRAME_WORD_VALID) != 0u)
+    {
+        uint32_t sequence = frame_sequences[FRAME_WORD_INDEX(word)];
+        mtb_dvp_cam_deferred_notify(kOV7675_Deferred_FrameBegin, sequence);
+        uint32_t crc = mtb_dvp_cam_crc_fold(word);
+
+        /* Take the buffer, unless the interrupt took it back in the meantime */
+        do
+        {
+            if (__LDREXW(&closed_word) != word)
+            {
+                __CLREX();
+                word = 0;
+                break;
+            }
+        } while (__STREXW(0u, &closed_word) != 0u);
+
+        if (word != 0u)
+        {
+            uint32_t index = FRAME_WORD_INDEX(word);
+            ov7675_frame_t* frame = &frames[index];
+
+            frame->sequence = frame_sequences[index];
+            frame->timestamp_us = frame_timestamps[index];
+            frame->status.crc = crc;
+            frame->status.lines = (uint16_t)FRAME_WORD_LINES(word);
+            frame->status.integrity = ((word & FRAME_WORD_MISMATCH) != 0u)
+                ? kOV7675_Frame_LineMismatch : kOV7675_Frame_Ok;
+
+            frame_queue_push(&ready_queue, index);
+            ring_stats.frames_captured++;
+            if (frame->status.integrity != kOV7675_Frame_Ok)
+            {
+                ring_stats.line_mismatch++;
+            }
+            mtb_dvp_cam_deferred_notify(kOV7675_Deferred_FrameQueued, sequence);
+        }
+        else
+        {
+            mtb_dvp_cam_deferred_notify(kOV7675_Deferred_FrameLost, sequence);
+        }
+    }
+
+    /* Then the frame being captured */
+    word = capture_word;
+    if ((word & FRAME_WORD_VALID) != 0u)
+    {
+        (void)mtb_dvp_cam_crc_fold(word);
+    }
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_deferred_request
+*****************************************************************************
+* Runs the deferred path once the camera interrupt returns.
+*****************************************************************************/
+static void mtb_dvp_cam_deferred_request(ov7675_deferred_event_t event, uint32_t sequence)
+{
+#if OV7675_DEFERRED_PENDSV
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+    mtb_dvp_cam_deferred_notify(event, sequence);
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_set_line_callback
+*****************************************************************************/
+void mtb_dvp_cam_ov7675_set_line_callback(ov7675_line_callback_t callback, uint32_t seed)
+{
+    line_seed = seed;
+    line_callback = callback;
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_set_timestamp
+*****************************************************************************/
+void mtb_dvp_cam_ov7675_set_timestamp(ov7675_timestamp_t timestamp)
+{
+    timestamp_callback = timestamp;
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_set_deferred_callback
+*****************************************************************************/
+void mtb_dvp_cam_ov7675_set_deferred_callback(ov7675_deferred_callback_t callback, void* context)
+{
+    deferred_context = context;
+    deferred_callback = callback;
+}
+
+
+#if OV7675_DEFERRED_PENDSV
+/*****************************************************************************
+* Function Name: PendSV_Handler
+*****************************************************************************/
+void PendSV_Handler(void)
+{
+    mtb_dvp_cam_deferred_process();
+}
+#endif
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_acquire
+*****************************************************************************/
+ov7675_frame_t* mtb_dvp_cam_ov7675_acquire(void)
+{
+    uint32_t index;
 
-		if (counter_visr != 480) printf("Strange... %d \r\n", counter_visr);
-		else
-		{
-			*_frame_ready = true;
-		}
-		counter_visr = 0;
+    if (!frame_queue_pop(&ready_queue, &index))
+    {
+        return NULL;
     }
+
+    return &frames[index];
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_release
+*****************************************************************************/
+void mtb_dvp_cam_ov7675_release(ov7675_frame_t* frame)
+{
+    frame_queue_push(&free_queue, (uint32_t)(frame - frames));
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_get_stats
+*****************************************************************************/
+void mtb_dvp_cam_ov7675_get_stats(ov7675_ring_stats_t* stats)
+{
+    *stats = ring_stats;
 }
 
 
@@ -869,7 +1317,7 @@ void mtb_dvp_cam_intr_init(void)
     cy_stc_sysint_t tIntrCfg =
     {
         .intrSrc      = CYBSP_DVP_CAM_HREF_IRQ, /* Interrupt source */
-        .intrPriority = 7UL /* Interrupt priority */
+        .intrPriority = DVP_CAM_INTR_PRIORITY /* Interrupt priority */
     };
     /* Initialize the interrupt */
     Cy_GPIO_ClearInterrupt(CYBSP_DVP_CAM_HREF_PORT, CYBSP_DVP_CAM_HREF_PIN);
@@ -879,6 +1327,11 @@ void mtb_dvp_cam_intr_init(void)
 
     Cy_SysInt_Init(&tIntrCfg, &mtb_dvp_cam_intr_callback);
 
+#if OV7675_DEFERRED_PENDSV
+    /* Deferred path of the interrupt */
+    NVIC_SetPriority(PendSV_IRQn, DVP_CAM_DEFERRED_PRIORITY);
+#endif
+
     /* Enable the interrupt. Since both HREF and VSYNC pins have the same
      * interrupt source, enabling any one is sufficient */
     NVIC_EnableIRQ(CYBSP_DVP_CAM_HREF_IRQ);
@@ -907,14 +1360,13 @@ cy_rslt_t mtb_dvp_cam_dma_init(void)
         return status;
     }
 
-    memset(line_buffer[0], 0x0, LINE_SIZE);
-    memset(line_buffer[1], 0x0, LINE_SIZE);
+    memset(line_buffer, 0x0, sizeof(line_buffer));
 
     Cy_DMA_Descriptor_SetSrcAddress(&CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0,
                                     (void*)&GPIO_PRT16->IN);
 
     Cy_DMA_Descriptor_SetDstAddress(&CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0,
-                                    line_buffer[row_buffer_flag]);
+                                    LINE_BUFFER(row_buffer_flag));
 
     #if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
     SCB_CleanDCache_by_Addr((uint32_t*)&GPIO_PRT16->IN, sizeof(GPIO_PRT16->IN));
@@ -955,7 +1407,7 @@ cy_rslt_t mtb_dvp_cam_axi_dmac_init(void)
                                         (uint32_t*)line_buffer);
 
     Cy_AXIDMAC_Descriptor_SetDstAddress(&CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0,
-                                        (uint32_t*)image_frames_0);
+                                        (uint32_t*)frames[capture_index].buffer);
 
     #if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
     SCB_CleanDCache_by_Addr((uint32_t*)&line_buffer, sizeof(line_buffer));
@@ -971,18 +1423,249 @@ cy_rslt_t mtb_dvp_cam_axi_dmac_init(void)
 }
 
 
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ring_reset
+*****************************************************************************
+* Empties the frame ring and hands it new buffers. No capture is open until
+* the next VSYNC, which starts filling the first buffer.
+*****************************************************************************/
+static void mtb_dvp_cam_ring_reset(uint8_t* const* buffers, uint32_t num_buffers)
+{
+    uint32_t i;
+
+    memset(&free_queue, 0, sizeof(free_queue));
+    memset(&ready_queue, 0, sizeof(ready_queue));
+
+    frame_count = num_buffers;
+    for (i = 0; i < num_buffers; ++i)
+    {
+        frames[i].buffer = buffers[i];
+        frame_crcs[i].generation = FRAME_WORD_GEN_Msk; /* no capture yet */
+    }
+
+    /* The DMA starts filling the first buffer, the others are free */
+    for (i = 1; i < num_buffers; ++i)
+    {
+        frame_queue_push(&free_queue, i);
+    }
+    capture_index = 0;
+    capture_generation = 0;
+    closed_word = 0;
+    capture_word = 0;
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_dma_set_geometry
+*****************************************************************************
+* Sets the line length and the number of lines of the current mode in the
+* descriptors when they differ from the ones of the BSP (initial mode).
+* Same layout as the descriptors of the BSP:
+* - DW: rows of the pixel port, as many as needed for one line per HREF
+* - AXIDMAC: one line per trigger from the two line buffers in turn,
+*   the lines follow each other in the frame buffer
+*****************************************************************************/
+static void mtb_dvp_cam_dma_set_geometry(void)
+{
+    cy_stc_dma_descriptor_t* line_descriptor = &CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0;
+    cy_stc_axidmac_descriptor_t* frame_descriptor = &CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0;
+    uint32_t row = Cy_DMA_Descriptor_GetXloopDataCount(line_descriptor);
+
+    if ((line_size == (OV7675_FRAME_WIDTH * OV7675_BYTES_PER_PIXEL)) && (frame_lines == OV7675_FRAME_HEIGHT))
+    {
+        return;
+    }
+
+    Cy_DMA_Descriptor_SetYloopDataCount(line_descriptor, line_size / row);
+    Cy_DMA_Descriptor_SetYloopDstIncrement(line_descriptor, (int32_t)row);
+
+    Cy_AXIDMAC_Descriptor_SetMloopDataCount(frame_descriptor, line_size);
+    Cy_AXIDMAC_Descriptor_SetXloopDataCount(frame_descriptor, BUFFER_COUNT);
+    Cy_AXIDMAC_Descriptor_SetXloopSrcIncrement(frame_descriptor, (int32_t)line_size);
+    Cy_AXIDMAC_Descriptor_SetXloopDstIncrement(frame_descriptor, (int32_t)line_size);
+    Cy_AXIDMAC_Descriptor_SetYloopDataCount(frame_descriptor, frame_lines / BUFFER_COUNT);
+    Cy_AXIDMAC_Descriptor_SetYloopSrcIncrement(frame_descriptor, 0);
+    Cy_AXIDMAC_Descriptor_SetYloopDstIncrement(frame_descriptor, (int32_t)(BUFFER_COUNT * line_size));
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_dma_rearm
+*****************************************************************************
+* Restarts both DMA channels from their first descriptor, set for the current
+* mode. The DW channel is enabled by the next HREF, the AXIDMAC channel by the
+* next VSYNC.
+*****************************************************************************/
+static cy_rslt_t mtb_dvp_cam_dma_rearm(void)
+{
+    cy_rslt_t status;
+
+    Cy_DMA_Channel_Disable(CYBSP_DMA_DVP_CAM_CONTROLLER_HW, CYBSP_DMA_DVP_CAM_CONTROLLER_CHANNEL);
+    Cy_AXIDMAC_Channel_Disable(CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_HW,
+                               CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_CHANNEL);
+
+    status = Cy_DMA_Descriptor_Init(&CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0,
+                                    &CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0_config);
+    if (status != CY_DMA_SUCCESS)
+    {
+        return status;
+    }
+    status = Cy_AXIDMAC_Descriptor_Init(&CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0,
+                                        &CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0_config);
+    if (CY_AXIDMAC_SUCCESS != status)
+    {
+        return status;
+    }
+    mtb_dvp_cam_dma_set_geometry();
+
+    Cy_DMA_Descriptor_SetSrcAddress(&CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0,
+                                    (void*)&GPIO_PRT16->IN);
+    Cy_DMA_Descriptor_SetDstAddress(&CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0,
+                                    LINE_BUFFER(row_buffer_flag));
+    Cy_AXIDMAC_Descriptor_SetSrcAddress(&CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0,
+                                        (uint32_t*)line_buffer);
+    Cy_AXIDMAC_Descriptor_SetDstAddress(&CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0,
+                                        (uint32_t*)frames[capture_index].buffer);
+
+    #if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
+    SCB_CleanDCache_by_Addr((uint32_t*)&CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0,
+                            sizeof(CYBSP_DMA_DVP_CAM_CONTROLLER_Descriptor_0));
+    SCB_CleanDCache_by_Addr((uint32_t*)&CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0,
+                            sizeof(CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_Descriptor_0));
+    #endif
+
+    status = Cy_DMA_Channel_Init(CYBSP_DMA_DVP_CAM_CONTROLLER_HW,
+                                 CYBSP_DMA_DVP_CAM_CONTROLLER_CHANNEL,
+                                 &CYBSP_DMA_DVP_CAM_CONTROLLER_channelConfig);
+    if (status != CY_DMA_SUCCESS)
+    {
+        return status;
+    }
+
+    return Cy_AXIDMAC_Channel_Init(CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_HW,
+                                   CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_CHANNEL,
+                                   &CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_channelConfig);
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_capture_restart
+*****************************************************************************
+* Restarts the capture of a mode, the sensor being programmed for it: the
+* frame ring restarts with the given buffers and the DMA at the next VSYNC.
+*****************************************************************************/
+static cy_rslt_t mtb_dvp_cam_capture_restart(const ov7675_mode_t* mode, uint8_t* const* buffers,
+                                             uint32_t num_buffers)
+{
+    cy_rslt_t status;
+
+    current_mode = *mode;
+    line_size = mode->width * OV7675_BYTES_PER_PIXEL;
+    frame_lines = mode->height;
+
+    mtb_dvp_cam_ring_reset(buffers, num_buffers);
+    row_buffer_flag = false;
+    counter_visr = 0;
+
+    status = mtb_dvp_cam_dma_rearm();
+    if (CY_RSLT_SUCCESS != status)
+    {
+        return status;
+    }
+
+    /* The HREF interrupt enables the DMA channels again */
+    Cy_GPIO_ClearInterrupt(CYBSP_DVP_CAM_HREF_PORT, CYBSP_DVP_CAM_HREF_NUM);
+    Cy_GPIO_ClearInterrupt(CYBSP_DVP_CAM_VSYNC_PORT, CYBSP_DVP_CAM_VSYNC_NUM);
+    NVIC_ClearPendingIRQ(CYBSP_DVP_CAM_HREF_IRQ);
+    NVIC_EnableIRQ(CYBSP_DVP_CAM_HREF_IRQ);
+
+    return CY_RSLT_SUCCESS;
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_set_mode
+*****************************************************************************/
+cy_rslt_t mtb_dvp_cam_ov7675_set_mode(const ov7675_mode_t* mode, uint8_t* const* buffers,
+                                      uint32_t num_buffers)
+{
+    const ov7675_config_t previous_config = s_Ov7675CameraConfig;
+    const ov7675_mode_t previous_mode = current_mode;
+    const uint32_t previous_count = frame_count;
+    uint8_t* previous_buffers[OV7675_FRAME_RING_DEPTH];
+    ov7675_config_t config;
+    cy_rslt_t status;
+    uint32_t i;
+
+    if ((num_buffers < 2u) || (num_buffers > OV7675_FRAME_RING_DEPTH)
+        || (mtb_dvp_cam_mode_config(mode, &config) != CY_RSLT_SUCCESS))
+    {
+        return (cy_rslt_t)kStatus_OV7675_Fail;
+    }
+
+    for (i = 0; i < previous_count; ++i)
+    {
+        previous_buffers[i] = frames[i].buffer;
+    }
+
+    /* No line or frame transfer until the next VSYNC of the new mode */
+    NVIC_DisableIRQ(CYBSP_DVP_CAM_HREF_IRQ);
+    Cy_DMA_Channel_Disable(CYBSP_DMA_DVP_CAM_CONTROLLER_HW, CYBSP_DMA_DVP_CAM_CONTROLLER_CHANNEL);
+    Cy_AXIDMAC_Channel_Disable(CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_HW,
+                               CYBSP_AXIDMAC_DVP_CAM_CONTROLLER_CHANNEL);
+
+    /* Registers written while the sensor runs, no reset */
+    status = (cy_rslt_t)OV7675_Configure(&s_Ov7675CameraHandler, &config);
+    if (CY_RSLT_SUCCESS != status)
+    {
+        goto restore;
+    }
+    s_Ov7675CameraConfig = config;
+
+    status = mtb_dvp_cam_capture_restart(mode, buffers, num_buffers);
+    if (CY_RSLT_SUCCESS != status)
+    {
+        goto restore;
+    }
+
+    return CY_RSLT_SUCCESS;
+
+restore:
+    /* The sensor may be partly programmed: previous mode, buffers and DMA again */
+    (void)OV7675_Configure(&s_Ov7675CameraHandler, &previous_config);
+    s_Ov7675CameraConfig = previous_config;
+    (void)mtb_dvp_cam_capture_restart(&previous_mode, previous_buffers, previous_count);
+
+    return status;
+}
+
+
+/*****************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_get_mode
+*****************************************************************************/
+void mtb_dvp_cam_ov7675_get_mode(ov7675_mode_t* mode)
+{
+    *mode = current_mode;
+}
+
+
 /*****************************************************************************
 * Function Name: mtb_dvp_cam_ov7675_init
 *****************************************************************************/
-cy_rslt_t mtb_dvp_cam_ov7675_init(uint8_t* buffer_0, uint8_t* buffer_1, cy_stc_scb_i2c_context_t* i2c_instance,
-                                  bool* _frame_ready_flag, bool* _active_frame_flag)
+cy_rslt_t mtb_dvp_cam_ov7675_init(uint8_t* const* buffers, uint32_t num_buffers,
+                                  cy_stc_scb_i2c_context_t* i2c_instance,
+                                  ov7675_drop_policy_t policy)
 {
     cy_rslt_t status = CY_RSLT_SUCCESS;
-    // image_frames = buffer;
-	image_frames_0 = buffer_0;
-	image_frames_1 = buffer_1;
-    _frame_ready = _frame_ready_flag;
-    _active_frame = _active_frame_flag;
+
+    if ((num_buffers < 2u) || (num_buffers > OV7675_FRAME_RING_DEPTH))
+    {
+        return (cy_rslt_t)kStatus_OV7675_Fail;
+    }
+
+    drop_policy = policy;
+    memset(&ring_stats, 0, sizeof(ring_stats));
+    mtb_dvp_cam_ring_reset(buffers, num_buffers);
 
     camera_i2c_context = i2c_instance;
     CY_ASSERT(NULL != i2c_instance);
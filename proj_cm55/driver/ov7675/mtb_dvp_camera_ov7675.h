@@ -36,10 +36,33 @@ extern "C"
  ******************************************************************************/
 #define OV7675_I2C_ADDR             (0x21U)
 #define OV7675_BYTES_PER_PIXEL      (2u)
+/* Mode at initialization (QVGA), the one of the DMA descriptors of the BSP */
 #define OV7675_FRAME_WIDTH          (320u)
 #define OV7675_FRAME_HEIGHT         (240u)
-#define LINE_SIZE                   (OV7675_FRAME_WIDTH * OV7675_BYTES_PER_PIXEL)
 #define OV7675_MEMORY_BUFFER_SIZE	(OV7675_FRAME_WIDTH * OV7675_FRAME_HEIGHT * OV7675_BYTES_PER_PIXEL)
+/* Largest mode (VGA) */
+#define OV7675_MAX_FRAME_WIDTH      (640u)
+#define OV7675_MAX_FRAME_HEIGHT     (480u)
+#define OV7675_MAX_LINE_SIZE        (OV7675_MAX_FRAME_WIDTH * OV7675_BYTES_PER_PIXEL)
+#define OV7675_MAX_MEMORY_BUFFER_SIZE (OV7675_MAX_FRAME_WIDTH * OV7675_MAX_FRAME_HEIGHT * OV7675_BYTES_PER_PIXEL)
+#define OV7675_HREF_IRQ_PER_LINE    (2u) /* HREF interrupt fires on both edges of a line */
+/* The VGA mode is refused by mtb_dvp_cam_ov7675_set_mode: its DMA geometry has
+ * not been run on the board yet (set to 1 to try it) */
+#ifndef OV7675_VGA_MODE_ENABLED
+#define OV7675_VGA_MODE_ENABLED     (0)
+#endif
+
+/* Maximum number of frame buffers handled by the frame ring (2..16) */
+#ifndef OV7675_FRAME_RING_DEPTH
+#define OV7675_FRAME_RING_DEPTH     (3u)
+#endif
+
+/* 1: the deferred path of the camera interrupt runs in the PendSV exception,
+ * 0: PendSV belongs to an RTOS, a task woken up by the deferred callback runs
+ * mtb_dvp_cam_deferred_process */
+#ifndef OV7675_DEFERRED_PENDSV
+#define OV7675_DEFERRED_PENDSV      (1)
+#endif
 
 /*******************************************************************************
  * Data Structures
@@ -99,6 +122,82 @@ typedef struct ov7675_handler
     uint8_t i2cDeviceAddr; /* I2C device address */
 } ov7675_handler_t;
 
+/** Integrity of a captured frame */
+typedef enum _ov7675_frame_integrity
+{
+    kOV7675_Frame_Ok = 0x0,           /* all lines captured and checksummed */
+    kOV7675_Frame_LineMismatch = 0x1  /* unexpected number of HREF interrupts */
+} ov7675_frame_integrity_t;
+
+/** Status of a captured frame */
+typedef struct ov7675_frame_status
+{
+    uint32_t crc;                       /* checksum of the lines captured (line callback) */
+    uint16_t lines;                     /* number of lines captured */
+    ov7675_frame_integrity_t integrity;
+} ov7675_frame_status_t;
+
+/** What to do at VSYNC when no free buffer is available for the next frame */
+typedef enum _ov7675_drop_policy
+{
+    kOV7675_DropOldest = 0x0,   /* reuse the oldest frame not acquired yet */
+    kOV7675_DropNewest = 0x1    /* overwrite the frame just captured */
+} ov7675_drop_policy_t;
+
+/** Events of the capture reported to the deferred callback */
+typedef enum _ov7675_deferred_event
+{
+    kOV7675_Deferred_Lines = 0x0,       /* interrupt: new lines in the frame buffer */
+    kOV7675_Deferred_Vsync = 0x1,       /* interrupt: VSYNC, the capture of a frame starts */
+    kOV7675_Deferred_FrameBegin = 0x2,  /* deferred path: the frame closed by VSYNC is checksummed */
+    kOV7675_Deferred_FrameQueued = 0x3, /* deferred path: the frame is queued */
+    kOV7675_Deferred_FrameLost = 0x4    /* deferred path: the interrupt took the frame back (crc_late) */
+} ov7675_deferred_event_t;
+
+/** Called by the camera interrupt and by the deferred path (sequence of the frame) */
+typedef void (*ov7675_deferred_callback_t)(void* context, ov7675_deferred_event_t event, uint32_t sequence);
+
+/** Folds a line into the checksum of its frame (deferred path), returns the new checksum */
+typedef uint32_t (*ov7675_line_callback_t)(uint32_t checksum, const uint8_t* line, uint32_t size);
+
+/** Time of the VSYNC in microseconds (camera interrupt) */
+typedef uint64_t (*ov7675_timestamp_t)(void);
+
+/** Captured frame, owned by the application between acquire and release */
+typedef struct ov7675_frame
+{
+    uint8_t* buffer;                    /* width * height * OV7675_BYTES_PER_PIXEL bytes of the mode */
+    uint32_t sequence;                  /* VSYNC counter at the start of the capture */
+    uint64_t timestamp_us;              /* VSYNC time at the start of the capture (timestamp callback) */
+    ov7675_frame_status_t status;
+} ov7675_frame_t;
+
+/** Counters of the frame ring */
+typedef struct ov7675_ring_stats
+{
+    uint32_t frames_captured;           /* frames put into the ring */
+    uint32_t dropped_oldest;            /* frames reused before being acquired */
+    uint32_t dropped_newest;            /* frames overwritten right after their capture */
+    uint32_t crc_late;                  /* frames lost: deferred checksum not done in time */
+    uint32_t line_mismatch;             /* frames queued with an unexpected number of HREF interrupts */
+} ov7675_ring_stats_t;
+
+/** Pixel format of the frames (OV7675_BYTES_PER_PIXEL bytes per pixel) */
+typedef enum _ov7675_pixel_format
+{
+    kOV7675_RGB565 = 0x0,
+    kOV7675_RGB555 = 0x1
+} ov7675_pixel_format_t;
+
+/** Capture mode */
+typedef struct ov7675_mode
+{
+    uint16_t width;                     /* 320 (QVGA) or 640 (VGA, see OV7675_VGA_MODE_ENABLED) */
+    uint16_t height;                    /* 240 (QVGA) or 480 (VGA) */
+    ov7675_pixel_format_t format;
+    uint8_t fps;                        /* 30, 15 or 5 frames per second (24 MHz XCLK) */
+} ov7675_mode_t;
+
 /** Initialization structure of OV7675 */
 typedef struct ov7675_config
 {
@@ -114,24 +213,171 @@ typedef struct ov7675_config
 * Function Name: mtb_dvp_cam_ov7675_init
 *******************************************************************************
 * Summary:
-*  This function initializes the OV7675 DVP camera (with a fixed configuration)
-*  and the MCU hardware resources that are required for interfacing the camera.
-*  It sets the frame_ready_flag flag that indicates whether the image frame is ready,
-*  and the active_frame_flag flag that indicates which frame buffer is active/ready.
-*  The "active_frame_flag == true" indicates that the index 1 of the double buffer is active.
+*  This function initializes the OV7675 DVP camera (QVGA, RGB565, 5 fps) and
+*  the MCU hardware resources that are required for interfacing the camera.
+*  The frames are handed over through a ring of num_buffers frame buffers:
+*  the DMA always fills a buffer that is neither queued nor acquired by the
+*  application, so an acquired frame is never overwritten.
+*  The checksum of the frame is computed line by line during the capture with
+*  the line callback (deferred to the PendSV exception or to a task, see
+*  OV7675_DEFERRED_PENDSV), a frame is queued as soon as its last line is
+*  checksummed.
 *
 * Parameters:
-*  buffer               Pointer to the image buffer
+*  buffers              Frame buffers (OV7675_MEMORY_BUFFER_SIZE bytes each)
+*  num_buffers          Number of frame buffers (2..OV7675_FRAME_RING_DEPTH)
 *  i2c_instance         Pointer to an initialized I2C object context
-*  frame_ready_flag     Pointer to the flag that indicates whether the image frame is ready
-*  active_frame_flag    Pointer to the flag that indicates which frame buffer is active/ready
-*                       in the double buffer
+*  policy               What to drop when the application does not release
+*                       the frames fast enough
+*
+* Return: cy_rslt_t -> Status of the execution
+*
+******************************************************************************/
+cy_rslt_t mtb_dvp_cam_ov7675_init(uint8_t* const* buffers, uint32_t num_buffers,
+                                  cy_stc_scb_i2c_context_t* i2c_instance,
+                                  ov7675_drop_policy_t policy);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_set_mode
+*******************************************************************************
+* Summary:
+*  Switches the capture mode while the camera is running: the capture is
+*  stopped, the sensor is reprogrammed (no reset), the DMA descriptors are set
+*  for the new line length and number of lines, and the frame ring restarts
+*  with the given buffers at the next VSYNC. The frames queued and not
+*  acquired are dropped. No frame may be acquired by the application.
+*  If the sensor or the DMA cannot be set for the new mode, the previous mode,
+*  frame buffers and DMA are restored and the capture goes on (the frames
+*  queued are dropped all the same).
+*
+* Parameters:
+*  mode                 Capture mode
+*  buffers              Frame buffers (width * height * OV7675_BYTES_PER_PIXEL
+*                       bytes each, 32-byte aligned)
+*  num_buffers          Number of frame buffers (2..OV7675_FRAME_RING_DEPTH)
 *
 * Return: cy_rslt_t -> Status of the execution
 *
 ******************************************************************************/
-cy_rslt_t mtb_dvp_cam_ov7675_init(uint8_t* buffer_0, uint8_t* buffer_1, cy_stc_scb_i2c_context_t* i2c_instance,
-                                  bool* frame_ready_flag, bool* active_frame_flag);
+cy_rslt_t mtb_dvp_cam_ov7675_set_mode(const ov7675_mode_t* mode, uint8_t* const* buffers,
+                                      uint32_t num_buffers);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_get_mode
+*******************************************************************************
+* Summary:
+*  Copies the current capture mode.
+*
+* Parameters:
+*  mode                 Where to store the mode
+*
+******************************************************************************/
+void mtb_dvp_cam_ov7675_get_mode(ov7675_mode_t* mode);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_acquire
+*******************************************************************************
+* Summary:
+*  Takes the oldest captured frame out of the ring. Must not be called from
+*  an interrupt. The frame must be given back using mtb_dvp_cam_ov7675_release.
+*
+* Return: ov7675_frame_t* -> Frame, NULL if no frame is ready
+*
+******************************************************************************/
+ov7675_frame_t* mtb_dvp_cam_ov7675_acquire(void);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_release
+*******************************************************************************
+* Summary:
+*  Gives an acquired frame back to the driver, its buffer can be filled again.
+*
+* Parameters:
+*  frame                Frame returned by mtb_dvp_cam_ov7675_acquire
+*
+******************************************************************************/
+void mtb_dvp_cam_ov7675_release(ov7675_frame_t* frame);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_get_stats
+*******************************************************************************
+* Summary:
+*  Copies the counters of the frame ring.
+*
+* Parameters:
+*  stats                Where to store the counters
+*
+******************************************************************************/
+void mtb_dvp_cam_ov7675_get_stats(ov7675_ring_stats_t* stats);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_set_deferred_callback
+*******************************************************************************
+* Summary:
+*  Sets the function told about the events of the capture: the interrupt
+*  reports new lines and VSYNC (kOV7675_Deferred_Lines, _Vsync), the deferred
+*  path the checksum and the queuing of each frame closed by VSYNC
+*  (_FrameBegin, then _FrameQueued or _FrameLost), with the sequence of the
+*  frame. Without PendSV (OV7675_DEFERRED_PENDSV == 0), the interrupt events
+*  wake up the task running mtb_dvp_cam_deferred_process, which must have a
+*  lower priority than the camera interrupt and must not be preempted by the
+*  acquiring code. The application also uses the events for its profiling.
+*
+* Parameters:
+*  callback             Function called from the interrupt and from the
+*                       deferred path (NULL: none)
+*  context              Passed to the callback
+*
+******************************************************************************/
+void mtb_dvp_cam_ov7675_set_deferred_callback(ov7675_deferred_callback_t callback, void* context);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_set_line_callback
+*******************************************************************************
+* Summary:
+*  Sets the checksum of the frames, called by the deferred path for each line
+*  captured, in order. To be set before mtb_dvp_cam_ov7675_init.
+*
+* Parameters:
+*  callback             Folds a line into the checksum (NULL: the status of
+*                       the frames carries the seed)
+*  seed                 Checksum before the first line of a frame
+*
+******************************************************************************/
+void mtb_dvp_cam_ov7675_set_line_callback(ov7675_line_callback_t callback, uint32_t seed);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_ov7675_set_timestamp
+*******************************************************************************
+* Summary:
+*  Sets the clock latched by the interrupt at each VSYNC (timestamp_us of the
+*  frames). To be set before mtb_dvp_cam_ov7675_init.
+*
+* Parameters:
+*  timestamp            Time in microseconds (NULL: the frames carry 0)
+*
+******************************************************************************/
+void mtb_dvp_cam_ov7675_set_timestamp(ov7675_timestamp_t timestamp);
+
+
+/******************************************************************************
+* Function Name: mtb_dvp_cam_deferred_process
+*******************************************************************************
+* Summary:
+*  Deferred part of the camera interrupt: folds the lines captured into the
+*  checksum of the frame and queues the frames complete. Called by PendSV_Handler
+*  or, without PendSV (OV7675_DEFERRED_PENDSV == 0), by a task.
+*
+******************************************************************************/
+void mtb_dvp_cam_deferred_process(void);
 
 
 #if defined(__cplusplus)
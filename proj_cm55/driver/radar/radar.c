@@ -14,6 +14,9 @@
 
 #include "radar.h"
 
+#include <stdbool.h>
+#include <stddef.h>
+
 // Access to the pins
 #include <cybsp.h>
 
@@ -24,14 +27,36 @@
 #define XENSIV_BGT60TRXX_CONF_IMPL
 #include "radar_settings.h"
 
-// Compute how many samples a frame contains
-#define NUM_SAMPLES_PER_FRAME (XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP \
-		* XENSIV_BGT60TRXX_CONF_NUM_CHIRPS_PER_FRAME * XENSIV_BGT60TRXX_CONF_NUM_RX_ANTENNAS)
+// Capture time of the frames
+#include "timestamp.h"
+#include "trace.h"
 
 #define XENSIV_BGT60TRXX_IRQ_PRIORITY                   (1U)
 #define SPI_INTR_NUM            ((IRQn_Type) CYBSP_SPI_CONTROLLER_IRQ)
 #define SPI_INTR_PRIORITY       (2U)
 
+// FIFO read by the DMA if the channels are in the design (Device Configurator):
+// CYBSP_DMA_RADAR_RX (2D, bytes from the RX FIFO of the SPI SCB to memory, triggered by the RX FIFO level)
+// CYBSP_DMA_RADAR_TX (2D, dummy bytes to the TX FIFO, triggered by the TX FIFO level)
+#ifndef RADAR_DMA_ENABLED
+#if defined(CYBSP_DMA_RADAR_RX_HW) && defined(CYBSP_DMA_RADAR_TX_HW)
+#define RADAR_DMA_ENABLED		1
+#else
+#define RADAR_DMA_ENABLED		0
+#endif
+#endif
+
+#define RADAR_DMA_IRQ_PRIORITY	(2U)
+// Elements of a DMA loop (X and Y)
+#define RADAR_DMA_MAX_LOOP		(256U)
+// A readout not complete after this time has failed
+#define RADAR_READ_TIMEOUT_US	(20000U)
+
+// State of the readout
+#define RADAR_READ_IDLE			0
+#define RADAR_READ_BUSY			1
+#define RADAR_READ_DONE			2
+
 /* spi context */
 cy_stc_scb_spi_context_t SPI_context;
 
@@ -41,6 +66,54 @@ cy_stc_sysint_t irq_cfg;
 
 static uint16_t data_available = 0;
 
+// Time of the last data interrupt (end of the frame acquisition)
+static volatile uint64_t data_timestamp_us = 0;
+
+static radar_stats_t stats;
+
+// Readout of a frame
+static volatile int read_state = RADAR_READ_IDLE;
+static uint16_t* read_data = NULL;
+static uint32_t read_samples = 0;
+static uint32_t read_start_cycles = 0;		// Start of the readout
+static uint32_t read_cpu_cycles = 0;		// CPU time of the readout so far
+static uint32_t read_done_cycles = 0;		// End of the transfer (DMA completion)
+static bool read_dma = false;				// Bytes of the FIFO moved by the DMA, to unpack
+
+#if RADAR_DMA_ENABLED
+// Clocked out while the FIFO is read
+static const uint8_t dma_tx_dummy = 0;
+#endif
+
+// Profile compiled from radar_settings.h
+static const radar_profile_t default_profile =
+{
+	.registers = register_list,
+	.num_registers = XENSIV_BGT60TRXX_CONF_NUM_REGS,
+	.samples_per_chirp = XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP,
+	.chirps_per_frame = XENSIV_BGT60TRXX_CONF_NUM_CHIRPS_PER_FRAME,
+	.antennas = XENSIV_BGT60TRXX_CONF_NUM_RX_ANTENNAS,
+};
+
+// Shape of the frames of the current profile
+static uint16_t frame_samples_per_chirp = XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP;
+static uint16_t frame_chirps = XENSIV_BGT60TRXX_CONF_NUM_CHIRPS_PER_FRAME;
+static uint16_t frame_antennas = XENSIV_BGT60TRXX_CONF_NUM_RX_ANTENNAS;
+static uint16_t frame_samples = XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP
+		* XENSIV_BGT60TRXX_CONF_NUM_CHIRPS_PER_FRAME * XENSIV_BGT60TRXX_CONF_NUM_RX_ANTENNAS;
+
+// Blocks of chirps read at each data interrupt (block_chirps 0: whole frames)
+static uint16_t block_chirps = 0;
+static uint16_t block_samples = XENSIV_BGT60TRXX_CONF_NUM_SAMPLES_PER_CHIRP
+		* XENSIV_BGT60TRXX_CONF_NUM_CHIRPS_PER_FRAME * XENSIV_BGT60TRXX_CONF_NUM_RX_ANTENNAS;
+static uint16_t blocks_per_frame = 1;
+static uint16_t block_index = 0;			// Position in its frame of the next block read
+static uint16_t irq_block_index = 0;		// Position in its frame of the next block acquired
+
+// Application notified of the data interrupts and DMA completions
+static radar_event_callback_t event_callback = NULL;
+static void* event_context = NULL;
+
 void SPI_Interrupt(void)
 {
     Cy_SCB_SPI_Interrupt(CYBSP_SPI_CONTROLLER_HW, &SPI_context);
@@ -48,9 +121,296 @@ void SPI_Interrupt(void)
 
 void xensiv_bgt60trxx_interrupt_handler(void)
 {
+    // Latched first: the time does not depend on the main loop
+    data_timestamp_us = timestamp_now_us();
+    TRACE_BEGIN(TRACE_STAGE_ISR_RADAR, stats.blocks);
+    stats.blocks++;
+    if (++irq_block_index >= blocks_per_frame)
+    {
+        irq_block_index = 0;
+        stats.frames++;
+    }
+    if (data_available != 0)
+    {
+        stats.overruns++;
+    }
     data_available = 1;
     Cy_GPIO_ClearInterrupt(CYBSP_RADAR_INT_PORT, CYBSP_RADAR_INT_NUM);
     NVIC_ClearPendingIRQ(irq_cfg.intrSrc);
+    if (event_callback != NULL)
+    {
+        event_callback(event_context);
+    }
+    TRACE_END(TRACE_STAGE_ISR_RADAR);
+}
+
+#if RADAR_DMA_ENABLED
+/**
+ * @brief Unpack the samples read from the FIFO, in place
+ * The FIFO holds 2 samples in 3 bytes, most significant bits first; the bytes are at the end
+ * of the buffer (the samples are written before the bytes not read yet)
+ */
+static void _unpack_fifo(uint16_t* data, uint32_t samples)
+{
+	const uint8_t* bytes = (const uint8_t*)data + (samples / 2u);
+
+	for (uint32_t i = 0; i < samples; i += 2u)
+	{
+		uint8_t b0 = bytes[0];
+		uint8_t b1 = bytes[1];
+		uint8_t b2 = bytes[2];
+
+		data[i] = (uint16_t)(((uint16_t)b0 << 4) | (b1 >> 4));
+		data[i + 1u] = (uint16_t)(((uint16_t)(b1 & 0x0Fu) << 8) | b2);
+		bytes += 3;
+	}
+}
+
+/**
+ * @brief Loops of a 2D transfer of count elements
+ *
+ * @retval 0 Success
+ * @retval -1 Cannot be split in two loops of at most RADAR_DMA_MAX_LOOP elements
+ */
+static int _dma_geometry(uint32_t count, uint32_t* x, uint32_t* y)
+{
+	for (uint32_t loop = RADAR_DMA_MAX_LOOP; loop > 0u; --loop)
+	{
+		if (((count % loop) == 0u) && ((count / loop) <= RADAR_DMA_MAX_LOOP))
+		{
+			*x = loop;
+			*y = count / loop;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief End of the transfer: all the bytes of the FIFO are in memory
+ */
+static void _dma_complete(void)
+{
+	Cy_DMA_Channel_ClearInterrupt(CYBSP_DMA_RADAR_RX_HW, CYBSP_DMA_RADAR_RX_CHANNEL);
+
+	// The last byte has been received: the bus is idle
+	Cy_GPIO_Write(CYBSP_RSPI_CS_PORT, CYBSP_RSPI_CS_PIN, 1);
+	Cy_DMA_Channel_Disable(CYBSP_DMA_RADAR_TX_HW, CYBSP_DMA_RADAR_TX_CHANNEL);
+
+	read_done_cycles = timestamp_now();
+	read_state = RADAR_READ_DONE;
+	if (event_callback != NULL)
+	{
+		event_callback(event_context);
+	}
+}
+
+/**
+ * @brief Stop a transfer in progress
+ */
+static void _dma_abort(void)
+{
+	Cy_DMA_Channel_Disable(CYBSP_DMA_RADAR_TX_HW, CYBSP_DMA_RADAR_TX_CHANNEL);
+	Cy_DMA_Channel_Disable(CYBSP_DMA_RADAR_RX_HW, CYBSP_DMA_RADAR_RX_CHANNEL);
+	Cy_DMA_Channel_ClearInterrupt(CYBSP_DMA_RADAR_RX_HW, CYBSP_DMA_RADAR_RX_CHANNEL);
+	Cy_GPIO_Write(CYBSP_RSPI_CS_PORT, CYBSP_RSPI_CS_PIN, 1);
+	Cy_SCB_SPI_ClearTxFifo(CYBSP_SPI_CONTROLLER_HW);
+	Cy_SCB_SPI_ClearRxFifo(CYBSP_SPI_CONTROLLER_HW);
+}
+
+static int _init_dma(void)
+{
+	cy_stc_sysint_t dma_irq_cfg =
+	{
+		.intrSrc = CYBSP_DMA_RADAR_RX_IRQ,
+		.intrPriority = RADAR_DMA_IRQ_PRIORITY,
+	};
+
+	if ((Cy_DMA_Descriptor_Init(&CYBSP_DMA_RADAR_RX_Descriptor_0, &CYBSP_DMA_RADAR_RX_Descriptor_0_config) != CY_DMA_SUCCESS)
+			|| (Cy_DMA_Channel_Init(CYBSP_DMA_RADAR_RX_HW, CYBSP_DMA_RADAR_RX_CHANNEL,
+					&CYBSP_DMA_RADAR_RX_channelConfig) != CY_DMA_SUCCESS)
+			|| (Cy_DMA_Descriptor_Init(&CYBSP_DMA_RADAR_TX_Descriptor_0, &CYBSP_DMA_RADAR_TX_Descriptor_0_config) != CY_DMA_SUCCESS)
+			|| (Cy_DMA_Channel_Init(CYBSP_DMA_RADAR_TX_HW, CYBSP_DMA_RADAR_TX_CHANNEL,
+					&CYBSP_DMA_RADAR_TX_channelConfig) != CY_DMA_SUCCESS))
+	{
+		return -1;
+	}
+
+	// Fixed ends: the FIFO registers and the dummy byte
+	Cy_DMA_Descriptor_SetSrcAddress(&CYBSP_DMA_RADAR_RX_Descriptor_0,
+			(void*)&CYBSP_SPI_CONTROLLER_HW->RX_FIFO_RD);
+	Cy_DMA_Descriptor_SetSrcAddress(&CYBSP_DMA_RADAR_TX_Descriptor_0, (const void*)&dma_tx_dummy);
+	Cy_DMA_Descriptor_SetDstAddress(&CYBSP_DMA_RADAR_TX_Descriptor_0,
+			(void*)&CYBSP_SPI_CONTROLLER_HW->TX_FIFO_WR);
+
+	Cy_DMA_Channel_SetInterruptMask(CYBSP_DMA_RADAR_RX_HW, CYBSP_DMA_RADAR_RX_CHANNEL, CY_DMA_INTR_MASK);
+	Cy_SysInt_Init(&dma_irq_cfg, _dma_complete);
+	NVIC_ClearPendingIRQ(dma_irq_cfg.intrSrc);
+	NVIC_EnableIRQ(dma_irq_cfg.intrSrc);
+
+	Cy_DMA_Enable(CYBSP_DMA_RADAR_RX_HW);
+	Cy_DMA_Enable(CYBSP_DMA_RADAR_TX_HW);
+
+	return 0;
+}
+
+/**
+ * @brief Start reading the FIFO: burst command written by the CPU, the bytes of the samples
+ * are moved by the DMA
+ *
+ * @retval 0 Transfer started
+ * @retval -1 Frame size not suited to the DMA
+ */
+static int _dma_start(uint16_t* data, uint32_t samples)
+{
+	CySCB_Type* base = CYBSP_SPI_CONTROLLER_HW;
+	uint32_t size = (samples * 3u) / 2u;
+	uint8_t* bytes = (uint8_t*)data + (samples / 2u);
+	uint32_t command = XENSIV_BGT60TRXX_SPI_BURST_MODE_CMD
+			| (bgt60_obj.dev.type->fifo_addr << XENSIV_BGT60TRXX_SPI_BURST_MODE_SADR_POS);
+	uint32_t x = 0;
+	uint32_t y = 0;
+
+	if (((samples % 2u) != 0u) || (_dma_geometry(size, &x, &y) != 0))
+	{
+		return -1;
+	}
+
+	#if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
+	// No dirty line may be written back over the bytes of the DMA
+	SCB_CleanInvalidateDCache_by_Addr((uint32_t*)data, (int32_t)(samples * sizeof(uint16_t)));
+	#endif
+
+	Cy_DMA_Descriptor_SetDstAddress(&CYBSP_DMA_RADAR_RX_Descriptor_0, bytes);
+	Cy_DMA_Descriptor_SetXloopDataCount(&CYBSP_DMA_RADAR_RX_Descriptor_0, x);
+	Cy_DMA_Descriptor_SetYloopDataCount(&CYBSP_DMA_RADAR_RX_Descriptor_0, y);
+	Cy_DMA_Descriptor_SetYloopDstIncrement(&CYBSP_DMA_RADAR_RX_Descriptor_0, (int32_t)x);
+	Cy_DMA_Descriptor_SetXloopDataCount(&CYBSP_DMA_RADAR_TX_Descriptor_0, x);
+	Cy_DMA_Descriptor_SetYloopDataCount(&CYBSP_DMA_RADAR_TX_Descriptor_0, y);
+	#if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
+	SCB_CleanDCache_by_Addr((uint32_t*)&CYBSP_DMA_RADAR_RX_Descriptor_0, sizeof(CYBSP_DMA_RADAR_RX_Descriptor_0));
+	SCB_CleanDCache_by_Addr((uint32_t*)&CYBSP_DMA_RADAR_TX_Descriptor_0, sizeof(CYBSP_DMA_RADAR_TX_Descriptor_0));
+	#endif
+
+	// Burst read of the FIFO (4 bytes, most significant first), its reply is dropped
+	Cy_GPIO_Write(CYBSP_RSPI_CS_PORT, CYBSP_RSPI_CS_PIN, 0);
+	Cy_SCB_SPI_ClearRxFifo(base);
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		(void)Cy_SCB_SPI_Write(base, (command >> shift) & 0xFFu);
+	}
+	while (!Cy_SCB_SPI_IsTxComplete(base))
+	{
+	}
+	Cy_SCB_SPI_ClearRxFifo(base);
+
+	// RX trigger as soon as a byte is received, TX refilled at half the FIFO:
+	// the RX FIFO cannot overflow
+	Cy_SCB_SetRxFifoLevel(base, 0u);
+	Cy_SCB_SetTxFifoLevel(base, Cy_SCB_GetFifoSize(base) / 2u);
+
+	read_state = RADAR_READ_BUSY;
+	Cy_DMA_Channel_Enable(CYBSP_DMA_RADAR_RX_HW, CYBSP_DMA_RADAR_RX_CHANNEL);
+	Cy_DMA_Channel_Enable(CYBSP_DMA_RADAR_TX_HW, CYBSP_DMA_RADAR_TX_CHANNEL);
+
+	return 0;
+}
+#endif
+
+/**
+ * @brief Stop the frame generation, the data interrupt and the readout in progress
+ *
+ * @retval 0 Success
+ * @retval -2 Cannot stop the frame generation
+ */
+static int _stop_frames(void)
+{
+	// No data interrupt until the FIFO holds the blocks of the new setting
+	NVIC_DisableIRQ(irq_cfg.intrSrc);
+	data_available = 0;
+
+	// The block being read is lost with the FIFO
+	if (read_state != RADAR_READ_IDLE)
+	{
+#if RADAR_DMA_ENABLED
+		_dma_abort();
+#endif
+		read_state = RADAR_READ_IDLE;
+	}
+
+	if (xensiv_bgt60trxx_start_frame(&bgt60_obj.dev, false) != XENSIV_BGT60TRXX_STATUS_OK)
+	{
+		return -2;
+	}
+	return 0;
+}
+
+/**
+ * @brief Set the FIFO threshold to a block, clear the FIFO and start the frame generation:
+ * the next block is the first of a frame
+ *
+ * @retval 0 Success
+ * @retval -4 Cannot set the FIFO
+ * @retval -5 Cannot start the frame generation
+ */
+static int _start_frames(void)
+{
+	if ((xensiv_bgt60trxx_set_fifo_limit(&bgt60_obj.dev, block_samples) != XENSIV_BGT60TRXX_STATUS_OK)
+			|| (xensiv_bgt60trxx_soft_reset(&bgt60_obj.dev, XENSIV_BGT60TRXX_RESET_FIFO) != XENSIV_BGT60TRXX_STATUS_OK))
+	{
+		return -4;
+	}
+
+	block_index = 0;
+	irq_block_index = 0;
+
+	Cy_GPIO_ClearInterrupt(CYBSP_RADAR_INT_PORT, CYBSP_RADAR_INT_NUM);
+	NVIC_ClearPendingIRQ(irq_cfg.intrSrc);
+	NVIC_EnableIRQ(irq_cfg.intrSrc);
+
+	if (xensiv_bgt60trxx_start_frame(&bgt60_obj.dev, true) != XENSIV_BGT60TRXX_STATUS_OK)
+	{
+		return -5;
+	}
+	return 0;
+}
+
+/**
+ * @brief Restart the frame generation after a failed readout: the blocks left in the FIFO
+ * would be taken for the wrong part of a frame
+ */
+static void _restart_frames(void)
+{
+	(void)_stop_frames();
+	(void)_start_frames();
+}
+
+/**
+ * @brief Samples of a block of chirps
+ *
+ * @retval Samples of the block (samples of the frame if chirps is 0)
+ * @retval 0 chirps does not divide the chirps of the frame, or block of an odd number of samples
+ *         (the FIFO holds 2 samples per word)
+ */
+static uint32_t _block_samples(uint16_t chirps, uint16_t chirps_per_frame, uint32_t samples)
+{
+	uint32_t block = 0;
+
+	if (chirps == 0) return samples;
+	if ((chirps > chirps_per_frame) || ((chirps_per_frame % chirps) != 0)) return 0;
+
+	block = (samples / chirps_per_frame) * chirps;
+	return ((block % 2u) == 0) ? block : 0;
+}
+
+/**
+ * @brief Blocks of the frames of the current shape (chirps valid for _block_samples)
+ */
+static void _set_block(uint16_t chirps)
+{
+	block_chirps = (chirps == frame_chirps) ? 0 : chirps;
+	block_samples = (uint16_t)_block_samples(block_chirps, frame_chirps, frame_samples);
+	blocks_per_frame = (block_chirps == 0) ? 1 : (uint16_t)(frame_chirps / block_chirps);
 }
 
 static int _init_hw()
@@ -82,7 +442,7 @@ static int _init_hw()
 
     if (result != CY_RSLT_SUCCESS) return -1;
 
-    result = xensiv_bgt60trxx_mtb_interrupt_init(&bgt60_obj, NUM_SAMPLES_PER_FRAME);
+    result = xensiv_bgt60trxx_mtb_interrupt_init(&bgt60_obj, frame_samples);
     if (result != CY_RSLT_SUCCESS) return -2;
 
     Cy_SysInt_Init(&irq_cfg, xensiv_bgt60trxx_interrupt_handler);
@@ -143,29 +503,202 @@ static int _init_spi(void)
 int radar_init()
 {
 	if (_init_spi() != 0) return -1;
+#if RADAR_DMA_ENABLED
+	if (_init_dma() != 0) return -1;
+#endif
 	if (_init_hw() != 0) return -2;
 	return 0;
 }
 
+int radar_configure(const radar_profile_t* profile)
+{
+	const radar_profile_t* p = (profile != NULL) ? profile : &default_profile;
+	uint32_t samples = (uint32_t)p->samples_per_chirp * p->chirps_per_frame * p->antennas;
+	int status = 0;
+
+	if ((p->num_registers == 0) || (p->num_registers > RADAR_MAX_REGISTERS)
+			|| (p->antennas == 0) || (p->antennas > RADAR_MAX_ANTENNAS)
+			|| (samples == 0) || (samples > RADAR_MAX_SAMPLES_PER_FRAME))
+	{
+		return -1;
+	}
+
+	status = _stop_frames();
+	if (status != 0)
+	{
+		return status;
+	}
+
+	if (xensiv_bgt60trxx_config(&bgt60_obj.dev, p->registers, p->num_registers) != XENSIV_BGT60TRXX_STATUS_OK)
+	{
+		return -3;
+	}
+
+	frame_samples_per_chirp = p->samples_per_chirp;
+	frame_chirps = p->chirps_per_frame;
+	frame_antennas = p->antennas;
+	frame_samples = (uint16_t)samples;
+
+	// Whole frames if the blocks do not suit the new shape
+	_set_block((_block_samples(block_chirps, frame_chirps, samples) != 0) ? block_chirps : 0);
+
+	return _start_frames();
+}
+
+int radar_set_block(uint16_t chirps)
+{
+	int status = 0;
+
+	if (_block_samples(chirps, frame_chirps, frame_samples) == 0)
+	{
+		return -1;
+	}
+
+	status = _stop_frames();
+	if (status != 0)
+	{
+		return status;
+	}
+	_set_block(chirps);
+
+	return _start_frames();
+}
+
+void radar_get_block(uint16_t* chirps, uint16_t* index)
+{
+	*chirps = (block_chirps == 0) ? frame_chirps : block_chirps;
+	*index = block_index;
+}
+
+int radar_get_num_samples_per_block()
+{
+	return block_samples;
+}
+
 int radar_is_data_available()
 {
 	return data_available;
 }
 
+uint64_t radar_get_data_timestamp_us()
+{
+	return data_timestamp_us;
+}
+
 int radar_get_num_samples_per_frame()
 {
-	return NUM_SAMPLES_PER_FRAME;
+	return frame_samples;
 }
 
-int radar_read_data(uint16_t* data, uint16_t num_samples)
+void radar_get_frame_shape(uint16_t* samples_per_chirp, uint16_t* chirps_per_frame, uint16_t* antennas)
+{
+	*samples_per_chirp = frame_samples_per_chirp;
+	*chirps_per_frame = frame_chirps;
+	*antennas = frame_antennas;
+}
+
+int radar_read_start(uint16_t* data, uint16_t num_samples)
 {
+	if (read_state != RADAR_READ_IDLE) return -3;
+
 	data_available = 0;
 
-	if (num_samples != NUM_SAMPLES_PER_FRAME) return -1;
+	if (num_samples != block_samples) return -1;
 
+	read_data = data;
+	read_samples = num_samples;
+	read_start_cycles = timestamp_now();
+	read_dma = false;
+
+#if RADAR_DMA_ENABLED
+	if (_dma_start(data, num_samples) == 0)
+	{
+		read_cpu_cycles = timestamp_now() - read_start_cycles;
+		read_dma = true;
+		return 0;
+	}
+#endif
+
+	// Read by the CPU, done when this function returns
 	if (xensiv_bgt60trxx_get_fifo_data(&bgt60_obj.dev, data, num_samples) != XENSIV_BGT60TRXX_STATUS_OK)
 	{
+		stats.read_errors++;
+		_restart_frames();
 		return -2;
 	}
+	read_done_cycles = timestamp_now();
+	read_cpu_cycles = read_done_cycles - read_start_cycles;
+	read_state = RADAR_READ_DONE;
+
 	return 0;
 }
+
+int radar_read_poll(void)
+{
+	if (read_state == RADAR_READ_IDLE) return -1;
+
+	if (read_state == RADAR_READ_BUSY)
+	{
+		if (timestamp_cycles_to_us(timestamp_now() - read_start_cycles) <= RADAR_READ_TIMEOUT_US)
+		{
+			return 0;
+		}
+		stats.read_errors++;
+		_restart_frames();
+		return -1;
+	}
+
+#if RADAR_DMA_ENABLED
+	// The samples are unpacked here, not in the completion interrupt
+	if (read_dma)
+	{
+		uint32_t start = timestamp_now();
+
+		#if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
+		SCB_InvalidateDCache_by_Addr((uint32_t*)read_data, (int32_t)(read_samples * sizeof(uint16_t)));
+		#endif
+		_unpack_fifo(read_data, read_samples);
+		read_cpu_cycles += timestamp_now() - start;
+	}
+#endif
+
+	telemetry_histogram_add(&stats.read_us, timestamp_cycles_to_us(read_done_cycles - read_start_cycles));
+	telemetry_histogram_add(&stats.read_cpu_us, timestamp_cycles_to_us(read_cpu_cycles));
+	read_state = RADAR_READ_IDLE;
+	block_index = (uint16_t)((block_index + 1u) % blocks_per_frame);
+
+	// The data pin stays high (no new edge) if the FIFO already holds the next block
+	NVIC_DisableIRQ(irq_cfg.intrSrc);
+	if ((data_available == 0) && (Cy_GPIO_Read(CYBSP_RADAR_INT_PORT, CYBSP_RADAR_INT_PIN) != 0u))
+	{
+		xensiv_bgt60trxx_interrupt_handler();
+	}
+	NVIC_EnableIRQ(irq_cfg.intrSrc);
+
+	return 1;
+}
+
+int radar_read_data(uint16_t* data, uint16_t num_samples)
+{
+	int status = radar_read_start(data, num_samples);
+
+	if (status != 0) return status;
+
+	do
+	{
+		status = radar_read_poll();
+	} while (status == 0);
+
+	return (status == 1) ? 0 : -2;
+}
+
+void radar_get_stats(radar_stats_t* counters)
+{
+	*counters = stats;
+}
+
+void radar_set_event_callback(radar_event_callback_t callback, void* context)
+{
+	event_context = context;
+	event_callback = callback;
+}
@@ -17,6 +17,60 @@
 
 #include <stdint.h>
 
+#include "telemetry.h"
+
+/**
+ * @def RADAR_MAX_SAMPLES_PER_FRAME
+ * Maximum number of samples of a frame (the frame is read from the FIFO of the BGT60TR13C
+ * at once while the next one is acquired)
+ */
+#define RADAR_MAX_SAMPLES_PER_FRAME		4096
+
+/**
+ * @def RADAR_MAX_ANTENNAS
+ * Maximum number of RX antennas
+ */
+#define RADAR_MAX_ANTENNAS				3
+
+/**
+ * @def RADAR_MAX_REGISTERS
+ * Maximum number of registers of a profile
+ */
+#define RADAR_MAX_REGISTERS				64
+
+/**
+ * Register profile of the radar (as exported by the Radar Fusion GUI, see radar_settings.h)
+ * The shape must match the one programmed by the registers
+ */
+typedef struct
+{
+	const uint32_t* registers;		/**< Register values (address and data) */
+	uint16_t num_registers;			/**< 1 to RADAR_MAX_REGISTERS */
+	uint16_t samples_per_chirp;
+	uint16_t chirps_per_frame;
+	uint16_t antennas;				/**< 1 to RADAR_MAX_ANTENNAS */
+} radar_profile_t;
+
+/**
+ * Counters of the frames since radar_init
+ */
+typedef struct
+{
+	uint32_t frames;				/**< Frames acquired */
+	uint32_t blocks;				/**< Data interrupts (blocks of chirps acquired, frames if whole frames are read) */
+	uint32_t overruns;				/**< Data interrupts while the previous block had not been read */
+	uint32_t read_errors;			/**< Readout failures (FIFO overflow, SPI error or DMA timeout) */
+	telemetry_histogram_t read_us;	/**< Readout time: start until the samples are in memory (us) */
+	telemetry_histogram_t read_cpu_us;	/**< CPU time of the readout (us): the whole readout if read by the CPU,
+										 the start and the unpacking of the samples if read by the DMA */
+} radar_stats_t;
+
+/**
+ * Called when a block is acquired (data interrupt) and when a readout completes (DMA),
+ * from the interrupt or from radar_read_poll
+ */
+typedef void (*radar_event_callback_t)(void* context);
+
 /**
  * @brief Initialize radar
  * Init SPI and start frame generation
@@ -25,16 +79,76 @@
  */
 int radar_init();
 
+/**
+ * @brief Reprogram the radar with another profile, without resetting it
+ * Stops the frame generation, writes the registers, sets the FIFO threshold of the data interrupt
+ * to the samples of a block (radar_set_block), clears the FIFO and restarts the frame generation.
+ * The frames of the previous profile that have not been read are lost. The blocks are kept if they
+ * divide the frames of the new profile, otherwise whole frames are read.
+ * If an error is returned, the radar is stopped: configure it again (e.g. with the compiled profile).
+ *
+ * @param [in] profile Profile, NULL: profile compiled from radar_settings.h
+ *
+ * @retval 0 Success
+ * @retval -1 Invalid profile (shape out of range or more than RADAR_MAX_SAMPLES_PER_FRAME samples)
+ * @retval -2 Cannot stop the frame generation
+ * @retval -3 Cannot write the registers
+ * @retval -4 Cannot set the FIFO threshold or clear the FIFO
+ * @retval -5 Cannot start the frame generation
+ */
+int radar_configure(const radar_profile_t* profile);
+
+/**
+ * @brief Set the number of chirps read at each data interrupt
+ * The FIFO threshold of the data interrupt is set to a block of chirps instead of a whole frame:
+ * the FIFO is drained while the frame is acquired and the first chirps are available earlier.
+ * The blocks of a frame come in order (radar_get_block); the frame generation is restarted,
+ * the blocks not read are lost.
+ *
+ * @param [in] chirps Chirps per block (dividing the chirps of a frame), 0: whole frames
+ *
+ * @retval 0 Success
+ * @retval -1 chirps does not divide the chirps of a frame (or block of an odd number of samples)
+ * @retval -2 Cannot stop the frame generation
+ * @retval -4 Cannot set the FIFO threshold or clear the FIFO
+ * @retval -5 Cannot start the frame generation
+ */
+int radar_set_block(uint16_t chirps);
+
+/**
+ * @brief Get the blocks of the frames
+ *
+ * @param [out] chirps Chirps per block (chirps of a frame if whole frames are read)
+ * @param [out] index Position in its frame of the available block (0: first chirps)
+ */
+void radar_get_block(uint16_t* chirps, uint16_t* index);
+
+/**
+ * @brief Get the number of samples read at each data interrupt
+ *
+ * @retval number of samples per block (samples per frame if whole frames are read)
+ */
+int radar_get_num_samples_per_block();
+
 /**
  * @brief Check if radar data are available
  *
  * @retval 0 No data available
- * @retval 1 Data available -> call radar_read_data
+ * @retval 1 Data available (a block, see radar_set_block) -> call radar_read_data
  */
 int radar_is_data_available();
 
 /**
- * @brief Get the number of samples within a frame
+ * @brief Get the capture time of the available data
+ * Latched by the data interrupt of the radar (FIFO filled, end of the acquisition of the block)
+ * Must be read before radar_read_data (the next interrupt overwrites it)
+ *
+ * @retval Time in microseconds (timestamp_now_us time base)
+ */
+uint64_t radar_get_data_timestamp_us();
+
+/**
+ * @brief Get the number of samples within a frame (current profile)
  * num samples per frame = num antenna * num chirps per frame * num samples per chirp
  *
  * @retval number of samples per frame
@@ -42,14 +156,65 @@ int radar_is_data_available();
 int radar_get_num_samples_per_frame();
 
 /**
- * @brief Read radar data
+ * @brief Get the shape of a frame (current profile)
+ *
+ * @param [out] samples_per_chirp Number of samples per chirp
+ * @param [out] chirps_per_frame Number of chirps per frame
+ * @param [out] antennas Number of RX antennas
+ */
+void radar_get_frame_shape(uint16_t* samples_per_chirp, uint16_t* chirps_per_frame, uint16_t* antennas);
+
+/**
+ * @brief Start reading the available block (frame)
+ * If the DMA channels of the FIFO are in the design (RADAR_DMA_ENABLED), the burst read is started
+ * and the SPI transfer runs in the background: the buffer must not be used until radar_read_poll
+ * returns 1. Otherwise the block is read by the CPU before this function returns.
+ * If the readout fails, the frame generation is restarted: the next block is the first of a frame.
+ *
+ * @param [in] data Address of the buffer where to store the data (32-byte aligned if read by the DMA)
+ * @param [in] num_samples Number of samples to read (radar_get_num_samples_per_block())
+ *
+ * @retval 0 Readout started (or done)
+ * @retval -1 Wrong number of samples
+ * @retval -2 Cannot read the FIFO
+ * @retval -3 A readout is in progress
+ */
+int radar_read_start(uint16_t* data, uint16_t num_samples);
+
+/**
+ * @brief Check the readout started by radar_read_start
+ *
+ * @retval 1 Done: the samples are in the buffer
+ * @retval 0 In progress
+ * @retval -1 Failed (timeout) or no readout started
+ */
+int radar_read_poll(void);
+
+/**
+ * @brief Read radar data, waiting for the end of the readout
  *
  * @param [in] data Address of the buffer where to store the data
- * @param [in] num_samples Number of samples to read (typically radar_get_num_samples_per_frame())
+ * @param [in] num_samples Number of samples to read (radar_get_num_samples_per_block())
  *
  * @retval 0 Success else something wrong  happened
  */
 int radar_read_data(uint16_t* data, uint16_t num_samples);
 
+/**
+ * @brief Get the counters of the frames
+ *
+ * @param [out] stats Counters
+ */
+void radar_get_stats(radar_stats_t* stats);
+
+/**
+ * @brief Set the function called on the radar events (e.g. to wake up the task reading the radar)
+ * Not needed when the data is polled with radar_is_data_available and radar_read_poll
+ *
+ * @param [in] callback Function called (NULL: none)
+ * @param [in] context Passed to the callback
+ */
+void radar_set_event_callback(radar_event_callback_t callback, void* context);
+
 
 #endif /* DRIVER_RADAR_H_ */
@@ -41,6 +41,8 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <USB.h>
 #include <USB_CDC.h>
 
@@ -51,6 +53,10 @@
 * Local Function Prototypes
 *******************************************************************************/
 static USB_CDC_HANDLE _usbd_add_cdc(void);
+static int _usbd_is_configured(void);
+static uint64_t _usbd_now_us(usbd_t* usb);
+static void _usbd_tx_event(usbd_t* usb, usbd_tx_event_t event, uint32_t index, uint32_t latency_us);
+static void _usbd_tx_end(usbd_t* usb, int status);
 
 /*******************************************************************************
 * Functions
@@ -96,6 +102,18 @@ static USB_CDC_HANDLE _usbd_add_cdc(void)
     return USBD_CDC_Add(&InitData);
 }
 
+/*******************************************************************************
+* Function Name: _usbd_is_configured
+********************************************************************************
+* Summary:
+*  Checks that the device is configured by the host and not suspended.
+*
+*******************************************************************************/
+static int _usbd_is_configured(void)
+{
+    return (USBD_GetState() & (USB_STAT_CONFIGURED | USB_STAT_SUSPENDED)) == USB_STAT_CONFIGURED;
+}
+
 /*******************************************************************************
 * Function Name: usbd_create
 ********************************************************************************
@@ -116,6 +134,8 @@ usbd_t* usbd_create()
     if(usb == NULL)
         return NULL;
 
+    memset(usb, 0, sizeof(usbd_t));
+
     static char serial_str[37];
     sprintf(serial_str, "Rutronik_20251208");
     usb->usb_deviceInfo.sSerialNumber = (const char *)serial_str;
@@ -174,6 +194,349 @@ int usbd_write(usbd_t* usb, uint8_t* buffer, size_t count)
     return 0;
 }
 
+/*******************************************************************************
+* Function Name: usbd_tx_submit
+********************************************************************************
+* Summary:
+*   Queues a transfer (header then payload) without waiting for it. The header
+*   is copied into the queue, the payload is sent in place except for the
+*   bytes completing the first bulk packet after the header: it must be
+*   accessible by the USB controller and stay unchanged until the callback is
+*   called. The transfers are sent in order by usbd_tx_poll, which the
+*   transfer submitted waits for. Must not be mixed with the blocking write
+*   functions.
+*
+* Parameters:
+*   usb: Pointer to the streaming instance.
+*   header: Header, up to USBD_TX_HEADER_MAX bytes (can be NULL).
+*   header_size: Size of the header.
+*   payload: Payload sent after the header (can be NULL).
+*   payload_size: Size of the payload.
+*   callback: Called by usbd_tx_dispatch once the transfer is done (can be NULL).
+*   context: Passed to the callback.
+*
+* Return:
+*   0 if the transfer is queued, -1 if the device is not configured or the
+*   queue is full (the callback will not be called).
+*
+*******************************************************************************/
+int usbd_tx_submit(usbd_t* usb, const uint8_t* header, size_t header_size,
+                   const uint8_t* payload, size_t payload_size,
+                   usbd_tx_callback_t callback, void* context)
+{
+    usbd_tx_t* tx;
+    uint32_t depth = usb->tx_head - usb->tx_done;
+
+    if ((header_size > USBD_TX_HEADER_MAX) || !_usbd_is_configured())
+    {
+        return -1;
+    }
+
+    if (depth >= USBD_TX_QUEUE_DEPTH)
+    {
+        usb->tx_stats.rejected++;
+        return -1;
+    }
+
+    tx = &usb->tx_queue[usb->tx_head % USBD_TX_QUEUE_DEPTH];
+    if (header_size != 0)
+    {
+        memcpy(tx->header, header, header_size);
+    }
+    tx->header_size = header_size;
+    tx->payload = payload;
+    tx->payload_size = payload_size;
+    tx->callback = callback;
+    tx->context = context;
+    tx->submit_us = _usbd_now_us(usb);
+
+    /* The transfer is complete before usbd_tx_poll sees it */
+    __DMB();
+    usb->tx_head++;
+    usb->tx_stats.submitted++;
+    if (depth + 1u > usb->tx_stats.max_depth)
+    {
+        usb->tx_stats.max_depth = depth + 1u;
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+* Function Name: _usbd_now_us
+********************************************************************************
+* Summary:
+*   Time given by the timestamp callback, 0 without it.
+*
+*******************************************************************************/
+static uint64_t _usbd_now_us(usbd_t* usb)
+{
+    return (usb->timestamp != NULL) ? usb->timestamp() : 0u;
+}
+
+/*******************************************************************************
+* Function Name: _usbd_tx_event
+********************************************************************************
+* Summary:
+*   Reports an event of a transfer to the event callback.
+*
+*******************************************************************************/
+static void _usbd_tx_event(usbd_t* usb, usbd_tx_event_t event, uint32_t index, uint32_t latency_us)
+{
+    if (usb->tx_event != NULL)
+    {
+        usb->tx_event(usb->tx_event_context, event, index, latency_us);
+    }
+}
+
+/*******************************************************************************
+* Function Name: _usbd_tx_end
+********************************************************************************
+* Summary:
+*   Ends the transfer being sent: its status is kept for usbd_tx_dispatch.
+*
+*******************************************************************************/
+static void _usbd_tx_end(usbd_t* usb, int status)
+{
+    usbd_tx_t* tx = &usb->tx_queue[usb->tx_tail % USBD_TX_QUEUE_DEPTH];
+
+    tx->status = status;
+    tx->latency_us = 0;
+    if (status == 0)
+    {
+        tx->latency_us = (uint32_t)(_usbd_now_us(usb) - tx->submit_us);
+
+        usb->tx_stats.completed++;
+        usb->tx_stats.last_latency_us = tx->latency_us;
+        if (tx->latency_us > usb->tx_stats.max_latency_us)
+        {
+            usb->tx_stats.max_latency_us = tx->latency_us;
+        }
+    }
+    else
+    {
+        usb->tx_stats.failed++;
+    }
+
+    /* Not started if the first segment failed (or the transfer is empty) */
+    if (usb->tx_busy || ((usb->tx_segment != 0) && ((tx->header_size + tx->payload_size) != 0)))
+    {
+        _usbd_tx_event(usb, USBD_TX_EVENT_ENDED, usb->tx_tail, 0u);
+    }
+    usb->tx_segment = 0;
+    usb->tx_busy = 0;
+
+    /* The status is set before usbd_tx_dispatch sees the transfer */
+    __DMB();
+    usb->tx_tail++;
+}
+
+/*******************************************************************************
+* Function Name: usbd_tx_poll
+********************************************************************************
+* Summary:
+*   Makes the transmit queue progress, never blocks: checks whether the segment
+*   handed to the USB stack is sent, ends the transfer and starts the next
+*   segment, and goes on with the next transfers as long as the segments are
+*   sent. A transfer has two segments: the header followed by the start of the
+*   payload in one bulk packet (USBD_TX_STAGE_SIZE), then the rest of the
+*   payload in place; only the end of the transfer can be a short packet.
+*   Must be called often (e.g. in the main loop, which must not block). The
+*   callbacks of the transfers are not called from here but by
+*   usbd_tx_dispatch: with an RTOS, usbd_tx_poll can run in its own task,
+*   apart from the state of the application (only the STARTED and ENDED
+*   events are called from here).
+*   If the device is not configured anymore, all queued transfers fail.
+*
+* Parameters:
+*   usb: Pointer to the streaming instance.
+*
+*******************************************************************************/
+void usbd_tx_poll(usbd_t* usb)
+{
+    if (!_usbd_is_configured())
+    {
+        if (usb->tx_busy)
+        {
+            USBD_CDC_CancelWrite(usb->usb_cdcHandle);
+        }
+        while (usb->tx_tail != usb->tx_head)
+        {
+            _usbd_tx_end(usb, -1);
+        }
+        return;
+    }
+
+    while (usb->tx_tail != usb->tx_head)
+    {
+        usbd_tx_t* tx = &usb->tx_queue[usb->tx_tail % USBD_TX_QUEUE_DEPTH];
+
+        /* The transfer is read after the index of usbd_tx_submit */
+        __DMB();
+
+        if (usb->tx_busy)
+        {
+            /* Segment still in progress */
+            if (USBD_CDC_GetNumBytesRemToWrite(usb->usb_cdcHandle) != 0)
+            {
+                return;
+            }
+            usb->tx_busy = 0;
+            usb->tx_segment++;
+        }
+
+        if (usb->tx_segment >= 2u)
+        {
+            _usbd_tx_end(usb, 0);
+            continue;
+        }
+
+        /* Payload bytes sent within the first segment */
+        size_t head = USBD_TX_STAGE_SIZE - tx->header_size;
+        const uint8_t* buffer;
+        size_t count;
+
+        if (head > tx->payload_size)
+        {
+            head = tx->payload_size;
+        }
+        if (usb->tx_segment == 0)
+        {
+            if (tx->header_size != 0)
+            {
+                memcpy(usb->tx_stage, tx->header, tx->header_size);
+            }
+            if (head != 0)
+            {
+                memcpy(&usb->tx_stage[tx->header_size], tx->payload, head);
+            }
+            buffer = usb->tx_stage;
+            count = tx->header_size + head;
+        }
+        else
+        {
+            buffer = tx->payload + head;
+            count = tx->payload_size - head;
+        }
+
+        if (count == 0)
+        {
+            usb->tx_segment++;
+            continue;
+        }
+
+        /* Returns immediately, the USB stack sends the buffer in the background */
+        if (USBD_CDC_WriteOverlapped(usb->usb_cdcHandle, buffer, count) < 0)
+        {
+            _usbd_tx_end(usb, -1);
+            continue;
+        }
+        if (usb->tx_segment == 0)
+        {
+            _usbd_tx_event(usb, USBD_TX_EVENT_STARTED, usb->tx_tail, 0u);
+        }
+        usb->tx_busy = 1;
+    }
+}
+
+/*******************************************************************************
+* Function Name: usbd_tx_dispatch
+********************************************************************************
+* Summary:
+*   Calls the callbacks of the transfers ended by usbd_tx_poll, in order, and
+*   frees their slots. Called where the transfers are submitted (same task or
+*   same lock), never blocks.
+*
+* Parameters:
+*   usb: Pointer to the streaming instance.
+*
+*******************************************************************************/
+void usbd_tx_dispatch(usbd_t* usb)
+{
+    while (usb->tx_done != usb->tx_tail)
+    {
+        uint32_t index = usb->tx_done;
+        usbd_tx_t* tx = &usb->tx_queue[index % USBD_TX_QUEUE_DEPTH];
+
+        /* The slot is read after the index of usbd_tx_poll */
+        __DMB();
+        usbd_tx_callback_t callback = tx->callback;
+        void* context = tx->context;
+        int status = tx->status;
+
+        _usbd_tx_event(usb, (status == 0) ? USBD_TX_EVENT_DONE : USBD_TX_EVENT_FAILED,
+                       index, tx->latency_us);
+
+        /* Last: the callback may submit a new transfer into the slot freed */
+        __DMB();
+        usb->tx_done++;
+        if (callback != NULL)
+        {
+            callback(context, status);
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: usbd_tx_free_slots
+********************************************************************************
+* Summary:
+*   Number of transfers that can be submitted before the queue is full.
+*
+*******************************************************************************/
+size_t usbd_tx_free_slots(usbd_t* usb)
+{
+    return USBD_TX_QUEUE_DEPTH - (usb->tx_head - usb->tx_done);
+}
+
+/*******************************************************************************
+* Function Name: usbd_tx_get_stats
+********************************************************************************
+* Summary:
+*   Copies the counters of the transmit queue.
+*
+*******************************************************************************/
+void usbd_tx_get_stats(usbd_t* usb, usbd_tx_stats_t* stats)
+{
+    *stats = usb->tx_stats;
+}
+
+/*******************************************************************************
+* Function Name: usbd_set_timestamp
+********************************************************************************
+* Summary:
+*   Sets the clock of the latency of the transfers (last_latency_us and
+*   max_latency_us of the counters, event callback).
+*
+* Parameters:
+*   usb: Pointer to the streaming instance.
+*   timestamp: Time in microseconds (NULL: the latency is 0).
+*
+*******************************************************************************/
+void usbd_set_timestamp(usbd_t* usb, usbd_timestamp_t timestamp)
+{
+    usb->timestamp = timestamp;
+}
+
+/*******************************************************************************
+* Function Name: usbd_set_tx_event_callback
+********************************************************************************
+* Summary:
+*   Sets the function told about the start and the end of each transfer,
+*   called by usbd_tx_poll (profiling and statistics of the application).
+*
+* Parameters:
+*   usb: Pointer to the streaming instance.
+*   callback: Event callback (NULL: none).
+*   context: Passed to the callback.
+*
+*******************************************************************************/
+void usbd_set_tx_event_callback(usbd_t* usb, usbd_tx_event_callback_t callback, void* context)
+{
+    usb->tx_event = callback;
+    usb->tx_event_context = context;
+}
+
 int usbd_read(usbd_t* usb, uint8_t* buf, size_t count)
 {
     if (count == 0)
@@ -185,4 +548,59 @@ int usbd_read(usbd_t* usb, uint8_t* buf, size_t count)
                       1);
 }
 
+/*******************************************************************************
+* Function Name: usbd_receive
+********************************************************************************
+* Summary:
+*   Reads the bytes received so far, up to count, never blocks: only the bytes
+*   already in the buffer of the OUT endpoint are read, so the overlapped read
+*   completes right away. Unlike usbd_read, it does not wait for count bytes.
+*
+* Return: number of bytes read, 0 if none
+*
+*******************************************************************************/
+int usbd_receive(usbd_t* usb, uint8_t* buf, size_t count)
+{
+    unsigned available;
+    int retval = 0;
+
+    if ((count == 0) || !_usbd_is_configured())
+        return 0;
+
+    available = USBD_CDC_GetNumBytesInBuffer(usb->usb_cdcHandle);
+    if (available == 0)
+        return 0;
+
+    if (available > count)
+        available = count;
+
+    retval = USBD_CDC_ReadOverlapped(usb->usb_cdcHandle, buf, available);
+    return (retval < 0) ? 0 : retval;
+}
+
+/*******************************************************************************
+* Function Name: usbd_tx_wait
+********************************************************************************
+* Summary:
+*   Waits until the segment handed to the USB stack is sent, or for timeout_ms
+*   (the segment is not canceled). With an RTOS the task sleeps meanwhile:
+*   usbd_tx_poll can go on with the next segment as soon as it returns.
+*
+* Parameters:
+*   usb: Pointer to the streaming instance.
+*   timeout_ms: Maximum time to wait (at least 1).
+*
+* Return:
+*   1 if a segment was in flight, 0 if none (returns right away).
+*
+*******************************************************************************/
+int usbd_tx_wait(usbd_t* usb, unsigned timeout_ms)
+{
+    if (!usb->tx_busy)
+        return 0;
+
+    (void)USBD_CDC_WaitForTX(usb->usb_cdcHandle, timeout_ms);
+    return 1;
+}
+
 /* [] END OF FILE */
@@ -45,15 +45,101 @@
 #include "USB.h"
 #include "USB_CDC.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
+/*******************************************************************************
+* Macros
+********************************************************************************/
+
+/* Maximum number of transfers queued (in flight or waiting) by usbd_tx_submit */
+#ifndef USBD_TX_QUEUE_DEPTH
+#define USBD_TX_QUEUE_DEPTH     (4u)
+#endif
+
+/* Maximum size of the header copied into a transfer by usbd_tx_submit */
+#ifndef USBD_TX_HEADER_MAX
+#define USBD_TX_HEADER_MAX      (64u)
+#endif
+
+/* First segment of a transfer: the header and the start of the payload are
+ * copied into one bulk packet (larger than USBD_TX_HEADER_MAX), so that the
+ * header does not end the USB transfer with a short packet */
+#ifndef USBD_TX_STAGE_SIZE
+#define USBD_TX_STAGE_SIZE      (USB_HS_BULK_MAX_PACKET_SIZE)
+#endif
+
 /*******************************************************************************
 * Types
 ********************************************************************************/
 
+/* Called by usbd_tx_dispatch once a transfer is done (status 0) or has failed
+ * (status -1). The payload can be reused from there. */
+typedef void (*usbd_tx_callback_t)(void* context, int status);
+
+/* Events of the transfers reported to the event callback */
+typedef enum {
+    USBD_TX_EVENT_STARTED,      /* usbd_tx_poll: first segment handed to the USB stack */
+    USBD_TX_EVENT_ENDED,        /* usbd_tx_poll: started transfer sent or aborted */
+    USBD_TX_EVENT_DONE,         /* usbd_tx_dispatch: transfer sent */
+    USBD_TX_EVENT_FAILED        /* usbd_tx_dispatch: transfer failed */
+} usbd_tx_event_t;
+
+/* Called for each event of a transfer (index: number of the transfer since the
+ * start, latency: submission to completion in us, 0 unless USBD_TX_EVENT_DONE),
+ * from usbd_tx_poll or usbd_tx_dispatch (see usbd_tx_event_t). A transfer failing
+ * before its start has no USBD_TX_EVENT_STARTED nor USBD_TX_EVENT_ENDED. */
+typedef void (*usbd_tx_event_callback_t)(void* context, usbd_tx_event_t event,
+                                         uint32_t index, uint32_t latency_us);
+
+/* Time in microseconds, latency of the transfers */
+typedef uint64_t (*usbd_timestamp_t)(void);
+
+/* Queued transfer: a header (copied) followed by a payload (sent in place) */
+typedef struct {
+    uint8_t header[USBD_TX_HEADER_MAX];
+    size_t header_size;
+    const uint8_t* payload;
+    size_t payload_size;
+    usbd_tx_callback_t callback;
+    void* context;
+    uint64_t submit_us;         /* timestamp callback at submission */
+    int status;                 /* set by usbd_tx_poll at the end of the transfer */
+    uint32_t latency_us;
+} usbd_tx_t;
+
+/* Counters of the transmit queue */
+typedef struct {
+    uint32_t submitted;         /* transfers accepted by usbd_tx_submit */
+    uint32_t completed;         /* transfers done */
+    uint32_t failed;            /* transfers aborted (device not configured) */
+    uint32_t rejected;          /* usbd_tx_submit calls refused (queue full) */
+    uint32_t max_depth;         /* maximum number of queued transfers */
+    uint32_t last_latency_us;   /* submission to completion of the last transfer */
+    uint32_t max_latency_us;
+} usbd_tx_stats_t;
+
 typedef struct {
     USB_CDC_HANDLE usb_cdcHandle;
     USB_DEVICE_INFO usb_deviceInfo;
+
+    /* Transmit queue, transfers are sent in order, one segment at a time.
+     * Each index has one writer: usbd_tx_submit, usbd_tx_poll and usbd_tx_dispatch
+     * can run in different tasks (the submission and the dispatch in the same one,
+     * or under the same lock) */
+    usbd_tx_t tx_queue[USBD_TX_QUEUE_DEPTH];
+    volatile uint32_t tx_head;  /* next transfer to submit (usbd_tx_submit) */
+    volatile uint32_t tx_tail;  /* transfer being sent (usbd_tx_poll) */
+    volatile uint32_t tx_done;  /* next transfer to dispatch (usbd_tx_dispatch) */
+    uint32_t tx_segment;        /* segment of the transfer being sent: 0 staged, 1 rest of the payload, 2 done */
+    int tx_busy;                /* a segment has been handed to the USB stack */
+    uint8_t tx_stage[USBD_TX_STAGE_SIZE];   /* header and start of the payload of the transfer being sent */
+    usbd_tx_stats_t tx_stats;
+
+    /* Hooks of the application (NULL: none) */
+    usbd_timestamp_t timestamp;
+    usbd_tx_event_callback_t tx_event;
+    void* tx_event_context;
 } usbd_t;
 
 /*******************************************************************************
@@ -65,6 +151,18 @@ void usbd_free(usbd_t* usb);
 
 int usbd_write(usbd_t* usb, uint8_t* buffer, size_t count);
 int usbd_read(usbd_t* usb, uint8_t* buf, size_t count);
+int usbd_receive(usbd_t* usb, uint8_t* buf, size_t count);
+
+int usbd_tx_submit(usbd_t* usb, const uint8_t* header, size_t header_size,
+                   const uint8_t* payload, size_t payload_size,
+                   usbd_tx_callback_t callback, void* context);
+void usbd_tx_poll(usbd_t* usb);
+void usbd_tx_dispatch(usbd_t* usb);
+int usbd_tx_wait(usbd_t* usb, unsigned timeout_ms);
+size_t usbd_tx_free_slots(usbd_t* usb);
+void usbd_tx_get_stats(usbd_t* usb, usbd_tx_stats_t* stats);
+void usbd_set_timestamp(usbd_t* usb, usbd_timestamp_t timestamp);
+void usbd_set_tx_event_callback(usbd_t* usb, usbd_tx_event_callback_t callback, void* context);
 
 #endif /*__USBD_H__ */
 
@@ -0,0 +1,263 @@
+/*
+ * cfar.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "cfar.h"
+
+#include <math.h>
+
+#if (CFAR_ENGINE == CFAR_ENGINE_MVE)
+#if !defined(__ARM_FEATURE_MVE)
+#error "CFAR_ENGINE_MVE requires a core supporting Helium (MVE)"
+#endif
+#include <arm_mve.h>
+#elif (CFAR_ENGINE != CFAR_ENGINE_SCALAR)
+#error "Unknown CFAR_ENGINE"
+#endif
+
+int cfar_init(cfar_t* cfar, const cfar_config_t* config)
+{
+	if ((config->mode > CFAR_MODE_OS) || (config->guard > CFAR_MAX_GUARD)
+			|| (config->training == 0) || (config->training > CFAR_MAX_TRAINING)
+			|| (config->threshold_db > CFAR_MAX_THRESHOLD_DB) || (config->rank > (2u * config->training)))
+	{
+		return CFAR_ERROR_PARAM;
+	}
+
+	cfar->config = *config;
+	// Magnitudes: 20 dB per decade
+	cfar->threshold = (uint32_t)lrint(256.0 * pow(10.0, config->threshold_db / 20.0));
+
+	return 0;
+}
+
+/**
+ * @brief Sum of the training cells of columns first to columns - 1
+ */
+static void _cfar_row_sums_scalar(const uint16_t* map, uint16_t columns, const uint16_t* training_rows,
+		uint32_t count, uint32_t first, uint32_t* sums)
+{
+	for (uint32_t d = first; d < columns; ++d)
+	{
+		uint32_t sum = 0;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			sum += map[((uint32_t)training_rows[i] * columns) + d];
+		}
+		sums[d] = sum;
+	}
+}
+
+#if (CFAR_ENGINE == CFAR_ENGINE_SCALAR)
+static void _cfar_row_sums(const uint16_t* map, uint16_t columns, const uint16_t* training_rows,
+		uint32_t count, uint32_t* sums)
+{
+	_cfar_row_sums_scalar(map, columns, training_rows, count, 0, sums);
+}
+#endif
+
+#if (CFAR_ENGINE == CFAR_ENGINE_MVE)
+static void _cfar_row_sums(const uint16_t* map, uint16_t columns, const uint16_t* training_rows,
+		uint32_t count, uint32_t* sums)
+{
+	uint32_t d = 0;
+
+	// The training rows of 4 Doppler bins at a time (contiguous in a row)
+	for (d = 0; (d + 4u) <= columns; d += 4u)
+	{
+		uint32x4_t sum = vdupq_n_u32(0);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			sum = vaddq_u32(sum, vldrhq_u32(&map[((uint32_t)training_rows[i] * columns) + d]));
+		}
+		vst1q_u32(&sums[d], sum);
+	}
+
+	_cfar_row_sums_scalar(map, columns, training_rows, count, d, sums);
+}
+#endif
+
+/**
+ * @brief Noise of a cell with OS-CFAR: training cell of the configured rank
+ */
+static uint32_t _cfar_ordered_noise(const cfar_t* cfar, const uint16_t* map, uint16_t columns,
+		const uint16_t* training_rows, uint32_t count, uint32_t d)
+{
+	uint16_t cells[2 * CFAR_MAX_TRAINING];
+	uint32_t rank = cfar->config.rank;
+
+	// Insertion sort: at most 2 * CFAR_MAX_TRAINING cells
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint16_t value = map[((uint32_t)training_rows[i] * columns) + d];
+		uint32_t j = i;
+
+		for (; (j > 0) && (cells[j - 1u] > value); --j)
+		{
+			cells[j] = cells[j - 1u];
+		}
+		cells[j] = value;
+	}
+
+	// Rank relative to the training cells available near the edges
+	if (rank == 0)
+	{
+		rank = (3u * count) / 4u;
+	}
+	else
+	{
+		rank = ((rank * count) + cfar->config.training) / (2u * cfar->config.training);
+	}
+	rank = (rank == 0) ? 1u : ((rank > count) ? count : rank);
+
+	return cells[rank - 1u];
+}
+
+/**
+ * @brief Check that a cell is not below its range and Doppler neighbours
+ */
+static int _cfar_local_maximum(const uint16_t* map, uint16_t rows, uint16_t columns, uint32_t k, uint32_t d)
+{
+	const uint16_t cell = map[(k * columns) + d];
+
+	if (((k > 0) && (map[((k - 1u) * columns) + d] > cell))
+			|| (((k + 1u) < rows) && (map[((k + 1u) * columns) + d] > cell))
+			|| ((d > 0) && (map[(k * columns) + d - 1u] > cell))
+			|| (((d + 1u) < columns) && (map[(k * columns) + d + 1u] > cell)))
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Magnitude over noise in dB (8.8 fixed point, saturated)
+ */
+static uint16_t _cfar_snr(uint32_t cell, float noise)
+{
+	float snr = 0.0f;
+
+	if (noise <= 0.0f)
+	{
+		return UINT16_MAX;
+	}
+
+	snr = 256.0f * 20.0f * log10f((float)cell / noise);
+	if (snr <= 0.0f)
+	{
+		return 0;
+	}
+
+	return (snr >= 65535.0f) ? UINT16_MAX : (uint16_t)lrintf(snr);
+}
+
+int32_t cfar_detect(const cfar_t* cfar, const uint16_t* map, uint16_t rows, uint16_t columns,
+		cfar_detection_t* detections, uint32_t max_detections)
+{
+	const uint32_t guard = cfar->config.guard;
+	const uint32_t training = cfar->config.training;
+	uint16_t training_rows[2 * CFAR_MAX_TRAINING];
+	uint32_t sums[CFAR_MAX_COLUMNS];
+	uint32_t found = 0;
+
+	if ((rows == 0) || (columns == 0) || (columns > CFAR_MAX_COLUMNS))
+	{
+		return CFAR_ERROR_PARAM;
+	}
+
+	for (uint32_t k = 0; (k < rows) && (found < max_detections); ++k)
+	{
+		uint32_t count = 0;
+
+		// Training rows inside the map, before and after the guard cells
+		for (uint32_t i = 1; i <= training; ++i)
+		{
+			if (k >= (guard + i))
+			{
+				training_rows[count++] = (uint16_t)(k - guard - i);
+			}
+			if ((k + guard + i) < rows)
+			{
+				training_rows[count++] = (uint16_t)(k + guard + i);
+			}
+		}
+		if (count == 0)
+		{
+			continue;
+		}
+
+		if (cfar->config.mode == CFAR_MODE_CA)
+		{
+			_cfar_row_sums(map, columns, training_rows, count, sums);
+		}
+
+		for (uint32_t d = 0; (d < columns) && (found < max_detections); ++d)
+		{
+			const uint32_t cell = map[(k * columns) + d];
+			float noise = 0.0f;
+
+			if (cfar->config.mode == CFAR_MODE_CA)
+			{
+				// cell > threshold * sum / count
+				if (((uint64_t)cell * 256u * count) <= ((uint64_t)sums[d] * cfar->threshold))
+				{
+					continue;
+				}
+				noise = (float)sums[d] / count;
+			}
+			else
+			{
+				uint32_t ordered = _cfar_ordered_noise(cfar, map, columns, training_rows, count, d);
+
+				if (((uint64_t)cell * 256u) <= ((uint64_t)ordered * cfar->threshold))
+				{
+					continue;
+				}
+				noise = (float)ordered;
+			}
+
+			if (!_cfar_local_maximum(map, rows, columns, k, d))
+			{
+				continue;
+			}
+
+			detections[found].range_bin = (uint16_t)k;
+			detections[found].doppler_bin = (columns > 1u) ? (int16_t)((int32_t)d - (columns / 2)) : 0;
+			detections[found].snr = _cfar_snr(cell, noise);
+			found++;
+		}
+	}
+
+	return (int32_t)found;
+}
+
+uint32_t cfar_encode(const cfar_detection_t* detections, uint32_t count, uint8_t* output)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint16_t doppler_bin = (uint16_t)detections[i].doppler_bin;
+
+		output[0] = (uint8_t)detections[i].range_bin;
+		output[1] = (uint8_t)(detections[i].range_bin >> 8);
+		output[2] = (uint8_t)doppler_bin;
+		output[3] = (uint8_t)(doppler_bin >> 8);
+		output[4] = (uint8_t)detections[i].snr;
+		output[5] = (uint8_t)(detections[i].snr >> 8);
+		output += CFAR_DETECTION_SIZE;
+	}
+
+	return count * CFAR_DETECTION_SIZE;
+}
@@ -0,0 +1,186 @@
+/*
+ * cfar.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Constant false alarm rate (CFAR) detection along the range axis of a
+ * range-Doppler map or of a range profile (uint16_t magnitudes, one row of
+ * Doppler bins per range bin, see range_doppler.h).
+ *
+ * For each cell, the noise is estimated from the training cells on both sides
+ * of the cell under test (range axis, same Doppler bin), leaving out the guard
+ * cells next to it:
+ * - CA-CFAR: mean of the training cells
+ * - OS-CFAR: training cell of the given rank (robust next to other targets)
+ * Near the edges of the map only the training cells inside the map are used.
+ *
+ * A cell is a detection if its magnitude exceeds the noise by the threshold
+ * and if it is a local maximum (not below its range and Doppler neighbours):
+ * an extended target gives one detection per peak.
+ *
+ * Detection list (cfar_encode), little endian, CFAR_DETECTION_SIZE bytes per detection:
+ *
+ * | Offset | Size | Field                                                  |
+ * |--------|------|--------------------------------------------------------|
+ * | 0      | 2    | Range bin                                              |
+ * | 2      | 2    | Doppler bin (int16_t, 0: zero velocity)                |
+ * | 4      | 2    | SNR: magnitude over noise in dB (8.8 fixed point)      |
+ *
+ * This file and cfar.c only depend on the C standard library:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef DSP_CFAR_H_
+#define DSP_CFAR_H_
+
+#include <stdint.h>
+
+/**
+ * @def CFAR_ENGINE_SCALAR
+ * Portable implementation
+ */
+#define CFAR_ENGINE_SCALAR			0
+
+/**
+ * @def CFAR_ENGINE_MVE
+ * Sums of the training cells (CA-CFAR) with Helium, 4 Doppler bins per iteration
+ * Only available if the compiler targets a core with MVE (Cortex-M55)
+ */
+#define CFAR_ENGINE_MVE				1
+
+/**
+ * @def CFAR_ENGINE
+ * Engine used by cfar_detect, selected at build time
+ * Both engines give the same detections
+ */
+#ifndef CFAR_ENGINE
+#if defined(__ARM_FEATURE_MVE)
+#define CFAR_ENGINE					CFAR_ENGINE_MVE
+#else
+#define CFAR_ENGINE					CFAR_ENGINE_SCALAR
+#endif
+#endif
+
+/**
+ * @def CFAR_MAX_GUARD
+ * Maximum number of guard cells on each side of the cell under test
+ */
+#define CFAR_MAX_GUARD				8
+
+/**
+ * @def CFAR_MAX_TRAINING
+ * Maximum number of training cells on each side of the cell under test
+ */
+#define CFAR_MAX_TRAINING			16
+
+/**
+ * @def CFAR_MAX_THRESHOLD_DB
+ * Maximum threshold
+ */
+#define CFAR_MAX_THRESHOLD_DB		60
+
+/**
+ * @def CFAR_MAX_COLUMNS
+ * Maximum number of Doppler bins of a map
+ */
+#define CFAR_MAX_COLUMNS			512
+
+/**
+ * @def CFAR_DETECTION_SIZE
+ * Size of an encoded detection
+ */
+#define CFAR_DETECTION_SIZE			6
+
+/**
+ * Errors
+ */
+#define CFAR_ERROR_PARAM			-1	/**< Invalid configuration or dimensions */
+
+/**
+ * Noise estimation
+ */
+typedef enum
+{
+	CFAR_MODE_CA = 0,				/**< Cell averaging */
+	CFAR_MODE_OS = 1,				/**< Ordered statistic */
+} cfar_mode_t;
+
+/**
+ * Configuration of the detector
+ */
+typedef struct
+{
+	uint8_t mode;					/**< cfar_mode_t */
+	uint8_t guard;					/**< Guard cells on each side (0 to CFAR_MAX_GUARD) */
+	uint8_t training;				/**< Training cells on each side (1 to CFAR_MAX_TRAINING) */
+	uint8_t threshold_db;			/**< Magnitude over noise of a detection (0 to CFAR_MAX_THRESHOLD_DB) */
+	uint8_t rank;					/**< OS-CFAR: rank of the noise in the sorted training cells (1: smallest),
+										 0: 3/4 of the training cells */
+} cfar_config_t;
+
+/**
+ * Detector
+ */
+typedef struct
+{
+	cfar_config_t config;
+	uint32_t threshold;				/**< Threshold as a factor of the noise (8.8 fixed point) */
+} cfar_t;
+
+/**
+ * Detection
+ */
+typedef struct
+{
+	uint16_t range_bin;
+	int16_t doppler_bin;			/**< 0: zero velocity */
+	uint16_t snr;					/**< dB, 8.8 fixed point */
+} cfar_detection_t;
+
+/**
+ * @brief Configure the detector
+ *
+ * @param [out] cfar Detector
+ * @param [in] config Configuration
+ *
+ * @retval 0 Success
+ * @retval CFAR_ERROR_PARAM Invalid configuration
+ */
+int cfar_init(cfar_t* cfar, const cfar_config_t* config);
+
+/**
+ * @brief Detect the targets of a map
+ *
+ * @param [in] cfar Detector
+ * @param [in] map Magnitudes, one row of columns Doppler bins per range bin
+ * @param [in] rows Range bins
+ * @param [in] columns Doppler bins (centered, see range_doppler.h), 1 for a range profile (at most CFAR_MAX_COLUMNS)
+ * @param [out] detections Detections, by increasing range bin then Doppler bin
+ * @param [in] max_detections Size of detections: the next detections are dropped
+ *
+ * @retval Number of detections
+ * @retval CFAR_ERROR_PARAM Invalid dimensions
+ */
+int32_t cfar_detect(const cfar_t* cfar, const uint16_t* map, uint16_t rows, uint16_t columns,
+		cfar_detection_t* detections, uint32_t max_detections);
+
+/**
+ * @brief Encode detections (see the table above)
+ *
+ * @param [in] detections Detections
+ * @param [in] count Number of detections
+ * @param [out] output Encoded detections (count * CFAR_DETECTION_SIZE bytes)
+ *
+ * @retval Size of the encoded detections
+ */
+uint32_t cfar_encode(const cfar_detection_t* detections, uint32_t count, uint8_t* output);
+
+#endif /* DSP_CFAR_H_ */
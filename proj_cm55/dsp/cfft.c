@@ -0,0 +1,162 @@
+/*
+ * cfft.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "cfft.h"
+
+#include <math.h>
+
+#if (CFFT_ENGINE == CFFT_ENGINE_MVE)
+#if !defined(__ARM_FEATURE_MVE) || !(__ARM_FEATURE_MVE & 2)
+#error "CFFT_ENGINE_MVE requires a core supporting Helium floating point (MVE-F)"
+#endif
+#include <arm_mve.h>
+#elif (CFFT_ENGINE != CFFT_ENGINE_SCALAR)
+#error "Unknown CFFT_ENGINE"
+#endif
+
+#define CFFT_PI		3.14159265358979323846
+
+int cfft_init(cfft_t* fft, uint16_t size)
+{
+	uint32_t bits = 0;
+
+	if ((size < CFFT_MIN_SIZE) || (size > CFFT_MAX_SIZE) || ((size & (size - 1u)) != 0))
+	{
+		return CFFT_ERROR_PARAM;
+	}
+
+	fft->size = size;
+
+	for (uint32_t h = 1; h < size; h *= 2u)
+	{
+		for (uint32_t j = 0; j < h; ++j)
+		{
+			fft->twiddle_re[h - 1u + j] = (float)cos((-CFFT_PI * j) / h);
+			fft->twiddle_im[h - 1u + j] = (float)sin((-CFFT_PI * j) / h);
+		}
+	}
+
+	while ((1u << bits) < size)
+	{
+		bits++;
+	}
+	for (uint32_t n = 0; n < size; ++n)
+	{
+		uint32_t reversed = 0;
+
+		for (uint32_t b = 0; b < bits; ++b)
+		{
+			reversed |= ((n >> b) & 1u) << (bits - 1u - b);
+		}
+		fft->bit_reverse[n] = (uint16_t)reversed;
+	}
+
+	return 0;
+}
+
+#if (CFFT_ENGINE == CFFT_ENGINE_SCALAR)
+/**
+ * @brief Butterflies of a stage with a half size of at least 4
+ */
+static void _cfft_stage(const cfft_t* fft, float* re, float* im, uint32_t h)
+{
+	const float* twiddle_re = &fft->twiddle_re[h - 1u];
+	const float* twiddle_im = &fft->twiddle_im[h - 1u];
+
+	for (uint32_t group = 0; group < fft->size; group += 2u * h)
+	{
+		float* a_re = &re[group];
+		float* a_im = &im[group];
+		float* b_re = &re[group + h];
+		float* b_im = &im[group + h];
+
+		for (uint32_t j = 0; j < h; ++j)
+		{
+			float t_re = (twiddle_re[j] * b_re[j]) - (twiddle_im[j] * b_im[j]);
+			float t_im = (twiddle_re[j] * b_im[j]) + (twiddle_im[j] * b_re[j]);
+
+			b_re[j] = a_re[j] - t_re;
+			b_im[j] = a_im[j] - t_im;
+			a_re[j] = a_re[j] + t_re;
+			a_im[j] = a_im[j] + t_im;
+		}
+	}
+}
+#endif
+
+#if (CFFT_ENGINE == CFFT_ENGINE_MVE)
+static void _cfft_stage(const cfft_t* fft, float* re, float* im, uint32_t h)
+{
+	const float* twiddle_re = &fft->twiddle_re[h - 1u];
+	const float* twiddle_im = &fft->twiddle_im[h - 1u];
+
+	for (uint32_t group = 0; group < fft->size; group += 2u * h)
+	{
+		float* a_re = &re[group];
+		float* a_im = &im[group];
+		float* b_re = &re[group + h];
+		float* b_im = &im[group + h];
+
+		for (uint32_t j = 0; j < h; j += 4u)
+		{
+			float32x4_t w_re = vld1q_f32(&twiddle_re[j]);
+			float32x4_t w_im = vld1q_f32(&twiddle_im[j]);
+			float32x4_t x_re = vld1q_f32(&b_re[j]);
+			float32x4_t x_im = vld1q_f32(&b_im[j]);
+			float32x4_t y_re = vld1q_f32(&a_re[j]);
+			float32x4_t y_im = vld1q_f32(&a_im[j]);
+			float32x4_t t_re = vsubq_f32(vmulq_f32(w_re, x_re), vmulq_f32(w_im, x_im));
+			float32x4_t t_im = vaddq_f32(vmulq_f32(w_re, x_im), vmulq_f32(w_im, x_re));
+
+			vst1q_f32(&b_re[j], vsubq_f32(y_re, t_re));
+			vst1q_f32(&b_im[j], vsubq_f32(y_im, t_im));
+			vst1q_f32(&a_re[j], vaddq_f32(y_re, t_re));
+			vst1q_f32(&a_im[j], vaddq_f32(y_im, t_im));
+		}
+	}
+}
+#endif
+
+void cfft_process(const cfft_t* fft, float* re, float* im)
+{
+	// Stages of half size 1 and 2 together (twiddles 1 and -i)
+	for (uint32_t n = 0; n < fft->size; n += 4u)
+	{
+		float* r = &re[n];
+		float* i = &im[n];
+		float a_re = r[0] + r[1];
+		float a_im = i[0] + i[1];
+		float b_re = r[0] - r[1];
+		float b_im = i[0] - i[1];
+		float c_re = r[2] + r[3];
+		float c_im = i[2] + i[3];
+		float d_re = r[2] - r[3];
+		float d_im = i[2] - i[3];
+
+		r[0] = a_re + c_re;
+		i[0] = a_im + c_im;
+		r[2] = a_re - c_re;
+		i[2] = a_im - c_im;
+		// -i * d
+		r[1] = b_re + d_im;
+		i[1] = b_im - d_re;
+		r[3] = b_re - d_im;
+		i[3] = b_im + d_re;
+	}
+
+	for (uint32_t h = 4; h < fft->size; h *= 2u)
+	{
+		_cfft_stage(fft, re, im, h);
+	}
+}
@@ -0,0 +1,105 @@
+/*
+ * cfft.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Radix 2 complex FFT (decimation in time) in single precision, in place.
+ * The real and imaginary parts are in separate arrays so that the butterflies
+ * of a stage are done 4 at a time with Helium.
+ *
+ * The input is expected in bit reversed order (bit_reverse table): the callers
+ * reorder the data while they prepare it (window, corner turn...) instead of
+ * running a separate pass.
+ *
+ * This file and cfft.c only depend on the C standard library:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef DSP_CFFT_H_
+#define DSP_CFFT_H_
+
+#include <stdint.h>
+
+/**
+ * @def CFFT_ENGINE_SCALAR
+ * Portable implementation
+ */
+#define CFFT_ENGINE_SCALAR		0
+
+/**
+ * @def CFFT_ENGINE_MVE
+ * Butterflies with Helium (MVE floating point), 4 butterflies per iteration
+ * Only available if the compiler targets a core with MVE-F (Cortex-M55 with FPU)
+ */
+#define CFFT_ENGINE_MVE			1
+
+/**
+ * @def CFFT_ENGINE
+ * Engine used by cfft_process, selected at build time
+ * Both engines give the same results (same operations in the same order)
+ */
+#ifndef CFFT_ENGINE
+#if defined(__ARM_FEATURE_MVE) && (__ARM_FEATURE_MVE & 2)
+#define CFFT_ENGINE				CFFT_ENGINE_MVE
+#else
+#define CFFT_ENGINE				CFFT_ENGINE_SCALAR
+#endif
+#endif
+
+/**
+ * @def CFFT_MIN_SIZE
+ * Minimum number of points
+ */
+#define CFFT_MIN_SIZE			4
+
+/**
+ * @def CFFT_MAX_SIZE
+ * Maximum number of points (size of the tables)
+ */
+#define CFFT_MAX_SIZE			512
+
+/**
+ * Errors
+ */
+#define CFFT_ERROR_PARAM		-1	/**< Size not a power of 2 or out of range */
+
+/**
+ * Tables for a given number of points
+ */
+typedef struct
+{
+	uint16_t size;								/**< Number of points */
+	float twiddle_re[CFFT_MAX_SIZE];			/**< Stage of half size h: exp(-i pi j / h), j < h, at index h - 1 */
+	float twiddle_im[CFFT_MAX_SIZE];
+	uint16_t bit_reverse[CFFT_MAX_SIZE];		/**< Position of the input n in the bit reversed order */
+} cfft_t;
+
+/**
+ * @brief Prepare the tables
+ *
+ * @param [out] fft Complex FFT
+ * @param [in] size Number of points (power of 2, CFFT_MIN_SIZE to CFFT_MAX_SIZE)
+ *
+ * @retval 0 Success
+ * @retval CFFT_ERROR_PARAM Invalid size
+ */
+int cfft_init(cfft_t* fft, uint16_t size);
+
+/**
+ * @brief Compute the FFT in place (no scaling)
+ *
+ * @param [in] fft Complex FFT
+ * @param [in,out] re Real parts: input n at re[bit_reverse[n]], bin k at re[k]
+ * @param [in,out] im Imaginary parts, same order as re
+ */
+void cfft_process(const cfft_t* fft, float* re, float* im);
+
+#endif /* DSP_CFFT_H_ */
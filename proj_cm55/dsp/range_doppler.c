@@ -0,0 +1,131 @@
+/*
+ * range_doppler.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "range_doppler.h"
+
+#include <math.h>
+
+#if (RANGE_DOPPLER_ENGINE == RANGE_DOPPLER_ENGINE_MVE)
+#if !defined(__ARM_FEATURE_MVE) || !(__ARM_FEATURE_MVE & 2)
+#error "RANGE_DOPPLER_ENGINE_MVE requires a core supporting Helium floating point (MVE-F)"
+#endif
+#include <arm_mve.h>
+#elif (RANGE_DOPPLER_ENGINE != RANGE_DOPPLER_ENGINE_SCALAR)
+#error "Unknown RANGE_DOPPLER_ENGINE"
+#endif
+
+#define RANGE_DOPPLER_PI	3.14159265358979323846
+
+int range_doppler_init(range_doppler_t* rd, uint16_t samples_per_chirp, uint16_t chirps)
+{
+	if ((range_fft_init(&rd->range, samples_per_chirp) != 0) || (cfft_init(&rd->doppler, chirps) != 0))
+	{
+		return RANGE_DOPPLER_ERROR_PARAM;
+	}
+
+	rd->chirps = chirps;
+
+	// Periodic Hann window
+	for (uint32_t c = 0; c < chirps; ++c)
+	{
+		rd->window[c] = (float)(0.5 - (0.5 * cos((2.0 * RANGE_DOPPLER_PI * c) / chirps)));
+	}
+
+	return 0;
+}
+
+uint32_t range_doppler_work_size(const range_doppler_t* rd)
+{
+	return (uint32_t)rd->range.bins * rd->chirps * 2u * sizeof(float);
+}
+
+uint32_t range_doppler_map_size(const range_doppler_t* rd)
+{
+	return (uint32_t)rd->range.bins * rd->chirps * sizeof(uint16_t);
+}
+
+#if (RANGE_DOPPLER_ENGINE == RANGE_DOPPLER_ENGINE_SCALAR)
+/**
+ * @brief Write the windowed range bins of the last chirp in a column of the work matrix
+ */
+static void _range_doppler_corner_turn(range_doppler_t* rd, float* re, float* im, uint32_t column, float weight)
+{
+	const uint32_t stride = rd->chirps;
+
+	for (uint32_t k = 0; k < rd->range.bins; ++k)
+	{
+		re[(k * stride) + column] = rd->range.re[k] * weight;
+		im[(k * stride) + column] = rd->range.im[k] * weight;
+	}
+}
+#endif
+
+#if (RANGE_DOPPLER_ENGINE == RANGE_DOPPLER_ENGINE_MVE)
+static void _range_doppler_corner_turn(range_doppler_t* rd, float* re, float* im, uint32_t column, float weight)
+{
+	const uint32_t stride = rd->chirps;
+	// Offsets (in floats) of 4 consecutive rows
+	uint32x4_t offsets = vmulq_n_u32(vidupq_n_u32(0, 1), stride);
+
+	// range.bins is a multiple of 4
+	for (uint32_t k = 0; k < rd->range.bins; k += 4u)
+	{
+		vstrwq_scatter_shifted_offset_f32(&re[column], offsets, vmulq_n_f32(vld1q_f32(&rd->range.re[k]), weight));
+		vstrwq_scatter_shifted_offset_f32(&im[column], offsets, vmulq_n_f32(vld1q_f32(&rd->range.im[k]), weight));
+		offsets = vaddq_n_u32(offsets, 4u * stride);
+	}
+}
+#endif
+
+int32_t range_doppler_process(range_doppler_t* rd, const uint16_t* samples, float* work, uint32_t work_size,
+		uint16_t* map, uint32_t map_size)
+{
+	const uint32_t chirps = rd->chirps;
+	const uint32_t bins = rd->range.bins;
+	const float scale = 32.0f / ((float)rd->range.size * chirps);
+	float* re = work;
+	float* im = &work[bins * chirps];
+
+	if ((work_size < range_doppler_work_size(rd)) || (map_size < range_doppler_map_size(rd)))
+	{
+		return RANGE_DOPPLER_ERROR_OVERFLOW;
+	}
+
+	// Range FFT and corner turn: chirp c goes to the column of the Doppler FFT input c
+	for (uint32_t c = 0; c < chirps; ++c)
+	{
+		range_fft_chirp(&rd->range, &samples[c * rd->range.size]);
+		_range_doppler_corner_turn(rd, re, im, rd->doppler.bit_reverse[c], rd->window[c]);
+	}
+
+	// The samples have been read: the map can be written over them
+	for (uint32_t k = 0; k < bins; ++k)
+	{
+		float* row_re = &re[k * chirps];
+		float* row_im = &im[k * chirps];
+
+		cfft_process(&rd->doppler, row_re, row_im);
+
+		for (uint32_t d = 0; d < chirps; ++d)
+		{
+			// Centered: negative velocities first
+			uint32_t bin = (d + (chirps / 2u)) & (chirps - 1u);
+			float magnitude = scale * sqrtf((row_re[bin] * row_re[bin]) + (row_im[bin] * row_im[bin]));
+
+			map[(k * chirps) + d] = (magnitude >= 65535.0f) ? UINT16_MAX : (uint16_t)lrintf(magnitude);
+		}
+	}
+
+	return (int32_t)range_doppler_map_size(rd);
+}
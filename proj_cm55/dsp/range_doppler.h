@@ -0,0 +1,138 @@
+/*
+ * range_doppler.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Range-Doppler map of a radar frame (chirps of N samples, one antenna):
+ * 1. Range FFT of each chirp (range_fft.h): N / 2 range bins
+ * 2. Corner turn: the bins of a chirp are written in a column of the work
+ *    matrix (one row per range bin), multiplied by the Hann window of the
+ *    chirps and in the bit reversed order of the Doppler FFT. The samples
+ *    are read once and there is no separate transposition pass.
+ * 3. Doppler FFT of each row (cfft.h), in place in the work matrix
+ * 4. Magnitude, scaled by 32 / (N * chirps) and saturated to uint16_t
+ *    (a full scale sine of a 12 bits ADC at a constant velocity gives 8192)
+ *
+ * Map layout: one row of chirps Doppler bins per range bin. The Doppler bins
+ * are centered: index chirps / 2 is the zero velocity, index 0 is -chirps / 2.
+ *
+ * The work matrix holds N / 2 * chirps complex floats (the real parts then the
+ * imaginary parts), i.e. twice the size of the samples. The map is half the
+ * size of the samples and can be written over them.
+ *
+ * This file and range_doppler.c only depend on the C standard library:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef DSP_RANGE_DOPPLER_H_
+#define DSP_RANGE_DOPPLER_H_
+
+#include <stdint.h>
+
+#include "cfft.h"
+#include "range_fft.h"
+
+/**
+ * @def RANGE_DOPPLER_ENGINE_SCALAR
+ * Portable implementation
+ */
+#define RANGE_DOPPLER_ENGINE_SCALAR		0
+
+/**
+ * @def RANGE_DOPPLER_ENGINE_MVE
+ * Corner turn with Helium scatter stores (MVE floating point), 4 range bins per iteration
+ * Only available if the compiler targets a core with MVE-F (Cortex-M55 with FPU)
+ */
+#define RANGE_DOPPLER_ENGINE_MVE		1
+
+/**
+ * @def RANGE_DOPPLER_ENGINE
+ * Engine used by range_doppler_process, selected at build time
+ * Both engines produce the same map
+ */
+#ifndef RANGE_DOPPLER_ENGINE
+#if defined(__ARM_FEATURE_MVE) && (__ARM_FEATURE_MVE & 2)
+#define RANGE_DOPPLER_ENGINE			RANGE_DOPPLER_ENGINE_MVE
+#else
+#define RANGE_DOPPLER_ENGINE			RANGE_DOPPLER_ENGINE_SCALAR
+#endif
+#endif
+
+/**
+ * @def RANGE_DOPPLER_MAX_CHIRPS
+ * Maximum number of chirps per frame
+ */
+#define RANGE_DOPPLER_MAX_CHIRPS		CFFT_MAX_SIZE
+
+/**
+ * Errors
+ */
+#define RANGE_DOPPLER_ERROR_PARAM		-1	/**< Size or number of chirps not a power of 2 or out of range */
+#define RANGE_DOPPLER_ERROR_OVERFLOW	-2	/**< Work or map buffer too small */
+
+/**
+ * Tables and work buffers of the range and Doppler FFTs
+ */
+typedef struct
+{
+	range_fft_t range;								/**< Range FFT (can be used alone) */
+	cfft_t doppler;									/**< Doppler FFT */
+	uint16_t chirps;								/**< Chirps per frame */
+	float window[RANGE_DOPPLER_MAX_CHIRPS];			/**< Hann window of the chirps */
+} range_doppler_t;
+
+/**
+ * @brief Prepare the tables
+ *
+ * @param [out] rd Range-Doppler processing
+ * @param [in] samples_per_chirp Samples per chirp (see range_fft_init)
+ * @param [in] chirps Chirps per frame (power of 2, CFFT_MIN_SIZE to RANGE_DOPPLER_MAX_CHIRPS)
+ *
+ * @retval 0 Success
+ * @retval RANGE_DOPPLER_ERROR_PARAM Invalid size or number of chirps
+ */
+int range_doppler_init(range_doppler_t* rd, uint16_t samples_per_chirp, uint16_t chirps);
+
+/**
+ * @brief Size of the work matrix
+ *
+ * @param [in] rd Range-Doppler processing
+ *
+ * @retval Size in bytes
+ */
+uint32_t range_doppler_work_size(const range_doppler_t* rd);
+
+/**
+ * @brief Size of a map
+ *
+ * @param [in] rd Range-Doppler processing
+ *
+ * @retval Size in bytes
+ */
+uint32_t range_doppler_map_size(const range_doppler_t* rd);
+
+/**
+ * @brief Compute the range-Doppler map of a frame
+ *
+ * @param [in,out] rd Range-Doppler processing (the work buffers are modified)
+ * @param [in] samples ADC samples, chirp after chirp
+ * @param [out] work Work matrix (4-byte aligned)
+ * @param [in] work_size Size of the work matrix
+ * @param [out] map Map, can be the samples buffer
+ * @param [in] map_size Size of the map buffer
+ *
+ * @retval Size of the map
+ * @retval RANGE_DOPPLER_ERROR_OVERFLOW Buffer too small
+ */
+int32_t range_doppler_process(range_doppler_t* rd, const uint16_t* samples, float* work, uint32_t work_size,
+		uint16_t* map, uint32_t map_size);
+
+#endif /* DSP_RANGE_DOPPLER_H_ */
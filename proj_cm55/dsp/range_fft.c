@@ -0,0 +1,225 @@
+/*
+ * range_fft.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "range_fft.h"
+
+#include <math.h>
+
+#if (RANGE_FFT_ENGINE == RANGE_FFT_ENGINE_MVE)
+#if !defined(__ARM_FEATURE_MVE) || !(__ARM_FEATURE_MVE & 2)
+#error "RANGE_FFT_ENGINE_MVE requires a core supporting Helium floating point (MVE-F)"
+#endif
+#include <arm_mve.h>
+#elif (RANGE_FFT_ENGINE != RANGE_FFT_ENGINE_SCALAR)
+#error "Unknown RANGE_FFT_ENGINE"
+#endif
+
+#define RANGE_FFT_PI	3.14159265358979323846
+
+int range_fft_init(range_fft_t* fft, uint16_t size)
+{
+	uint32_t half = size / 2u;
+
+	if ((size < RANGE_FFT_MIN_SIZE) || (size > RANGE_FFT_MAX_SIZE) || ((size & (size - 1u)) != 0))
+	{
+		return RANGE_FFT_ERROR_PARAM;
+	}
+
+	fft->size = size;
+	fft->bins = (uint16_t)half;
+
+	// Periodic Hann window
+	for (uint32_t n = 0; n < size; ++n)
+	{
+		fft->window[n] = (float)(0.5 - (0.5 * cos((2.0 * RANGE_FFT_PI * n) / size)));
+	}
+
+	for (uint32_t k = 0; k < half; ++k)
+	{
+		fft->split_re[k] = (float)cos((-2.0 * RANGE_FFT_PI * k) / size);
+		fft->split_im[k] = (float)sin((-2.0 * RANGE_FFT_PI * k) / size);
+	}
+
+	return (cfft_init(&fft->cfft, (uint16_t)half) == 0) ? 0 : RANGE_FFT_ERROR_PARAM;
+}
+
+uint32_t range_fft_chirp_size(const range_fft_t* fft, range_fft_output_t output)
+{
+	switch (output)
+	{
+		case RANGE_FFT_OUTPUT_MAG_U16:
+			return fft->bins * sizeof(uint16_t);
+		case RANGE_FFT_OUTPUT_MAG_F32:
+			return fft->bins * sizeof(float);
+		case RANGE_FFT_OUTPUT_COMPLEX_I16:
+			return fft->bins * 2u * sizeof(int16_t);
+		case RANGE_FFT_OUTPUT_COMPLEX_F32:
+			return fft->bins * 2u * sizeof(float);
+		default:
+			return 0;
+	}
+}
+
+#if (RANGE_FFT_ENGINE == RANGE_FFT_ENGINE_SCALAR)
+/**
+ * @brief Remove the mean of the chirp and apply the window
+ */
+static void _range_fft_window(range_fft_t* fft, const uint16_t* samples, float mean)
+{
+	for (uint32_t n = 0; n < fft->size; ++n)
+	{
+		fft->samples[n] = ((float)samples[n] - mean) * fft->window[n];
+	}
+}
+#endif
+
+#if (RANGE_FFT_ENGINE == RANGE_FFT_ENGINE_MVE)
+static void _range_fft_window(range_fft_t* fft, const uint16_t* samples, float mean)
+{
+	for (uint32_t n = 0; n < fft->size; n += 4u)
+	{
+		float32x4_t x = vcvtq_f32_u32(vldrhq_u32(&samples[n]));
+
+		vst1q_f32(&fft->samples[n], vmulq_f32(vsubq_n_f32(x, mean), vld1q_f32(&fft->window[n])));
+	}
+}
+#endif
+
+void range_fft_chirp(range_fft_t* fft, const uint16_t* samples)
+{
+	const uint32_t half = fft->bins;
+	const uint16_t* bit_reverse = fft->cfft.bit_reverse;
+	uint32_t sum = 0;
+
+	for (uint32_t n = 0; n < fft->size; ++n)
+	{
+		sum += samples[n];
+	}
+	_range_fft_window(fft, samples, (float)sum / fft->size);
+
+	// Complex FFT of the N / 2 points (even samples: real part, odd samples: imaginary part)
+	// in bit reversed order, then split in the N / 2 first bins of the real FFT
+	for (uint32_t n = 0; n < half; ++n)
+	{
+		fft->re[bit_reverse[n]] = fft->samples[2u * n];
+		fft->im[bit_reverse[n]] = fft->samples[(2u * n) + 1u];
+	}
+
+	cfft_process(&fft->cfft, fft->re, fft->im);
+
+	// X[k] = (Z[k] + conj(Z[M - k])) / 2 - i W^k (Z[k] - conj(Z[M - k])) / 2
+	// Pairs k, M - k computed together (in place)
+	for (uint32_t k = 0; k <= (half / 2u); ++k)
+	{
+		uint32_t m = (half - k) & (half - 1u);
+		float z_re = fft->re[k];
+		float z_im = fft->im[k];
+		float y_re = fft->re[m];
+		float y_im = fft->im[m];
+
+		// Bin k
+		float e_re = 0.5f * (z_re + y_re);
+		float e_im = 0.5f * (z_im - y_im);
+		float o_re = 0.5f * (z_im + y_im);
+		float o_im = -0.5f * (z_re - y_re);
+		float x_re = e_re + ((fft->split_re[k] * o_re) - (fft->split_im[k] * o_im));
+		float x_im = e_im + ((fft->split_re[k] * o_im) + (fft->split_im[k] * o_re));
+
+		if ((m != k) && (k != 0))
+		{
+			// Bin M - k: same terms with the roles of Z[k] and Z[M - k] swapped
+			float f_re = e_re;
+			float f_im = -e_im;
+			float p_re = o_re;
+			float p_im = -o_im;
+
+			fft->re[m] = f_re + ((fft->split_re[m] * p_re) - (fft->split_im[m] * p_im));
+			fft->im[m] = f_im + ((fft->split_re[m] * p_im) + (fft->split_im[m] * p_re));
+		}
+
+		fft->re[k] = x_re;
+		fft->im[k] = x_im;
+	}
+}
+
+static int16_t _range_fft_saturate_i16(float value)
+{
+	if (value >= 32767.0f)
+	{
+		return INT16_MAX;
+	}
+	if (value <= -32768.0f)
+	{
+		return INT16_MIN;
+	}
+
+	return (int16_t)lrintf(value);
+}
+
+static uint16_t _range_fft_saturate_u16(float value)
+{
+	if (value >= 65535.0f)
+	{
+		return UINT16_MAX;
+	}
+
+	return (uint16_t)lrintf(value);
+}
+
+int32_t range_fft_process(range_fft_t* fft, const uint16_t* samples, uint32_t chirps,
+		range_fft_output_t output, void* bins, uint32_t bins_size)
+{
+	const uint32_t chirp_size = range_fft_chirp_size(fft, output);
+	const float scale = 16.0f / fft->size;
+
+	if (chirp_size == 0)
+	{
+		return RANGE_FFT_ERROR_PARAM;
+	}
+	if ((chirp_size * chirps) > bins_size)
+	{
+		return RANGE_FFT_ERROR_OVERFLOW;
+	}
+
+	for (uint32_t chirp = 0; chirp < chirps; ++chirp)
+	{
+		range_fft_chirp(fft, &samples[chirp * fft->size]);
+
+		for (uint32_t k = 0; k < fft->bins; ++k)
+		{
+			uint32_t index = (chirp * fft->bins) + k;
+
+			switch (output)
+			{
+				case RANGE_FFT_OUTPUT_MAG_U16:
+					((uint16_t*)bins)[index] = _range_fft_saturate_u16(
+							scale * sqrtf((fft->re[k] * fft->re[k]) + (fft->im[k] * fft->im[k])));
+					break;
+				case RANGE_FFT_OUTPUT_MAG_F32:
+					((float*)bins)[index] = sqrtf((fft->re[k] * fft->re[k]) + (fft->im[k] * fft->im[k]));
+					break;
+				case RANGE_FFT_OUTPUT_COMPLEX_I16:
+					((int16_t*)bins)[2u * index] = _range_fft_saturate_i16(scale * fft->re[k]);
+					((int16_t*)bins)[(2u * index) + 1u] = _range_fft_saturate_i16(scale * fft->im[k]);
+					break;
+				default:
+					((float*)bins)[2u * index] = fft->re[k];
+					((float*)bins)[(2u * index) + 1u] = fft->im[k];
+					break;
+			}
+		}
+	}
+
+	return (int32_t)(chirp_size * chirps);
+}
@@ -0,0 +1,152 @@
+/*
+ * range_fft.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Range processing of the radar chirps: removal of the DC offset, Hann window
+ * and real FFT of each chirp. A chirp of N samples gives N / 2 range bins
+ * (bin k: beat frequency k * sample rate / N).
+ *
+ * The bins are computed in single precision floating point and written in one
+ * of the range_fft_output_t formats. The integer formats are scaled by 16 / N
+ * (a full scale sine of a 12 bits ADC stays below 16384).
+ *
+ * This file and range_fft.c only depend on the C standard library:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef DSP_RANGE_FFT_H_
+#define DSP_RANGE_FFT_H_
+
+#include <stdint.h>
+
+#include "cfft.h"
+
+/**
+ * @def RANGE_FFT_ENGINE_SCALAR
+ * Portable implementation
+ */
+#define RANGE_FFT_ENGINE_SCALAR		0
+
+/**
+ * @def RANGE_FFT_ENGINE_MVE
+ * Window with Helium (MVE floating point), 4 samples per instruction
+ * (the butterflies of the complex FFT follow CFFT_ENGINE)
+ * Only available if the compiler targets a core with MVE-F (Cortex-M55 with FPU)
+ */
+#define RANGE_FFT_ENGINE_MVE		1
+
+/**
+ * @def RANGE_FFT_ENGINE
+ * Engine used by range_fft_process, selected at build time
+ * Both engines give the same bins to the rounding of the floating point operations
+ */
+#ifndef RANGE_FFT_ENGINE
+#if defined(__ARM_FEATURE_MVE) && (__ARM_FEATURE_MVE & 2)
+#define RANGE_FFT_ENGINE			RANGE_FFT_ENGINE_MVE
+#else
+#define RANGE_FFT_ENGINE			RANGE_FFT_ENGINE_SCALAR
+#endif
+#endif
+
+/**
+ * @def RANGE_FFT_MIN_SIZE
+ * Minimum number of samples per chirp
+ */
+#define RANGE_FFT_MIN_SIZE			16
+
+/**
+ * @def RANGE_FFT_MAX_SIZE
+ * Maximum number of samples per chirp (size of the tables)
+ */
+#define RANGE_FFT_MAX_SIZE			(2 * CFFT_MAX_SIZE)
+
+/**
+ * Errors
+ */
+#define RANGE_FFT_ERROR_PARAM		-1	/**< Size not a power of 2 or out of range, unknown output */
+#define RANGE_FFT_ERROR_OVERFLOW	-2	/**< Output buffer too small */
+
+/**
+ * Format of the range bins
+ */
+typedef enum
+{
+	RANGE_FFT_OUTPUT_MAG_U16 = 0,		/**< Magnitude, uint16_t (scaled, saturated) */
+	RANGE_FFT_OUTPUT_MAG_F32 = 1,		/**< Magnitude, float */
+	RANGE_FFT_OUTPUT_COMPLEX_I16 = 2,	/**< Real and imaginary parts, int16_t (scaled, saturated) */
+	RANGE_FFT_OUTPUT_COMPLEX_F32 = 3,	/**< Real and imaginary parts, float */
+} range_fft_output_t;
+
+/**
+ * Tables and work buffers for a given number of samples per chirp
+ */
+typedef struct
+{
+	uint16_t size;									/**< Samples per chirp (N) */
+	uint16_t bins;									/**< Range bins per chirp (N / 2) */
+	float window[RANGE_FFT_MAX_SIZE];				/**< Hann window */
+	cfft_t cfft;									/**< Complex FFT of N / 2 points */
+	float split_re[RANGE_FFT_MAX_SIZE / 2];			/**< exp(-2 pi i k / N) of the real FFT */
+	float split_im[RANGE_FFT_MAX_SIZE / 2];
+	float samples[RANGE_FFT_MAX_SIZE];				/**< Windowed chirp */
+	float re[RANGE_FFT_MAX_SIZE / 2];				/**< Bins of the last chirp (range_fft_chirp) */
+	float im[RANGE_FFT_MAX_SIZE / 2];
+} range_fft_t;
+
+/**
+ * @brief Prepare the tables
+ *
+ * @param [out] fft Range processing
+ * @param [in] size Samples per chirp (power of 2, RANGE_FFT_MIN_SIZE to RANGE_FFT_MAX_SIZE)
+ *
+ * @retval 0 Success
+ * @retval RANGE_FFT_ERROR_PARAM Invalid size
+ */
+int range_fft_init(range_fft_t* fft, uint16_t size);
+
+/**
+ * @brief Size of the range bins of one chirp
+ *
+ * @param [in] fft Range processing
+ * @param [in] output Format of the bins
+ *
+ * @retval Size in bytes, 0 if the format is unknown
+ */
+uint32_t range_fft_chirp_size(const range_fft_t* fft, range_fft_output_t output);
+
+/**
+ * @brief Compute the range bins of a chirp in floating point (no scaling)
+ * The bins are left in fft->re and fft->im
+ *
+ * @param [in,out] fft Range processing
+ * @param [in] samples ADC samples of the chirp
+ */
+void range_fft_chirp(range_fft_t* fft, const uint16_t* samples);
+
+/**
+ * @brief Compute the range bins of chirps
+ *
+ * @param [in,out] fft Range processing (the work buffers are modified)
+ * @param [in] samples ADC samples, chirp after chirp
+ * @param [in] chirps Number of chirps
+ * @param [in] output Format of the bins
+ * @param [out] bins Range bins, chirp after chirp
+ * @param [in] bins_size Size of the bins buffer
+ *
+ * @retval Size of the bins written
+ * @retval RANGE_FFT_ERROR_PARAM Unknown format
+ * @retval RANGE_FFT_ERROR_OVERFLOW Buffer too small
+ */
+int32_t range_fft_process(range_fft_t* fft, const uint16_t* samples, uint32_t chirps,
+		range_fft_output_t output, void* bins, uint32_t bins_size);
+
+#endif /* DSP_RANGE_FFT_H_ */
@@ -0,0 +1,223 @@
+/*
+ * io_ring.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "io_ring.h"
+
+#include <string.h>
+
+#include "cybsp.h"
+#include "cy_pdl.h"
+#include "crc.h"
+
+#if (IO_RING_SIZE & (IO_RING_SIZE - 1)) != 0
+#error "IO_RING_SIZE must be a power of two"
+#endif
+
+/**
+ * Cycle counter at the last io_ring_tick (CM33)
+ */
+static uint32_t io_ring_last_cycles = 0;
+
+/**
+ * @brief Write the lines of the CM55 back to the memory
+ */
+static void _clean(const void* data, uint32_t size)
+{
+	#if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
+	SCB_CleanDCache_by_Addr((uint32_t*)data, (int32_t)size);
+	#else
+	(void)data;
+	(void)size;
+	#endif
+}
+
+/**
+ * @brief Drop the lines of the CM33 from the cache, the next reads get the memory
+ */
+static void _invalidate(const void* data, uint32_t size)
+{
+	#if defined (__DCACHE_PRESENT) && (__DCACHE_PRESENT != 0)
+	SCB_InvalidateDCache_by_Addr((uint32_t*)data, (int32_t)size);
+	#else
+	(void)data;
+	(void)size;
+	#endif
+}
+
+int io_ring_publish(io_ring_t* ring)
+{
+	IPC_STRUCT_Type* ipc = Cy_IPC_Drv_GetIpcBaseAddress(IO_RING_IPC_CHANNEL);
+
+	// The lock is kept: the address stays in the channel for the CM33
+	if (Cy_IPC_Drv_LockAcquire(ipc) != CY_IPC_DRV_SUCCESS)
+	{
+		return -1;
+	}
+
+	memset(ring, 0, sizeof(*ring));
+	ring->producer.magic = IO_RING_MAGIC;
+	_clean(ring, sizeof(*ring));
+	Cy_IPC_Drv_WriteDataValue(ipc, (uint32_t)(uintptr_t)ring);
+	__DSB();
+
+	return 0;
+}
+
+bool io_ring_ready(io_ring_t* ring)
+{
+	_invalidate(&ring->consumer, sizeof(ring->consumer));
+	return ((volatile uint32_t*)&ring->consumer.ready)[0] == IO_RING_MAGIC;
+}
+
+int io_ring_post(io_ring_t* ring, const void* data, uint32_t size)
+{
+	uint32_t head = ring->producer.head;
+	uint32_t slot = head & (IO_RING_SIZE - 1u);
+
+	if ((head - ring->producer.reaped) >= IO_RING_SIZE)
+	{
+		return -1;
+	}
+
+	_clean(data, size);
+	ring->producer.requests[slot].address = (uint32_t)(uintptr_t)data;
+	ring->producer.requests[slot].size = size;
+
+	// The request must be in memory before the CM33 sees the new head
+	_clean(&ring->producer.requests[slot], sizeof(ring->producer.requests[slot]));
+	__DMB();
+	((volatile uint32_t*)&ring->producer.head)[0] = head + 1u;
+	_clean(&ring->producer.head, sizeof(ring->producer.head));
+	__DSB();
+
+	// Wakes the CM33 up if it waits for an event
+	__SEV();
+
+	return (int)slot;
+}
+
+int io_ring_reap(io_ring_t* ring, io_ring_result_t* result)
+{
+	uint32_t reaped = ring->producer.reaped;
+	uint32_t slot = reaped & (IO_RING_SIZE - 1u);
+
+	if (reaped == ring->producer.head)
+	{
+		return IO_RING_EMPTY;
+	}
+
+	_invalidate(&ring->consumer, sizeof(ring->consumer));
+	if (((volatile uint32_t*)&ring->consumer.tail)[0] == reaped)
+	{
+		return IO_RING_PENDING;
+	}
+
+	// The result is read after the index
+	__DMB();
+	*result = ring->consumer.results[slot];
+	ring->producer.reaped = reaped + 1u;
+
+	return (int)slot;
+}
+
+int io_ring_cancel(io_ring_t* ring)
+{
+	uint32_t reaped = ring->producer.reaped;
+
+	if (reaped == ring->producer.head)
+	{
+		return IO_RING_EMPTY;
+	}
+
+	ring->producer.reaped = reaped + 1u;
+	return (int)(reaped & (IO_RING_SIZE - 1u));
+}
+
+void io_ring_get_stats(io_ring_t* ring, io_ring_stats_t* stats)
+{
+	if (!io_ring_ready(ring))
+	{
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+
+	*stats = ring->consumer.stats;
+}
+
+io_ring_t* io_ring_find(void)
+{
+	IPC_STRUCT_Type* ipc = Cy_IPC_Drv_GetIpcBaseAddress(IO_RING_IPC_CHANNEL);
+	io_ring_t* ring;
+
+	if (!Cy_IPC_Drv_IsLockAcquired(ipc))
+	{
+		return NULL;
+	}
+
+	ring = (io_ring_t*)(uintptr_t)Cy_IPC_Drv_ReadDataValue(ipc);
+	if ((ring == NULL) || (((volatile uint32_t*)&ring->producer.magic)[0] != IO_RING_MAGIC))
+	{
+		return NULL;
+	}
+
+	// The tail has been cleared by io_ring_publish, the CM55 posts once the ring is ready
+	memset(&ring->consumer.stats, 0, sizeof(ring->consumer.stats));
+	ring->consumer.stats.cycles_per_us = SystemCoreClock / 1000000u;
+	io_ring_last_cycles = DWT->CYCCNT;
+	__DMB();
+	ring->consumer.ready = IO_RING_MAGIC;
+
+	return ring;
+}
+
+int io_ring_serve(io_ring_t* ring)
+{
+	uint32_t tail = ring->consumer.tail;
+	uint32_t slot = tail & (IO_RING_SIZE - 1u);
+	uint32_t start;
+	io_ring_request_t request;
+	io_ring_result_t result;
+
+	if (((volatile uint32_t*)&ring->producer.head)[0] == tail)
+	{
+		return 0;
+	}
+
+	// The request is read after the index
+	__DMB();
+	request = ring->producer.requests[slot];
+
+	start = DWT->CYCCNT;
+	result.crc = crc32_compute((const uint8_t*)(uintptr_t)request.address, request.size);
+	result.cycles = DWT->CYCCNT - start;
+	ring->consumer.results[slot] = result;
+
+	ring->consumer.stats.requests++;
+	ring->consumer.stats.bytes += request.size;
+	ring->consumer.stats.busy_cycles += result.cycles;
+
+	// The result must be visible before the CM55 sees the new tail
+	__DMB();
+	((volatile uint32_t*)&ring->consumer.tail)[0] = tail + 1u;
+
+	return 1;
+}
+
+void io_ring_tick(io_ring_t* ring)
+{
+	uint32_t now = DWT->CYCCNT;
+
+	ring->consumer.stats.total_cycles += now - io_ring_last_cycles;
+	io_ring_last_cycles = now;
+}
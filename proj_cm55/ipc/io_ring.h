@@ -0,0 +1,210 @@
+/*
+ * io_ring.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Descriptor ring between the CM55 (producer) and the CM33 (I/O core, consumer):
+ * the CM55 posts the finished message buffers, the CM33 computes their CRC-32
+ * and returns it in the same order. The ring has a single producer and a
+ * single consumer and is lock-free: each side only writes its own index.
+ *
+ * The ring is in memory seen by both cores (.cy_sharedmem). Each core links
+ * its own image, so only the CM55 allocates the ring and publishes its address
+ * through an IPC channel (io_ring_publish / io_ring_find). The fields written
+ * by each core are in their own cache lines: the CM55 cleans its lines after
+ * writing and invalidates the lines of the CM33 before reading them.
+ * The buffers posted must be at addresses valid for both cores (e.g. SoCMEM),
+ * not in the TCM of the CM55.
+ *
+ * This file and io_ring.c are compiled in both projects (see the Makefile of proj_cm33_ns).
+ */
+
+#ifndef IPC_IO_RING_H_
+#define IPC_IO_RING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @def IO_RING_SIZE
+ * Requests in flight (power of two)
+ */
+#define IO_RING_SIZE				8
+
+/**
+ * @def IO_RING_IPC_CHANNEL
+ * IPC channel carrying the address of the ring (a channel free in the BSP, the lower ones are used by the system)
+ */
+#ifndef IO_RING_IPC_CHANNEL
+#define IO_RING_IPC_CHANNEL			8u
+#endif
+
+/**
+ * @def IO_RING_MAGIC
+ * Written by each side once its part of the ring is valid
+ */
+#define IO_RING_MAGIC				0x52494F31u
+
+/**
+ * Results of io_ring_reap
+ */
+#define IO_RING_PENDING				-1	/**< The oldest request is not done yet */
+#define IO_RING_EMPTY				-2	/**< No request in flight */
+
+/**
+ * Request of the CM55
+ */
+typedef struct
+{
+	uint32_t address;				/**< Buffer */
+	uint32_t size;					/**< Number of bytes */
+} io_ring_request_t;
+
+/**
+ * Result of the CM33
+ */
+typedef struct
+{
+	uint32_t crc;					/**< crc32_compute() of the buffer */
+	uint32_t cycles;				/**< CM33 cycles spent on the request */
+} io_ring_result_t;
+
+/**
+ * Statistics of the I/O core, since it started serving the ring
+ */
+typedef struct
+{
+	uint32_t requests;				/**< Requests done */
+	uint32_t bytes;					/**< Bytes of the requests done */
+	uint32_t busy_cycles;			/**< Cycles spent on the requests (wraps) */
+	uint32_t total_cycles;			/**< Cycles elapsed (wraps) */
+	uint32_t cycles_per_us;			/**< Clock of the I/O core */
+} io_ring_stats_t;
+
+/**
+ * Ring, each part is written by one core only
+ */
+typedef struct
+{
+	struct
+	{
+		uint32_t magic;				/**< IO_RING_MAGIC once initialized */
+		uint32_t head;				/**< Requests posted */
+		uint32_t reaped;			/**< Results read back (not read by the CM33) */
+		io_ring_request_t requests[IO_RING_SIZE];
+	} __attribute__((aligned(32))) producer;
+	struct
+	{
+		uint32_t ready;				/**< IO_RING_MAGIC while the CM33 serves the ring */
+		uint32_t tail;				/**< Requests done */
+		io_ring_stats_t stats;
+		io_ring_result_t results[IO_RING_SIZE];
+	} __attribute__((aligned(32))) consumer;
+} io_ring_t;
+
+/*
+ * CM55 (producer)
+ */
+
+/**
+ * @brief Initialize the ring and publish its address to the CM33
+ *
+ * @param [out] ring Ring (in .cy_sharedmem, aligned on 32 bytes)
+ *
+ * @retval 0 Success
+ * @retval -1 The IPC channel is used by another owner
+ */
+int io_ring_publish(io_ring_t* ring);
+
+/**
+ * @brief Check if the CM33 serves the ring
+ *
+ * @param [in] ring Ring
+ *
+ * @retval true The requests posted will be done
+ */
+bool io_ring_ready(io_ring_t* ring);
+
+/**
+ * @brief Post a request, the buffer must stay unchanged until its result is reaped
+ * The buffer is written back from the data cache
+ *
+ * @param [in,out] ring Ring
+ * @param [in] data Buffer
+ * @param [in] size Number of bytes
+ *
+ * @retval Slot of the request (0 to IO_RING_SIZE - 1)
+ * @retval -1 Ring full
+ */
+int io_ring_post(io_ring_t* ring, const void* data, uint32_t size);
+
+/**
+ * @brief Read the result of the oldest request
+ *
+ * @param [in,out] ring Ring
+ * @param [out] result Result of the request
+ *
+ * @retval Slot of the request done
+ * @retval IO_RING_PENDING The oldest request is not done yet
+ * @retval IO_RING_EMPTY No request in flight
+ */
+int io_ring_reap(io_ring_t* ring, io_ring_result_t* result);
+
+/**
+ * @brief Give up the oldest request (the CM33 stopped answering), its result is ignored
+ * The ring must not be used any more: the CM33 could still write the result
+ *
+ * @param [in,out] ring Ring
+ *
+ * @retval Slot of the request given up
+ * @retval IO_RING_EMPTY No request in flight
+ */
+int io_ring_cancel(io_ring_t* ring);
+
+/**
+ * @brief Get the statistics of the I/O core
+ *
+ * @param [in] ring Ring
+ * @param [out] stats Statistics (0 if the CM33 does not serve the ring)
+ */
+void io_ring_get_stats(io_ring_t* ring, io_ring_stats_t* stats);
+
+/*
+ * CM33 (consumer)
+ */
+
+/**
+ * @brief Get the ring published by the CM55, the caller then serves it
+ * The cycle counter must be running
+ *
+ * @retval Ring
+ * @retval NULL Not published yet
+ */
+io_ring_t* io_ring_find(void);
+
+/**
+ * @brief Do the oldest request waiting
+ *
+ * @param [in,out] ring Ring
+ *
+ * @retval 1 A request has been done
+ * @retval 0 No request waiting
+ */
+int io_ring_serve(io_ring_t* ring);
+
+/**
+ * @brief Count the cycles elapsed, busy or not (call at least once per wrap of the cycle counter)
+ *
+ * @param [in,out] ring Ring
+ */
+void io_ring_tick(io_ring_t* ring);
+
+#endif /* IPC_IO_RING_H_ */
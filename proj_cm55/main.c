@@ -52,67 +52,500 @@
 * any liability of Rutronik is insofar excluded
 *******************************************************************************/
 
-#include "cybsp.h"
-#include "cy_pdl.h"
+#include "app.h"
 
-#include <stdlib.h>
-#include <string.h>
+/**
+ * Streams of the scheduler
+ */
+int radar_stream = -1;
+int camera_stream = -1;
+int control_stream = -1;
 
-// Access to retarget-io initialization
-// used to have printf over KitProg3
-#include "driver/retarget_io/retarget_io_init.h"
+/**
+ * Set by the USB completion callbacks when a transfer failed
+ */
+int usb_tx_error = 0;
 
-// Driver of the OV7675 camera (over DVP for stream and I2C for configuration)
-#include "driver/ov7675/mtb_dvp_camera_ov7675.h"
+/**
+ * Latency of the USB transfers, submission to completion (us), filled by usb_transfer_event
+ */
+static telemetry_histogram_t usb_latency_us;
 
-// Driver for USBD support (using emUSB from Seeger)
-#include "driver/usbd/usbd.h"
+/**
+ * Sequence number of the replies to the host (control stream)
+ */
+uint32_t control_sequence = 0;
 
-// Driver for radar (BGT60TR13C)
-#include "driver/radar/radar.h"
+/**
+ * Counters of the streams (the ones of the drivers are copied by telemetry_update)
+ * and report sent to the host, busy until sent
+ */
+telemetry_report_t telemetry;
+static uint8_t telemetry_packet[TELEMETRY_REPORT_SIZE];
+static bool telemetry_busy = false;
+uint32_t telemetry_period_us = TELEMETRY_PERIOD_MS * 1000u;
+uint64_t telemetry_last_us = 0;
 
-#include "crc.h"
+/**
+ * Ring of the CRC requests to the CM33 and messages waiting for them, in submission order
+ */
+static io_ring_t io_ring __attribute__((section(IO_RING_SECTION), aligned(32))) __attribute((used));
+static bool io_offload = false;
+static io_offload_entry_t io_offload_queue[IO_OFFLOAD_QUEUE_SIZE];
+static uint32_t io_offload_first = 0;
+static uint32_t io_offload_count = 0;
+static io_offload_stats_t io_offload_stats;
+static io_ring_stats_t io_offload_last_stats;
 
 /**
- * @def COM_OVERHEAD
- * Size of the header packet (USB communication)
- * Used for synchronization and validation
+ * State of the main loop, shared by its stages (USB, commands, camera, radar)
  */
-#define COM_OVERHEAD	8
+static cy_stc_scb_i2c_context_t i2c_master_context;
+usbd_t* usb_handle = NULL;
+int send_data = 0;
+uint8_t command_rx[COMMAND_RX_SIZE];
 
+#if RTOS_ENABLED
 /**
- * @def COM_CMD_SIZE
- * Size of a command from computer to PSoC Edge
+ * Run time of the tasks when the stream started, and at the end (statistics)
  */
-#define COM_CMD_SIZE	1
+static TaskStatus_t rtos_start_status[RTOS_MAX_TASKS];
+static UBaseType_t rtos_start_count = 0;
+static configRUN_TIME_COUNTER_TYPE rtos_start_time = 0;
+static TaskStatus_t rtos_status[RTOS_MAX_TASKS];
+#else
+/**
+ * Load of the main loop since the stream started (cycles)
+ */
+static uint64_t loop_busy_cycles = 0;
+static uint64_t loop_total_cycles = 0;
+#endif
 
 /**
- * @def COM_CMD_START_STREAM
- * Command enabling to start the streaming of data
+ * @brief Prepare the header of a message (protocol v2)
+ * The size and fragment fields are set by the scheduler for each chunk
+ *
+ * @param [out] header Header of the message
+ * @param [in] stream Stream of the message (protocol_stream_t)
+ * @param [in] format Format of the payload (protocol_format_t)
+ * @param [in] sequence Sequence number of the message in its stream
+ * @param [in] timestamp_us Capture time
+ * @param [in] crc CRC-32 of the payload
  */
-#define COM_CMD_START_STREAM	49
+void fill_header(protocol_header_t* header, uint8_t stream, uint8_t format,
+		uint32_t sequence, uint64_t timestamp_us, uint32_t crc)
+{
+	memset(header, 0, sizeof(protocol_header_t));
+	header->stream = stream;
+	header->format = format;
+	header->sequence = sequence;
+	header->timestamp_us = timestamp_us;
+	header->message_crc = crc;
+}
 
-int main(void)
+/**
+ * @brief Send a message, its CRC computed by the CM33 if its payload is in shared memory
+ * The messages of a stream keep their order: a message behind a request of the CM33 waits in the queue
+ *
+ * @param [in] stream Stream of the message
+ * @param [in,out] message Message, its CRC is computed if compute_crc
+ * @param [in] shared The payload is at an address valid for the CM33
+ * @param [in] compute_crc false: the CRC of the message is already set
+ *
+ * @retval 0 Submitted or queued
+ * @retval -1 Failed (USB queue or offload queue full)
+ */
+int io_offload_submit(int stream, scheduler_message_t* message, bool shared, bool compute_crc)
+{
+	bool queued = false;
+	bool large = shared && compute_crc && (message->size >= IO_OFFLOAD_MIN_SIZE);
+	int slot = -1;
+	io_offload_entry_t* entry;
+
+	for (uint32_t i = 0; i < io_offload_count; ++i)
+	{
+		queued = queued || (io_offload_queue[(io_offload_first + i) % IO_OFFLOAD_QUEUE_SIZE].stream == stream);
+	}
+
+	if (large && io_offload && (io_offload_count < IO_OFFLOAD_QUEUE_SIZE) && io_ring_ready(&io_ring))
+	{
+		slot = io_ring_post(&io_ring, message->payload, message->size);
+	}
+	if ((slot < 0) && compute_crc)
+	{
+		TRACE_BEGIN(TRACE_STAGE_CRC, message->header.sequence);
+		message->header.message_crc = crc32_compute(message->payload, message->size);
+		TRACE_END(TRACE_STAGE_CRC);
+		if (large && io_offload)
+		{
+			io_offload_stats.local++;
+		}
+	}
+
+	if ((slot < 0) && !queued)
+	{
+		return scheduler_submit(stream, message);
+	}
+	if (io_offload_count >= IO_OFFLOAD_QUEUE_SIZE)
+	{
+		return -1;
+	}
+
+	entry = &io_offload_queue[(io_offload_first + io_offload_count) % IO_OFFLOAD_QUEUE_SIZE];
+	entry->message = *message;
+	entry->stream = stream;
+	entry->slot = slot;
+	entry->posted_us = timestamp_now_us();
+	io_offload_count++;
+
+	return 0;
+}
+
+/**
+ * @brief Submit the queued messages whose CRC is done, in order
+ * A request not done by the CM33 within IO_OFFLOAD_TIMEOUT_US stops the offload:
+ * the CRCs of the requests in flight are computed here
+ */
+static void io_offload_poll(void)
+{
+	while (io_offload_count != 0)
+	{
+		io_offload_entry_t* entry = &io_offload_queue[io_offload_first];
+		io_ring_result_t result;
+
+		// Retried once the stream has room
+		if (scheduler_free_slots(entry->stream) == 0)
+		{
+			return;
+		}
+
+		if (entry->slot >= 0)
+		{
+			uint32_t wait_us = (uint32_t)(timestamp_now_us() - entry->posted_us);
+			int slot = io_offload ? io_ring_reap(&io_ring, &result) : IO_RING_PENDING;
+
+			if (slot == IO_RING_PENDING)
+			{
+				if (io_offload && (wait_us < IO_OFFLOAD_TIMEOUT_US))
+				{
+					return;
+				}
+				if (io_offload)
+				{
+					printf("CM33 not answering, CRC computed by the CM55 \r\n");
+					io_offload = false;
+					io_offload_stats.timeouts++;
+				}
+				(void)io_ring_cancel(&io_ring);
+				TRACE_BEGIN(TRACE_STAGE_CRC, entry->message.header.sequence);
+				result.crc = crc32_compute(entry->message.payload, entry->message.size);
+				TRACE_END(TRACE_STAGE_CRC);
+			}
+			else
+			{
+				io_offload_stats.offloaded++;
+				io_offload_stats.bytes += entry->message.size;
+				telemetry_histogram_add(&io_offload_stats.latency, wait_us);
+			}
+			entry->message.header.message_crc = result.crc;
+		}
+
+		if ((scheduler_submit(entry->stream, &entry->message) != 0) && (entry->message.callback != NULL))
+		{
+			// Counted as dropped
+			entry->message.callback(entry->message.context, -1);
+		}
+		io_offload_first = (io_offload_first + 1u) % IO_OFFLOAD_QUEUE_SIZE;
+		io_offload_count--;
+	}
+}
+
+/**
+ * @brief Event callback of the USB driver: profiling probe (lock free, called by usbd_tx_poll)
+ * and latency of the transfers (called by usbd_tx_dispatch, with the state of the application)
+ *
+ * @param [in] context Not used
+ * @param [in] event Start or end of a transfer
+ * @param [in] index Number of the transfer
+ * @param [in] latency_us Submission to completion of a transfer sent
+ */
+static void usb_transfer_event(void* context, usbd_tx_event_t event, uint32_t index, uint32_t latency_us)
+{
+	(void)context;
+	(void)index;
+
+	switch (event)
+	{
+	case USBD_TX_EVENT_STARTED:
+		TRACE_BEGIN(TRACE_STAGE_USB_TRANSFER, index);
+		break;
+	case USBD_TX_EVENT_ENDED:
+		TRACE_END(TRACE_STAGE_USB_TRANSFER);
+		break;
+	case USBD_TX_EVENT_DONE:
+		telemetry_histogram_add(&usb_latency_us, latency_us);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Called once a reply to the host (control stream) has been sent
+ *
+ * @param [in] context Busy flag of the reply (bool*)
+ * @param [in] status 0 if the reply has been sent
+ */
+void control_sent_callback(void* context, int status)
+{
+	(void)status;
+	*(bool*)context = false;
+}
+
+/**
+ * @brief Copy the counters of the drivers into the report
+ */
+static void telemetry_update(void)
+{
+	uint32_t* camera = telemetry.counters[TELEMETRY_STREAM_CAMERA];
+	uint32_t* radar = telemetry.counters[TELEMETRY_STREAM_RADAR];
+	ov7675_ring_stats_t ring_stats;
+	radar_stats_t radar_stats;
+	scheduler_stream_stats_t stream_stats;
+
+	mtb_dvp_cam_ov7675_get_stats(&ring_stats);
+	camera[TELEMETRY_CAPTURED] = ring_stats.frames_captured;
+	camera[TELEMETRY_DROP_RING] = ring_stats.dropped_oldest + ring_stats.dropped_newest;
+	camera[TELEMETRY_DROP_CRC_LATE] = ring_stats.crc_late;
+	camera[TELEMETRY_DROP_LINES] = ring_stats.line_mismatch;
+	telemetry.histograms[TELEMETRY_HISTOGRAM_CAMERA_CRC] = camera_crc_us;
+
+	radar_get_stats(&radar_stats);
+	radar[TELEMETRY_CAPTURED] = radar_stats.frames;
+	radar[TELEMETRY_DROP_OVERRUN] = radar_stats.overruns;
+	radar[TELEMETRY_DROP_FIFO] = radar_stats.read_errors;
+	telemetry.histograms[TELEMETRY_HISTOGRAM_RADAR_READ] = radar_stats.read_us;
+	telemetry.histograms[TELEMETRY_HISTOGRAM_RADAR_READ_CPU] = radar_stats.read_cpu_us;
+	telemetry.histograms[TELEMETRY_HISTOGRAM_IO_OFFLOAD] = io_offload_stats.latency;
+
+	telemetry.histograms[TELEMETRY_HISTOGRAM_USB] = usb_latency_us;
+	scheduler_get_stats(camera_stream, &stream_stats);
+	telemetry.histograms[TELEMETRY_HISTOGRAM_CAMERA] = stream_stats.latency;
+	scheduler_get_stats(radar_stream, &stream_stats);
+	telemetry.histograms[TELEMETRY_HISTOGRAM_RADAR] = stream_stats.latency;
+}
+
+/**
+ * @brief Send the statistics to the host (control stream, PROTOCOL_FORMAT_TELEMETRY)
+ * Skipped while the previous report is being sent
+ */
+void telemetry_send(void)
+{
+	scheduler_message_t message;
+
+	if (telemetry_busy)
+	{
+		return;
+	}
+
+	telemetry_update();
+	message.size = telemetry_encode(&telemetry, telemetry_packet);
+	message.payload = telemetry_packet;
+	fill_header(&message.header, PROTOCOL_STREAM_CONTROL, PROTOCOL_FORMAT_TELEMETRY,
+			control_sequence, timestamp_now_us(), crc32_compute(telemetry_packet, message.size));
+	message.header.dims[0] = TELEMETRY_COUNTER_COUNT;
+	message.header.dims[1] = TELEMETRY_HISTOGRAM_COUNT;
+	message.header.dims[2] = TELEMETRY_BUCKETS;
+	message.callback = control_sent_callback;
+	message.context = &telemetry_busy;
+
+	telemetry_busy = true;
+	if (scheduler_submit(control_stream, &message) != 0)
+	{
+		telemetry_busy = false;
+		return;
+	}
+	control_sequence++;
+}
+
+/**
+ * @brief Print the statistics since the device started
+ */
+void telemetry_print(void)
+{
+	const uint32_t* camera = telemetry.counters[TELEMETRY_STREAM_CAMERA];
+	const uint32_t* radar = telemetry.counters[TELEMETRY_STREAM_RADAR];
+	io_ring_stats_t ring_stats;
+	uint32_t busy_cycles;
+	uint32_t total_cycles;
+
+	telemetry_update();
+	printf("Camera frames: %lu captured, %lu sent, %lu skipped, dropped %lu ring, %lu CRC late, %lu lines, %lu idle, %lu USB \r\n",
+			(unsigned long)camera[TELEMETRY_CAPTURED], (unsigned long)camera[TELEMETRY_SENT],
+			(unsigned long)camera[TELEMETRY_SKIPPED], (unsigned long)camera[TELEMETRY_DROP_RING],
+			(unsigned long)camera[TELEMETRY_DROP_CRC_LATE], (unsigned long)camera[TELEMETRY_DROP_LINES],
+			(unsigned long)camera[TELEMETRY_DROP_IDLE], (unsigned long)camera[TELEMETRY_DROP_USB]);
+	printf("Radar frames: %lu captured, %lu sent, %lu overruns, dropped %lu FIFO, %lu idle, %lu USB \r\n",
+			(unsigned long)radar[TELEMETRY_CAPTURED], (unsigned long)radar[TELEMETRY_SENT],
+			(unsigned long)radar[TELEMETRY_DROP_OVERRUN], (unsigned long)radar[TELEMETRY_DROP_FIFO],
+			(unsigned long)radar[TELEMETRY_DROP_IDLE], (unsigned long)radar[TELEMETRY_DROP_USB]);
+	telemetry_histogram_print("USB transfers", &telemetry.histograms[TELEMETRY_HISTOGRAM_USB]);
+	telemetry_histogram_print("Camera messages", &telemetry.histograms[TELEMETRY_HISTOGRAM_CAMERA]);
+	telemetry_histogram_print("Radar messages", &telemetry.histograms[TELEMETRY_HISTOGRAM_RADAR]);
+	telemetry_histogram_print("Camera CRC", &telemetry.histograms[TELEMETRY_HISTOGRAM_CAMERA_CRC]);
+	telemetry_histogram_print("Radar readout", &telemetry.histograms[TELEMETRY_HISTOGRAM_RADAR_READ]);
+	telemetry_histogram_print("Radar readout CPU", &telemetry.histograms[TELEMETRY_HISTOGRAM_RADAR_READ_CPU]);
+	telemetry_histogram_print("CM33 CRC", &telemetry.histograms[TELEMETRY_HISTOGRAM_IO_OFFLOAD]);
+
+	// Load of the CM33 since the last print
+	io_ring_get_stats(&io_ring, &ring_stats);
+	busy_cycles = ring_stats.busy_cycles - io_offload_last_stats.busy_cycles;
+	total_cycles = ring_stats.total_cycles - io_offload_last_stats.total_cycles;
+	io_offload_last_stats = ring_stats;
+	printf("CM33 CRC: %lu messages (%lu KB), %lu computed by the CM55, %lu timeouts, load %lu.%lu %% \r\n",
+			(unsigned long)io_offload_stats.offloaded, (unsigned long)(io_offload_stats.bytes / 1024u),
+			(unsigned long)io_offload_stats.local, (unsigned long)io_offload_stats.timeouts,
+			(unsigned long)((total_cycles != 0) ? ((uint64_t)busy_cycles * 100u / total_cycles) : 0),
+			(unsigned long)((total_cycles != 0) ? (((uint64_t)busy_cycles * 1000u / total_cycles) % 10u) : 0));
+}
+
+/**
+ * @brief Start the load measurement (stream started)
+ */
+void pipeline_stats_reset(void)
 {
-	// Used to store video stream
-	// Double buffering used
-	uint8_t* image_buffer_0 = NULL;
-	uint8_t* image_buffer_1 = NULL;
+#if RTOS_ENABLED
+	rtos_start_count = uxTaskGetSystemState(rtos_start_status, RTOS_MAX_TASKS, &rtos_start_time);
+#else
+	loop_busy_cycles = 0;
+	loop_total_cycles = 0;
+#endif
+}
 
-	uint8_t* comm_buffer = NULL;
-	uint16_t* radar_data = NULL;
-	uint16_t radar_num_samples = 0;
-	size_t radar_data_size = 0;
+/**
+ * @brief Print the load since the stream started: per task with the RTOS
+ * (and the stack left), else the share of the main loop iterations doing work
+ */
+void pipeline_print_stats(void)
+{
+#if RTOS_ENABLED
+	configRUN_TIME_COUNTER_TYPE now = 0;
+	configRUN_TIME_COUNTER_TYPE elapsed = 0;
+	UBaseType_t count = uxTaskGetSystemState(rtos_status, RTOS_MAX_TASKS, &now);
 
-	cy_stc_scb_i2c_context_t i2c_master_context;
-	usbd_t* usb_handle;
+	elapsed = now - rtos_start_time;
+	for (UBaseType_t i = 0; i < count; ++i)
+	{
+		configRUN_TIME_COUNTER_TYPE run = rtos_status[i].ulRunTimeCounter;
 
-	bool frame_ready = false;
-	bool active_frame = false;
+		// Tasks created after the start run since their creation
+		for (UBaseType_t j = 0; j < rtos_start_count; ++j)
+		{
+			if (rtos_start_status[j].xHandle == rtos_status[i].xHandle)
+			{
+				run -= rtos_start_status[j].ulRunTimeCounter;
+				break;
+			}
+		}
 
-	int send_data = 0;
+		printf("Task %s: load %lu.%lu %%, stack %lu words free \r\n", rtos_status[i].pcTaskName,
+				(unsigned long)((elapsed != 0) ? (run * 1000u / elapsed) / 10u : 0u),
+				(unsigned long)((elapsed != 0) ? (run * 1000u / elapsed) % 10u : 0u),
+				(unsigned long)rtos_status[i].usStackHighWaterMark);
+	}
+#else
+	uint64_t permille = (loop_total_cycles != 0) ? (loop_busy_cycles * 1000u / loop_total_cycles) : 0u;
+
+	printf("Main loop: busy %lu.%lu %% (iterations handling a frame or a command) \r\n",
+			(unsigned long)(permille / 10u), (unsigned long)(permille % 10u));
+#endif
+}
 
-	uint8_t counterint = 0;
+/**
+ * @brief Let the USB transfers progress (completion callbacks of the transfers ended by usbd_tx_poll
+ * are called from here) and apply the command waiting for them
+ */
+void usb_stage(void)
+{
+	TRACE_BEGIN(TRACE_STAGE_SCHEDULER, 0);
+	scheduler_poll();
+	io_offload_poll();
+	TRACE_END(TRACE_STAGE_SCHEDULER);
+	drain_stage();
+	if (usb_tx_error)
+	{
+		usb_tx_error = 0;
+		if (send_data == 1)
+		{
+			printf("Failed to write data over USB\r\n");
+			send_data = 0;
+		}
+	}
+}
+
+/**
+ * @brief Start the USB, the scheduler and its streams, and the sensors
+ *
+ * @retval 0 Success
+ * @retval -1 A sensor cannot be initialized
+ */
+int app_start(void)
+{
+	scheduler_stream_config_t stream_config;
+	cy_rslt_t result;
+
+	// Init USB CDC
+	// This call will block until USB cable is plugged to a computer
+	usb_handle = usbd_create();
+	usbd_set_timestamp(usb_handle, timestamp_now_us);
+	usbd_set_tx_event_callback(usb_handle, usb_transfer_event, NULL);
+
+	// Radar first: its small frames go between the fragments of the camera frames
+	// The replies to the host (a few bytes) share the highest priority
+	scheduler_init(usb_handle);
+	stream_config.priority = 0;
+	stream_config.weight = 1;
+	stream_config.chunk_size = 0;
+	stream_config.latency_bound_us = RADAR_LATENCY_BOUND_US;
+	radar_stream = scheduler_add_stream(&stream_config);
+	stream_config.latency_bound_us = 0;
+	control_stream = scheduler_add_stream(&stream_config);
+	stream_config.priority = 1;
+	stream_config.weight = 1;
+	stream_config.chunk_size = CAMERA_CHUNK_SIZE;
+	stream_config.latency_bound_us = 0;
+	camera_stream = scheduler_add_stream(&stream_config);
+
+    // Initialize the camera DVP OV7675
+    // The oldest frame is dropped if the USB is slower than the camera
+    mtb_dvp_cam_ov7675_set_line_callback(camera_line_crc, CRC32_INIT);
+    mtb_dvp_cam_ov7675_set_timestamp(timestamp_now_us);
+    mtb_dvp_cam_ov7675_set_deferred_callback(camera_deferred_event, NULL);
+    result = mtb_dvp_cam_ov7675_init(camera_frames, OV7675_FRAME_RING_DEPTH,
+    		&i2c_master_context, kOV7675_DropOldest);
+    if (CY_RSLT_SUCCESS != result)
+    {
+		printf("Cannot initialize OV7675 \r\n");
+		return -1;
+    }
+    mtb_dvp_cam_ov7675_get_mode(&camera_mode);
+
+    // Initialize radar sensor
+	if (radar_init() != 0)
+	{
+		printf("Cannot initialize radar sensor ...\r\n");
+		return -1;
+	}
+
+	printf("Sensors have been initialized - Start streaming \r\n");
+
+	return 0;
+}
+
+int main(void)
+{
+	// Default detector of the targets
+	cfar_config_t radar_cfar_config = { 0 };
 
     cy_rslt_t result;
 
@@ -126,6 +559,21 @@ int main(void)
     // Init retarget-io -> printf redirected to KitProg3
 	init_retarget_io();
 
+	// Cycle counter used to measure the USB transfers and to timestamp the captures
+	timestamp_init();
+#if TRACE_ENABLED
+	trace_start();
+#endif
+
+#if IO_OFFLOAD_ENABLED
+	// The CM33 serves the ring once it has found it, the CRCs are computed here until then
+	io_offload = (io_ring_publish(&io_ring) == 0);
+	if (!io_offload)
+	{
+		printf("IPC channel of the CM33 ring in use, CRC computed by the CM55\r\n");
+	}
+#endif
+
     // Enable global interrupts
     __enable_irq();
 
@@ -141,147 +589,113 @@ int main(void)
     Cy_SCB_I2C_Enable(CYBSP_I2C_CAM_CONTROLLER_HW);
 
     // Memory allocation
-    image_buffer_0 = malloc(OV7675_MEMORY_BUFFER_SIZE);
-	if (image_buffer_0 == NULL)
+	// Ring of frame buffers handled by the camera driver (initial mode, the larger modes use camera_pool)
+	for (uint32_t i = 0; i < OV7675_FRAME_RING_DEPTH; ++i)
 	{
-		printf("Cannot allocate image_buffer_0 \r\n");
-		return 0;
+		camera_heap_frames[i] = malloc(OV7675_MEMORY_BUFFER_SIZE);
+		if (camera_heap_frames[i] == NULL)
+		{
+			printf("Cannot allocate camera_heap_frames[%u] \r\n", (unsigned int)i);
+			return 0;
+		}
+		memset(camera_heap_frames[i], 0, OV7675_MEMORY_BUFFER_SIZE);
 	}
-	memset(image_buffer_0, 0, OV7675_MEMORY_BUFFER_SIZE);
 
-	image_buffer_1 = malloc(OV7675_MEMORY_BUFFER_SIZE);
-	if (image_buffer_1 == NULL)
+	// Last camera frame sent, compared with the new ones by the motion gating
+	camera_heap_reference = malloc(OV7675_MEMORY_BUFFER_SIZE);
+	if (camera_heap_reference == NULL)
 	{
-		printf("Cannot allocate image_buffer_1 \r\n");
+		printf("Cannot allocate camera_heap_reference \r\n");
 		return 0;
 	}
 
-	// Allocate communication buffer
-	// We assume that the size of a picture captured by the OV7675
-	// is bigger than the size of a radar frame
-	comm_buffer = malloc(OV7675_MEMORY_BUFFER_SIZE + COM_OVERHEAD);
-	if (comm_buffer == NULL)
+	// Compressed frames, raw until the host selects a codec
+	camera_codec = CAMERA_CODEC_RAW;
+	for (uint32_t i = 0; i < CAMERA_CODEC_BUFFER_COUNT; ++i)
 	{
-		printf("Cannot allocate comm_buffer \r\n");
-		return 0;
+		camera_heap_codec_data[i] = malloc(CAMERA_CODEC_BUFFER_SIZE(OV7675_MEMORY_BUFFER_SIZE));
+		if (camera_heap_codec_data[i] == NULL)
+		{
+			printf("Cannot allocate camera_heap_codec_data[%u] \r\n", (unsigned int)i);
+			return 0;
+		}
 	}
+	camera_buffers_set(OV7675_MEMORY_BUFFER_SIZE);
 
-	// Allocate for radar sensor
-	radar_num_samples = radar_get_num_samples_per_frame();
-	radar_data_size = radar_num_samples * sizeof(uint16_t);
-	radar_data = malloc(radar_data_size);
-	if (radar_data == NULL)
+	// Allocate for radar sensor (compiled profile until the host uploads another one)
+	if (radar_buffers_alloc() != 0)
 	{
-		printf("Cannot allocate radar_data \r\n");
 		return 0;
 	}
 
-	// Init USB CDC
-	// This call will block until USB cable is plugged to a computer
-	usb_handle = usbd_create();
+	// Detector: CA-CFAR with 2 guard and 8 training cells on each side, 12 dB over the noise
+	radar_cfar_config.mode = CFAR_MODE_CA;
+	radar_cfar_config.guard = 2;
+	radar_cfar_config.training = 8;
+	radar_cfar_config.threshold_db = 12;
+	(void)cfar_init(&radar_cfar, &radar_cfar_config);
 
-    // Initialize the camera DVP OV7675
-    result = mtb_dvp_cam_ov7675_init(image_buffer_0, image_buffer_1,
-    		&i2c_master_context,
-			&frame_ready, &active_frame);
-    if (CY_RSLT_SUCCESS != result)
-    {
-		printf("Cannot initialize OV7675 \r\n");
-		return 0;
-    }
+	command_parser_init(&command_parser);
 
-    // Initialize radar sensor
-	if (radar_init() != 0)
+#if RTOS_ENABLED
+	// The USB task starts the USB, the sensors and the other tasks
+	rtos_start();
+
+	// Not reached: the kernel runs the tasks
+	return 0;
+#else
+	if (app_start() != 0)
 	{
-		printf("Cannot initialize radar sensor ...\r\n");
 		return 0;
 	}
 
-	printf("Sensors have been initialized - Start streaming \r\n");
-
-    for (;;)
-    {
-    	uint8_t cmd = 0;
-
-    	// Something in USB read buffer?
-    	if ( usbd_read(usb_handle, &cmd, COM_CMD_SIZE) == COM_CMD_SIZE)
-    	{
-    		printf("Received command: %d \r\n", cmd);
-    		if (cmd == COM_CMD_START_STREAM)
-    		{
-    			send_data = 1;
-    			counterint = 0;
-    		}
-    		else send_data = 0;
-    	}
-
-    	// Frame ready from the OV7675?
-		if (frame_ready)
+	// The stages run one after the other
+	for (;;)
+	{
+		uint32_t start = timestamp_now();
+		uint32_t cycles = 0;
+		uint32_t size = 0;
+		uint64_t rx_us = 0;
+		bool busy = false;
+		camera_handle_t camera;
+		int radar_index = -1;
+		uint64_t radar_frame_us = 0;
+
+		// Ends the segments sent, then starts the chunks handed over by the scheduler
+		usbd_tx_poll(usb_handle);
+		usb_stage();
+		usbd_tx_poll(usb_handle);
+
+		// Something in USB read buffer? (never blocks)
+		size = (uint32_t)usbd_receive(usb_handle, command_rx, sizeof(command_rx));
+		if (size != 0)
 		{
-			frame_ready = false;
+			rx_us = timestamp_now_us();
+			busy = true;
+		}
+		command_stage(command_rx, size, rx_us);
 
-			// Copy to the communication buffer
-			if (active_frame == 0)
-				memcpy(&comm_buffer[COM_OVERHEAD], image_buffer_0, OV7675_MEMORY_BUFFER_SIZE);
-			else
-				memcpy(&comm_buffer[COM_OVERHEAD], image_buffer_1, OV7675_MEMORY_BUFFER_SIZE);
-
-			// Add overhead
-			comm_buffer[0] = 0x55;
-			comm_buffer[1] = 0x55;
-			comm_buffer[2] = counterint;
-			counterint++;
-			*((uint32_t*)&comm_buffer[3]) = OV7675_MEMORY_BUFFER_SIZE;
-			comm_buffer[7] = crc_compute(&comm_buffer[COM_OVERHEAD], OV7675_MEMORY_BUFFER_SIZE);
-
-			// Send per USB
-			if (send_data == 1)
-			{
-				Cy_GPIO_Write(CYBSP_LED_RGB_GREEN_PORT, CYBSP_LED_RGB_GREEN_PIN, 1);
-				if (usbd_write(usb_handle, comm_buffer, OV7675_MEMORY_BUFFER_SIZE + COM_OVERHEAD) != 0)
-				{
-					printf("Failed to write OV7675 values over USB\r\n");
-					send_data = 0;
-				}
-				Cy_GPIO_Write(CYBSP_LED_RGB_GREEN_PORT, CYBSP_LED_RGB_GREEN_PIN, 0);
-			}
+		// Frame ready from the OV7675?
+		if (camera_acquire(&camera))
+		{
+			camera_process(&camera);
+			busy = true;
 		}
 
 		// Radar data available?
-		if (radar_is_data_available())
+		radar_index = radar_acquire(&radar_frame_us);
+		if (radar_index >= 0)
 		{
-			if (radar_read_data(radar_data, radar_num_samples) != 0)
-			{
-				printf("Error reading radar data\r\n");
-			}
-			else
-			{
-				// Alive LED
-				Cy_GPIO_Inv(CYBSP_USER_LED1_PORT, CYBSP_USER_LED1_PIN);
-
-				// Copy data
-				memcpy(&comm_buffer[COM_OVERHEAD], (uint8_t*)radar_data, radar_data_size);
-
-				// Add overhead
-				comm_buffer[0] = 0x55;
-				comm_buffer[1] = 0x55;
-				comm_buffer[2] = counterint;
-				counterint++;
-				*((uint32_t*)&comm_buffer[3]) = (uint32_t)radar_data_size;
-				comm_buffer[7] = crc_compute(&comm_buffer[COM_OVERHEAD], radar_data_size);
-
-				// Send once per USB
-				if (send_data == 1)
-				{
-					Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 1);
-					if (usbd_write(usb_handle, comm_buffer, radar_data_size + COM_OVERHEAD) != 0)
-					{
-						printf("Failed to write radar data over USB\r\n");
-						send_data = 0;
-					}
-					Cy_GPIO_Write(CYBSP_USER_LED2_PORT, CYBSP_USER_LED2_PIN, 0);
-				}
-			}
+			radar_process(radar_index, radar_frame_us);
+			busy = true;
 		}
-    }
+
+		cycles = timestamp_now() - start;
+		loop_total_cycles += cycles;
+		if (busy)
+		{
+			loop_busy_cycles += cycles;
+		}
+	}
+#endif
 }
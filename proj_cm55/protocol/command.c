@@ -0,0 +1,180 @@
+/*
+ * command.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "command.h"
+
+#include <string.h>
+
+#include "crc.h"
+
+/*
+ * Byte order independent accessors (the wire format is little endian)
+ */
+static void _put_u16(uint8_t* buffer, uint16_t value)
+{
+	buffer[0] = (uint8_t)value;
+	buffer[1] = (uint8_t)(value >> 8);
+}
+
+static void _put_u32(uint8_t* buffer, uint32_t value)
+{
+	_put_u16(buffer, (uint16_t)value);
+	_put_u16(&buffer[2], (uint16_t)(value >> 16));
+}
+
+static uint16_t _get_u16(const uint8_t* buffer)
+{
+	return (uint16_t)(buffer[0] | (buffer[1] << 8));
+}
+
+static uint32_t _get_u32(const uint8_t* buffer)
+{
+	return (uint32_t)_get_u16(buffer) | ((uint32_t)_get_u16(&buffer[2]) << 16);
+}
+
+/**
+ * @brief Drop the first byte of the buffered frame and the bytes before the next first sync byte
+ */
+static void _command_parser_resync(command_parser_t* parser)
+{
+	uint32_t start = 1;
+
+	while ((start < parser->length) && (parser->frame[start] != COMMAND_SYNC_0))
+	{
+		start++;
+	}
+
+	parser->stats.skipped_bytes += start;
+	parser->length -= start;
+	memmove(parser->frame, &parser->frame[start], parser->length);
+}
+
+/**
+ * @brief Check the buffered bytes, dropping the invalid frames
+ *
+ * @retval 1 A command is complete at the start of the buffer
+ * @retval 0 More bytes are needed
+ */
+static int _command_parser_check(command_parser_t* parser, command_t* command)
+{
+	for (;;)
+	{
+		uint32_t size = 0;
+		uint32_t total = 0;
+
+		if ((parser->length >= 1) && (parser->frame[0] != COMMAND_SYNC_0))
+		{
+			_command_parser_resync(parser);
+			continue;
+		}
+		if ((parser->length >= 2) && (parser->frame[1] != COMMAND_SYNC_1))
+		{
+			_command_parser_resync(parser);
+			continue;
+		}
+		if (parser->length < COMMAND_HEADER_SIZE)
+		{
+			return 0;
+		}
+
+		size = _get_u16(&parser->frame[6]);
+		if (size > COMMAND_MAX_PARAMS)
+		{
+			parser->stats.size_errors++;
+			_command_parser_resync(parser);
+			continue;
+		}
+
+		total = COMMAND_HEADER_SIZE + size + COMMAND_CRC_SIZE;
+		if (parser->length < total)
+		{
+			return 0;
+		}
+
+		if (_get_u32(&parser->frame[COMMAND_HEADER_SIZE + size])
+				!= crc32_compute(parser->frame, COMMAND_HEADER_SIZE + size))
+		{
+			parser->stats.crc_errors++;
+			_command_parser_resync(parser);
+			continue;
+		}
+
+		command->id = parser->frame[2];
+		command->flags = parser->frame[3];
+		command->request_id = _get_u16(&parser->frame[4]);
+		command->size = (uint16_t)size;
+		command->params = &parser->frame[COMMAND_HEADER_SIZE];
+		parser->delivered = total;
+		parser->stats.commands++;
+		return 1;
+	}
+}
+
+void command_parser_init(command_parser_t* parser)
+{
+	memset(parser, 0, sizeof(*parser));
+}
+
+int command_parser_push(command_parser_t* parser, const uint8_t* data, uint32_t size, uint32_t* consumed,
+		command_t* command)
+{
+	uint32_t used = 0;
+	int found = 0;
+
+	// The command returned last time is done with
+	if (parser->delivered != 0)
+	{
+		parser->length -= parser->delivered;
+		memmove(parser->frame, &parser->frame[parser->delivered], parser->length);
+		parser->delivered = 0;
+	}
+
+	// One byte at a time: the buffer never holds more than the frame being checked
+	found = _command_parser_check(parser, command);
+	while (!found && (used < size))
+	{
+		parser->frame[parser->length++] = data[used++];
+		found = _command_parser_check(parser, command);
+	}
+
+	*consumed = used;
+	return found;
+}
+
+uint32_t command_encode(const command_t* command, uint8_t* buffer)
+{
+	buffer[0] = COMMAND_SYNC_0;
+	buffer[1] = COMMAND_SYNC_1;
+	buffer[2] = command->id;
+	buffer[3] = command->flags;
+	_put_u16(&buffer[4], command->request_id);
+	_put_u16(&buffer[6], command->size);
+	if (command->size != 0)
+	{
+		memcpy(&buffer[COMMAND_HEADER_SIZE], command->params, command->size);
+	}
+	_put_u32(&buffer[COMMAND_HEADER_SIZE + command->size], crc32_compute(buffer, COMMAND_HEADER_SIZE + command->size));
+
+	return COMMAND_HEADER_SIZE + command->size + COMMAND_CRC_SIZE;
+}
+
+uint32_t command_encode_ack(const command_t* command, int32_t status, uint8_t* buffer)
+{
+	_put_u16(&buffer[0], command->request_id);
+	buffer[2] = command->id;
+	buffer[3] = 0;
+	_put_u32(&buffer[4], (uint32_t)status);
+
+	return COMMAND_ACK_SIZE;
+}
@@ -0,0 +1,185 @@
+/*
+ * command.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Commands of the host (CDC OUT endpoint): every command is a frame
+ * All fields are little endian
+ *
+ * | Offset   | Size | Field                                                |
+ * |----------|------|------------------------------------------------------|
+ * | 0        | 2    | Sync 0xA5 0x5A                                       |
+ * | 2        | 1    | Command                                              |
+ * | 3        | 1    | Flags (0)                                            |
+ * | 4        | 2    | Request id (returned in the acknowledgement)         |
+ * | 6        | 2    | Size of the parameters (at most COMMAND_MAX_PARAMS)  |
+ * | 8        | n    | Parameters                                           |
+ * | 8 + n    | 4    | CRC-32 of the bytes 0 .. 8 + n - 1                   |
+ *
+ * The frames are parsed incrementally, whatever the USB packets they are split
+ * into: the bytes are pushed as they are received and a command is returned
+ * once its frame is complete. A frame with invalid size or CRC is dropped and
+ * the parser resynchronizes on the next sync bytes.
+ *
+ * Each command is acknowledged on the control stream (PROTOCOL_FORMAT_COMMAND_ACK),
+ * in-band with the data streams:
+ *
+ * | Offset | Size | Field                                                  |
+ * |--------|------|--------------------------------------------------------|
+ * | 0      | 2    | Request id                                             |
+ * | 2      | 1    | Command                                                |
+ * | 3      | 1    | Reserved (0)                                           |
+ * | 4      | 4    | Status (int32_t, 0: success, COMMAND_STATUS_xxx)       |
+ * | 8      | n    | Data of the command (e.g. state of the device)         |
+ *
+ * This file and command.c only depend on the C standard library and crc.c:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef PROTOCOL_COMMAND_H_
+#define PROTOCOL_COMMAND_H_
+
+#include <stdint.h>
+
+/**
+ * @def COMMAND_SYNC_0
+ * First byte of a command
+ */
+#define COMMAND_SYNC_0				0xA5
+
+/**
+ * @def COMMAND_SYNC_1
+ * Second byte of a command
+ */
+#define COMMAND_SYNC_1				0x5A
+
+/**
+ * @def COMMAND_HEADER_SIZE
+ * Size of the header of a command (before the parameters)
+ */
+#define COMMAND_HEADER_SIZE			8
+
+/**
+ * @def COMMAND_CRC_SIZE
+ * Size of the CRC following the parameters
+ */
+#define COMMAND_CRC_SIZE			4
+
+/**
+ * @def COMMAND_MAX_PARAMS
+ * Maximum size of the parameters of a command
+ */
+#define COMMAND_MAX_PARAMS			512
+
+/**
+ * @def COMMAND_MAX_FRAME_SIZE
+ * Maximum size of a command
+ */
+#define COMMAND_MAX_FRAME_SIZE		(COMMAND_HEADER_SIZE + COMMAND_MAX_PARAMS + COMMAND_CRC_SIZE)
+
+/**
+ * @def COMMAND_ACK_SIZE
+ * Size of an acknowledgement without data
+ */
+#define COMMAND_ACK_SIZE			8
+
+/**
+ * Status of an acknowledgement, also carried by the replies of the commands
+ */
+#define COMMAND_STATUS_OK				0
+#define COMMAND_STATUS_UNKNOWN			-1	/**< Unknown command */
+#define COMMAND_STATUS_PARAM			-2	/**< Wrong size of the parameters */
+#define COMMAND_STATUS_BUSY				-3	/**< The previous reply of this command is being sent, or a sensor switch is pending */
+#define COMMAND_STATUS_INVALID			-4	/**< Parameter out of range, the setting in use is kept */
+#define COMMAND_STATUS_CONFIG_FAILED	-5	/**< The sensor cannot be programmed, a known setting is restored */
+#define COMMAND_STATUS_DRAIN_TIMEOUT	-6	/**< The transfers in flight cannot be completed, nothing changed */
+#define COMMAND_STATUS_NO_MEMORY		-7	/**< No memory for the new setting, a known setting is restored */
+
+/**
+ * Command received from the host
+ */
+typedef struct
+{
+	uint8_t id;						/**< Command */
+	uint8_t flags;
+	uint16_t request_id;
+	uint16_t size;					/**< Size of the parameters */
+	const uint8_t* params;			/**< Parameters (in the parser: valid until the next push) */
+} command_t;
+
+/**
+ * Errors of the parser since its initialization
+ */
+typedef struct
+{
+	uint32_t commands;				/**< Valid commands */
+	uint32_t crc_errors;			/**< Frames dropped: wrong CRC */
+	uint32_t size_errors;			/**< Frames dropped: parameters too large */
+	uint32_t skipped_bytes;			/**< Bytes dropped while searching the sync bytes */
+} command_parser_stats_t;
+
+/**
+ * Incremental parser of the commands
+ */
+typedef struct
+{
+	uint8_t frame[COMMAND_MAX_FRAME_SIZE];	/**< Bytes received, from the start of the next frame */
+	uint32_t length;						/**< Number of bytes in frame */
+	uint32_t delivered;						/**< Size of the command returned by the last push, removed by the next one */
+	command_parser_stats_t stats;
+} command_parser_t;
+
+/**
+ * @brief Prepare a parser
+ *
+ * @param [out] parser Parser
+ */
+void command_parser_init(command_parser_t* parser);
+
+/**
+ * @brief Push received bytes, until a command is complete
+ * Call again with the bytes not consumed (or none) as long as a command is returned:
+ * the bytes buffered after a dropped frame can hold further commands.
+ *
+ * @param [in,out] parser Parser
+ * @param [in] data Received bytes
+ * @param [in] size Number of bytes
+ * @param [out] consumed Number of bytes of data taken by the parser
+ * @param [out] command Command, its parameters are in the parser until the next push
+ *
+ * @retval 1 A command is complete
+ * @retval 0 All bytes consumed, no command complete
+ */
+int command_parser_push(command_parser_t* parser, const uint8_t* data, uint32_t size, uint32_t* consumed,
+		command_t* command);
+
+/**
+ * @brief Encode a command
+ *
+ * @param [in] command Command (size at most COMMAND_MAX_PARAMS)
+ * @param [out] buffer Destination (COMMAND_HEADER_SIZE + size + COMMAND_CRC_SIZE bytes)
+ *
+ * @retval Size of the frame
+ */
+uint32_t command_encode(const command_t* command, uint8_t* buffer);
+
+/**
+ * @brief Encode the acknowledgement of a command, without its data
+ *
+ * @param [in] command Command acknowledged
+ * @param [in] status Status of the command
+ * @param [out] buffer Destination (COMMAND_ACK_SIZE bytes, followed by the data of the command if any)
+ *
+ * @retval COMMAND_ACK_SIZE
+ */
+uint32_t command_encode_ack(const command_t* command, int32_t status, uint8_t* buffer);
+
+#endif /* PROTOCOL_COMMAND_H_ */
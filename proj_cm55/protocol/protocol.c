@@ -0,0 +1,179 @@
+/*
+ * protocol.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "protocol.h"
+
+#include <string.h>
+
+#include "crc.h"
+
+/**
+ * @def PROTOCOL_HEADER_CRC_OFFSET
+ * Offset of the CRC of the header (covers the bytes before)
+ */
+#define PROTOCOL_HEADER_CRC_OFFSET	44
+
+/*
+ * Byte order independent accessors (the wire format is little endian)
+ */
+static void _put_u16(uint8_t* buffer, uint16_t value)
+{
+	buffer[0] = (uint8_t)value;
+	buffer[1] = (uint8_t)(value >> 8);
+}
+
+static void _put_u32(uint8_t* buffer, uint32_t value)
+{
+	_put_u16(buffer, (uint16_t)value);
+	_put_u16(&buffer[2], (uint16_t)(value >> 16));
+}
+
+static uint16_t _get_u16(const uint8_t* buffer)
+{
+	return (uint16_t)(buffer[0] | (buffer[1] << 8));
+}
+
+static uint32_t _get_u32(const uint8_t* buffer)
+{
+	return (uint32_t)_get_u16(buffer) | ((uint32_t)_get_u16(&buffer[2]) << 16);
+}
+
+uint32_t protocol_encode_header(const protocol_header_t* header, uint8_t* buffer)
+{
+	buffer[0] = PROTOCOL_SYNC_0;
+	buffer[1] = PROTOCOL_SYNC_1;
+	buffer[2] = PROTOCOL_VERSION;
+	buffer[3] = PROTOCOL_HEADER_SIZE;
+	buffer[4] = header->stream;
+	buffer[5] = header->format;
+	_put_u16(&buffer[6], header->flags);
+	_put_u32(&buffer[8], header->sequence);
+	_put_u32(&buffer[12], header->payload_size);
+	_put_u32(&buffer[16], (uint32_t)header->timestamp_us);
+	_put_u32(&buffer[20], (uint32_t)(header->timestamp_us >> 32));
+	_put_u32(&buffer[24], header->message_size);
+	_put_u32(&buffer[28], header->fragment_offset);
+	_put_u16(&buffer[32], header->dims[0]);
+	_put_u16(&buffer[34], header->dims[1]);
+	_put_u16(&buffer[36], header->dims[2]);
+	_put_u16(&buffer[38], header->encode_cost);
+	_put_u32(&buffer[40], header->message_crc);
+	_put_u32(&buffer[PROTOCOL_HEADER_CRC_OFFSET], crc32_compute(buffer, PROTOCOL_HEADER_CRC_OFFSET));
+
+	return PROTOCOL_HEADER_SIZE;
+}
+
+int protocol_decode_header(const uint8_t* buffer, uint32_t size, protocol_header_t* header)
+{
+	if (size < PROTOCOL_HEADER_SIZE)
+	{
+		return PROTOCOL_ERROR_SIZE;
+	}
+
+	if ((buffer[0] != PROTOCOL_SYNC_0) || (buffer[1] != PROTOCOL_SYNC_1))
+	{
+		return PROTOCOL_ERROR_SYNC;
+	}
+
+	if ((buffer[2] != PROTOCOL_VERSION) || (buffer[3] != PROTOCOL_HEADER_SIZE))
+	{
+		return PROTOCOL_ERROR_VERSION;
+	}
+
+	if (_get_u32(&buffer[PROTOCOL_HEADER_CRC_OFFSET]) != crc32_compute(buffer, PROTOCOL_HEADER_CRC_OFFSET))
+	{
+		return PROTOCOL_ERROR_HEADER_CRC;
+	}
+
+	header->stream = buffer[4];
+	header->format = buffer[5];
+	header->flags = _get_u16(&buffer[6]);
+	header->sequence = _get_u32(&buffer[8]);
+	header->payload_size = _get_u32(&buffer[12]);
+	header->timestamp_us = (uint64_t)_get_u32(&buffer[16]) | ((uint64_t)_get_u32(&buffer[20]) << 32);
+	header->message_size = _get_u32(&buffer[24]);
+	header->fragment_offset = _get_u32(&buffer[28]);
+	header->dims[0] = _get_u16(&buffer[32]);
+	header->dims[1] = _get_u16(&buffer[34]);
+	header->dims[2] = _get_u16(&buffer[36]);
+	header->encode_cost = _get_u16(&buffer[38]);
+	header->message_crc = _get_u32(&buffer[40]);
+
+	// Overflow safe: fragment_offset + payload_size <= message_size
+	if ((header->payload_size > header->message_size)
+			|| (header->fragment_offset > (header->message_size - header->payload_size)))
+	{
+		return PROTOCOL_ERROR_FRAGMENT;
+	}
+
+	return 0;
+}
+
+uint32_t protocol_encode_batch_entry(const protocol_batch_entry_t* entry, uint8_t* buffer)
+{
+	_put_u32(&buffer[0], entry->size);
+	_put_u32(&buffer[4], entry->timestamp_offset_us);
+	_put_u16(&buffer[8], entry->dims[0]);
+	_put_u16(&buffer[10], entry->dims[1]);
+	_put_u16(&buffer[12], entry->dims[2]);
+	_put_u16(&buffer[14], entry->encode_cost);
+	buffer[16] = entry->format;
+	buffer[17] = 0;
+	_put_u16(&buffer[18], 0);
+
+	return PROTOCOL_BATCH_ENTRY_SIZE;
+}
+
+int32_t protocol_decode_batch_entry(const uint8_t* buffer, uint32_t size, protocol_batch_entry_t* entry)
+{
+	if (size < PROTOCOL_BATCH_ENTRY_SIZE)
+	{
+		return PROTOCOL_ERROR_BATCH;
+	}
+
+	entry->size = _get_u32(&buffer[0]);
+	entry->timestamp_offset_us = _get_u32(&buffer[4]);
+	entry->dims[0] = _get_u16(&buffer[8]);
+	entry->dims[1] = _get_u16(&buffer[10]);
+	entry->dims[2] = _get_u16(&buffer[12]);
+	entry->encode_cost = _get_u16(&buffer[14]);
+	entry->format = buffer[16];
+
+	if (entry->size > (size - PROTOCOL_BATCH_ENTRY_SIZE))
+	{
+		return PROTOCOL_ERROR_BATCH;
+	}
+
+	return (int32_t)(PROTOCOL_BATCH_ENTRY_SIZE + entry->size);
+}
+
+uint32_t protocol_find_sync(const uint8_t* buffer, uint32_t size)
+{
+	uint32_t i = 0;
+
+	for (i = 0; i + 1 < size; ++i)
+	{
+		if ((buffer[i] == PROTOCOL_SYNC_0) && (buffer[i + 1] == PROTOCOL_SYNC_1))
+		{
+			return i;
+		}
+	}
+
+	if ((size > 0) && (buffer[size - 1] == PROTOCOL_SYNC_0))
+	{
+		return size - 1;
+	}
+
+	return size;
+}
@@ -0,0 +1,235 @@
+/*
+ * protocol.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Wire protocol v2: every packet is a 48 bytes header followed by the payload
+ * All fields are little endian and aligned to their size
+ *
+ * | Offset | Size | Field                                                  |
+ * |--------|------|--------------------------------------------------------|
+ * | 0      | 2    | Sync 0x55 0xAA                                         |
+ * | 2      | 1    | Version (2)                                            |
+ * | 3      | 1    | Header size (48)                                       |
+ * | 4      | 1    | Stream (protocol_stream_t)                             |
+ * | 5      | 1    | Payload format (protocol_format_t)                     |
+ * | 6      | 2    | Flags (PROTOCOL_FLAG_xxx)                              |
+ * | 8      | 4    | Sequence number (per stream)                           |
+ * | 12     | 4    | Payload size (this packet)                             |
+ * | 16     | 8    | Capture timestamp (us)                                 |
+ * | 24     | 4    | Message size (all fragments)                           |
+ * | 28     | 4    | Offset of the fragment in the message                  |
+ * | 32     | 6    | Dimensions: width/height/- or samples/chirps/antennas  |
+ * | 38     | 2    | Encode cost of compressed frames (0 if not measured)   |
+ * | 40     | 4    | CRC-32 of the whole message                            |
+ * | 44     | 4    | CRC-32 of the header bytes 0..43                       |
+ *
+ * A batch (PROTOCOL_FORMAT_RADAR_BATCH) carries several radar frames in one
+ * message: the header is the one of the first frame (timestamp) and each frame
+ * is an entry header followed by its payload:
+ *
+ * | Offset | Size | Field                                                  |
+ * |--------|------|--------------------------------------------------------|
+ * | 0      | 4    | Payload size of the frame                              |
+ * | 4      | 4    | Capture timestamp - timestamp of the message (us)      |
+ * | 8      | 6    | Dimensions (see the format of the frame)               |
+ * | 14     | 2    | Encode cost                                            |
+ * | 16     | 1    | Payload format of the frame                            |
+ * | 17     | 3    | Reserved (0)                                           |
+ *
+ * This file and protocol.c only depend on the C standard library and crc.c:
+ * they can be compiled for the host as well.
+ */
+
+#ifndef PROTOCOL_PROTOCOL_H_
+#define PROTOCOL_PROTOCOL_H_
+
+#include <stdint.h>
+
+/**
+ * @def PROTOCOL_SYNC_0
+ * First byte of a header
+ */
+#define PROTOCOL_SYNC_0				0x55
+
+/**
+ * @def PROTOCOL_SYNC_1
+ * Second byte of a header
+ */
+#define PROTOCOL_SYNC_1				0xAA
+
+/**
+ * @def PROTOCOL_VERSION
+ * Version of the protocol
+ */
+#define PROTOCOL_VERSION			2
+
+/**
+ * @def PROTOCOL_HEADER_SIZE
+ * Size of the header
+ */
+#define PROTOCOL_HEADER_SIZE		48
+
+/**
+ * @def PROTOCOL_FLAG_FRAGMENT
+ * The packet is a fragment of a message
+ */
+#define PROTOCOL_FLAG_FRAGMENT			0x0001
+
+/**
+ * @def PROTOCOL_FLAG_MORE_FRAGMENTS
+ * More fragments of the message follow
+ */
+#define PROTOCOL_FLAG_MORE_FRAGMENTS	0x0002
+
+/**
+ * @def PROTOCOL_BATCH_ENTRY_SIZE
+ * Size of the header of a frame in a batch
+ */
+#define PROTOCOL_BATCH_ENTRY_SIZE	20
+
+/**
+ * Decoding errors
+ */
+#define PROTOCOL_ERROR_SIZE			-1	/**< Less than PROTOCOL_HEADER_SIZE bytes */
+#define PROTOCOL_ERROR_SYNC			-2	/**< No sync bytes */
+#define PROTOCOL_ERROR_VERSION		-3	/**< Unknown version or header size */
+#define PROTOCOL_ERROR_HEADER_CRC	-4	/**< Header corrupted */
+#define PROTOCOL_ERROR_FRAGMENT		-5	/**< Fragment outside of the message */
+#define PROTOCOL_ERROR_BATCH		-6	/**< Frame of a batch outside of the message */
+
+/**
+ * Stream of a packet
+ */
+typedef enum
+{
+	PROTOCOL_STREAM_RADAR = 1,
+	PROTOCOL_STREAM_CAMERA = 2,
+	PROTOCOL_STREAM_CONTROL = 3,		/**< Replies to the commands of the host */
+} protocol_stream_t;
+
+/**
+ * Format of the payload
+ */
+typedef enum
+{
+	PROTOCOL_FORMAT_RAW = 0,			/**< No dimensions */
+	PROTOCOL_FORMAT_RGB565 = 1,			/**< dims: width, height */
+	PROTOCOL_FORMAT_RADAR_U16 = 2,		/**< dims: samples per chirp, chirps, antennas (uint16_t samples) */
+	PROTOCOL_FORMAT_TIME_SYNC = 3,		/**< Token of the request (uint32_t), timestamp: time the request has been read */
+	PROTOCOL_FORMAT_JPEG = 4,			/**< dims: width, height (baseline JPEG file, the message size is the compressed size) */
+	PROTOCOL_FORMAT_RGB565_LOSSLESS = 5,	/**< dims: width, height (lossless_codec.h, the message size is the compressed size) */
+	PROTOCOL_FORMAT_RGB565_TILES = 6,	/**< dims: width, height, tile size (tiles changed since the last frame, tile_delta.h) */
+	PROTOCOL_FORMAT_RADAR_U12 = 7,		/**< dims: samples per chirp, chirps, antennas (12 bits samples packed by 2 in 3 bytes, pack12.h) */
+	PROTOCOL_FORMAT_RANGE_MAG_U16 = 8,	/**< dims: range bins, chirps, antennas (magnitude of the bins, uint16_t, range_fft.h) */
+	PROTOCOL_FORMAT_RANGE_MAG_F32 = 9,	/**< dims: range bins, chirps, antennas (magnitude of the bins, float) */
+	PROTOCOL_FORMAT_RANGE_COMPLEX_I16 = 10,	/**< dims: range bins, chirps, antennas (real and imaginary parts of the bins, int16_t) */
+	PROTOCOL_FORMAT_RANGE_COMPLEX_F32 = 11,	/**< dims: range bins, chirps, antennas (real and imaginary parts of the bins, float) */
+	PROTOCOL_FORMAT_RANGE_DOPPLER_U16 = 12,	/**< dims: Doppler bins, range bins, antennas (magnitude of the range-Doppler map, uint16_t, range_doppler.h) */
+	PROTOCOL_FORMAT_DETECTIONS = 13,		/**< dims: detections, range bins, Doppler bins (1: range profile) of the detector (list of detections, cfar.h) */
+	PROTOCOL_FORMAT_RADAR_BATCH = 14,	/**< dims: frames (radar frames of any other format, see protocol_batch_entry_t) */
+	PROTOCOL_FORMAT_RADAR_PROFILE = 15,	/**< dims: samples per chirp, chirps, antennas of the radar frames after the switch
+											 (status int32_t, 0: success, and switch time in us uint32_t) */
+	PROTOCOL_FORMAT_CAMERA_MODE = 16,	/**< dims: width, height, frame rate of the active camera mode (status int32_t, 0: success,
+											 reconfiguration time and time to the first frame in us, uint32_t) */
+	PROTOCOL_FORMAT_RGB555 = 17,		/**< dims: width, height */
+	PROTOCOL_FORMAT_COMMAND_ACK = 18,	/**< dims: 0 (acknowledgement of a command of the host, see command.h) */
+	PROTOCOL_FORMAT_TELEMETRY = 19,		/**< dims: counters per stream, histograms, buckets per histogram (statistics of the device, telemetry.h) */
+	PROTOCOL_FORMAT_TRACE = 20,			/**< dims: events, stages (events of the profiling probes, trace.h) */
+	PROTOCOL_FORMAT_RADAR_CHIRPS = 21,	/**< dims: samples per chirp, chirps, antennas of a block of chirps (frame number uint32_t,
+											 first chirp and chirps per frame uint16_t, then the uint16_t samples) */
+} protocol_format_t;
+
+/**
+ * Content of a header
+ */
+typedef struct
+{
+	uint8_t stream;				/**< protocol_stream_t */
+	uint8_t format;				/**< protocol_format_t */
+	uint16_t flags;				/**< PROTOCOL_FLAG_xxx */
+	uint32_t sequence;			/**< Sequence number of the message in its stream */
+	uint32_t payload_size;		/**< Size of the payload following the header */
+	uint64_t timestamp_us;		/**< Capture time of the message */
+	uint32_t message_size;		/**< Size of the whole message */
+	uint32_t fragment_offset;	/**< Offset of the payload inside the message */
+	uint16_t dims[3];			/**< Dimensions, see protocol_format_t */
+	uint16_t encode_cost;		/**< CPU cycles per pixel (sample) spent compressing (processing) the data (8.8 fixed point) */
+	uint32_t message_crc;		/**< crc32_compute() of the whole message */
+} protocol_header_t;
+
+/**
+ * Header of a frame in a batch
+ */
+typedef struct
+{
+	uint32_t size;				/**< Size of the payload of the frame */
+	uint32_t timestamp_offset_us;	/**< Capture time of the frame - capture time of the message */
+	uint16_t dims[3];			/**< Dimensions, see protocol_format_t */
+	uint16_t encode_cost;		/**< See protocol_header_t */
+	uint8_t format;				/**< protocol_format_t */
+} protocol_batch_entry_t;
+
+/**
+ * @brief Encode a header
+ *
+ * @param [in] header Content of the header
+ * @param [out] buffer Destination (PROTOCOL_HEADER_SIZE bytes)
+ *
+ * @retval PROTOCOL_HEADER_SIZE
+ */
+uint32_t protocol_encode_header(const protocol_header_t* header, uint8_t* buffer);
+
+/**
+ * @brief Decode and check a header
+ *
+ * @param [in] buffer Received bytes, starting with the header
+ * @param [in] size Number of bytes available
+ * @param [out] header Content of the header
+ *
+ * @retval 0 Success
+ * @retval PROTOCOL_ERROR_xxx The bytes are not a valid header
+ */
+int protocol_decode_header(const uint8_t* buffer, uint32_t size, protocol_header_t* header);
+
+/**
+ * @brief Encode the header of a frame in a batch
+ *
+ * @param [in] entry Content of the header
+ * @param [out] buffer Destination (PROTOCOL_BATCH_ENTRY_SIZE bytes)
+ *
+ * @retval PROTOCOL_BATCH_ENTRY_SIZE
+ */
+uint32_t protocol_encode_batch_entry(const protocol_batch_entry_t* entry, uint8_t* buffer);
+
+/**
+ * @brief Decode the header of a frame in a batch and check that its payload is in the batch
+ *
+ * @param [in] buffer Bytes of the batch, starting with the header of the frame
+ * @param [in] size Number of bytes of the batch from there
+ * @param [out] entry Content of the header
+ *
+ * @retval Size of the header and of the payload of the frame (offset of the next frame)
+ * @retval PROTOCOL_ERROR_BATCH Header or payload outside of the batch
+ */
+int32_t protocol_decode_batch_entry(const uint8_t* buffer, uint32_t size, protocol_batch_entry_t* entry);
+
+/**
+ * @brief Search the sync bytes of a header (to resynchronize after an error)
+ *
+ * @param [in] buffer Received bytes
+ * @param [in] size Number of bytes available
+ *
+ * @retval Offset of the first possible header start (size if none, size - 1 if the last byte could be one)
+ */
+uint32_t protocol_find_sync(const uint8_t* buffer, uint32_t size);
+
+#endif /* PROTOCOL_PROTOCOL_H_ */
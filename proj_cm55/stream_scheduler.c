@@ -0,0 +1,328 @@
+/*
+ * stream_scheduler.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "stream_scheduler.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "timestamp.h"
+
+/**
+ * Message queued in a stream
+ */
+typedef struct
+{
+	scheduler_message_t message;
+	uint32_t submit_time;		/**< timestamp_now() at submission */
+	uint32_t offset;			/**< Bytes handed to the USB */
+	uint32_t chunks;			/**< Chunks handed to the USB */
+	uint32_t in_flight;			/**< Chunks not completed yet */
+	int status;					/**< -1 if a chunk failed */
+	uint8_t stream;
+} scheduler_entry_t;
+
+/**
+ * Stream: configuration, queue of messages and counters
+ */
+typedef struct
+{
+	scheduler_stream_config_t config;
+	scheduler_entry_t queue[SCHEDULER_STREAM_QUEUE_DEPTH];
+	uint32_t head;				/**< Next message to submit */
+	uint32_t tail;				/**< Oldest message not completed */
+	uint32_t next;				/**< Message being split into chunks */
+	uint32_t deficit;			/**< Bytes the stream may send in this round */
+	scheduler_stream_stats_t stats;
+} scheduler_stream_t;
+
+static usbd_t* scheduler_usb = NULL;
+static scheduler_stream_t streams[SCHEDULER_MAX_STREAMS];
+static uint32_t num_streams = 0;
+static uint32_t in_flight = 0;
+static uint32_t round_robin = 0;
+
+/**
+ * @brief Check if the stream has bytes not handed to the USB yet
+ */
+static int scheduler_has_data(const scheduler_stream_t* stream)
+{
+	if (stream->next == stream->head)
+	{
+		return 0;
+	}
+
+	const scheduler_entry_t* entry = &stream->queue[stream->next % SCHEDULER_STREAM_QUEUE_DEPTH];
+
+	// A message without payload still has its header to send
+	return (entry->offset < entry->message.size) || (entry->chunks == 0);
+}
+
+/**
+ * @brief Size of the next chunk of the stream
+ */
+static uint32_t scheduler_next_chunk_size(const scheduler_stream_t* stream)
+{
+	const scheduler_entry_t* entry = &stream->queue[stream->next % SCHEDULER_STREAM_QUEUE_DEPTH];
+	uint32_t remaining = entry->message.size - entry->offset;
+
+	if ((stream->config.chunk_size != 0) && (remaining > stream->config.chunk_size))
+	{
+		return stream->config.chunk_size;
+	}
+
+	return remaining;
+}
+
+/**
+ * @brief Select the stream sending the next chunk
+ * Strict priority, then deficit round robin between the streams of the same priority
+ *
+ * @retval Stream index, -1 if no stream has data
+ */
+static int scheduler_pick(void)
+{
+	int priority = -1;
+	uint32_t i;
+
+	for (i = 0; i < num_streams; ++i)
+	{
+		if (scheduler_has_data(&streams[i])
+				&& ((priority < 0) || (streams[i].config.priority < priority)))
+		{
+			priority = streams[i].config.priority;
+		}
+	}
+
+	if (priority < 0)
+	{
+		return -1;
+	}
+
+	// Terminates: the deficit of a candidate grows at each visit
+	for (;;)
+	{
+		scheduler_stream_t* stream = &streams[round_robin];
+
+		if (scheduler_has_data(stream) && (stream->config.priority == priority))
+		{
+			uint32_t size = scheduler_next_chunk_size(stream);
+
+			if (stream->deficit >= size)
+			{
+				stream->deficit -= size;
+				return (int)round_robin;
+			}
+
+			stream->deficit += (uint32_t)stream->config.weight * SCHEDULER_QUANTUM;
+		}
+
+		round_robin = (round_robin + 1) % num_streams;
+	}
+}
+
+/**
+ * @brief Completion of a chunk (called by the USB transmit queue)
+ */
+static void scheduler_chunk_done(void* context, int status)
+{
+	scheduler_entry_t* entry = (scheduler_entry_t*)context;
+	scheduler_stream_t* stream = &streams[entry->stream];
+
+	in_flight--;
+	entry->in_flight--;
+	if (status != 0)
+	{
+		entry->status = -1;
+	}
+
+	// The USB sends in order: the chunks (and messages) of a stream complete in order
+	while (stream->tail != stream->next)
+	{
+		entry = &stream->queue[stream->tail % SCHEDULER_STREAM_QUEUE_DEPTH];
+		if (entry->in_flight != 0)
+		{
+			break;
+		}
+
+		if (entry->status == 0)
+		{
+			uint32_t latency = timestamp_cycles_to_us(timestamp_now() - entry->submit_time);
+
+			stream->stats.messages++;
+			stream->stats.last_latency_us = latency;
+			telemetry_histogram_add(&stream->stats.latency, latency);
+			if (latency > stream->stats.max_latency_us)
+			{
+				stream->stats.max_latency_us = latency;
+			}
+
+			if (stream->config.latency_bound_us != 0)
+			{
+				if (latency <= stream->config.latency_bound_us)
+				{
+					stream->stats.bound_met++;
+				}
+				else
+				{
+					stream->stats.bound_missed++;
+				}
+			}
+		}
+		else
+		{
+			stream->stats.failed++;
+		}
+
+		scheduler_callback_t callback = entry->message.callback;
+		void* callback_context = entry->message.context;
+		int message_status = entry->status;
+
+		stream->tail++;
+
+		if (callback != NULL)
+		{
+			callback(callback_context, message_status);
+		}
+	}
+}
+
+void scheduler_init(usbd_t* usb)
+{
+	scheduler_usb = usb;
+	memset(streams, 0, sizeof(streams));
+	num_streams = 0;
+	in_flight = 0;
+	round_robin = 0;
+}
+
+int scheduler_add_stream(const scheduler_stream_config_t* config)
+{
+	if (num_streams >= SCHEDULER_MAX_STREAMS)
+	{
+		return -1;
+	}
+
+	scheduler_stream_t* stream = &streams[num_streams];
+	memset(stream, 0, sizeof(scheduler_stream_t));
+	stream->config = *config;
+	if (stream->config.weight == 0)
+	{
+		stream->config.weight = 1;
+	}
+
+	return (int)num_streams++;
+}
+
+int scheduler_submit(int stream_id, const scheduler_message_t* message)
+{
+	scheduler_stream_t* stream = &streams[stream_id];
+
+	if ((stream->head - stream->tail) >= SCHEDULER_STREAM_QUEUE_DEPTH)
+	{
+		stream->stats.rejected++;
+		return -1;
+	}
+
+	scheduler_entry_t* entry = &stream->queue[stream->head % SCHEDULER_STREAM_QUEUE_DEPTH];
+	entry->message = *message;
+	entry->submit_time = timestamp_now();
+	entry->offset = 0;
+	entry->chunks = 0;
+	entry->in_flight = 0;
+	entry->status = 0;
+	entry->stream = (uint8_t)stream_id;
+
+	stream->head++;
+
+	return 0;
+}
+
+uint32_t scheduler_free_slots(int stream_id)
+{
+	const scheduler_stream_t* stream = &streams[stream_id];
+
+	return SCHEDULER_STREAM_QUEUE_DEPTH - (stream->head - stream->tail);
+}
+
+void scheduler_poll(void)
+{
+	uint8_t header[PROTOCOL_HEADER_SIZE];
+	protocol_header_t chunk_header;
+
+	// Completion of the chunks sent (ended by usbd_tx_poll)
+	usbd_tx_dispatch(scheduler_usb);
+
+	while ((in_flight < SCHEDULER_MAX_IN_FLIGHT) && (usbd_tx_free_slots(scheduler_usb) > 0))
+	{
+		int stream_id = scheduler_pick();
+		if (stream_id < 0)
+		{
+			break;
+		}
+
+		scheduler_stream_t* stream = &streams[stream_id];
+		scheduler_entry_t* entry = &stream->queue[stream->next % SCHEDULER_STREAM_QUEUE_DEPTH];
+		uint32_t size = scheduler_next_chunk_size(stream);
+		uint32_t offset = entry->offset;
+		uint32_t header_size = 0;
+
+		// Message split into chunks: each chunk is a fragment
+		chunk_header = entry->message.header;
+		chunk_header.payload_size = size;
+		chunk_header.message_size = entry->message.size;
+		chunk_header.fragment_offset = offset;
+		chunk_header.flags = 0;
+		if (size != entry->message.size)
+		{
+			chunk_header.flags |= PROTOCOL_FLAG_FRAGMENT;
+			if ((offset + size) < entry->message.size)
+			{
+				chunk_header.flags |= PROTOCOL_FLAG_MORE_FRAGMENTS;
+			}
+		}
+		header_size = protocol_encode_header(&chunk_header, header);
+
+		entry->offset += size;
+		entry->chunks++;
+		entry->in_flight++;
+		in_flight++;
+		stream->stats.chunks++;
+
+		// Whole message handed to the USB: the next chunk of the stream is taken from the next message
+		if (entry->offset >= entry->message.size)
+		{
+			stream->next++;
+		}
+
+		// Stream without data left: no credit kept for the next round
+		if (!scheduler_has_data(stream))
+		{
+			stream->deficit = 0;
+		}
+
+		if (usbd_tx_submit(scheduler_usb, header, header_size,
+				(entry->message.payload != NULL) ? &entry->message.payload[offset] : NULL, size,
+				scheduler_chunk_done, entry) != 0)
+		{
+			// Device not configured: the chunk fails right away
+			scheduler_chunk_done(entry, -1);
+		}
+	}
+}
+
+void scheduler_get_stats(int stream_id, scheduler_stream_stats_t* stats)
+{
+	*stats = streams[stream_id].stats;
+}
@@ -0,0 +1,163 @@
+/*
+ * stream_scheduler.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#ifndef STREAM_SCHEDULER_H_
+#define STREAM_SCHEDULER_H_
+
+#include <stdint.h>
+
+#include "driver/usbd/usbd.h"
+#include "protocol/protocol.h"
+#include "telemetry.h"
+
+/**
+ * @def SCHEDULER_MAX_STREAMS
+ * Maximum number of streams
+ */
+#ifndef SCHEDULER_MAX_STREAMS
+#define SCHEDULER_MAX_STREAMS			4
+#endif
+
+/**
+ * @def SCHEDULER_STREAM_QUEUE_DEPTH
+ * Maximum number of messages queued per stream
+ */
+#ifndef SCHEDULER_STREAM_QUEUE_DEPTH
+#define SCHEDULER_STREAM_QUEUE_DEPTH	4
+#endif
+
+/**
+ * @def SCHEDULER_MAX_IN_FLIGHT
+ * Maximum number of chunks handed to the USB transmit queue
+ * 2: one chunk is sent while the next one waits, the USB never idles between
+ * two chunks and a message of a higher priority waits for at most 2 chunks
+ */
+#ifndef SCHEDULER_MAX_IN_FLIGHT
+#define SCHEDULER_MAX_IN_FLIGHT			2
+#endif
+
+/**
+ * @def SCHEDULER_QUANTUM
+ * Number of bytes credited per unit of weight and per round, used to share
+ * the bandwidth between the streams of the same priority (deficit round robin)
+ */
+#ifndef SCHEDULER_QUANTUM
+#define SCHEDULER_QUANTUM				4096u
+#endif
+
+/**
+ * Called once a message has been sent (status 0) or has failed (status -1)
+ * The payload can be reused from there
+ */
+typedef void (*scheduler_callback_t)(void* context, int status);
+
+/**
+ * Message submitted to a stream
+ */
+typedef struct
+{
+	const uint8_t* payload;		/**< Sent in place, must stay unchanged until the callback */
+	uint32_t size;				/**< Size of the payload */
+	protocol_header_t header;	/**< Stream, format, sequence, timestamp, dimensions and CRC of the message
+									 The size, fragment and flags fields are set per chunk */
+	scheduler_callback_t callback;	/**< Called once the message is sent (can be NULL) */
+	void* context;				/**< Passed to the callback */
+} scheduler_message_t;
+
+/**
+ * Configuration of a stream
+ */
+typedef struct
+{
+	uint8_t priority;			/**< 0 is the highest priority, strict between priorities */
+	uint16_t weight;			/**< Bandwidth share between the streams of the same priority */
+	uint32_t chunk_size;		/**< Maximum payload bytes per USB transfer, 0: never split */
+	uint32_t latency_bound_us;	/**< Submission to completion, 0: no bound */
+} scheduler_stream_config_t;
+
+/**
+ * Counters of a stream
+ */
+typedef struct
+{
+	uint32_t messages;			/**< Messages sent */
+	uint32_t failed;			/**< Messages failed (USB) */
+	uint32_t rejected;			/**< scheduler_submit calls refused (queue full) */
+	uint32_t chunks;			/**< USB transfers */
+	uint32_t bound_met;			/**< Messages sent within the latency bound */
+	uint32_t bound_missed;		/**< Messages sent after the latency bound */
+	uint32_t last_latency_us;
+	uint32_t max_latency_us;
+	telemetry_histogram_t latency;	/**< Submission to completion of the messages (us) */
+} scheduler_stream_stats_t;
+
+/**
+ * @brief Initialize the scheduler, all streams are removed
+ * Each chunk is sent with a protocol v2 header, a message sent in several
+ * chunks is marked as fragments (PROTOCOL_FLAG_FRAGMENT)
+ *
+ * @param [in] usb USB instance used to send the chunks
+ */
+void scheduler_init(usbd_t* usb);
+
+/**
+ * @brief Add a stream
+ *
+ * @param [in] config Configuration of the stream
+ *
+ * @retval Stream identifier, -1 if SCHEDULER_MAX_STREAMS streams already exist
+ */
+int scheduler_add_stream(const scheduler_stream_config_t* config);
+
+/**
+ * @brief Queue a message, it is sent by scheduler_poll
+ *
+ * @param [in] stream Stream identifier
+ * @param [in] message Message (copied)
+ *
+ * @retval 0 Success
+ * @retval -1 Queue of the stream full (the callback will not be called)
+ */
+int scheduler_submit(int stream, const scheduler_message_t* message);
+
+/**
+ * @brief Number of messages that can be submitted to a stream before its queue is full
+ *
+ * @param [in] stream Stream identifier
+ *
+ * @retval Number of free slots
+ */
+uint32_t scheduler_free_slots(int stream);
+
+/**
+ * @brief Hand the next chunks to the USB, never blocks
+ * Must be called periodically (e.g. in the main loop). The callbacks are called from this function.
+ * The chunks are sent by usbd_tx_poll, called apart (main loop, or USB task without the lock
+ * of the application).
+ *
+ * The chunk to send is taken from the stream of highest priority having data,
+ * the streams of the same priority share the bandwidth according to their weight.
+ * A message is only preempted between two of its chunks.
+ */
+void scheduler_poll(void);
+
+/**
+ * @brief Get the counters of a stream
+ *
+ * @param [in] stream Stream identifier
+ * @param [out] stats Counters
+ */
+void scheduler_get_stats(int stream, scheduler_stream_stats_t* stats);
+
+#endif /* STREAM_SCHEDULER_H_ */
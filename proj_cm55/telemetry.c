@@ -0,0 +1,119 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "telemetry.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Bucket of a value: number of significant bits, at most TELEMETRY_BUCKETS - 1
+ */
+static uint32_t _telemetry_bucket(uint32_t value)
+{
+	uint32_t bucket = 0;
+
+#if defined(__GNUC__) || defined(__clang__)
+	// One CLZ instruction on the Cortex-M
+	bucket = (value == 0) ? 0 : (32u - (uint32_t)__builtin_clz(value));
+#else
+	while (value != 0)
+	{
+		bucket++;
+		value >>= 1;
+	}
+#endif
+
+	return (bucket < TELEMETRY_BUCKETS) ? bucket : (TELEMETRY_BUCKETS - 1);
+}
+
+static void _put_u32(uint8_t* buffer, uint32_t value)
+{
+	buffer[0] = (uint8_t)value;
+	buffer[1] = (uint8_t)(value >> 8);
+	buffer[2] = (uint8_t)(value >> 16);
+	buffer[3] = (uint8_t)(value >> 24);
+}
+
+void telemetry_histogram_add(telemetry_histogram_t* histogram, uint32_t value)
+{
+	histogram->buckets[_telemetry_bucket(value)]++;
+	histogram->count++;
+	if (value > histogram->max)
+	{
+		histogram->max = value;
+	}
+}
+
+uint32_t telemetry_histogram_percentile(const telemetry_histogram_t* histogram, uint32_t percent)
+{
+	uint64_t target = ((uint64_t)histogram->count * percent + 99u) / 100u;
+	uint64_t sum = 0;
+
+	if (histogram->count == 0)
+	{
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < (TELEMETRY_BUCKETS - 1); ++i)
+	{
+		sum += histogram->buckets[i];
+		if (sum >= target)
+		{
+			// Largest value of the bucket, never above the maximum
+			uint32_t bound = (i == 0) ? 0 : ((1u << i) - 1u);
+			return (bound < histogram->max) ? bound : histogram->max;
+		}
+	}
+
+	return histogram->max;
+}
+
+void telemetry_histogram_print(const char* name, const telemetry_histogram_t* histogram)
+{
+	printf("%s: %lu, median <= %lu us, 99%% <= %lu us, max %lu us \r\n", name,
+			(unsigned long)histogram->count,
+			(unsigned long)telemetry_histogram_percentile(histogram, 50),
+			(unsigned long)telemetry_histogram_percentile(histogram, 99),
+			(unsigned long)histogram->max);
+}
+
+uint32_t telemetry_encode(const telemetry_report_t* report, uint8_t* buffer)
+{
+	uint32_t offset = 0;
+
+	for (uint32_t s = 0; s < TELEMETRY_STREAM_COUNT; ++s)
+	{
+		for (uint32_t c = 0; c < TELEMETRY_COUNTER_COUNT; ++c)
+		{
+			_put_u32(&buffer[offset], report->counters[s][c]);
+			offset += 4;
+		}
+	}
+
+	for (uint32_t h = 0; h < TELEMETRY_HISTOGRAM_COUNT; ++h)
+	{
+		const telemetry_histogram_t* histogram = &report->histograms[h];
+
+		_put_u32(&buffer[offset], histogram->count);
+		_put_u32(&buffer[offset + 4], histogram->max);
+		offset += 8;
+		for (uint32_t b = 0; b < TELEMETRY_BUCKETS; ++b)
+		{
+			_put_u32(&buffer[offset], histogram->buckets[b]);
+			offset += 4;
+		}
+	}
+
+	return offset;
+}
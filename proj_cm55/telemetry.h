@@ -0,0 +1,144 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Runtime statistics: counters of the frames of each stream (captured, sent,
+ * skipped, dropped and why) and histograms of durations in log2 buckets.
+ * The events are counted where they happen (an increment, or a count leading
+ * zeros and two increments for a histogram) and the report is sent in-band
+ * on the control stream (PROTOCOL_FORMAT_TELEMETRY).
+ *
+ * Report (TELEMETRY_REPORT_SIZE bytes, uint32_t little endian), counted since the device started:
+ * - TELEMETRY_COUNTER_COUNT counters of each stream (camera then radar, telemetry_counter_t)
+ * - TELEMETRY_HISTOGRAM_COUNT histograms (telemetry_histogram_id_t): number of values, maximum
+ *   and TELEMETRY_BUCKETS buckets each
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+
+/**
+ * @def TELEMETRY_BUCKETS
+ * Buckets of a histogram: bucket 0 counts the values 0, bucket b the values
+ * from 2^(b-1) to 2^b - 1, the last bucket all the values from 2^(TELEMETRY_BUCKETS - 2)
+ */
+#define TELEMETRY_BUCKETS			16
+
+/**
+ * Streams counted
+ */
+typedef enum
+{
+	TELEMETRY_STREAM_CAMERA = 0,
+	TELEMETRY_STREAM_RADAR = 1,
+	TELEMETRY_STREAM_COUNT
+} telemetry_stream_t;
+
+/**
+ * Counters of a stream, in frames
+ */
+typedef enum
+{
+	TELEMETRY_CAPTURED = 0,			/**< Frames captured by the sensor */
+	TELEMETRY_SENT,					/**< Frames sent to the host */
+	TELEMETRY_SKIPPED,				/**< Frames not sent on purpose (camera: motion gating) */
+	TELEMETRY_DROP_RING,			/**< Dropped at the buffer handoff: no free buffer (camera ring) */
+	TELEMETRY_DROP_CRC_LATE,		/**< Dropped: checksum of the frame not done in time (camera) */
+	TELEMETRY_DROP_LINES,			/**< Dropped: unexpected number of lines (camera HREF count) */
+	TELEMETRY_DROP_OVERRUN,			/**< Next frame captured before this one has been read (radar FIFO overrun) */
+	TELEMETRY_DROP_FIFO,			/**< Dropped: cannot be read from the sensor (radar FIFO or SPI error) */
+	TELEMETRY_DROP_IDLE,			/**< Dropped: captured while not streaming */
+	TELEMETRY_DROP_USB,				/**< Dropped: USB transfer failed or queue full */
+	TELEMETRY_COUNTER_COUNT
+} telemetry_counter_t;
+
+/**
+ * Histograms of the report
+ */
+typedef enum
+{
+	TELEMETRY_HISTOGRAM_USB = 0,		/**< USB transfers, submission to completion (us) */
+	TELEMETRY_HISTOGRAM_CAMERA,			/**< Camera messages, submission to completion (us) */
+	TELEMETRY_HISTOGRAM_RADAR,			/**< Radar messages, submission to completion (us) */
+	TELEMETRY_HISTOGRAM_CAMERA_CRC,		/**< Checksum of a camera frame (us) */
+	TELEMETRY_HISTOGRAM_RADAR_READ,		/**< Readout of a radar frame, start until in memory (us) */
+	TELEMETRY_HISTOGRAM_RADAR_READ_CPU,	/**< CPU time of the readout of a radar frame (us) */
+	TELEMETRY_HISTOGRAM_IO_OFFLOAD,		/**< CRC of a message by the CM33, request posted until done (us) */
+	TELEMETRY_HISTOGRAM_COUNT
+} telemetry_histogram_id_t;
+
+/**
+ * Histogram of durations
+ */
+typedef struct
+{
+	uint32_t count;							/**< Values added */
+	uint32_t max;
+	uint32_t buckets[TELEMETRY_BUCKETS];
+} telemetry_histogram_t;
+
+/**
+ * Content of the report
+ */
+typedef struct
+{
+	uint32_t counters[TELEMETRY_STREAM_COUNT][TELEMETRY_COUNTER_COUNT];
+	telemetry_histogram_t histograms[TELEMETRY_HISTOGRAM_COUNT];
+} telemetry_report_t;
+
+/**
+ * @def TELEMETRY_REPORT_SIZE
+ * Size of an encoded report
+ */
+#define TELEMETRY_REPORT_SIZE		(4 * ((TELEMETRY_STREAM_COUNT * TELEMETRY_COUNTER_COUNT) \
+										+ (TELEMETRY_HISTOGRAM_COUNT * (2 + TELEMETRY_BUCKETS))))
+
+/**
+ * @brief Add a value to a histogram
+ * Can be called from an interrupt (not for the same histogram as the main loop)
+ *
+ * @param [in,out] histogram Histogram
+ * @param [in] value Value
+ */
+void telemetry_histogram_add(telemetry_histogram_t* histogram, uint32_t value);
+
+/**
+ * @brief Upper bound of a percentile of a histogram
+ *
+ * @param [in] histogram Histogram
+ * @param [in] percent 1 to 100
+ *
+ * @retval Bound below which at least percent % of the values are (the maximum for the last bucket), 0 if empty
+ */
+uint32_t telemetry_histogram_percentile(const telemetry_histogram_t* histogram, uint32_t percent);
+
+/**
+ * @brief Print the number of values, median, 99th percentile and maximum of a histogram
+ *
+ * @param [in] name Name of the histogram
+ * @param [in] histogram Histogram
+ */
+void telemetry_histogram_print(const char* name, const telemetry_histogram_t* histogram);
+
+/**
+ * @brief Encode a report
+ *
+ * @param [in] report Report
+ * @param [out] buffer Destination (TELEMETRY_REPORT_SIZE bytes)
+ *
+ * @retval TELEMETRY_REPORT_SIZE
+ */
+uint32_t telemetry_encode(const telemetry_report_t* report, uint8_t* buffer);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,80 @@
+/*
+ * timestamp.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "timestamp.h"
+
+#include "cybsp.h"
+
+/**
+ * Extension of the cycle counter to 64 bits
+ */
+static uint32_t timestamp_last = 0;
+static uint32_t timestamp_high = 0;
+
+void timestamp_init(void)
+{
+	// Enable the trace unit (needed by the DWT), then the cycle counter
+#if defined(DCB)
+	DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+#else
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#endif
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	timestamp_last = 0;
+	timestamp_high = 0;
+}
+
+uint32_t timestamp_now(void)
+{
+	return DWT->CYCCNT;
+}
+
+uint64_t timestamp_now_us(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint64_t cycles;
+	uint32_t cycles_per_us = SystemCoreClock / 1000000u;
+
+	// Can be called from the interrupts as well
+	__disable_irq();
+	uint32_t now = DWT->CYCCNT;
+	if (now < timestamp_last)
+	{
+		timestamp_high++;
+	}
+	timestamp_last = now;
+	cycles = ((uint64_t)timestamp_high << 32) | now;
+	__set_PRIMASK(primask);
+
+	if (cycles_per_us == 0)
+	{
+		return cycles;
+	}
+
+	return cycles / cycles_per_us;
+}
+
+uint32_t timestamp_cycles_to_us(uint32_t cycles)
+{
+	uint32_t cycles_per_us = SystemCoreClock / 1000000u;
+
+	if (cycles_per_us == 0)
+	{
+		return cycles;
+	}
+
+	return cycles / cycles_per_us;
+}
@@ -0,0 +1,52 @@
+/*
+ * timestamp.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Start the cycle counter of the core (DWT CYCCNT)
+ * Must be called once before timestamp_now
+ */
+void timestamp_init(void);
+
+/**
+ * @brief Get the current value of the cycle counter
+ * Can be called from an interrupt. Wraps around after 2^32 cycles.
+ *
+ * @retval Number of CPU cycles
+ */
+uint32_t timestamp_now(void);
+
+/**
+ * @brief Get the time since timestamp_init in microseconds (64-bit, does not wrap)
+ * The cycle counter is extended by software: must be called at least once
+ * per wrap around of the cycle counter (2^32 cycles, about 10 s at 400 MHz)
+ *
+ * @retval Time in microseconds
+ */
+uint64_t timestamp_now_us(void);
+
+/**
+ * @brief Convert a number of cycles (e.g. difference of two timestamps) to microseconds
+ *
+ * @param [in] cycles Number of CPU cycles
+ *
+ * @retval Duration in microseconds
+ */
+uint32_t timestamp_cycles_to_us(uint32_t cycles);
+
+#endif /* TIMESTAMP_H_ */
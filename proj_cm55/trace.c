@@ -0,0 +1,138 @@
+/*
+ * trace.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ */
+
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+#include <stdbool.h>
+
+#include "cybsp.h"
+#include "timestamp.h"
+
+#if (TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) != 0
+#error "TRACE_RING_SIZE must be a power of two"
+#endif
+
+/**
+ * Event of the ring
+ */
+typedef struct
+{
+	uint32_t cycles;
+	uint32_t info;				/**< Stage, type and argument, as dumped */
+	uint32_t commit;			/**< Number of the event + 1 once written */
+} trace_event_t;
+
+static trace_event_t trace_ring[TRACE_RING_SIZE];
+static volatile uint32_t trace_head = 0;	/**< Events recorded since trace_start */
+static volatile bool trace_running = false;
+
+static void _put_u32(uint8_t* buffer, uint32_t value)
+{
+	buffer[0] = (uint8_t)value;
+	buffer[1] = (uint8_t)(value >> 8);
+	buffer[2] = (uint8_t)(value >> 16);
+	buffer[3] = (uint8_t)(value >> 24);
+}
+
+void trace_start(void)
+{
+	trace_running = false;
+	for (uint32_t i = 0; i < TRACE_RING_SIZE; ++i)
+	{
+		trace_ring[i].commit = 0;
+	}
+	trace_head = 0;
+	__DMB();
+	trace_running = true;
+}
+
+void trace_stop(void)
+{
+	trace_running = false;
+}
+
+void trace_record(uint8_t stage, uint8_t type, uint16_t arg)
+{
+	uint32_t index;
+	uint32_t cycles;
+	trace_event_t* event;
+
+	if (!trace_running)
+	{
+		return;
+	}
+
+	// The time is read with the slot reserved: an interrupt in between makes
+	// the store fail, the events are in the order of their time
+	do
+	{
+		index = __LDREXW(&trace_head);
+		cycles = timestamp_now();
+	} while (__STREXW(index + 1u, &trace_head) != 0u);
+
+	event = &trace_ring[index & (TRACE_RING_SIZE - 1u)];
+	event->cycles = cycles;
+	event->info = (uint32_t)stage | ((uint32_t)type << 8) | ((uint32_t)arg << 16);
+
+	// The event must be visible before it is marked as written
+	__DMB();
+	event->commit = index + 1u;
+}
+
+uint32_t trace_dump(uint8_t* buffer)
+{
+	// The time after the last event dumped
+	uint32_t head = trace_head;
+	uint32_t now = timestamp_now();
+	uint32_t first = (head > TRACE_RING_SIZE) ? (head - TRACE_RING_SIZE) : 0;
+	uint32_t count = 0;
+	uint8_t* output = &buffer[TRACE_DUMP_HEADER_SIZE];
+
+	for (uint32_t index = first; index != head; ++index)
+	{
+		const trace_event_t* event = &trace_ring[index & (TRACE_RING_SIZE - 1u)];
+		uint32_t cycles;
+		uint32_t info;
+
+		if (event->commit != (index + 1u))
+		{
+			continue;
+		}
+		cycles = event->cycles;
+		info = event->info;
+
+		// Overwritten while being copied?
+		__DMB();
+		if (event->commit != (index + 1u))
+		{
+			continue;
+		}
+
+		_put_u32(output, cycles);
+		_put_u32(&output[4], info);
+		output += TRACE_EVENT_SIZE;
+		count++;
+	}
+
+	_put_u32(buffer, SystemCoreClock / 1000000u);
+	_put_u32(&buffer[4], now);
+	_put_u32(&buffer[8], head);
+	_put_u32(&buffer[12], count);
+
+	return TRACE_DUMP_HEADER_SIZE + (count * TRACE_EVENT_SIZE);
+}
+
+#endif /* TRACE_ENABLED */
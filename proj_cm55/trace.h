@@ -0,0 +1,146 @@
+/*
+ * trace.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Profiling probes: the start and the end of the stages of the main loop and
+ * of the interrupts are recorded with the cycle counter (DWT CYCCNT) into a
+ * ring of events. The ring is filled from any context without lock (the slot
+ * is reserved with LDREX/STREX) and keeps the last TRACE_RING_SIZE events.
+ *
+ * The probes only exist if the project is built with TRACE_ENABLED=1
+ * (DEFINES of the Makefile): otherwise the TRACE_xxx macros are empty and
+ * this module is not compiled, the probes cost nothing.
+ *
+ * Dump (PROTOCOL_FORMAT_TRACE, all fields uint32_t little endian):
+ * - cycles per microsecond, cycle counter at the time of the dump (the timestamp
+ *   of the message is taken right before), events recorded since the start, events in the dump
+ * - events, oldest first: cycle counter, then stage (trace_stage_t, bits 0..7),
+ *   type (trace_type_t, bits 8..15) and argument (bits 16..31)
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+
+/**
+ * @def TRACE_ENABLED
+ * 1: probes compiled in
+ */
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED				0
+#endif
+
+/**
+ * @def TRACE_RING_SIZE
+ * Events kept (power of two)
+ */
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE				1024
+#endif
+
+/**
+ * @def TRACE_DUMP_HEADER_SIZE
+ * Size of the header of a dump
+ */
+#define TRACE_DUMP_HEADER_SIZE		16
+
+/**
+ * @def TRACE_EVENT_SIZE
+ * Size of an event in a dump
+ */
+#define TRACE_EVENT_SIZE			8
+
+/**
+ * @def TRACE_DUMP_SIZE
+ * Maximum size of a dump
+ */
+#define TRACE_DUMP_SIZE				(TRACE_DUMP_HEADER_SIZE + (TRACE_RING_SIZE * TRACE_EVENT_SIZE))
+
+/**
+ * Stages traced
+ */
+typedef enum
+{
+	TRACE_STAGE_SCHEDULER = 0,			/**< scheduler_poll: USB transfers progress, completion callbacks */
+	TRACE_STAGE_COMMANDS,				/**< Reception, parsing and handling of the commands */
+	TRACE_STAGE_CAMERA_FRAME,			/**< Camera frame acquired until submitted or released (argument: sequence) */
+	TRACE_STAGE_CAMERA_MOTION,			/**< Motion gating: changed tiles detection and delta encoding */
+	TRACE_STAGE_CAMERA_COPY,			/**< Copy of a keyframe into the motion reference */
+	TRACE_STAGE_CAMERA_ENCODE,			/**< Compression of a camera frame */
+	TRACE_STAGE_CRC,					/**< crc32_compute of a message */
+	TRACE_STAGE_SUBMIT,					/**< scheduler_submit of a data message */
+	TRACE_STAGE_RADAR_READ,				/**< Readout of a radar frame, radar_read_start until radar_read_poll is done (argument: sequence) */
+	TRACE_STAGE_RADAR_PROCESS,			/**< Packing or range processing of a radar frame */
+	TRACE_STAGE_USB_TRANSFER,			/**< USB transfer, first segment started until completed (argument: queue index) */
+	TRACE_STAGE_ISR_VSYNC,				/**< Camera interrupt, VSYNC (mark, argument: sequence) */
+	TRACE_STAGE_ISR_CAMERA_CRC,			/**< Camera deferred interrupt, frame closed by VSYNC (argument: sequence) */
+	TRACE_STAGE_ISR_RADAR,				/**< Radar data interrupt */
+	TRACE_STAGE_COUNT
+} trace_stage_t;
+
+/**
+ * Type of an event
+ */
+typedef enum
+{
+	TRACE_TYPE_BEGIN = 0,
+	TRACE_TYPE_END = 1,
+	TRACE_TYPE_MARK = 2					/**< Instant */
+} trace_type_t;
+
+#if TRACE_ENABLED
+
+#define TRACE_BEGIN(stage, arg)		trace_record((stage), TRACE_TYPE_BEGIN, (uint16_t)(arg))
+#define TRACE_END(stage)			trace_record((stage), TRACE_TYPE_END, 0)
+#define TRACE_MARK(stage, arg)		trace_record((stage), TRACE_TYPE_MARK, (uint16_t)(arg))
+
+/**
+ * @brief Clear the ring and start recording
+ * The cycle counter must be running (timestamp_init)
+ */
+void trace_start(void);
+
+/**
+ * @brief Stop recording, the events stay in the ring
+ */
+void trace_stop(void);
+
+/**
+ * @brief Record an event (use the TRACE_xxx macros)
+ * Can be called from any context, including the interrupts
+ *
+ * @param [in] stage Stage (trace_stage_t)
+ * @param [in] type Type (trace_type_t)
+ * @param [in] arg Argument of the stage
+ */
+void trace_record(uint8_t stage, uint8_t type, uint16_t arg);
+
+/**
+ * @brief Copy the events of the ring, recording goes on
+ * The events being written or overwritten during the copy are left out
+ *
+ * @param [out] buffer Destination (TRACE_DUMP_SIZE bytes)
+ *
+ * @retval Size of the dump
+ */
+uint32_t trace_dump(uint8_t* buffer);
+
+#else
+
+#define TRACE_BEGIN(stage, arg)		((void)0)
+#define TRACE_END(stage)			((void)0)
+#define TRACE_MARK(stage, arg)		((void)0)
+
+#endif /* TRACE_ENABLED */
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,152 @@
+/*
+ * host_test.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Helpers of the host tests: checks, pseudo-random data and timing.
+ * A test returns host_test_result() from main: 0 if every check passed.
+ * The benchmarks report bytes per cycle with the time stamp counter on x86
+ * (nanoseconds elsewhere, reported as cycles at 1 GHz).
+ */
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * Number of failed checks
+ */
+static int host_test_failures = 0;
+
+/**
+ * @def CHECK
+ * Count and print a failed condition, the test goes on
+ */
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			host_test_failures++; \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+/**
+ * @def CHECK_EQUAL
+ * Count and print a failed comparison of two integers
+ */
+#define CHECK_EQUAL(expected, actual) \
+	do \
+	{ \
+		long long host_expected = (long long)(expected); \
+		long long host_actual = (long long)(actual); \
+		if (host_expected != host_actual) \
+		{ \
+			host_test_failures++; \
+			printf("%s:%d: %s: expected %lld, got %lld\n", __FILE__, __LINE__, #actual, \
+					host_expected, host_actual); \
+		} \
+	} while (0)
+
+/**
+ * @brief Result of the test, printed
+ *
+ * @param [in] name Name of the test
+ *
+ * @retval 0 Every check passed
+ * @retval 1 At least one check failed
+ */
+static inline int host_test_result(const char* name)
+{
+	if (host_test_failures != 0)
+	{
+		printf("%s: %d check(s) failed\n", name, host_test_failures);
+		return 1;
+	}
+	printf("%s: passed\n", name);
+	return 0;
+}
+
+/**
+ * State of the pseudo-random generator (xorshift32), fixed seed: the runs are reproducible
+ */
+static uint32_t host_random_state = 0x2545F491u;
+
+/**
+ * @brief Next pseudo-random value
+ */
+static inline uint32_t host_random(void)
+{
+	uint32_t x = host_random_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	host_random_state = x;
+	return x;
+}
+
+/**
+ * @brief Fill a buffer with pseudo-random bytes
+ */
+static inline void host_random_fill(void* buffer, size_t size)
+{
+	uint8_t* bytes = (uint8_t*)buffer;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		bytes[i] = (uint8_t)host_random();
+	}
+}
+
+/**
+ * @brief Cycle counter of the host
+ */
+static inline uint64_t host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Iterations of a benchmark: the first argument of the test, else the default
+ * (the tests run by ctest use the default, short)
+ */
+static inline unsigned long host_iterations(int argc, char** argv, unsigned long default_count)
+{
+	if (argc > 1)
+	{
+		unsigned long count = strtoul(argv[1], NULL, 10);
+
+		if (count != 0)
+		{
+			return count;
+		}
+	}
+	return default_count;
+}
+
+#endif /* HOST_TEST_H_ */
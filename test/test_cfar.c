@@ -0,0 +1,424 @@
+/*
+ * test_cfar.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * CFAR detector (cfar.h) fed with range-Doppler maps: maps of simulated frames
+ * (range_doppler.h, targets and noise) or recorded maps. For every map, both modes
+ * and several configurations, the detections must be the ones of a reference
+ * implementation written from the description of cfar.h (same cells, SNR within
+ * 1/128 dB). The simulated targets must be found and the noise alone must give few
+ * detections. Then the configuration errors, the truncation of the list, the
+ * encoding and the cycles per cell of both modes.
+ *
+ * Arguments: iterations of the benchmark, then optionally recorded maps to replay
+ * (uint16_t magnitudes as sent with format 12, little endian, map after map),
+ * range bins and Doppler bins of the maps.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "dsp/cfar.h"
+#include "dsp/range_doppler.h"
+
+/**
+ * @def PI
+ * Pi in double precision
+ */
+#define PI				3.14159265358979323846
+
+/**
+ * @def SAMPLES
+ * Samples per chirp of the simulated frames
+ */
+#define SAMPLES			128
+
+/**
+ * @def CHIRPS
+ * Chirps of the simulated frames
+ */
+#define CHIRPS			64
+
+/**
+ * @def MAX_CELLS
+ * Largest map
+ */
+#define MAX_CELLS		(64 * 1024)
+
+/**
+ * @def MAX_DETECTIONS
+ * Size of the detection lists
+ */
+#define MAX_DETECTIONS	1024
+
+/**
+ * Simulated target
+ */
+typedef struct
+{
+	double range;		/**< Beat frequency, cycles per sample */
+	double velocity;	/**< Phase per chirp, cycles */
+	double amplitude;	/**< ADC codes */
+} target_t;
+
+static const target_t targets[] =
+{
+	{ 0.0625, 0.0, 600.0 },
+	{ 0.1875, 0.125, 300.0 },
+	{ 0.3125, -0.25, 150.0 },
+};
+
+static const cfar_config_t configs[] =
+{
+	{ CFAR_MODE_CA, 2, 8, 12, 0 },
+	{ CFAR_MODE_CA, 0, 1, 6, 0 },
+	{ CFAR_MODE_CA, 8, 16, 20, 0 },
+	{ CFAR_MODE_OS, 2, 8, 12, 0 },
+	{ CFAR_MODE_OS, 1, 4, 10, 3 },
+	{ CFAR_MODE_OS, 4, 16, 15, 32 },
+};
+
+static range_doppler_t rd;
+static uint16_t samples[SAMPLES * CHIRPS];
+static float work[SAMPLES * CHIRPS];
+static uint16_t map[MAX_CELLS];
+static cfar_detection_t detections[MAX_DETECTIONS];
+static cfar_detection_t expected[MAX_DETECTIONS];
+
+/**
+ * @brief Range-Doppler map of a simulated frame
+ *
+ * @param [in] with_targets 0: noise only
+ */
+static void simulate(int with_targets)
+{
+	for (uint32_t c = 0; c < CHIRPS; ++c)
+	{
+		for (uint32_t n = 0; n < SAMPLES; ++n)
+		{
+			double value = 2048.0 + (double)(host_random() % 65u) - 32.0;
+
+			for (size_t t = 0; with_targets && (t < sizeof(targets) / sizeof(targets[0])); ++t)
+			{
+				value += targets[t].amplitude * cos(2.0 * PI * ((targets[t].range * n) + (targets[t].velocity * c)));
+			}
+			samples[(c * SAMPLES) + n] = (uint16_t)lrint(value);
+		}
+	}
+
+	range_doppler_process(&rd, samples, work, sizeof(work), map, sizeof(map));
+}
+
+/**
+ * @brief Reference detector, from the description of cfar.h
+ */
+static uint32_t reference(const cfar_config_t* config, const uint16_t* cells, uint16_t rows, uint16_t columns,
+		cfar_detection_t* list, uint32_t max_detections)
+{
+	const uint32_t factor = (uint32_t)lrint(256.0 * pow(10.0, config->threshold_db / 20.0));
+	uint32_t found = 0;
+
+	for (uint32_t k = 0; k < rows; ++k)
+	{
+		for (uint32_t d = 0; d < columns; ++d)
+		{
+			uint32_t training[2 * CFAR_MAX_TRAINING];
+			uint32_t count = 0;
+			uint32_t cell = cells[(k * columns) + d];
+			double noise = 0;
+			int maximum = 1;
+
+			// Training cells inside the map, on both sides of the guard cells
+			for (int32_t r = (int32_t)k - config->guard - config->training; r <= (int32_t)k + config->guard + config->training; ++r)
+			{
+				if ((r >= 0) && (r < rows) && (abs(r - (int32_t)k) > config->guard))
+				{
+					training[count++] = cells[((uint32_t)r * columns) + d];
+				}
+			}
+			if (count == 0)
+			{
+				continue;
+			}
+
+			if (config->mode == CFAR_MODE_CA)
+			{
+				uint64_t sum = 0;
+
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					sum += training[i];
+				}
+				noise = (double)sum / count;
+			}
+			else
+			{
+				// Rank scaled to the cells available near the edges, 3/4 by default
+				uint32_t rank = (config->rank == 0) ? ((3u * count) / 4u)
+						: (((config->rank * count) + config->training) / (2u * config->training));
+
+				rank = (rank == 0) ? 1u : ((rank > count) ? count : rank);
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					for (uint32_t j = i + 1; j < count; ++j)
+					{
+						if (training[j] < training[i])
+						{
+							uint32_t swap = training[i];
+
+							training[i] = training[j];
+							training[j] = swap;
+						}
+					}
+				}
+				noise = training[rank - 1];
+			}
+
+			// Above the threshold (8.8 factor) and not below the neighbours
+			if ((256.0 * cell) <= (noise * factor))
+			{
+				continue;
+			}
+			maximum = !(((k > 0) && (cells[((k - 1) * columns) + d] > cell))
+					|| ((k + 1 < rows) && (cells[((k + 1) * columns) + d] > cell))
+					|| ((d > 0) && (cells[(k * columns) + d - 1] > cell))
+					|| ((d + 1 < columns) && (cells[(k * columns) + d + 1] > cell)));
+			if (!maximum)
+			{
+				continue;
+			}
+
+			if (found < max_detections)
+			{
+				double snr = (noise > 0) ? (256.0 * 20.0 * log10(cell / noise)) : 65535.0;
+
+				list[found].range_bin = (uint16_t)k;
+				list[found].doppler_bin = (columns > 1) ? (int16_t)((int32_t)d - (columns / 2)) : 0;
+				list[found].snr = (snr <= 0) ? 0 : ((snr >= 65535.0) ? UINT16_MAX : (uint16_t)lrint(snr));
+			}
+			found++;
+		}
+	}
+
+	return (found < max_detections) ? found : max_detections;
+}
+
+/**
+ * @brief Detections of every configuration against the reference
+ *
+ * @retval Detections of the first configuration
+ */
+static uint32_t compare(const uint16_t* cells, uint16_t rows, uint16_t columns)
+{
+	uint32_t first = 0;
+
+	for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); ++i)
+	{
+		cfar_t cfar;
+		int32_t count = 0;
+		uint32_t reference_count = 0;
+
+		CHECK_EQUAL(0, cfar_init(&cfar, &configs[i]));
+		count = cfar_detect(&cfar, cells, rows, columns, detections, MAX_DETECTIONS);
+		reference_count = reference(&configs[i], cells, rows, columns, expected, MAX_DETECTIONS);
+		CHECK_EQUAL(reference_count, count);
+		for (uint32_t j = 0; (j < reference_count) && ((int32_t)j < count); ++j)
+		{
+			CHECK_EQUAL(expected[j].range_bin, detections[j].range_bin);
+			CHECK_EQUAL(expected[j].doppler_bin, detections[j].doppler_bin);
+			CHECK(abs((int)expected[j].snr - (int)detections[j].snr) <= 2);
+		}
+		if (i == 0)
+		{
+			first = reference_count;
+		}
+	}
+
+	return first;
+}
+
+/**
+ * @brief Simulated maps and range profiles: reference, targets found, few false alarms
+ */
+static void test_simulated(void)
+{
+	const uint16_t rows = SAMPLES / 2;
+	uint32_t noise_detections = 0;
+
+	range_doppler_init(&rd, SAMPLES, CHIRPS);
+
+	for (int frame = 0; frame < 8; ++frame)
+	{
+		cfar_t cfar;
+		int32_t count = 0;
+		uint16_t profile[SAMPLES / 2];
+
+		simulate(1);
+		compare(map, rows, CHIRPS);
+
+		// Every target is found within a bin of its position
+		CHECK_EQUAL(0, cfar_init(&cfar, &configs[0]));
+		count = cfar_detect(&cfar, map, rows, CHIRPS, detections, MAX_DETECTIONS);
+		for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); ++t)
+		{
+			double range_bin = targets[t].range * SAMPLES;
+			double doppler_bin = targets[t].velocity * CHIRPS;
+			int seen = 0;
+
+			for (int32_t i = 0; i < count; ++i)
+			{
+				seen |= (fabs(detections[i].range_bin - range_bin) <= 1.0) && (fabs(detections[i].doppler_bin - doppler_bin) <= 1.0);
+			}
+			CHECK(seen);
+		}
+
+		// Range profile: mean of the Doppler bins
+		for (uint32_t k = 0; k < rows; ++k)
+		{
+			uint32_t sum = 0;
+
+			for (uint32_t d = 0; d < CHIRPS; ++d)
+			{
+				sum += map[(k * CHIRPS) + d];
+			}
+			profile[k] = (uint16_t)(sum / CHIRPS);
+		}
+		compare(profile, rows, 1);
+
+		simulate(0);
+		noise_detections += compare(map, rows, CHIRPS);
+	}
+
+	// 12 dB over the noise: a few cells of the 8 maps at most
+	printf("Noise only: %u detections in 8 maps of %u cells\n", (unsigned)noise_detections, (unsigned)(rows * CHIRPS));
+	CHECK(noise_detections <= 8u * 8u);
+}
+
+/**
+ * @brief Recorded maps against the reference
+ */
+static void test_recorded(const char* path, uint16_t rows, uint16_t columns)
+{
+	FILE* file = fopen(path, "rb");
+	uint32_t cells = (uint32_t)rows * columns;
+	uint32_t maps = 0;
+	uint8_t bytes[2];
+
+	CHECK((file != NULL) && (cells != 0) && (cells <= MAX_CELLS));
+	if ((file == NULL) || (cells == 0) || (cells > MAX_CELLS))
+	{
+		if (file != NULL)
+		{
+			fclose(file);
+		}
+		return;
+	}
+
+	for (;;)
+	{
+		uint32_t i = 0;
+
+		for (i = 0; (i < cells) && (fread(bytes, 1, 2, file) == 2); ++i)
+		{
+			map[i] = (uint16_t)(bytes[0] | (bytes[1] << 8));
+		}
+		if (i < cells)
+		{
+			break;
+		}
+		compare(map, rows, columns);
+		maps++;
+	}
+	fclose(file);
+
+	printf("Recorded: %u maps of %u x %u\n", (unsigned)maps, (unsigned)rows, (unsigned)columns);
+	CHECK(maps != 0);
+}
+
+/**
+ * @brief Configuration errors, truncation of the list and encoding
+ */
+static void test_errors_and_encoding(void)
+{
+	static const cfar_config_t invalid[] =
+	{
+		{ 2, 2, 8, 12, 0 },
+		{ CFAR_MODE_CA, CFAR_MAX_GUARD + 1, 8, 12, 0 },
+		{ CFAR_MODE_CA, 2, 0, 12, 0 },
+		{ CFAR_MODE_CA, 2, CFAR_MAX_TRAINING + 1, 12, 0 },
+		{ CFAR_MODE_CA, 2, 8, CFAR_MAX_THRESHOLD_DB + 1, 0 },
+		{ CFAR_MODE_OS, 2, 8, 12, 17 },
+	};
+	cfar_t cfar;
+	int32_t count = 0;
+	uint8_t encoded[2 * CFAR_DETECTION_SIZE];
+	cfar_detection_t pair[2] = { { 0x0102, -3, 0x0A0B }, { 700, 31, 0 } };
+	static const uint8_t expected_bytes[] = { 0x02, 0x01, 0xFD, 0xFF, 0x0B, 0x0A, 0xBC, 0x02, 0x1F, 0x00, 0x00, 0x00 };
+
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+	{
+		CHECK_EQUAL(CFAR_ERROR_PARAM, cfar_init(&cfar, &invalid[i]));
+	}
+
+	CHECK_EQUAL(0, cfar_init(&cfar, &configs[1]));
+	CHECK_EQUAL(CFAR_ERROR_PARAM, cfar_detect(&cfar, map, 0, CHIRPS, detections, MAX_DETECTIONS));
+	CHECK_EQUAL(CFAR_ERROR_PARAM, cfar_detect(&cfar, map, 64, 0, detections, MAX_DETECTIONS));
+	CHECK_EQUAL(CFAR_ERROR_PARAM, cfar_detect(&cfar, map, 2, CFAR_MAX_COLUMNS + 1, detections, MAX_DETECTIONS));
+
+	// The list is truncated to its size, first detections first
+	simulate(1);
+	count = cfar_detect(&cfar, map, SAMPLES / 2, CHIRPS, expected, MAX_DETECTIONS);
+	CHECK(count > 2);
+	CHECK_EQUAL(2, cfar_detect(&cfar, map, SAMPLES / 2, CHIRPS, detections, 2));
+	CHECK(memcmp(detections, expected, 2 * sizeof(cfar_detection_t)) == 0);
+
+	CHECK_EQUAL(sizeof(encoded), cfar_encode(pair, 2, encoded));
+	CHECK(memcmp(encoded, expected_bytes, sizeof(encoded)) == 0);
+}
+
+/**
+ * @brief Cycles per cell of both modes (best run)
+ */
+static void benchmark(unsigned long iterations)
+{
+	simulate(1);
+
+	for (size_t i = 0; i < 4; i += 3)
+	{
+		cfar_t cfar;
+		uint64_t best = UINT64_MAX;
+
+		cfar_init(&cfar, &configs[i]);
+		for (unsigned long j = 0; j < iterations; ++j)
+		{
+			uint64_t start = host_cycles();
+			uint64_t cycles = 0;
+
+			cfar_detect(&cfar, map, SAMPLES / 2, CHIRPS, detections, MAX_DETECTIONS);
+			cycles = host_cycles() - start;
+			best = (cycles < best) ? cycles : best;
+		}
+		printf("%s-CFAR (guard %u, training %u) of a %u x %u map: %.1f cycles/cell\n",
+				(configs[i].mode == CFAR_MODE_CA) ? "CA" : "OS", (unsigned)configs[i].guard,
+				(unsigned)configs[i].training, SAMPLES / 2, CHIRPS, (double)best / ((SAMPLES / 2) * CHIRPS));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 20);
+
+	test_simulated();
+	test_errors_and_encoding();
+	if (argc > 4)
+	{
+		test_recorded(argv[2], (uint16_t)strtoul(argv[3], NULL, 10), (uint16_t)strtoul(argv[4], NULL, 10));
+	}
+	benchmark(iterations);
+
+	return host_test_result("test_cfar");
+}
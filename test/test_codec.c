@@ -0,0 +1,354 @@
+/*
+ * test_codec.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Camera codecs: the lossless codec encodes and decodes back the exact pixels
+ * (smooth, noisy, flat and random frames, whole frame or line by line), rejects
+ * the small buffers and the corrupted data. The JPEG encoder writes a file that
+ * libjpeg decodes close to the frame (when built with libjpeg). Then the cycles
+ * per pixel of the lossless encoder and decoder and of the JPEG encoder.
+ * Argument: iterations of the benchmark.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "codec/jpeg_encoder.h"
+#include "codec/lossless_codec.h"
+
+#if HOST_TEST_LIBJPEG
+#include <jpeglib.h>
+#endif
+
+/**
+ * @def WIDTH
+ * QVGA frame
+ */
+#define WIDTH			320
+
+/**
+ * @def HEIGHT
+ * QVGA frame
+ */
+#define HEIGHT			240
+
+/**
+ * @def PIXELS
+ * Pixels of a frame
+ */
+#define PIXELS			(WIDTH * HEIGHT)
+
+/**
+ * @def OUTPUT_SIZE
+ * Worst case of the lossless codec, enough for the JPEG files as well
+ */
+#define OUTPUT_SIZE		(PIXELS * LOSSLESS_MAX_BYTES_PER_PIXEL)
+
+/**
+ * Content of a test frame
+ */
+typedef enum
+{
+	SCENE_SMOOTH,		/**< Gradients: small and medium residuals */
+	SCENE_NOISY,		/**< Gradients and sensor noise */
+	SCENE_FLAT,			/**< Uniform with a few objects: runs */
+	SCENE_RANDOM,		/**< Literals only (worst case) */
+	SCENE_COUNT
+} scene_t;
+
+static const char* const scene_names[SCENE_COUNT] = { "smooth", "noisy", "flat", "random" };
+
+static uint16_t image[PIXELS];
+static uint16_t decoded[PIXELS];
+static uint8_t output[OUTPUT_SIZE];
+
+/**
+ * @brief Pack 8 bits components in a RGB565 pixel
+ */
+static uint16_t rgb565(int r, int g, int b)
+{
+	r = (r < 0) ? 0 : ((r > 255) ? 255 : r);
+	g = (g < 0) ? 0 : ((g > 255) ? 255 : g);
+	b = (b < 0) ? 0 : ((b > 255) ? 255 : b);
+
+	return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+/**
+ * @brief Draw a test frame
+ */
+static void draw(scene_t scene, uint16_t* pixels, uint16_t width, uint16_t height)
+{
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			int r = (int)((x * 255u) / width);
+			int g = (int)((y * 255u) / height);
+			int b = (int)(((x + y) * 127u) / (width + height)) + 64;
+			uint16_t* pixel = &pixels[(y * width) + x];
+
+			switch (scene)
+			{
+			case SCENE_SMOOTH:
+				*pixel = rgb565(r, g, b);
+				break;
+			case SCENE_NOISY:
+				*pixel = rgb565(r + (int)(host_random() % 13u) - 6, g + (int)(host_random() % 13u) - 6,
+						b + (int)(host_random() % 13u) - 6);
+				break;
+			case SCENE_FLAT:
+				*pixel = (((x / 40u) + (y / 30u)) % 5u == 0) ? rgb565(200, 40, 40) : rgb565(90, 90, 90);
+				break;
+			default:
+				*pixel = (uint16_t)host_random();
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Lossless round trip of every scene, whole frame and line by line, and odd sizes
+ */
+static void test_lossless_round_trip(void)
+{
+	static const uint16_t sizes[][2] = { { 1, 1 }, { 1, 7 }, { 65, 3 }, { 129, 17 }, { 37, 64 } };
+
+	for (int scene = 0; scene < SCENE_COUNT; ++scene)
+	{
+		lossless_encoder_t encoder;
+		int32_t size = 0;
+		int32_t line_size = 0;
+		uint8_t* lines = malloc(OUTPUT_SIZE);
+
+		draw((scene_t)scene, image, WIDTH, HEIGHT);
+		size = lossless_encode_rgb565(image, WIDTH, HEIGHT, output, OUTPUT_SIZE);
+		CHECK(size > 0);
+		CHECK(size <= OUTPUT_SIZE);
+		memset(decoded, 0, sizeof(decoded));
+		CHECK_EQUAL(0, lossless_decode_rgb565(output, (uint32_t)size, WIDTH, HEIGHT, decoded));
+		CHECK(memcmp(image, decoded, sizeof(image)) == 0);
+		printf("Lossless %-6s: %d bytes (%.2f bits/pixel)\n", scene_names[scene], (int)size,
+				(8.0 * size) / PIXELS);
+
+		// The encoding line by line gives the same bytes
+		lossless_encoder_start(&encoder, WIDTH, lines, OUTPUT_SIZE);
+		for (uint32_t y = 0; y < HEIGHT; ++y)
+		{
+			CHECK_EQUAL(0, lossless_encoder_line(&encoder, &image[y * WIDTH]));
+		}
+		line_size = lossless_encoder_finish(&encoder);
+		CHECK_EQUAL(size, line_size);
+		CHECK(memcmp(output, lines, (size_t)size) == 0);
+		free(lines);
+
+		for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+		{
+			uint16_t width = sizes[i][0];
+			uint16_t height = sizes[i][1];
+
+			draw((scene_t)scene, image, width, height);
+			size = lossless_encode_rgb565(image, width, height, output, OUTPUT_SIZE);
+			CHECK(size > 0);
+			CHECK_EQUAL(0, lossless_decode_rgb565(output, (uint32_t)size, width, height, decoded));
+			CHECK(memcmp(image, decoded, (size_t)width * height * sizeof(uint16_t)) == 0);
+		}
+	}
+}
+
+/**
+ * @brief Lossless errors: dimensions, small buffers, truncated and corrupted data
+ */
+static void test_lossless_errors(void)
+{
+	int32_t size = 0;
+
+	draw(SCENE_NOISY, image, WIDTH, HEIGHT);
+	CHECK_EQUAL(LOSSLESS_ERROR_PARAM, lossless_encode_rgb565(image, 0, HEIGHT, output, OUTPUT_SIZE));
+	CHECK_EQUAL(LOSSLESS_ERROR_PARAM, lossless_encode_rgb565(image, WIDTH, 0, output, OUTPUT_SIZE));
+
+	size = lossless_encode_rgb565(image, WIDTH, HEIGHT, output, OUTPUT_SIZE);
+	CHECK(size > 0);
+	CHECK_EQUAL(LOSSLESS_ERROR_OVERFLOW, lossless_encode_rgb565(image, WIDTH, HEIGHT, output, (uint32_t)size - 1));
+	CHECK_EQUAL(LOSSLESS_ERROR_DATA, lossless_decode_rgb565(output, (uint32_t)size - 1, WIDTH, HEIGHT, decoded));
+	CHECK_EQUAL(LOSSLESS_ERROR_PARAM, lossless_decode_rgb565(output, (uint32_t)size, 0, HEIGHT, decoded));
+
+	// Reserved code
+	output[0] = 0xC1;
+	CHECK_EQUAL(LOSSLESS_ERROR_DATA, lossless_decode_rgb565(output, (uint32_t)size, WIDTH, HEIGHT, decoded));
+
+	// Random data never reads or writes out of the buffers (sanitizers)
+	for (int i = 0; i < 2000; ++i)
+	{
+		uint32_t length = 1 + (host_random() % 256u);
+		uint16_t width = (uint16_t)(1 + (host_random() % 64u));
+		uint16_t height = (uint16_t)(1 + (host_random() % 8u));
+		int result = 0;
+
+		host_random_fill(output, length);
+		result = lossless_decode_rgb565(output, length, width, height, decoded);
+		CHECK((result == 0) || (result == LOSSLESS_ERROR_DATA));
+	}
+}
+
+#if HOST_TEST_LIBJPEG
+/**
+ * @brief Decode a JPEG file with libjpeg and compute the PSNR against the frame
+ *
+ * @retval PSNR in dB, 0 if libjpeg rejects the file
+ */
+static double jpeg_psnr(const uint8_t* file, uint32_t size, const uint16_t* pixels)
+{
+	struct jpeg_decompress_struct info;
+	struct jpeg_error_mgr error;
+	uint8_t line[WIDTH * 3];
+	double squares = 0;
+
+	info.err = jpeg_std_error(&error);
+	jpeg_create_decompress(&info);
+	jpeg_mem_src(&info, file, size);
+	if ((jpeg_read_header(&info, TRUE) != JPEG_HEADER_OK) || (info.image_width != WIDTH)
+			|| (info.image_height != HEIGHT))
+	{
+		jpeg_destroy_decompress(&info);
+		return 0;
+	}
+	info.out_color_space = JCS_RGB;
+	jpeg_start_decompress(&info);
+
+	while (info.output_scanline < info.output_height)
+	{
+		const uint16_t* source = &pixels[info.output_scanline * WIDTH];
+		JSAMPROW row = line;
+
+		jpeg_read_scanlines(&info, &row, 1);
+		for (uint32_t x = 0; x < WIDTH; ++x)
+		{
+			int r = (source[x] >> 11) & 0x1F;
+			int g = (source[x] >> 5) & 0x3F;
+			int b = source[x] & 0x1F;
+			int dr = ((r << 3) | (r >> 2)) - line[x * 3];
+			int dg = ((g << 2) | (g >> 4)) - line[(x * 3) + 1];
+			int db = ((b << 3) | (b >> 2)) - line[(x * 3) + 2];
+
+			squares += (double)((dr * dr) + (dg * dg) + (db * db));
+		}
+	}
+	jpeg_finish_decompress(&info);
+	jpeg_destroy_decompress(&info);
+
+	return 10.0 * log10((255.0 * 255.0 * 3.0 * PIXELS) / ((squares > 0) ? squares : 1.0));
+}
+#endif
+
+/**
+ * @brief JPEG files: markers, errors, and the decoded frame close to the source
+ */
+static void test_jpeg(void)
+{
+	static const uint8_t qualities[] = { 10, 50, 90 };
+	jpeg_encoder_t encoder;
+	int32_t size = 0;
+
+	CHECK_EQUAL(JPEG_ERROR_PARAM, jpeg_encoder_init(&encoder, 0));
+	CHECK_EQUAL(JPEG_ERROR_PARAM, jpeg_encoder_init(&encoder, 101));
+	CHECK_EQUAL(0, jpeg_encoder_init(&encoder, 50));
+
+	draw(SCENE_SMOOTH, image, WIDTH, HEIGHT);
+	CHECK_EQUAL(JPEG_ERROR_PARAM, jpeg_encode_rgb565(&encoder, (const uint8_t*)image, WIDTH - 8, HEIGHT, output, OUTPUT_SIZE));
+	CHECK_EQUAL(JPEG_ERROR_OVERFLOW, jpeg_encode_rgb565(&encoder, (const uint8_t*)image, WIDTH, HEIGHT, output, 1024));
+
+	for (int scene = 0; scene < SCENE_COUNT; ++scene)
+	{
+		draw((scene_t)scene, image, WIDTH, HEIGHT);
+
+		for (size_t i = 0; i < sizeof(qualities); ++i)
+		{
+			CHECK_EQUAL(0, jpeg_encoder_init(&encoder, qualities[i]));
+			size = jpeg_encode_rgb565(&encoder, (const uint8_t*)image, WIDTH, HEIGHT, output, OUTPUT_SIZE);
+			CHECK(size > 4);
+			if (size <= 4)
+			{
+				continue;
+			}
+
+			// SOI and EOI
+			CHECK((output[0] == 0xFF) && (output[1] == 0xD8));
+			CHECK((output[size - 2] == 0xFF) && (output[size - 1] == 0xD9));
+#if HOST_TEST_LIBJPEG
+			{
+				double psnr = jpeg_psnr(output, (uint32_t)size, image);
+
+				// Random pixels are not compressible: the file only has to be valid
+				CHECK(psnr >= ((scene == SCENE_RANDOM) ? 5.0 : ((qualities[i] >= 50) ? 30.0 : 24.0)));
+				printf("JPEG %-6s quality %2u: %6d bytes, PSNR %.1f dB\n", scene_names[scene],
+						(unsigned)qualities[i], (int)size, psnr);
+			}
+#else
+			printf("JPEG %-6s quality %2u: %6d bytes\n", scene_names[scene], (unsigned)qualities[i], (int)size);
+#endif
+		}
+	}
+}
+
+/**
+ * @brief Cycles per pixel of the codecs on the noisy scene (best run)
+ */
+static void benchmark(unsigned long iterations)
+{
+	uint64_t encode = UINT64_MAX;
+	uint64_t decode = UINT64_MAX;
+	uint64_t jpeg = UINT64_MAX;
+	jpeg_encoder_t encoder;
+	int32_t size = 0;
+
+	draw(SCENE_NOISY, image, WIDTH, HEIGHT);
+	jpeg_encoder_init(&encoder, 75);
+
+	for (unsigned long i = 0; i < iterations; ++i)
+	{
+		uint64_t start = host_cycles();
+		uint64_t cycles = 0;
+
+		size = lossless_encode_rgb565(image, WIDTH, HEIGHT, output, OUTPUT_SIZE);
+		cycles = host_cycles() - start;
+		encode = (cycles < encode) ? cycles : encode;
+
+		start = host_cycles();
+		lossless_decode_rgb565(output, (uint32_t)size, WIDTH, HEIGHT, decoded);
+		cycles = host_cycles() - start;
+		decode = (cycles < decode) ? cycles : decode;
+
+		start = host_cycles();
+		jpeg_encode_rgb565(&encoder, (const uint8_t*)image, WIDTH, HEIGHT, output, OUTPUT_SIZE);
+		cycles = host_cycles() - start;
+		jpeg = (cycles < jpeg) ? cycles : jpeg;
+	}
+
+	printf("Lossless encode: %.1f cycles/pixel, decode: %.1f cycles/pixel, JPEG quality 75: %.1f cycles/pixel\n",
+			(double)encode / PIXELS, (double)decode / PIXELS, (double)jpeg / PIXELS);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 5);
+
+	test_lossless_round_trip();
+	test_lossless_errors();
+	test_jpeg();
+	benchmark(iterations);
+
+	return host_test_result("test_codec");
+}
@@ -0,0 +1,404 @@
+/*
+ * test_command.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Command channel (protocol/command.h) and its host client (host/command_client.h).
+ *
+ * Fuzzing of command_parser_push: each iteration writes random bytes, a valid frame,
+ * a damaged frame (one byte changed, cut short, or a size above the maximum) or
+ * random sync bytes to the stream, which is pushed in chunks of random sizes. At
+ * every push the parser must not consume more than it was given, nor return a
+ * command larger than COMMAND_MAX_PARAMS or outside of its buffer; and it must
+ * return exactly the valid frames, in order, with their parameters.
+ *
+ * Client: requests through the parser of the device, acknowledgements in a stream
+ * mixed with data messages and noise, round trip times, expired requests.
+ *
+ * Argument: iterations of the fuzzing (default 2000000).
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "command_client.h"
+#include "crc.h"
+
+/**
+ * @def STREAM_SIZE
+ * Bytes written to the stream before they are pushed
+ */
+#define STREAM_SIZE			(16 * 1024)
+
+/**
+ * @def MAX_EXPECTED
+ * Valid frames written and not returned yet
+ */
+#define MAX_EXPECTED		64
+
+/**
+ * Valid frame written to the stream
+ */
+typedef struct
+{
+	uint8_t id;
+	uint16_t request_id;
+	uint16_t size;
+	uint32_t crc;			/**< CRC-32 of the parameters */
+} expected_t;
+
+/**
+ * Fuzzing state
+ */
+typedef struct
+{
+	command_parser_t parser;
+	uint8_t stream[STREAM_SIZE + COMMAND_MAX_FRAME_SIZE];
+	uint32_t length;
+	expected_t expected[MAX_EXPECTED];
+	uint32_t head;
+	uint32_t count;
+	uint32_t returned;
+	uint32_t valid;
+} fuzz_t;
+
+static fuzz_t fuzz;
+
+/**
+ * @brief Size of the parameters of a random frame (mostly small, as the real commands)
+ */
+static uint16_t random_params_size(void)
+{
+	uint32_t choice = host_random() % 8u;
+
+	if (choice == 0)
+	{
+		return (uint16_t)(host_random() % (COMMAND_MAX_PARAMS + 1u));
+	}
+	if (choice == 1)
+	{
+		return COMMAND_MAX_PARAMS;
+	}
+	return (uint16_t)(host_random() % 9u);
+}
+
+/**
+ * @brief Write a random valid frame at the end of the stream
+ *
+ * @retval Size of the frame
+ */
+static uint32_t write_frame(uint8_t* buffer, expected_t* expected)
+{
+	uint8_t params[COMMAND_MAX_PARAMS];
+	command_t command;
+
+	command.id = (uint8_t)host_random();
+	command.flags = 0;
+	command.request_id = (uint16_t)host_random();
+	command.size = random_params_size();
+	command.params = params;
+	host_random_fill(params, command.size);
+
+	expected->id = command.id;
+	expected->request_id = command.request_id;
+	expected->size = command.size;
+	expected->crc = crc32_compute(params, command.size);
+
+	return command_encode(&command, buffer);
+}
+
+/**
+ * @brief Push the stream in chunks of random sizes and check every return of the parser
+ */
+static void push_stream(void)
+{
+	uint32_t offset = 0;
+
+	while (offset < fuzz.length)
+	{
+		uint32_t chunk = 1 + (host_random() % 256u);
+		int found = 1;
+
+		chunk = (chunk > (fuzz.length - offset)) ? (fuzz.length - offset) : chunk;
+
+		// Push again as long as a command is returned, with the rest of the chunk
+		while (found)
+		{
+			command_t command;
+			uint32_t consumed = UINT32_MAX;
+
+			found = command_parser_push(&fuzz.parser, &fuzz.stream[offset], chunk, &consumed, &command);
+			CHECK(consumed <= chunk);
+			CHECK(fuzz.parser.length <= COMMAND_MAX_FRAME_SIZE);
+			if (consumed > chunk)
+			{
+				return;
+			}
+			offset += consumed;
+			chunk -= consumed;
+
+			if (!found)
+			{
+				CHECK_EQUAL(chunk, 0);
+				continue;
+			}
+
+			CHECK(command.size <= COMMAND_MAX_PARAMS);
+			CHECK((command.params >= &fuzz.parser.frame[COMMAND_HEADER_SIZE])
+					&& ((command.params + command.size + COMMAND_CRC_SIZE) <= &fuzz.parser.frame[COMMAND_MAX_FRAME_SIZE]));
+			if ((command.size > COMMAND_MAX_PARAMS) || (fuzz.count == 0))
+			{
+				// Command from random bytes with a valid CRC: practically impossible
+				CHECK(fuzz.count != 0);
+				continue;
+			}
+
+			{
+				const expected_t* expected = &fuzz.expected[fuzz.head];
+
+				CHECK_EQUAL(expected->id, command.id);
+				CHECK_EQUAL(expected->request_id, command.request_id);
+				CHECK_EQUAL(expected->size, command.size);
+				CHECK_EQUAL(expected->crc, crc32_compute(command.params, command.size));
+				fuzz.head = (fuzz.head + 1u) % MAX_EXPECTED;
+				fuzz.count--;
+				fuzz.returned++;
+			}
+		}
+	}
+
+	fuzz.length = 0;
+}
+
+/**
+ * @brief Write one random element to the stream
+ */
+static void write_element(void)
+{
+	uint8_t* end = &fuzz.stream[fuzz.length];
+	uint32_t choice = host_random() % 16u;
+	expected_t expected;
+	uint32_t size = 0;
+
+	if (choice < 6)
+	{
+		// Valid frame
+		size = write_frame(end, &expected);
+		if (fuzz.count < MAX_EXPECTED)
+		{
+			fuzz.expected[(fuzz.head + fuzz.count) % MAX_EXPECTED] = expected;
+			fuzz.count++;
+			fuzz.valid++;
+		}
+		else
+		{
+			size = 0;
+		}
+	}
+	else if (choice < 9)
+	{
+		// Damaged frame: one byte changed (never to the same value)
+		size = write_frame(end, &expected);
+		end[host_random() % size] ^= (uint8_t)(1u + (host_random() % 255u));
+	}
+	else if (choice < 11)
+	{
+		// Truncated frame followed by a byte of another value (the next element could
+		// complete it with the missing bytes otherwise, which is a valid frame)
+		size = write_frame(end, &expected);
+		size = host_random() % size;
+		end[size] ^= 0xFFu;
+		size++;
+	}
+	else if (choice < 12)
+	{
+		// Header with parameters too large
+		size = write_frame(end, &expected);
+		end[6] = (uint8_t)host_random();
+		end[7] = (uint8_t)(0x02u + (host_random() % 0xFEu));
+	}
+	else if (choice < 14)
+	{
+		// Sync bytes alone or followed by random bytes
+		end[0] = COMMAND_SYNC_0;
+		end[1] = COMMAND_SYNC_1;
+		size = 2 + (host_random() % 12u);
+		host_random_fill(&end[2], size - 2);
+	}
+	else
+	{
+		// Random bytes
+		size = 1 + (host_random() % 64u);
+		host_random_fill(end, size);
+	}
+
+	fuzz.length += size;
+}
+
+/**
+ * @brief Fuzz the parser, then check that every valid frame has been returned
+ */
+static void test_parser_fuzz(unsigned long iterations)
+{
+	command_parser_init(&fuzz.parser);
+
+	for (unsigned long i = 0; i < iterations; ++i)
+	{
+		write_element();
+		if (fuzz.length >= STREAM_SIZE)
+		{
+			push_stream();
+		}
+	}
+
+	// A damaged header can still wait for bytes: zeros complete it, the parser resynchronizes
+	memset(&fuzz.stream[fuzz.length], 0, COMMAND_MAX_FRAME_SIZE);
+	fuzz.length += COMMAND_MAX_FRAME_SIZE;
+	push_stream();
+
+	CHECK_EQUAL(0, fuzz.count);
+	CHECK_EQUAL(fuzz.valid, fuzz.returned);
+	CHECK_EQUAL(fuzz.valid, fuzz.parser.stats.commands);
+	printf("Parser: %lu iterations, %u commands, %u CRC errors, %u size errors, %u bytes skipped\n", iterations,
+			(unsigned)fuzz.parser.stats.commands, (unsigned)fuzz.parser.stats.crc_errors,
+			(unsigned)fuzz.parser.stats.size_errors, (unsigned)fuzz.parser.stats.skipped_bytes);
+}
+
+/**
+ * @brief Write a message of the device to a stream
+ *
+ * @retval Size of the message
+ */
+static uint32_t write_message(uint8_t* buffer, uint8_t stream, uint8_t format, const uint8_t* payload, uint32_t size)
+{
+	protocol_header_t header;
+
+	memset(&header, 0, sizeof(header));
+	header.stream = stream;
+	header.format = format;
+	header.payload_size = size;
+	header.message_size = size;
+	header.message_crc = crc32_compute(payload, size);
+	protocol_encode_header(&header, buffer);
+	memcpy(&buffer[PROTOCOL_HEADER_SIZE], payload, size);
+
+	return PROTOCOL_HEADER_SIZE + size;
+}
+
+/**
+ * @brief Requests through the parser of the device, acknowledgements mixed with data and noise
+ */
+static void test_client(void)
+{
+	static uint8_t device[256 * 1024];
+	static uint8_t data[8 * 1024];
+	command_client_t client;
+	command_parser_t parser;
+	command_client_ack_t ack;
+	uint8_t frame[COMMAND_MAX_FRAME_SIZE];
+	uint8_t params[4] = { 1, 2, 3, 4 };
+	uint32_t length = 0;
+	uint32_t acks = 0;
+	uint16_t first_id = 0;
+
+	command_client_init(&client);
+	command_parser_init(&parser);
+	CHECK_EQUAL(COMMAND_CLIENT_ERROR_PARAM, command_client_request(&client, 49, NULL, COMMAND_MAX_PARAMS + 1, 0, frame, sizeof(frame)));
+	CHECK_EQUAL(COMMAND_CLIENT_ERROR_OVERFLOW, command_client_request(&client, 52, params, 2, 0, frame, COMMAND_HEADER_SIZE + 2 + 3));
+
+	// The device parses each request and acknowledges it, between data messages and noise
+	for (uint32_t i = 0; i < 20; ++i)
+	{
+		int32_t size = command_client_request(&client, (uint8_t)(49 + i), params, (uint16_t)(i % 5u), 1000u * i, frame, sizeof(frame));
+		uint32_t consumed = 0;
+		command_t command;
+		uint8_t payload[COMMAND_ACK_SIZE + 4];
+		uint32_t payload_size = 0;
+
+		CHECK(size > 0);
+		CHECK_EQUAL(1, command_parser_push(&parser, frame, (uint32_t)size, &consumed, &command));
+		CHECK_EQUAL(size, consumed);
+		CHECK_EQUAL(49 + i, command.id);
+		CHECK_EQUAL(i % 5u, command.size);
+		first_id = (i == 0) ? command.request_id : first_id;
+
+		host_random_fill(data, sizeof(data));
+		length += write_message(&device[length], PROTOCOL_STREAM_RADAR, PROTOCOL_FORMAT_RADAR_U16, data, 1000u + (host_random() % 4000u));
+		if ((i % 3u) == 0)
+		{
+			host_random_fill(&device[length], 37);
+			length += 37;
+		}
+		payload_size = command_encode_ack(&command, (i == 7) ? COMMAND_STATUS_PARAM : COMMAND_STATUS_OK, payload);
+		memcpy(&payload[payload_size], "\x11\x22\x33\x44", 4);
+		payload_size += (i == 9) ? 4u : 0u;
+		length += write_message(&device[length], PROTOCOL_STREAM_CONTROL, PROTOCOL_FORMAT_COMMAND_ACK, payload, payload_size);
+		length += write_message(&device[length], PROTOCOL_STREAM_CAMERA, PROTOCOL_FORMAT_JPEG, data, host_random() % 2000u);
+	}
+
+	// Read by USB transfers of random sizes
+	for (uint32_t offset = 0; offset < length;)
+	{
+		uint32_t chunk = 1 + (host_random() % 700u);
+		uint32_t consumed = 0;
+
+		chunk = (chunk > (length - offset)) ? (length - offset) : chunk;
+		while (command_client_receive(&client, &device[offset], chunk, &consumed, 50000u, &ack))
+		{
+			CHECK_EQUAL((uint16_t)(first_id + acks), ack.request_id);
+			CHECK_EQUAL(49 + acks, ack.command);
+			CHECK_EQUAL((acks == 7) ? COMMAND_STATUS_PARAM : COMMAND_STATUS_OK, ack.status);
+			CHECK_EQUAL((acks == 9) ? 4 : 0, ack.size);
+			CHECK((ack.size == 0) || (memcmp(ack.data, "\x11\x22\x33\x44", 4) == 0));
+			CHECK_EQUAL(50000 - (1000 * (int64_t)acks), ack.round_trip_us);
+			acks++;
+			offset += consumed;
+			chunk -= consumed;
+		}
+		offset += consumed;
+	}
+	CHECK_EQUAL(20, acks);
+	CHECK_EQUAL(60, client.stats.messages);
+	CHECK_EQUAL(0, client.stats.crc_errors);
+	CHECK_EQUAL(0, client.stats.lost);
+	CHECK(client.stats.header_errors > 0);
+
+	// Expired request, acknowledgement of an unknown request, damaged acknowledgement
+	{
+		command_t command = { 59, 0, 0, 0, NULL };
+		uint8_t payload[COMMAND_ACK_SIZE];
+		uint32_t consumed = 0;
+
+		command_client_request(&client, 50, NULL, 0, 100000u, frame, sizeof(frame));
+		command_client_request(&client, 59, NULL, 0, 100000u + COMMAND_CLIENT_TIMEOUT_US + 1u, frame, sizeof(frame));
+		CHECK_EQUAL(1, client.stats.lost);
+
+		command.request_id = 0x7777;
+		command_encode_ack(&command, 0, payload);
+		length = write_message(device, PROTOCOL_STREAM_CONTROL, PROTOCOL_FORMAT_COMMAND_ACK, payload, sizeof(payload));
+		CHECK_EQUAL(1, command_client_receive(&client, device, length, &consumed, 0, &ack));
+		CHECK_EQUAL(-1, ack.round_trip_us);
+
+		device[length - 1] ^= 1;
+		CHECK_EQUAL(0, command_client_receive(&client, device, length, &consumed, 0, &ack));
+		CHECK_EQUAL(1, client.stats.crc_errors);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 2000000);
+
+	test_parser_fuzz(iterations);
+	test_client();
+
+	return host_test_result("test_command");
+}
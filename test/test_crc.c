@@ -0,0 +1,106 @@
+/*
+ * test_crc.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * CRC-32 engine selected by CRC_ENGINE (built once per engine, 0 to 3): checks
+ * crc32_compute and crc32_update against the bitwise reference for every length up to 1 KB and random splits,
+ * then measures the bytes per cycle of the engine and of the reference on a QVGA frame.
+ * Argument: iterations of the benchmark.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "crc.h"
+
+/**
+ * @def FRAME_SIZE
+ * QVGA RGB565 frame
+ */
+#define FRAME_SIZE		(320 * 240 * 2)
+
+/**
+ * @def MAX_CHECK_LENGTH
+ * Every length up to this one is checked (head and tail of the sliced engines)
+ */
+#define MAX_CHECK_LENGTH	1024
+
+static const char* const engine_names[] = { "bitwise", "table", "slice-by-4", "slice-by-8" };
+
+static uint8_t frame[FRAME_SIZE];
+
+/**
+ * @brief Same results as the bitwise reference, whole buffers and buffers in parts
+ */
+static void check_engine(void)
+{
+	for (uint32_t length = 0; length <= MAX_CHECK_LENGTH; ++length)
+	{
+		// Unaligned start as well
+		const uint8_t* data = &frame[length & 7u];
+
+		CHECK_EQUAL(crc32_update_bitwise(CRC32_INIT, data, length), crc32_compute(data, length));
+	}
+
+	for (int i = 0; i < 200; ++i)
+	{
+		uint32_t length = host_random() % FRAME_SIZE;
+		uint32_t split = (length != 0) ? (host_random() % length) : 0;
+		uint32_t crc = crc32_update(CRC32_INIT, frame, split);
+
+		crc = crc32_update(crc, &frame[split], length - split);
+		CHECK_EQUAL(crc32_update_bitwise(CRC32_INIT, frame, length), crc);
+	}
+}
+
+/**
+ * @brief Bytes per cycle of a CRC function over the frame
+ */
+static double bytes_per_cycle(uint32_t (*function)(uint32_t, const uint8_t*, uint32_t), unsigned long iterations)
+{
+	volatile uint32_t sink = 0;
+	uint64_t best = UINT64_MAX;
+
+	// Best run: the least disturbed by the host
+	for (unsigned long i = 0; i < iterations; ++i)
+	{
+		uint64_t start = host_cycles();
+		uint64_t cycles;
+
+		sink = function(CRC32_INIT, frame, FRAME_SIZE);
+		cycles = host_cycles() - start;
+		if (cycles < best)
+		{
+			best = cycles;
+		}
+	}
+	(void)sink;
+
+	return (double)FRAME_SIZE / (double)best;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 5);
+	double engine = 0;
+	double reference = 0;
+
+	host_random_fill(frame, sizeof(frame));
+	check_engine();
+
+	engine = bytes_per_cycle(crc32_update, iterations);
+	reference = bytes_per_cycle(crc32_update_bitwise, iterations);
+	printf("CRC-32 %-10s: %.3f bytes/cycle, bitwise %.3f bytes/cycle (x%.1f)\n",
+			engine_names[CRC_ENGINE], engine, reference, engine / reference);
+
+	return host_test_result("test_crc");
+}
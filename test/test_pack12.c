@@ -0,0 +1,148 @@
+/*
+ * test_pack12.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Packing of the 12 bits radar samples (pack12.h): byte layout of the header,
+ * round trip through pack12_unpack for every count up to 64 and a radar frame,
+ * packing in place and upper bits ignored. Then the cycles per sample of the
+ * packing and of the unpacking.
+ * Argument: iterations of the benchmark.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "codec/pack12.h"
+
+/**
+ * @def FRAME_SAMPLES
+ * Radar frame of the default profile: 128 samples, 64 chirps, 3 antennas
+ */
+#define FRAME_SAMPLES		(128 * 64 * 3)
+
+static uint16_t samples[FRAME_SAMPLES + 1];
+static uint16_t unpacked[FRAME_SAMPLES + 1];
+static uint8_t packed[PACK12_SIZE(FRAME_SAMPLES + 1)];
+
+/**
+ * @brief Pack from the layout of pack12.h, one pair at a time
+ */
+static void plain_pack(const uint16_t* input, uint32_t count, uint8_t* output)
+{
+	uint32_t i = 0;
+
+	for (i = 0; i + 1 < count; i += 2)
+	{
+		uint32_t word = (input[i] & 0x0FFFu) | ((uint32_t)(input[i + 1] & 0x0FFFu) << 12);
+
+		*output++ = (uint8_t)word;
+		*output++ = (uint8_t)(word >> 8);
+		*output++ = (uint8_t)(word >> 16);
+	}
+
+	if (i < count)
+	{
+		*output++ = (uint8_t)input[i];
+		*output++ = (uint8_t)((input[i] >> 8) & 0x0Fu);
+	}
+}
+
+/**
+ * @brief Round trip of random samples, layout against the definition
+ */
+static void test_round_trip(void)
+{
+	static uint8_t expected[PACK12_SIZE(FRAME_SAMPLES + 1)];
+	static const uint32_t counts[] = { FRAME_SAMPLES - 1, FRAME_SAMPLES, FRAME_SAMPLES + 1 };
+
+	CHECK_EQUAL(0, PACK12_SIZE(0));
+	CHECK_EQUAL(2, PACK12_SIZE(1));
+	CHECK_EQUAL(3, PACK12_SIZE(2));
+	CHECK_EQUAL(5, PACK12_SIZE(3));
+
+	for (uint32_t count = 0; count <= 64 + (sizeof(counts) / sizeof(counts[0])); ++count)
+	{
+		uint32_t n = (count <= 64) ? count : counts[count - 65];
+
+		// The upper 4 bits must be ignored
+		host_random_fill(samples, n * sizeof(uint16_t));
+		memset(packed, 0xEE, sizeof(packed));
+		memset(unpacked, 0xEE, sizeof(unpacked));
+
+		CHECK_EQUAL(PACK12_SIZE(n), pack12_pack(samples, n, packed));
+		plain_pack(samples, n, expected);
+		CHECK(memcmp(packed, expected, PACK12_SIZE(n)) == 0);
+		// Nothing written after the packed samples
+		CHECK((n == FRAME_SAMPLES + 1) || (packed[PACK12_SIZE(n)] == 0xEE));
+
+		pack12_unpack(packed, n, unpacked);
+		for (uint32_t i = 0; i < n; ++i)
+		{
+			if (unpacked[i] != (samples[i] & 0x0FFFu))
+			{
+				CHECK_EQUAL(samples[i] & 0x0FFFu, unpacked[i]);
+				break;
+			}
+		}
+		CHECK((n == FRAME_SAMPLES + 1) || (unpacked[n] == 0xEEEE));
+	}
+}
+
+/**
+ * @brief Packing in the buffer of the samples, as the firmware does in the radar buffer
+ */
+static void test_in_place(void)
+{
+	static uint16_t buffer[FRAME_SAMPLES];
+
+	for (uint32_t i = 0; i < FRAME_SAMPLES; ++i)
+	{
+		samples[i] = (uint16_t)(host_random() & 0x0FFFu);
+	}
+	memcpy(buffer, samples, sizeof(buffer));
+
+	CHECK_EQUAL(PACK12_SIZE(FRAME_SAMPLES), pack12_pack(buffer, FRAME_SAMPLES, (uint8_t*)buffer));
+	pack12_unpack((const uint8_t*)buffer, FRAME_SAMPLES, unpacked);
+	CHECK(memcmp(samples, unpacked, sizeof(buffer)) == 0);
+}
+
+/**
+ * @brief Cycles per sample of the packing and of the unpacking (best run)
+ */
+static void benchmark(unsigned long iterations)
+{
+	uint64_t pack = UINT64_MAX;
+	uint64_t unpack = UINT64_MAX;
+
+	host_random_fill(samples, sizeof(samples));
+	for (unsigned long i = 0; i < iterations; ++i)
+	{
+		uint64_t start = host_cycles();
+		uint64_t cycles = 0;
+
+		pack12_pack(samples, FRAME_SAMPLES, packed);
+		cycles = host_cycles() - start;
+		pack = (cycles < pack) ? cycles : pack;
+
+		start = host_cycles();
+		pack12_unpack(packed, FRAME_SAMPLES, unpacked);
+		cycles = host_cycles() - start;
+		unpack = (cycles < unpack) ? cycles : unpack;
+	}
+
+	printf("Pack: %.2f cycles/sample, unpack: %.2f cycles/sample\n", (double)pack / FRAME_SAMPLES,
+			(double)unpack / FRAME_SAMPLES);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 20);
+
+	test_round_trip();
+	test_in_place();
+	benchmark(iterations);
+
+	return host_test_result("test_pack12");
+}
@@ -0,0 +1,293 @@
+/*
+ * test_protocol.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Framing of protocol v2 (protocol.h): layout of the 48 bytes header, round trip,
+ * rejection of the damaged headers, batch entries and resynchronization. CRC-32
+ * against the check vectors and zlib, then the throughput of the header
+ * encoding/decoding and of the CRC-32 compared with zlib.
+ * Argument: iterations of the benchmark.
+ */
+
+#include <string.h>
+#include <zlib.h>
+
+#include "host_test.h"
+#include "crc.h"
+#include "protocol/protocol.h"
+
+/**
+ * @def BENCH_SIZE
+ * Size of the message of the CRC benchmark (QVGA RGB565 frame)
+ */
+#define BENCH_SIZE		(320 * 240 * 2)
+
+static uint8_t message[BENCH_SIZE];
+
+/**
+ * @brief Header with a different value in every field
+ */
+static protocol_header_t test_header(void)
+{
+	protocol_header_t header =
+	{
+		.stream = PROTOCOL_STREAM_CAMERA,
+		.format = PROTOCOL_FORMAT_JPEG,
+		.flags = PROTOCOL_FLAG_FRAGMENT | PROTOCOL_FLAG_MORE_FRAGMENTS,
+		.sequence = 0x01020304u,
+		.payload_size = 0x4000u,
+		.timestamp_us = 0x1122334455667788ull,
+		.message_size = 0x12345u,
+		.fragment_offset = 0x8000u,
+		.dims = { 320, 240, 1 },
+		.encode_cost = 0x0180u,
+		.message_crc = 0xDEADBEEFu,
+	};
+
+	return header;
+}
+
+/**
+ * @brief CRC-32 of the check vectors and random buffers, in one call or in parts, against zlib
+ */
+static void test_crc32(void)
+{
+	static const struct
+	{
+		const char* text;
+		uint32_t crc;
+	} vectors[] =
+	{
+		{ "", 0x00000000u },
+		{ "a", 0xE8B7BE43u },
+		{ "abc", 0x352441C2u },
+		{ "123456789", 0xCBF43926u },
+		{ "The quick brown fox jumps over the lazy dog", 0x414FA339u },
+	};
+
+	for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i)
+	{
+		const uint8_t* data = (const uint8_t*)vectors[i].text;
+		uint32_t length = (uint32_t)strlen(vectors[i].text);
+
+		CHECK_EQUAL(vectors[i].crc, crc32_compute(data, length));
+		CHECK_EQUAL(vectors[i].crc, (uint32_t)crc32(0, data, length));
+	}
+
+	for (int i = 0; i < 500; ++i)
+	{
+		uint32_t length = host_random() % 4096;
+		uint32_t split = (length != 0) ? (host_random() % length) : 0;
+		const uint8_t* data = &message[host_random() % 64];
+		uint32_t crc = crc32_update(CRC32_INIT, data, split);
+
+		crc = crc32_update(crc, &data[split], length - split);
+		CHECK_EQUAL((uint32_t)crc32(0, data, length), crc32_compute(data, length));
+		CHECK_EQUAL((uint32_t)crc32(0, data, length), crc);
+	}
+}
+
+/**
+ * @brief Byte layout of the header (little endian, protocol table of the README) and round trip
+ */
+static void test_header_layout(void)
+{
+	protocol_header_t header = test_header();
+	protocol_header_t decoded;
+	uint8_t buffer[PROTOCOL_HEADER_SIZE];
+	static const uint8_t expected[44] =
+	{
+		0x55, 0xAA, 2, 48, 2, 4, 0x03, 0x00,
+		0x04, 0x03, 0x02, 0x01,
+		0x00, 0x40, 0x00, 0x00,
+		0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11,
+		0x45, 0x23, 0x01, 0x00,
+		0x00, 0x80, 0x00, 0x00,
+		0x40, 0x01, 0xF0, 0x00, 0x01, 0x00,
+		0x80, 0x01,
+		0xEF, 0xBE, 0xAD, 0xDE,
+	};
+	uint32_t header_crc = (uint32_t)crc32(0, expected, sizeof(expected));
+
+	CHECK_EQUAL(PROTOCOL_HEADER_SIZE, protocol_encode_header(&header, buffer));
+	CHECK(memcmp(buffer, expected, sizeof(expected)) == 0);
+	CHECK_EQUAL(header_crc, (uint32_t)(buffer[44] | (buffer[45] << 8) | (buffer[46] << 16) | ((uint32_t)buffer[47] << 24)));
+
+	memset(&decoded, 0, sizeof(decoded));
+	CHECK_EQUAL(0, protocol_decode_header(buffer, sizeof(buffer), &decoded));
+	CHECK_EQUAL(header.stream, decoded.stream);
+	CHECK_EQUAL(header.format, decoded.format);
+	CHECK_EQUAL(header.flags, decoded.flags);
+	CHECK_EQUAL(header.sequence, decoded.sequence);
+	CHECK_EQUAL(header.payload_size, decoded.payload_size);
+	CHECK(header.timestamp_us == decoded.timestamp_us);
+	CHECK_EQUAL(header.message_size, decoded.message_size);
+	CHECK_EQUAL(header.fragment_offset, decoded.fragment_offset);
+	CHECK(memcmp(header.dims, decoded.dims, sizeof(header.dims)) == 0);
+	CHECK_EQUAL(header.encode_cost, decoded.encode_cost);
+	CHECK_EQUAL(header.message_crc, decoded.message_crc);
+}
+
+/**
+ * @brief Headers that must be rejected
+ */
+static void test_header_errors(void)
+{
+	protocol_header_t header = test_header();
+	protocol_header_t decoded;
+	uint8_t buffer[PROTOCOL_HEADER_SIZE];
+	uint8_t damaged[PROTOCOL_HEADER_SIZE];
+
+	protocol_encode_header(&header, buffer);
+	CHECK_EQUAL(PROTOCOL_ERROR_SIZE, protocol_decode_header(buffer, PROTOCOL_HEADER_SIZE - 1, &decoded));
+
+	// Any bit flip is detected
+	for (uint32_t bit = 0; bit < PROTOCOL_HEADER_SIZE * 8; ++bit)
+	{
+		int expected = PROTOCOL_ERROR_HEADER_CRC;
+
+		memcpy(damaged, buffer, sizeof(damaged));
+		damaged[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+		if (bit < 16)
+		{
+			expected = PROTOCOL_ERROR_SYNC;
+		}
+		else if (bit < 32)
+		{
+			expected = PROTOCOL_ERROR_VERSION;
+		}
+		CHECK_EQUAL(expected, protocol_decode_header(damaged, sizeof(damaged), &decoded));
+	}
+
+	// Fragment outside of the message, including the wrap around of offset + size
+	header.fragment_offset = header.message_size - header.payload_size + 1;
+	protocol_encode_header(&header, buffer);
+	CHECK_EQUAL(PROTOCOL_ERROR_FRAGMENT, protocol_decode_header(buffer, sizeof(buffer), &decoded));
+	header.fragment_offset = 0xFFFFF000u;
+	protocol_encode_header(&header, buffer);
+	CHECK_EQUAL(PROTOCOL_ERROR_FRAGMENT, protocol_decode_header(buffer, sizeof(buffer), &decoded));
+	header.fragment_offset = 0;
+	header.payload_size = header.message_size + 1;
+	protocol_encode_header(&header, buffer);
+	CHECK_EQUAL(PROTOCOL_ERROR_FRAGMENT, protocol_decode_header(buffer, sizeof(buffer), &decoded));
+
+	// Last fragment exactly at the end
+	header.payload_size = 0x345u;
+	header.fragment_offset = header.message_size - header.payload_size;
+	protocol_encode_header(&header, buffer);
+	CHECK_EQUAL(0, protocol_decode_header(buffer, sizeof(buffer), &decoded));
+}
+
+/**
+ * @brief Frames of a batch: round trip and payload outside of the batch
+ */
+static void test_batch_entry(void)
+{
+	protocol_batch_entry_t entry =
+	{
+		.size = 100,
+		.timestamp_offset_us = 123456,
+		.dims = { 64, 32, 3 },
+		.encode_cost = 0x0200,
+		.format = PROTOCOL_FORMAT_RANGE_MAG_U16,
+	};
+	protocol_batch_entry_t decoded;
+	uint8_t buffer[PROTOCOL_BATCH_ENTRY_SIZE + 100];
+
+	memset(buffer, 0xFF, sizeof(buffer));
+	CHECK_EQUAL(PROTOCOL_BATCH_ENTRY_SIZE, protocol_encode_batch_entry(&entry, buffer));
+	CHECK_EQUAL(0, buffer[17]);
+	CHECK_EQUAL(0, buffer[18]);
+	CHECK_EQUAL(0, buffer[19]);
+
+	CHECK_EQUAL(PROTOCOL_BATCH_ENTRY_SIZE + 100, protocol_decode_batch_entry(buffer, sizeof(buffer), &decoded));
+	CHECK_EQUAL(entry.size, decoded.size);
+	CHECK_EQUAL(entry.timestamp_offset_us, decoded.timestamp_offset_us);
+	CHECK(memcmp(entry.dims, decoded.dims, sizeof(entry.dims)) == 0);
+	CHECK_EQUAL(entry.encode_cost, decoded.encode_cost);
+	CHECK_EQUAL(entry.format, decoded.format);
+
+	CHECK_EQUAL(PROTOCOL_ERROR_BATCH, protocol_decode_batch_entry(buffer, sizeof(buffer) - 1, &decoded));
+	CHECK_EQUAL(PROTOCOL_ERROR_BATCH, protocol_decode_batch_entry(buffer, PROTOCOL_BATCH_ENTRY_SIZE - 1, &decoded));
+}
+
+/**
+ * @brief Resynchronization on the sync bytes
+ */
+static void test_find_sync(void)
+{
+	static const uint8_t none[] = { 0x00, 0xAA, 0x55, 0x12 };
+	static const uint8_t middle[] = { 0x12, 0x55, 0x55, 0xAA, 0x00 };
+	static const uint8_t last[] = { 0x12, 0x34, 0x55 };
+
+	CHECK_EQUAL(0, protocol_find_sync(none, 0));
+	CHECK_EQUAL(sizeof(none), protocol_find_sync(none, sizeof(none)));
+	CHECK_EQUAL(2, protocol_find_sync(middle, sizeof(middle)));
+	CHECK_EQUAL(2, protocol_find_sync(last, sizeof(last)));
+}
+
+/**
+ * @brief Headers encoded and decoded per second, CRC-32 of the firmware and of zlib in bytes per cycle
+ */
+static void benchmark(unsigned long iterations)
+{
+	protocol_header_t header = test_header();
+	protocol_header_t decoded;
+	uint8_t buffer[PROTOCOL_HEADER_SIZE];
+	volatile uint32_t sink = 0;
+	uint64_t start = 0;
+	uint64_t firmware = UINT64_MAX;
+	uint64_t reference = UINT64_MAX;
+	unsigned long headers = iterations * 10000ul;
+
+	start = host_cycles();
+	for (unsigned long i = 0; i < headers; ++i)
+	{
+		header.sequence = (uint32_t)i;
+		protocol_encode_header(&header, buffer);
+		sink += (uint32_t)protocol_decode_header(buffer, sizeof(buffer), &decoded) + decoded.sequence;
+	}
+	printf("Header encode + decode: %.0f cycles\n", (double)(host_cycles() - start) / (double)headers);
+
+	for (unsigned long i = 0; i < iterations; ++i)
+	{
+		uint64_t cycles = 0;
+
+		start = host_cycles();
+		sink += crc32_compute(message, sizeof(message));
+		cycles = host_cycles() - start;
+		firmware = (cycles < firmware) ? cycles : firmware;
+
+		start = host_cycles();
+		sink += (uint32_t)crc32(0, message, sizeof(message));
+		cycles = host_cycles() - start;
+		reference = (cycles < reference) ? cycles : reference;
+	}
+	(void)sink;
+	printf("CRC-32 of %u bytes: %.3f bytes/cycle, zlib %.3f bytes/cycle\n", (unsigned)sizeof(message),
+			(double)sizeof(message) / (double)firmware, (double)sizeof(message) / (double)reference);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 5);
+
+	host_random_fill(message, sizeof(message));
+	test_crc32();
+	test_header_layout();
+	test_header_errors();
+	test_batch_entry();
+	test_find_sync();
+	benchmark(iterations);
+
+	return host_test_result("test_protocol");
+}
@@ -0,0 +1,291 @@
+/*
+ * test_range_doppler.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Range-Doppler map (range_doppler.h) of simulated radar frames (moving targets
+ * and noise on 12 bits ADC codes):
+ * - bit exact against a reference implementation of the same steps in their plain
+ *   form (range FFT of every chirp in a chirp x bin cube, separate transposition,
+ *   window of the chirps, reordering and Doppler FFT of each row, magnitude),
+ *   which checks the corner turn fused with the window and the bit reversal;
+ * - within 1 LSB of the map computed in double precision with DFTs;
+ * - the same map when written over the samples (in place).
+ * Then the time per frame for several shapes.
+ * Argument: iterations of the benchmark.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "dsp/range_doppler.h"
+
+/**
+ * @def PI
+ * Pi in double precision
+ */
+#define PI				3.14159265358979323846
+
+/**
+ * @def MAX_SAMPLES
+ * Largest frame tested
+ */
+#define MAX_SAMPLES		(256 * 64)
+
+/**
+ * Shape of a frame
+ */
+typedef struct
+{
+	uint16_t samples_per_chirp;
+	uint16_t chirps;
+} shape_t;
+
+static const shape_t shapes[] =
+{
+	{ 128, 16 },
+	{ 128, 64 },
+	{ 64, 32 },
+	{ 256, 8 },
+	{ 16, 4 },
+};
+
+static range_doppler_t rd;
+static uint16_t samples[MAX_SAMPLES];
+static uint16_t in_place[MAX_SAMPLES];
+static uint16_t map[MAX_SAMPLES / 2];
+static uint16_t reference_map[MAX_SAMPLES / 2];
+static float work[MAX_SAMPLES];
+static float cube_re[MAX_SAMPLES / 2];
+static float cube_im[MAX_SAMPLES / 2];
+static double exact_re[MAX_SAMPLES / 2];
+static double exact_im[MAX_SAMPLES / 2];
+
+/**
+ * @brief Frame with targets at several ranges and velocities
+ */
+static void simulate(uint16_t size, uint16_t chirps)
+{
+	static const struct
+	{
+		double range;		/**< Beat frequency, cycles per sample */
+		double velocity;	/**< Phase per chirp, cycles */
+		double amplitude;
+	} targets[] =
+	{
+		{ 0.06, 0.0, 700.0 },
+		{ 0.19, 0.125, 500.0 },
+		{ 0.31, -0.28, 300.0 },
+	};
+
+	for (uint32_t c = 0; c < chirps; ++c)
+	{
+		for (uint32_t n = 0; n < size; ++n)
+		{
+			double value = 2048.0 + (double)(host_random() % 33u) - 16.0;
+
+			for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); ++t)
+			{
+				value += targets[t].amplitude * cos(2.0 * PI * ((targets[t].range * n) + (targets[t].velocity * c)));
+			}
+			samples[(c * size) + n] = (uint16_t)lrint(value);
+		}
+	}
+}
+
+/**
+ * @brief Reference implementation: the steps of range_doppler.h one after the other
+ */
+static void reference(const uint16_t* input, uint16_t* output)
+{
+	const uint32_t size = rd.range.size;
+	const uint32_t bins = rd.range.bins;
+	const uint32_t chirps = rd.chirps;
+	const float scale = 32.0f / ((float)size * chirps);
+	float row_re[RANGE_DOPPLER_MAX_CHIRPS];
+	float row_im[RANGE_DOPPLER_MAX_CHIRPS];
+
+	// Range FFT of each chirp, cube[chirp][bin]
+	for (uint32_t c = 0; c < chirps; ++c)
+	{
+		range_fft_chirp(&rd.range, &input[c * size]);
+		memcpy(&cube_re[c * bins], rd.range.re, bins * sizeof(float));
+		memcpy(&cube_im[c * bins], rd.range.im, bins * sizeof(float));
+	}
+
+	for (uint32_t k = 0; k < bins; ++k)
+	{
+		float column_re[RANGE_DOPPLER_MAX_CHIRPS];
+		float column_im[RANGE_DOPPLER_MAX_CHIRPS];
+
+		// Transposition and window of the chirps, then the input order of the FFT
+		for (uint32_t c = 0; c < chirps; ++c)
+		{
+			column_re[c] = cube_re[(c * bins) + k] * rd.window[c];
+			column_im[c] = cube_im[(c * bins) + k] * rd.window[c];
+		}
+		for (uint32_t c = 0; c < chirps; ++c)
+		{
+			row_re[rd.doppler.bit_reverse[c]] = column_re[c];
+			row_im[rd.doppler.bit_reverse[c]] = column_im[c];
+		}
+
+		cfft_process(&rd.doppler, row_re, row_im);
+
+		// Zero velocity in the middle
+		for (uint32_t d = 0; d < chirps; ++d)
+		{
+			uint32_t bin = (d + (chirps / 2u)) % chirps;
+			float magnitude = scale * sqrtf((row_re[bin] * row_re[bin]) + (row_im[bin] * row_im[bin]));
+
+			output[(k * chirps) + d] = (magnitude >= 65535.0f) ? UINT16_MAX : (uint16_t)lrintf(magnitude);
+		}
+	}
+}
+
+/**
+ * @brief Map in double precision: DFTs along the samples then along the chirps
+ *
+ * @retval Largest difference with the map of the firmware in LSB
+ */
+static long exact_difference(const uint16_t* input, const uint16_t* output)
+{
+	const uint32_t size = rd.range.size;
+	const uint32_t bins = rd.range.bins;
+	const uint32_t chirps = rd.chirps;
+	long difference = 0;
+
+	for (uint32_t c = 0; c < chirps; ++c)
+	{
+		double mean = 0;
+
+		for (uint32_t n = 0; n < size; ++n)
+		{
+			mean += input[(c * size) + n];
+		}
+		mean /= size;
+
+		for (uint32_t k = 0; k < bins; ++k)
+		{
+			double sum_re = 0;
+			double sum_im = 0;
+
+			for (uint32_t n = 0; n < size; ++n)
+			{
+				double x = (input[(c * size) + n] - mean) * (0.5 - (0.5 * cos((2.0 * PI * n) / size)));
+				double angle = (-2.0 * PI * (double)((k * n) % size)) / size;
+
+				sum_re += x * cos(angle);
+				sum_im += x * sin(angle);
+			}
+			exact_re[(c * bins) + k] = sum_re;
+			exact_im[(c * bins) + k] = sum_im;
+		}
+	}
+
+	for (uint32_t k = 0; k < bins; ++k)
+	{
+		for (uint32_t d = 0; d < chirps; ++d)
+		{
+			uint32_t bin = (d + (chirps / 2u)) % chirps;
+			double sum_re = 0;
+			double sum_im = 0;
+			long expected = 0;
+			long actual = output[(k * chirps) + d];
+
+			for (uint32_t c = 0; c < chirps; ++c)
+			{
+				double w = 0.5 - (0.5 * cos((2.0 * PI * c) / chirps));
+				double angle = (-2.0 * PI * (double)((bin * c) % chirps)) / chirps;
+				double x_re = w * exact_re[(c * bins) + k];
+				double x_im = w * exact_im[(c * bins) + k];
+
+				sum_re += (x_re * cos(angle)) - (x_im * sin(angle));
+				sum_im += (x_re * sin(angle)) + (x_im * cos(angle));
+			}
+			expected = lrint((32.0 / ((double)size * chirps)) * hypot(sum_re, sum_im));
+			expected = (expected > 65535) ? 65535 : expected;
+			difference = (labs(actual - expected) > difference) ? labs(actual - expected) : difference;
+		}
+	}
+
+	return difference;
+}
+
+/**
+ * @brief Every shape: bit exact against the reference, close to the double precision map, in place
+ */
+static void test_shapes(void)
+{
+	CHECK_EQUAL(RANGE_DOPPLER_ERROR_PARAM, range_doppler_init(&rd, 100, 16));
+	CHECK_EQUAL(RANGE_DOPPLER_ERROR_PARAM, range_doppler_init(&rd, 128, 12));
+	CHECK_EQUAL(RANGE_DOPPLER_ERROR_PARAM, range_doppler_init(&rd, 128, RANGE_DOPPLER_MAX_CHIRPS * 2));
+
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i)
+	{
+		const uint32_t count = (uint32_t)shapes[i].samples_per_chirp * shapes[i].chirps;
+		uint32_t map_size = 0;
+		uint32_t work_size = 0;
+
+		CHECK_EQUAL(0, range_doppler_init(&rd, shapes[i].samples_per_chirp, shapes[i].chirps));
+		map_size = range_doppler_map_size(&rd);
+		work_size = range_doppler_work_size(&rd);
+		CHECK_EQUAL(count, map_size);
+		CHECK_EQUAL(count * 4, work_size);
+
+		simulate(shapes[i].samples_per_chirp, shapes[i].chirps);
+		CHECK_EQUAL(RANGE_DOPPLER_ERROR_OVERFLOW, range_doppler_process(&rd, samples, work, work_size - 4, map, map_size));
+		CHECK_EQUAL(RANGE_DOPPLER_ERROR_OVERFLOW, range_doppler_process(&rd, samples, work, work_size, map, map_size - 2));
+
+		CHECK_EQUAL(map_size, range_doppler_process(&rd, samples, work, work_size, map, map_size));
+		reference(samples, reference_map);
+		CHECK(memcmp(map, reference_map, map_size) == 0);
+		CHECK(exact_difference(samples, map) <= 1);
+
+		// Map written over the samples
+		memcpy(in_place, samples, count * sizeof(uint16_t));
+		CHECK_EQUAL(map_size, range_doppler_process(&rd, in_place, work, work_size, in_place, count * sizeof(uint16_t)));
+		CHECK(memcmp(in_place, map, map_size) == 0);
+	}
+}
+
+/**
+ * @brief Time per frame of every shape (best run)
+ */
+static void benchmark(unsigned long iterations)
+{
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i)
+	{
+		const uint32_t count = (uint32_t)shapes[i].samples_per_chirp * shapes[i].chirps;
+		uint64_t best = UINT64_MAX;
+
+		range_doppler_init(&rd, shapes[i].samples_per_chirp, shapes[i].chirps);
+		simulate(shapes[i].samples_per_chirp, shapes[i].chirps);
+
+		for (unsigned long j = 0; j < iterations; ++j)
+		{
+			uint64_t start = host_cycles();
+			uint64_t cycles = 0;
+
+			range_doppler_process(&rd, samples, work, sizeof(work), map, sizeof(map));
+			cycles = host_cycles() - start;
+			best = (cycles < best) ? cycles : best;
+		}
+
+		printf("Range-Doppler map %3u samples x %2u chirps: %8llu cycles per frame (%.1f cycles/sample)\n",
+				(unsigned)shapes[i].samples_per_chirp, (unsigned)shapes[i].chirps, (unsigned long long)best,
+				(double)best / count);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 20);
+
+	test_shapes();
+	benchmark(iterations);
+
+	return host_test_result("test_range_doppler");
+}
@@ -0,0 +1,278 @@
+/*
+ * test_range_fft.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Range processing of the radar chirps: the complex FFT (cfft.h) of every size
+ * against a DFT in double precision, then the range bins of range_fft_process in
+ * the four output formats against the DC removal, the Hann window and the DFT
+ * computed in double precision. Then the cycles of a complex FFT and of a radar
+ * frame per output format.
+ * Argument: iterations of the benchmark.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "dsp/cfft.h"
+#include "dsp/range_fft.h"
+
+/**
+ * @def PI
+ * Pi in double precision
+ */
+#define PI				3.14159265358979323846
+
+/**
+ * @def FRAME_CHIRPS
+ * Chirps of the radar frame of the benchmark (128 samples per chirp)
+ */
+#define FRAME_CHIRPS	64
+
+static cfft_t cfft;
+static range_fft_t range;
+static double reference_re[RANGE_FFT_MAX_SIZE];
+static double reference_im[RANGE_FFT_MAX_SIZE];
+static uint16_t samples[RANGE_FFT_MAX_SIZE * FRAME_CHIRPS];
+static float bins[RANGE_FFT_MAX_SIZE * FRAME_CHIRPS];
+
+/**
+ * @brief DFT in double precision
+ */
+static void dft(const double* in_re, const double* in_im, uint32_t size, double* out_re, double* out_im)
+{
+	for (uint32_t k = 0; k < size; ++k)
+	{
+		double sum_re = 0;
+		double sum_im = 0;
+
+		for (uint32_t n = 0; n < size; ++n)
+		{
+			double angle = (-2.0 * PI * (double)((k * n) % size)) / size;
+
+			sum_re += (in_re[n] * cos(angle)) - (in_im[n] * sin(angle));
+			sum_im += (in_re[n] * sin(angle)) + (in_im[n] * cos(angle));
+		}
+		out_re[k] = sum_re;
+		out_im[k] = sum_im;
+	}
+}
+
+/**
+ * @brief Complex FFT of random data, of an impulse and of a tone for every size
+ */
+static void test_cfft(void)
+{
+	static float re[CFFT_MAX_SIZE];
+	static float im[CFFT_MAX_SIZE];
+	static double in_re[CFFT_MAX_SIZE];
+	static double in_im[CFFT_MAX_SIZE];
+
+	CHECK_EQUAL(CFFT_ERROR_PARAM, cfft_init(&cfft, 0));
+	CHECK_EQUAL(CFFT_ERROR_PARAM, cfft_init(&cfft, CFFT_MIN_SIZE / 2));
+	CHECK_EQUAL(CFFT_ERROR_PARAM, cfft_init(&cfft, 48));
+	CHECK_EQUAL(CFFT_ERROR_PARAM, cfft_init(&cfft, CFFT_MAX_SIZE * 2));
+
+	for (uint32_t size = CFFT_MIN_SIZE; size <= CFFT_MAX_SIZE; size *= 2)
+	{
+		double error = 0;
+		double peak = 0;
+
+		CHECK_EQUAL(0, cfft_init(&cfft, (uint16_t)size));
+
+		// Random data: error relative to the largest bin
+		for (uint32_t n = 0; n < size; ++n)
+		{
+			in_re[n] = (double)(int32_t)(host_random() % 4096u) - 2048.0;
+			in_im[n] = (double)(int32_t)(host_random() % 4096u) - 2048.0;
+			re[cfft.bit_reverse[n]] = (float)in_re[n];
+			im[cfft.bit_reverse[n]] = (float)in_im[n];
+		}
+		cfft_process(&cfft, re, im);
+		dft(in_re, in_im, size, reference_re, reference_im);
+		for (uint32_t k = 0; k < size; ++k)
+		{
+			error = fmax(error, hypot(re[k] - reference_re[k], im[k] - reference_im[k]));
+			peak = fmax(peak, hypot(reference_re[k], reference_im[k]));
+		}
+		CHECK(error <= 1e-6 * peak * log2(size));
+
+		// Impulse at 0: every bin is 1
+		memset(re, 0, sizeof(re));
+		memset(im, 0, sizeof(im));
+		re[cfft.bit_reverse[0]] = 1.0f;
+		cfft_process(&cfft, re, im);
+		for (uint32_t k = 0; k < size; ++k)
+		{
+			CHECK((fabsf(re[k] - 1.0f) < 1e-6f) && (fabsf(im[k]) < 1e-6f));
+		}
+
+		// Complex tone of bin size / 4 + 1: one bin of amplitude size
+		for (uint32_t n = 0; n < size; ++n)
+		{
+			double angle = (2.0 * PI * (double)((((size / 4u) + 1u) * n) % size)) / size;
+
+			re[cfft.bit_reverse[n]] = (float)cos(angle);
+			im[cfft.bit_reverse[n]] = (float)sin(angle);
+		}
+		cfft_process(&cfft, re, im);
+		for (uint32_t k = 0; k < size; ++k)
+		{
+			double expected = (k == (size / 4u) + 1u) ? size : 0.0;
+
+			CHECK(hypot(re[k] - expected, im[k]) < 1e-5 * size);
+		}
+	}
+}
+
+/**
+ * @brief Range bins of random chirps with tones, in the four formats, against the double precision reference
+ */
+static void test_range_fft(void)
+{
+	static double windowed[RANGE_FFT_MAX_SIZE];
+	static const double zeros[RANGE_FFT_MAX_SIZE];
+
+	CHECK_EQUAL(RANGE_FFT_ERROR_PARAM, range_fft_init(&range, RANGE_FFT_MIN_SIZE / 2));
+	CHECK_EQUAL(RANGE_FFT_ERROR_PARAM, range_fft_init(&range, 100));
+	CHECK_EQUAL(RANGE_FFT_ERROR_PARAM, range_fft_init(&range, RANGE_FFT_MAX_SIZE * 2));
+
+	for (uint32_t size = RANGE_FFT_MIN_SIZE; size <= RANGE_FFT_MAX_SIZE; size *= 2)
+	{
+		const uint32_t half = size / 2u;
+		const uint32_t chirps = 4;
+		const double scale = 16.0 / size;
+		double mean = 0;
+		double error = 0;
+		double peak = 0;
+
+		CHECK_EQUAL(0, range_fft_init(&range, (uint16_t)size));
+		CHECK_EQUAL(half, range.bins);
+
+		// ADC codes: offset, two beat tones and noise; the first chirp is the reference
+		for (uint32_t c = 0; c < chirps; ++c)
+		{
+			for (uint32_t n = 0; n < size; ++n)
+			{
+				double tone = (900.0 * sin((2.0 * PI * 0.11 * n) + c)) + (300.0 * cos(2.0 * PI * 0.37 * n));
+
+				samples[(c * size) + n] = (uint16_t)lrint(2048.0 + tone + (double)(host_random() % 17u) - 8.0);
+			}
+		}
+		for (uint32_t n = 0; n < size; ++n)
+		{
+			mean += samples[n];
+		}
+		mean /= size;
+		for (uint32_t n = 0; n < size; ++n)
+		{
+			windowed[n] = (samples[n] - mean) * (0.5 - (0.5 * cos((2.0 * PI * n) / size)));
+		}
+		dft(windowed, zeros, size, reference_re, reference_im);
+		for (uint32_t k = 0; k < half; ++k)
+		{
+			peak = fmax(peak, hypot(reference_re[k], reference_im[k]));
+		}
+
+		// Complex float
+		CHECK_EQUAL(RANGE_FFT_ERROR_OVERFLOW, range_fft_process(&range, samples, chirps, RANGE_FFT_OUTPUT_COMPLEX_F32,
+				bins, (range_fft_chirp_size(&range, RANGE_FFT_OUTPUT_COMPLEX_F32) * chirps) - 1));
+		CHECK_EQUAL(half * 2 * sizeof(float) * chirps, range_fft_process(&range, samples, chirps,
+				RANGE_FFT_OUTPUT_COMPLEX_F32, bins, sizeof(bins)));
+		for (uint32_t k = 0; k < half; ++k)
+		{
+			error = fmax(error, hypot(bins[2 * k] - reference_re[k], bins[(2 * k) + 1] - reference_im[k]));
+		}
+		CHECK(error <= 2e-6 * peak * log2(size));
+
+		// Magnitude float
+		CHECK_EQUAL(half * sizeof(float) * chirps, range_fft_process(&range, samples, chirps,
+				RANGE_FFT_OUTPUT_MAG_F32, bins, sizeof(bins)));
+		for (uint32_t k = 0; k < half; ++k)
+		{
+			CHECK(fabs(bins[k] - hypot(reference_re[k], reference_im[k])) <= 2e-6 * peak * log2(size));
+		}
+
+		// Integer formats scaled by 16 / N: the rounding of the reference, 1 LSB apart at most
+		CHECK_EQUAL(half * sizeof(uint16_t) * chirps, range_fft_process(&range, samples, chirps,
+				RANGE_FFT_OUTPUT_MAG_U16, bins, sizeof(bins)));
+		for (uint32_t k = 0; k < half; ++k)
+		{
+			long expected = lrint(scale * hypot(reference_re[k], reference_im[k]));
+
+			CHECK(labs((long)((const uint16_t*)bins)[k] - expected) <= 1);
+		}
+
+		CHECK_EQUAL(half * 2 * sizeof(int16_t) * chirps, range_fft_process(&range, samples, chirps,
+				RANGE_FFT_OUTPUT_COMPLEX_I16, bins, sizeof(bins)));
+		for (uint32_t k = 0; k < half; ++k)
+		{
+			CHECK(labs((long)((const int16_t*)bins)[2 * k] - lrint(scale * reference_re[k])) <= 1);
+			CHECK(labs((long)((const int16_t*)bins)[(2 * k) + 1] - lrint(scale * reference_im[k])) <= 1);
+		}
+	}
+
+	CHECK_EQUAL(RANGE_FFT_ERROR_PARAM, range_fft_process(&range, samples, 1, (range_fft_output_t)4, bins, sizeof(bins)));
+}
+
+/**
+ * @brief Cycles of a complex FFT of 64 points and of a radar frame (128 samples, 64 chirps) per format
+ */
+static void benchmark(unsigned long iterations)
+{
+	static float re[CFFT_MAX_SIZE];
+	static float im[CFFT_MAX_SIZE];
+	static const char* const names[] = { "magnitude uint16", "magnitude float", "complex int16", "complex float" };
+	uint64_t best = UINT64_MAX;
+
+	cfft_init(&cfft, 64);
+	for (uint32_t n = 0; n < 64; ++n)
+	{
+		re[n] = (float)(host_random() % 4096u);
+		im[n] = (float)(host_random() % 4096u);
+	}
+	for (unsigned long i = 0; i < iterations * 100ul; ++i)
+	{
+		uint64_t start = host_cycles();
+		uint64_t cycles = 0;
+
+		cfft_process(&cfft, re, im);
+		cycles = host_cycles() - start;
+		best = (cycles < best) ? cycles : best;
+	}
+	printf("Complex FFT of 64 points: %llu cycles\n", (unsigned long long)best);
+
+	range_fft_init(&range, 128);
+	for (uint32_t n = 0; n < 128 * FRAME_CHIRPS; ++n)
+	{
+		samples[n] = (uint16_t)(host_random() & 0x0FFFu);
+	}
+	for (int output = RANGE_FFT_OUTPUT_MAG_U16; output <= RANGE_FFT_OUTPUT_COMPLEX_F32; ++output)
+	{
+		best = UINT64_MAX;
+		for (unsigned long i = 0; i < iterations; ++i)
+		{
+			uint64_t start = host_cycles();
+			uint64_t cycles = 0;
+
+			range_fft_process(&range, samples, FRAME_CHIRPS, (range_fft_output_t)output, bins, sizeof(bins));
+			cycles = host_cycles() - start;
+			best = (cycles < best) ? cycles : best;
+		}
+		printf("Range FFT of a frame (128 samples, %d chirps), %-16s: %llu cycles (%.1f cycles/sample)\n",
+				FRAME_CHIRPS, names[output], (unsigned long long)best, (double)best / (128.0 * FRAME_CHIRPS));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 20);
+
+	test_cfft();
+	test_range_fft();
+	benchmark(iterations);
+
+	return host_test_result("test_range_fft");
+}
@@ -0,0 +1,323 @@
+/*
+ * test_tile_delta.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ROJ030
+ *
+ * Rutronik Elektronische Bauelemente GmbH Disclaimer: The evaluation board
+ * including the software is for testing purposes only and,
+ * because it has limited functions and limited resilience, is not suitable
+ * for permanent use under real conditions. If the evaluation board is
+ * nevertheless used under real conditions, this is done at one’s responsibility;
+ * any liability of Rutronik is insofar excluded
+ *
+ * Motion gating (tile_delta.h) on a sequence of camera frames: the receiver
+ * applying the delta frames has the reference frame of the device after every
+ * frame and each tile not sent is within the threshold of the frame (with a
+ * threshold of 0, the compared lines are rebuilt exactly). The SAD is checked against
+ * a plain implementation of its definition, the errors and the corrupted delta
+ * frames are checked, then the cycles per pixel of the detection are printed.
+ *
+ * Arguments: iterations of the benchmark, then optionally a recording to replay
+ * (raw QVGA RGB565 frames, little endian, one after the other). Without it a
+ * sequence is generated: sensor noise, an object moving over a still background
+ * and an exposure step.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "codec/tile_delta.h"
+
+/**
+ * @def WIDTH
+ * QVGA frame
+ */
+#define WIDTH			320
+
+/**
+ * @def HEIGHT
+ * QVGA frame
+ */
+#define HEIGHT			240
+
+/**
+ * @def PIXELS
+ * Pixels of a frame
+ */
+#define PIXELS			(WIDTH * HEIGHT)
+
+/**
+ * @def TILES
+ * Tiles of a frame
+ */
+#define TILES			((WIDTH / TILE_DELTA_SIZE) * (HEIGHT / TILE_DELTA_SIZE))
+
+/**
+ * @def GENERATED_FRAMES
+ * Length of the generated sequence
+ */
+#define GENERATED_FRAMES	60
+
+/**
+ * @def OUTPUT_SIZE
+ * Delta frame with every tile
+ */
+#define OUTPUT_SIZE		(TILES * TILE_DELTA_ENTRY_SIZE)
+
+static uint16_t frame[PIXELS];
+static uint16_t reference[PIXELS];
+static uint16_t received[PIXELS];
+static uint8_t changed[TILES];
+static uint8_t output[OUTPUT_SIZE];
+
+/**
+ * @brief Source of the frames: a recording or the generated sequence
+ */
+typedef struct
+{
+	FILE* file;
+	uint32_t index;
+} sequence_t;
+
+/**
+ * @brief Pack 8 bits components in a RGB565 pixel
+ */
+static uint16_t rgb565(int r, int g, int b)
+{
+	r = (r < 0) ? 0 : ((r > 255) ? 255 : r);
+	g = (g < 0) ? 0 : ((g > 255) ? 255 : g);
+	b = (b < 0) ? 0 : ((b > 255) ? 255 : b);
+
+	return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+/**
+ * @brief Next frame of the sequence
+ *
+ * @retval 1 Frame read
+ * @retval 0 End of the sequence
+ */
+static int sequence_next(sequence_t* sequence, uint16_t* pixels)
+{
+	uint32_t index = sequence->index++;
+
+	if (sequence->file != NULL)
+	{
+		uint8_t bytes[WIDTH * 2];
+
+		for (uint32_t y = 0; y < HEIGHT; ++y)
+		{
+			if (fread(bytes, 1, sizeof(bytes), sequence->file) != sizeof(bytes))
+			{
+				return 0;
+			}
+			for (uint32_t x = 0; x < WIDTH; ++x)
+			{
+				pixels[(y * WIDTH) + x] = (uint16_t)(bytes[x * 2] | (bytes[(x * 2) + 1] << 8));
+			}
+		}
+		return 1;
+	}
+
+	if (index >= GENERATED_FRAMES)
+	{
+		return 0;
+	}
+
+	// Object of 40 x 30 pixels crossing the frame, exposure step at the middle
+	{
+		uint32_t object_x = (index * 5u) % (WIDTH - 40u);
+		uint32_t object_y = 60u + ((index * 2u) % (HEIGHT - 90u));
+		int exposure = (index >= (GENERATED_FRAMES / 2)) ? 24 : 0;
+
+		for (uint32_t y = 0; y < HEIGHT; ++y)
+		{
+			for (uint32_t x = 0; x < WIDTH; ++x)
+			{
+				int noise = (int)(host_random() % 5u) - 2;
+				int inside = (x >= object_x) && (x < object_x + 40u) && (y >= object_y) && (y < object_y + 30u);
+				int r = inside ? 220 : (int)(40 + ((x * 120u) / WIDTH));
+				int g = inside ? 60 : (int)(60 + ((y * 100u) / HEIGHT));
+				int b = inside ? 50 : 90;
+
+				pixels[(y * WIDTH) + x] = rgb565(r + exposure + noise, g + exposure + noise, b + exposure + noise);
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief SAD of a tile, from the definition of tile_delta.h
+ */
+static uint32_t plain_sad(const uint16_t* a, const uint16_t* b, uint16_t width, uint16_t column, uint16_t row)
+{
+	uint32_t sad = 0;
+
+	for (uint32_t y = 0; y < TILE_DELTA_SIZE; y += 2)
+	{
+		for (uint32_t x = 0; x < TILE_DELTA_SIZE; ++x)
+		{
+			uint32_t i = (((row * TILE_DELTA_SIZE) + y) * width) + (column * TILE_DELTA_SIZE) + x;
+			int dr = ((a[i] >> 11) & 0x1F) - ((b[i] >> 11) & 0x1F);
+			int dg = ((a[i] >> 5) & 0x3F) - ((b[i] >> 5) & 0x3F);
+			int db = (a[i] & 0x1F) - (b[i] & 0x1F);
+
+			sad += (uint32_t)((2 * abs(dr)) + abs(dg) + (2 * abs(db)));
+		}
+	}
+
+	return sad;
+}
+
+/**
+ * @brief Replay the sequence through the device side and the receiver side
+ *
+ * @param [in] path Recording, NULL for the generated sequence
+ * @param [in] threshold Threshold of the detection
+ */
+static void replay(const char* path, uint8_t threshold)
+{
+	sequence_t sequence = { NULL, 0 };
+	uint32_t frames = 0;
+	uint32_t sent = 0;
+	uint64_t bytes = 0;
+
+	if (path != NULL)
+	{
+		sequence.file = fopen(path, "rb");
+		CHECK(sequence.file != NULL);
+		if (sequence.file == NULL)
+		{
+			return;
+		}
+	}
+
+	// The first frame is sent whole (raw RGB565) by the device
+	CHECK(sequence_next(&sequence, frame) != 0);
+	memcpy(reference, frame, sizeof(frame));
+	memcpy(received, frame, sizeof(frame));
+
+	while (sequence_next(&sequence, frame) != 0)
+	{
+		int32_t count = tile_delta_detect(frame, reference, WIDTH, HEIGHT, threshold, changed);
+		int32_t size = 0;
+
+		CHECK(count >= 0);
+		if (count <= 0)
+		{
+			frames++;
+			continue;
+		}
+
+		size = tile_delta_encode(frame, reference, WIDTH, HEIGHT, changed, output, sizeof(output));
+		CHECK_EQUAL(count * TILE_DELTA_ENTRY_SIZE, size);
+		CHECK_EQUAL(0, tile_delta_apply(output, (uint32_t)size, WIDTH, HEIGHT, received));
+		CHECK(memcmp(reference, received, sizeof(reference)) == 0);
+
+		// What was not sent is close to the frame (threshold 0: the compared lines are exact)
+		for (uint16_t row = 0; row < HEIGHT / TILE_DELTA_SIZE; ++row)
+		{
+			for (uint16_t column = 0; column < WIDTH / TILE_DELTA_SIZE; ++column)
+			{
+				CHECK(plain_sad(frame, received, WIDTH, column, row) <= (uint32_t)threshold * TILE_DELTA_SAMPLES);
+			}
+		}
+
+		frames++;
+		sent += (uint32_t)count;
+		bytes += (uint64_t)size;
+	}
+
+	printf("Threshold %3u: %u frames, %.1f tiles/frame, %.1f%% of the raw bandwidth\n", (unsigned)threshold,
+			(unsigned)frames, (frames != 0) ? (double)sent / frames : 0.0,
+			(frames != 0) ? (100.0 * (double)bytes) / ((double)frames * PIXELS * 2) : 0.0);
+
+	if (sequence.file != NULL)
+	{
+		fclose(sequence.file);
+	}
+}
+
+/**
+ * @brief SAD against its definition, errors and corrupted delta frames
+ */
+static void test_sad_and_errors(void)
+{
+	int32_t size = 0;
+
+	host_random_fill(frame, sizeof(frame));
+	host_random_fill(reference, sizeof(reference));
+	for (uint16_t row = 0; row < HEIGHT / TILE_DELTA_SIZE; ++row)
+	{
+		for (uint16_t column = 0; column < WIDTH / TILE_DELTA_SIZE; ++column)
+		{
+			CHECK_EQUAL(plain_sad(frame, reference, WIDTH, column, row), tile_delta_sad(frame, reference, WIDTH, column, row));
+		}
+	}
+
+	CHECK_EQUAL(TILE_DELTA_ERROR_PARAM, tile_delta_detect(frame, reference, WIDTH - 1, HEIGHT, 0, changed));
+	CHECK_EQUAL(TILE_DELTA_ERROR_PARAM, tile_delta_detect(frame, reference, WIDTH, 0, 0, changed));
+
+	// A delta frame that does not fit leaves the reference unchanged
+	memcpy(received, reference, sizeof(reference));
+	CHECK_EQUAL(TILES, tile_delta_detect(frame, reference, WIDTH, HEIGHT, 0, changed));
+	CHECK_EQUAL(TILE_DELTA_ERROR_OVERFLOW, tile_delta_encode(frame, reference, WIDTH, HEIGHT, changed, output, sizeof(output) - 1));
+	CHECK(memcmp(received, reference, sizeof(reference)) == 0);
+
+	size = tile_delta_encode(frame, reference, WIDTH, HEIGHT, changed, output, sizeof(output));
+	CHECK_EQUAL(OUTPUT_SIZE, size);
+
+	// Truncated entry, tile outside of the frame
+	CHECK_EQUAL(TILE_DELTA_ERROR_DATA, tile_delta_apply(output, TILE_DELTA_ENTRY_SIZE - 1, WIDTH, HEIGHT, received));
+	output[0] = WIDTH / TILE_DELTA_SIZE;
+	CHECK_EQUAL(TILE_DELTA_ERROR_DATA, tile_delta_apply(output, TILE_DELTA_ENTRY_SIZE, WIDTH, HEIGHT, received));
+	output[0] = 0;
+	output[1] = HEIGHT / TILE_DELTA_SIZE;
+	CHECK_EQUAL(TILE_DELTA_ERROR_DATA, tile_delta_apply(output, TILE_DELTA_ENTRY_SIZE, WIDTH, HEIGHT, received));
+}
+
+/**
+ * @brief Cycles per pixel of the detection (best run, frame against a noisy copy)
+ */
+static void benchmark(unsigned long iterations)
+{
+	uint64_t best = UINT64_MAX;
+	volatile int32_t sink = 0;
+
+	for (uint32_t i = 0; i < PIXELS; ++i)
+	{
+		frame[i] = rgb565((int)(i % 256u), 128, 64);
+		reference[i] = (uint16_t)(frame[i] ^ (host_random() & 0x0821u));
+	}
+
+	for (unsigned long i = 0; i < iterations; ++i)
+	{
+		uint64_t start = host_cycles();
+		uint64_t cycles = 0;
+
+		sink = tile_delta_detect(frame, reference, WIDTH, HEIGHT, 4, changed);
+		cycles = host_cycles() - start;
+		best = (cycles < best) ? cycles : best;
+	}
+	(void)sink;
+
+	printf("Detection: %.2f cycles/pixel\n", (double)best / PIXELS);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = host_iterations(argc, argv, 20);
+	const char* recording = (argc > 2) ? argv[2] : NULL;
+
+	test_sad_and_errors();
+	replay(recording, 0);
+	replay(recording, 2);
+	replay(recording, 8);
+	replay(recording, 32);
+	benchmark(iterations);
+
+	return host_test_result("test_tile_delta");
+}